@@ -0,0 +1,552 @@
+/*
+  osdp-bench-loop - ACU to PD round trip benchmark over a pseudo-tty
+
+  usage: osdp-bench-loop [seconds [baud [mix]]]
+
+    seconds  how long to run (default 10)
+    baud     emulated line speed, 0 for as fast as the pty goes (default 115200)
+    mix      commands and weights, e.g. POLL:8,ID:1,CAP:1,LSTAT:1 (default POLL)
+
+  The PD is a child process running the library on the slave side of a
+  posix_openpt pair; the ACU runs in this process on the master side.
+  A pty has no line speed so send_osdp_data waits out the time the frame
+  would take on the wire (10 bits an octet.)  Each command is sent once
+  the previous response was processed, and the round trip is the time
+  from send_message to the response being processed.  That includes
+  whatever the library does with the response (ID and PDID run the
+  action scripts, as in open-osdp.)
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+
+#include <open-osdp.h>
+#include <osdp_conformance.h>
+
+
+OSDP_CONTEXT context;
+unsigned char creds_buffer_a [64*1024];
+int creds_buffer_a_lth;
+int creds_buffer_a_next;
+int creds_buffer_a_remaining;
+OSDP_BUFFER osdp_buf;
+OSDP_INTEROP_ASSESSMENT osdp_conformance;
+OSDP_PARAMETERS p_card;
+char trace_in_buffer [4*OSDP_OFFICIAL_MSG_MAX];
+char trace_out_buffer [4*OSDP_OFFICIAL_MSG_MAX];
+
+#define BENCH_MAX_MIX     (16)
+#define BENCH_MAX_SAMPLES (4*1024*1024)
+#define BENCH_PD_ADDRESS  (0)
+
+typedef struct bench_command
+{
+  char *name;
+  int command;
+  int data_length;
+  unsigned char data [4];
+} BENCH_COMMAND;
+
+BENCH_COMMAND bench_commands [] =
+{
+  { "POLL",  OSDP_POLL,  0, { 0 } },
+  { "ID",    OSDP_ID,    1, { 0 } },
+  { "CAP",   OSDP_CAP,   1, { 0 } },
+  { "LSTAT", OSDP_LSTAT, 0, { 0 } },
+  { "ISTAT", OSDP_ISTAT, 0, { 0 } },
+  { "OSTAT", OSDP_OSTAT, 0, { 0 } },
+  { "RSTAT", OSDP_RSTAT, 0, { 0 } },
+  { NULL,    0,          0, { 0 } }
+};
+
+typedef struct bench_mix
+{
+  BENCH_COMMAND *cmd;
+  int weight;
+  long sent;
+  long answered;
+} BENCH_MIX;
+
+int bench_baud;
+
+
+void
+  bench_context
+    (OSDP_CONTEXT *ctx,
+    int role);
+int
+  bench_mix_parse
+    (char *mix_string,
+    BENCH_MIX *mix,
+    int *mix_count);
+int
+  bench_sample_compare
+    (const void *a,
+    const void *b);
+long
+  bench_usec
+    (struct timespec *from,
+    struct timespec *to);
+int
+  pd_loop
+    (char *device);
+int
+  read_and_process
+    (OSDP_CONTEXT *ctx,
+    int timeout_ms);
+
+
+int
+  main
+    (int argc,
+    char *argv [])
+
+{ /* main for osdp-bench-loop */
+
+  long bytes_start;
+  int current_length;
+  struct timespec deadline;
+  int done;
+  struct timespec end_time;
+  int i;
+  int master;
+  BENCH_MIX mix [BENCH_MAX_MIX];
+  int mix_count;
+  char *mix_string;
+  pid_t pd_pid;
+  long run_seconds;
+  long *samples;
+  long sample_count;
+  struct timespec sent;
+  struct timespec start_time;
+  int status;
+  int slave;
+  char slave_path [1024];
+  struct termios tio;
+  long timeouts;
+  int turn;
+  long wait_usec;
+  long waited;
+  int w;
+
+
+  status = ST_OK;
+  run_seconds = 10;
+  bench_baud = 115200;
+  mix_string = "POLL";
+  if (argc > 1)
+    run_seconds = atol (argv [1]);
+  if (argc > 2)
+    bench_baud = atoi (argv [2]);
+  if (argc > 3)
+    mix_string = argv [3];
+  samples = malloc (BENCH_MAX_SAMPLES * sizeof (samples [0]));
+  if (samples EQUALS NULL)
+    status = -1;
+  if (status EQUALS ST_OK)
+    status = bench_mix_parse (mix_string, mix, &mix_count);
+
+  // the pty pair.  the slave is put in raw mode before either end talks.
+
+  master = -1;
+  if (status EQUALS ST_OK)
+  {
+    master = posix_openpt (O_RDWR | O_NOCTTY);
+    if ((master EQUALS -1) || (grantpt (master) != 0) ||
+      (unlockpt (master) != 0))
+      status = ST_SERIAL_OPEN_ERR;
+  };
+  if (status EQUALS ST_OK)
+  {
+    strcpy (slave_path, ptsname (master));
+    slave = open (slave_path, O_RDWR | O_NOCTTY);
+    if (slave EQUALS -1)
+      status = ST_SERIAL_OPEN_ERR;
+  };
+  if (status EQUALS ST_OK)
+  {
+    (void)tcgetattr (slave, &tio);
+    cfmakeraw (&tio);
+    (void)tcsetattr (slave, TCSANOW, &tio);
+    pd_pid = fork ();
+    if (pd_pid EQUALS 0)
+    {
+      close (master);
+      exit (pd_loop (slave_path));
+    };
+    if (pd_pid EQUALS -1)
+      status = -1;
+  };
+
+  if (status EQUALS ST_OK)
+  {
+    bench_context (&context, OSDP_ROLE_ACU);
+    context.fd = master;
+    (void)fcntl (master, F_SETFL, fcntl (master, F_GETFL, 0) | O_NONBLOCK);
+    fprintf (stdout, "osdp-bench-loop: %ld. sec at %d. baud, mix %s, PD on %s\n",
+      run_seconds, bench_baud, mix_string, slave_path);
+    fflush (stdout);
+
+    // one command at a time, each sent once the last one was answered
+    // (or timed out.)  the mix is worked through in order, by weight.
+
+    sample_count = 0;
+    timeouts = 0;
+    wait_usec = context.timer [OSDP_TIMER_RESPONSE].i_sec * 1000000l +
+      context.timer [OSDP_TIMER_RESPONSE].i_nsec / 1000l;
+    bytes_start = context.bytes_received;
+    clock_gettime (CLOCK_MONOTONIC, &start_time);
+    deadline = start_time;
+    deadline.tv_sec = deadline.tv_sec + run_seconds;
+    done = 0;
+    turn = 0;
+    w = 0;
+    while (!done)
+    {
+      BENCH_MIX *m;
+
+      m = &(mix [turn]);
+      current_length = 0;
+      clock_gettime (CLOCK_MONOTONIC, &sent);
+      status = send_message (&context, m->cmd->command, BENCH_PD_ADDRESS,
+        &current_length, m->cmd->data_length, m->cmd->data);
+      m->sent ++;
+      waited = 0;
+      while ((!context.last_was_processed) && (waited < wait_usec))
+      {
+        (void)read_and_process (&context, 1);
+        clock_gettime (CLOCK_MONOTONIC, &end_time);
+        waited = bench_usec (&sent, &end_time);
+      };
+      clock_gettime (CLOCK_MONOTONIC, &end_time);
+      if (context.last_was_processed)
+      {
+        m->answered ++;
+        if (sample_count < BENCH_MAX_SAMPLES)
+        {
+          samples [sample_count] = bench_usec (&sent, &end_time);
+          sample_count ++;
+        };
+      }
+      else
+      {
+        timeouts ++;
+
+        // start over on sequence 0, like a PD that was reset
+        context.next_sequence = 0;
+      };
+
+      w ++;
+      if (w >= m->weight)
+      {
+        w = 0;
+        turn = (turn + 1) % mix_count;
+      };
+      if ((end_time.tv_sec > deadline.tv_sec) ||
+        ((end_time.tv_sec EQUALS deadline.tv_sec) &&
+        (end_time.tv_nsec >= deadline.tv_nsec)))
+        done = 1;
+    };
+
+    // report
+
+    {
+      double elapsed;
+
+      elapsed = bench_usec (&start_time, &end_time) / 1000000.0;
+      qsort (samples, sample_count, sizeof (samples [0]), bench_sample_compare);
+      fprintf (stdout, "round trips: %ld. timeouts: %ld. in %.3f sec\n",
+        sample_count, timeouts, elapsed);
+      fprintf (stdout, "throughput: %.1f commands/sec, %.1f octets/sec received\n",
+        sample_count / elapsed,
+        (context.bytes_received - bytes_start) / elapsed);
+      if (sample_count > 0)
+        fprintf (stdout, "latency usec: p50 %ld. p99 %ld. p999 %ld. max %ld.\n",
+          samples [(sample_count * 50) / 100],
+          samples [(sample_count * 99) / 100],
+          samples [(sample_count * 999) / 1000],
+          samples [sample_count - 1]);
+      for (i=0; i<mix_count; i++)
+        fprintf (stdout, "  %-6s sent %ld. answered %ld.\n",
+          mix [i].cmd->name, mix [i].sent, mix [i].answered);
+    };
+    kill (pd_pid, SIGTERM);
+    (void)waitpid (pd_pid, NULL, 0);
+    status = ST_OK;
+  };
+  if (status != ST_OK)
+    fprintf (stderr, "osdp-bench-loop failed (%d)\n", status);
+  return (status);
+
+} /* main for osdp-bench-loop */
+
+
+/*
+  bench_context - what initialize_osdp sets up, without the lock, the
+  configuration file or the log (so an ACU and a PD can share a box.)
+*/
+
+void
+  bench_context
+    (OSDP_CONTEXT *ctx,
+    int role)
+
+{ /* bench_context */
+
+  memset (ctx, 0, sizeof (*ctx));
+  memset (&p_card, 0, sizeof (p_card));
+  memset (&osdp_buf, 0, sizeof (osdp_buf));
+  memset (&osdp_conformance, 0, sizeof (osdp_conformance));
+  ctx->role = role;
+  ctx->verbosity = 0;
+  ctx->log = fopen ("/dev/null", "w");
+  ctx->fd = -1;
+  ctx->enable_poll = OO_POLL_ENABLED;
+  ctx->current_key_slot = -1;
+  ctx->model = 2;
+  ctx->version = 2;
+  ctx->vendor_code [0] = 0x0A;
+  ctx->vendor_code [1] = 0x00;
+  ctx->vendor_code [2] = 0x17;
+  ctx->pd_address = BENCH_PD_ADDRESS;
+  p_card.addr = BENCH_PD_ADDRESS;
+  p_card.bits = 26;
+  m_check = OSDP_CRC;
+  ctx->timer_count = 3;
+  ctx->timer [OSDP_TIMER_STATISTICS].timeout_action = OSDP_TIMER_RESTART_ALWAYS;
+  ctx->timer [OSDP_TIMER_STATISTICS].i_sec = 3;
+  ctx->timer [OSDP_TIMER_RESPONSE].timeout_action = OSDP_TIMER_RESTART_NONE;
+  ctx->timer [OSDP_TIMER_RESPONSE].i_nsec = 200000000l;
+  ctx->timer [OSDP_TIMER_SUMMARY].timeout_action = OSDP_TIMER_RESTART_ALWAYS;
+  ctx->timer [OSDP_TIMER_SUMMARY].i_sec = 60;
+
+} /* bench_context */
+
+
+/*
+  bench_mix_parse - "POLL:8,ID:1" into the mix table (weight defaults to 1)
+*/
+
+int
+  bench_mix_parse
+    (char *mix_string,
+    BENCH_MIX *mix,
+    int *mix_count)
+
+{ /* bench_mix_parse */
+
+  char *colon;
+  int i;
+  char mix_copy [1024];
+  int status;
+  char *token;
+
+
+  status = ST_OK;
+  *mix_count = 0;
+  strncpy (mix_copy, mix_string, sizeof (mix_copy)-1);
+  mix_copy [sizeof (mix_copy)-1] = 0;
+  token = strtok (mix_copy, ",");
+  while ((token != NULL) && (status EQUALS ST_OK))
+  {
+    if (*mix_count >= BENCH_MAX_MIX)
+      status = ST_CMD_OVERFLOW;
+    if (status EQUALS ST_OK)
+    {
+      memset (&(mix [*mix_count]), 0, sizeof (mix [0]));
+      mix [*mix_count].weight = 1;
+      colon = strchr (token, ':');
+      if (colon != NULL)
+      {
+        *colon = 0;
+        mix [*mix_count].weight = atoi (colon+1);
+        if (mix [*mix_count].weight < 1)
+          mix [*mix_count].weight = 1;
+      };
+      for (i=0; bench_commands [i].name != NULL; i++)
+        if (0 EQUALS strcasecmp (token, bench_commands [i].name))
+          mix [*mix_count].cmd = &(bench_commands [i]);
+      if (mix [*mix_count].cmd EQUALS NULL)
+      {
+        fprintf (stderr, "unknown command in mix: %s\n", token);
+        status = ST_CMD_INVALID;
+      };
+    };
+    if (status EQUALS ST_OK)
+      (*mix_count) ++;
+    token = strtok (NULL, ",");
+  };
+  if ((status EQUALS ST_OK) && (*mix_count EQUALS 0))
+    status = ST_CMD_INVALID;
+  return (status);
+
+} /* bench_mix_parse */
+
+
+int
+  bench_sample_compare
+    (const void *a,
+    const void *b)
+
+{ /* bench_sample_compare */
+
+  long la;
+  long lb;
+
+
+  la = *(const long *)a;
+  lb = *(const long *)b;
+  return ((la > lb) - (la < lb));
+
+} /* bench_sample_compare */
+
+
+long
+  bench_usec
+    (struct timespec *from,
+    struct timespec *to)
+
+{ /* bench_usec */
+
+  return ((to->tv_sec - from->tv_sec) * 1000000l +
+    (to->tv_nsec - from->tv_nsec) / 1000l);
+
+} /* bench_usec */
+
+
+/*
+  pd_loop - the PD: answer whatever comes in until told to stop
+*/
+
+int
+  pd_loop
+    (char *device)
+
+{ /* pd_loop */
+
+  int status;
+
+
+  bench_context (&context, OSDP_ROLE_PD);
+  status = init_serial (&context, device);
+  while (status EQUALS ST_OK)
+    (void)read_and_process (&context, 1000);
+  return (status);
+
+} /* pd_loop */
+
+
+/*
+  read_and_process - wait for input and process every whole frame
+*/
+
+int
+  read_and_process
+    (OSDP_CONTEXT *ctx,
+    int timeout_ms)
+
+{ /* read_and_process */
+
+  int previous_count;
+  struct pollfd pfd;
+  int space;
+  int status;
+  int status_io;
+  unsigned char *tail;
+
+
+  status = ST_OK;
+  pfd.fd = ctx->fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  if (poll (&pfd, 1, timeout_ms) > 0)
+  {
+    status_io = 1;
+    space = 1;
+    while ((status_io > 0) && (space > 0))
+    {
+      tail = osdp_buffer_tailroom (&osdp_buf, &space);
+      status_io = 0;
+      if (space > 0)
+        status_io = read (ctx->fd, tail, space);
+      if (status_io > 0)
+      {
+        osdp_buffer_produce (&osdp_buf, status_io);
+        ctx->bytes_received = ctx->bytes_received + status_io;
+      };
+    };
+    do
+    {
+      (void)osdp_buffer_skip_to_som (&osdp_buf);
+      previous_count = osdp_buffer_count (&osdp_buf);
+      status = ST_OK;
+      if (previous_count > 0)
+        status = process_osdp_input (&osdp_buf);
+      if (status EQUALS ST_SERIAL_IN)
+        status = ST_OK;
+    } while ((status EQUALS ST_OK) && (osdp_buffer_count (&osdp_buf) > 0) &&
+      (osdp_buffer_count (&osdp_buf) < previous_count));
+  };
+  return (status);
+
+} /* read_and_process */
+
+
+/*
+  send_osdp_data - write the frame and wait out its time on the wire
+*/
+
+int
+  send_osdp_data
+    (OSDP_CONTEXT *ctx,
+    unsigned char *buf,
+    int lth)
+
+{ /* send_osdp_data */
+
+  struct timespec wire_time;
+  long wire_nsec;
+
+
+  if (write (ctx->fd, buf, lth) EQUALS lth)
+    ctx->bytes_sent = ctx->bytes_sent + lth;
+  if (bench_baud > 0)
+  {
+    wire_nsec = (long)((10.0 * lth * 1000000000.0) / bench_baud);
+    wire_time.tv_sec = wire_nsec / 1000000000l;
+    wire_time.tv_nsec = wire_nsec % 1000000000l;
+    (void)nanosleep (&wire_time, NULL);
+  };
+  return (ST_OK);
+
+} /* send_osdp_data */
+
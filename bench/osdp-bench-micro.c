@@ -0,0 +1,565 @@
+/*
+  osdp-bench-micro - timings for the library's per-frame code paths
+
+  usage: osdp-bench-micro [milliseconds-per-case [cipher]]
+
+  Each case is run over frames from 8 octets (a POLL) to 1440 octets
+  (OSDP_OFFICIAL_MSG_MAX) until it has taken at least the given time
+  (default 200) and is reported as ns/frame and MB/s (octets processed
+  over time, 10^6 octets a second.)  The octet count is the whole frame
+  for the framing cases and the payload for the crypto ones.
+
+  cipher is the AES backend for the crypto cases, "auto" (the default),
+  "aes-ni" or "software", as for the "cipher" setting.
+
+  Library chatter to stderr (osdp_decrypt_payload has some) is sent to
+  /dev/null while a case is timed.
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#include <open-osdp.h>
+#include <osdp_conformance.h>
+
+
+OSDP_CONTEXT context;
+unsigned char creds_buffer_a [64*1024];
+int creds_buffer_a_lth;
+int creds_buffer_a_next;
+int creds_buffer_a_remaining;
+OSDP_BUFFER osdp_buf;
+OSDP_INTEROP_ASSESSMENT osdp_conformance;
+OSDP_PARAMETERS p_card;
+char trace_in_buffer [4*OSDP_OFFICIAL_MSG_MAX];
+char trace_out_buffer [4*OSDP_OFFICIAL_MSG_MAX];
+
+// secure frame overhead: header 5, security block 3, command 1, MAC 4, CRC 2
+#define BENCH_SECURE_OVERHEAD (15)
+
+// oosdp_print_message_RAW hex-dumps the card data into a 1024 octet string
+#define BENCH_RAW_FORMAT_MAX  (512)
+
+typedef struct bench_frame
+{
+  int size;
+  unsigned char data [OSDP_BUF_MAX];
+  int data_length;
+  unsigned char frame [OSDP_BUF_MAX];
+  int frame_length;
+  OSDP_MSG frame_desc;
+  unsigned char payload [OSDP_BUF_MAX];
+  int payload_length;
+  unsigned char raw_frame [OSDP_BUF_MAX];
+  int raw_frame_length;
+  unsigned char work [OSDP_BUF_MAX];
+} BENCH_FRAME;
+
+typedef struct bench_case
+{
+  char *name;
+  int (*run) (BENCH_FRAME *bf);
+} BENCH_CASE;
+
+int bench_build_message (BENCH_FRAME *bf);
+int bench_build_secure_message (BENCH_FRAME *bf);
+int bench_cbc_encrypt (BENCH_FRAME *bf);
+int bench_cbc_mac (BENCH_FRAME *bf);
+int bench_checksum (BENCH_FRAME *bf);
+int bench_crc (BENCH_FRAME *bf);
+int bench_decrypt_payload (BENCH_FRAME *bf);
+int bench_encrypt_payload (BENCH_FRAME *bf);
+int bench_hash_check (BENCH_FRAME *bf);
+int bench_log_tx_message (BENCH_FRAME *bf);
+int bench_make_message (BENCH_FRAME *bf);
+int bench_parse_message (BENCH_FRAME *bf);
+void bench_setup (BENCH_FRAME *bf, int size);
+
+BENCH_CASE bench_cases [] =
+{
+  { "fCrcBlk",                   bench_crc },
+  { "checksum",                  bench_checksum },
+  { "osdp_build_message",        bench_build_message },
+  { "osdp_build_secure_message", bench_build_secure_message },
+  { "osdp_parse_message",        bench_parse_message },
+  { "osdp_log_tx_message",       bench_log_tx_message },
+  { "oo_hash_check",             bench_hash_check },
+  { "osdp_encrypt_payload",      bench_encrypt_payload },
+  { "osdp_decrypt_payload",      bench_decrypt_payload },
+  { "osdp_cipher_cbc_encrypt",   bench_cbc_encrypt },
+  { "osdp_cipher_cbc_mac",       bench_cbc_mac },
+  { "oosdp_make_message",        bench_make_message },
+  { NULL,                        NULL }
+};
+
+// results nobody looks at go here so the calls are not optimized away
+volatile unsigned int bench_sink;
+
+int bench_sizes [] = { 8, 16, 32, 64, 128, 256, 512, 1024, OSDP_OFFICIAL_MSG_MAX, 0 };
+
+
+int
+  main
+    (int argc,
+    char *argv [])
+
+{ /* main for osdp-bench-micro */
+
+  BENCH_FRAME *bf;
+  long bytes;
+  int c;
+  double elapsed_ns;
+  long i;
+  long iterations;
+  long min_ns;
+  int null_fd;
+  int octets;
+  int s;
+  int saved_stderr;
+  struct timespec start_time;
+  int status;
+  struct timespec stop_time;
+
+
+  status = ST_OK;
+  min_ns = 200 * 1000000l;
+  if (argc > 1)
+    min_ns = atol (argv [1]) * 1000000l;
+  context.cipher = OSDP_CIPHER_AUTO;
+  if (argc > 2)
+  {
+    if (0 EQUALS strcmp (argv [2], "aes-ni"))
+      context.cipher = OSDP_CIPHER_AESNI;
+    if (0 EQUALS strcmp (argv [2], "software"))
+      context.cipher = OSDP_CIPHER_SOFTWARE;
+  };
+  bf = malloc (sizeof (*bf));
+  if (bf EQUALS NULL)
+    status = -1;
+  null_fd = open ("/dev/null", O_WRONLY);
+  saved_stderr = dup (2);
+
+  if (status EQUALS ST_OK)
+  {
+    i = context.cipher;
+    memset (&context, 0, sizeof (context));
+    context.cipher = i;
+    context.log = fopen ("/dev/null", "w");
+    context.verbosity = 0;
+    context.current_key_slot = -1;
+    m_check = OSDP_CRC;
+
+    // fixed keys and MAC chaining values; what they are does not matter
+    for (i=0; i<OSDP_KEY_OCTETS; i++)
+    {
+      context.s_enc [i] = 0x10 + i;
+      context.s_mac1 [i] = 0x20 + i;
+      context.s_mac2 [i] = 0x30 + i;
+      context.last_calculated_in_mac [i] = 0x40 + i;
+      context.last_calculated_out_mac [i] = 0x50 + i;
+    };
+    if (osdp_cipher_select (&context) != ST_OK)
+      fprintf (stdout, "cipher %s failed its known answer tests\n",
+        osdp_cipher_name ());
+    fprintf (stdout, "cipher %s\n", osdp_cipher_name ());
+
+    fprintf (stdout, "%-26s %6s %10s %12s %10s\n",
+      "case", "octets", "iterations", "ns/frame", "MB/s");
+    for (c=0; bench_cases [c].name != NULL; c++)
+    {
+      for (s=0; bench_sizes [s] != 0; s++)
+      {
+        bench_setup (bf, bench_sizes [s]);
+        fflush (stderr);
+        dup2 (null_fd, 2);
+
+        // warm up (and find out how many octets a run covers), then run in
+        // doubling batches until the batch takes long enough
+
+        octets = (*(bench_cases [c].run)) (bf);
+        iterations = 1;
+        elapsed_ns = 0;
+        while ((octets > 0) && (elapsed_ns < min_ns))
+        {
+          iterations = iterations * 2;
+          clock_gettime (CLOCK_MONOTONIC, &start_time);
+          for (i=0; i<iterations; i++)
+            (void)(*(bench_cases [c].run)) (bf);
+          clock_gettime (CLOCK_MONOTONIC, &stop_time);
+          elapsed_ns = (stop_time.tv_sec - start_time.tv_sec) * 1000000000.0 +
+            (stop_time.tv_nsec - start_time.tv_nsec);
+        };
+        fflush (stderr);
+        dup2 (saved_stderr, 2);
+
+        if (octets > 0)
+        {
+          bytes = octets * iterations;
+          fprintf (stdout, "%-26s %6d %10ld %12.1f %10.2f\n",
+            bench_cases [c].name, octets, iterations,
+            elapsed_ns / iterations, (bytes * 1000.0) / elapsed_ns);
+        }
+        else
+          fprintf (stdout, "%-26s %6d %10s\n",
+            bench_cases [c].name, bench_sizes [s], "n/a");
+        fflush (stdout);
+      };
+    };
+  };
+  if (status != ST_OK)
+    fprintf (stderr, "osdp-bench-micro failed (%d)\n", status);
+  return (status);
+
+} /* main for osdp-bench-micro */
+
+
+/*
+  bench_setup - frames and payloads for one size
+
+  frame is an osdp_TEXT command (a POLL at 8 octets) with CRC, as the
+  ACU sends it.  raw_frame is an osdp_RAW reply for the log formatter.
+  payload is what a secure frame of the same size would carry.
+*/
+
+void
+  bench_setup
+    (BENCH_FRAME *bf,
+    int size)
+
+{ /* bench_setup */
+
+  int i;
+
+
+  memset (bf, 0, sizeof (*bf));
+  bf->size = size;
+  for (i=0; i<sizeof (bf->data); i++)
+    bf->data [i] = 0xff & (i * 7 + 3);
+
+  // header 5, command 1, CRC 2
+  bf->data_length = size - 8;
+  context.role = OSDP_ROLE_ACU;
+  m_check = OSDP_CRC;
+  if (bf->data_length EQUALS 0)
+    (void)osdp_build_message (bf->frame, &(bf->frame_length), OSDP_POLL,
+      0, 0, 0, NULL, 0, &(bf->frame_desc));
+  else
+    (void)osdp_build_message (bf->frame, &(bf->frame_length), OSDP_TEXT,
+      0, 0, bf->data_length, bf->data, 0, &(bf->frame_desc));
+
+  if (size <= BENCH_RAW_FORMAT_MAX)
+  {
+    context.role = OSDP_ROLE_PD;
+    bf->raw_frame [0] = 0;
+    (void)osdp_build_message (bf->raw_frame, &(bf->raw_frame_length),
+      OSDP_RAW, 0, 0, bf->data_length, bf->data, 0, NULL);
+    context.role = OSDP_ROLE_ACU;
+  };
+
+  bf->payload_length = size - BENCH_SECURE_OVERHEAD;
+  if (bf->payload_length < 0)
+    bf->payload_length = 0;
+  memcpy (bf->payload, bf->data, bf->payload_length);
+
+} /* bench_setup */
+
+
+int
+  bench_build_message
+    (BENCH_FRAME *bf)
+
+{ /* bench_build_message */
+
+  int command;
+
+
+  bf->frame_length = 0;
+  command = OSDP_TEXT;
+  if (bf->data_length EQUALS 0)
+    command = OSDP_POLL;
+  (void)osdp_build_message (bf->work, &(bf->frame_length), command, 0,
+    1, bf->data_length, bf->data, 0, NULL);
+  return (bf->frame_length);
+
+} /* bench_build_message */
+
+
+/*
+  bench_build_secure_message - SCS_17 (MAC and encrypted payload), or
+  SCS_15 where there is no payload
+*/
+
+int
+  bench_build_secure_message
+    (BENCH_FRAME *bf)
+
+{ /* bench_build_secure_message */
+
+  int command;
+  int length;
+  unsigned char sec_blk [1];
+  int sec_type;
+
+
+  length = 0;
+  command = OSDP_TEXT;
+  sec_type = OSDP_SEC_SCS_17;
+  if (bf->payload_length EQUALS 0)
+  {
+    command = OSDP_POLL;
+    sec_type = OSDP_SEC_SCS_15;
+  };
+  sec_blk [0] = OSDP_KEY_SCBK;
+  (void)osdp_build_secure_message (&context, bf->work, &length, command, 0,
+    1, bf->payload_length, bf->payload, sec_type, 1, sec_blk, NULL);
+  return (length);
+
+} /* bench_build_secure_message */
+
+
+/*
+  bench_cbc_encrypt, bench_cbc_mac - the cipher backend alone, on the
+  payload rounded up to whole blocks
+*/
+
+int
+  bench_cbc_encrypt
+    (BENCH_FRAME *bf)
+
+{ /* bench_cbc_encrypt */
+
+  int length;
+
+
+  length = (bf->payload_length / OSDP_KEY_OCTETS) * OSDP_KEY_OCTETS;
+  if (length > 0)
+    osdp_cipher_cbc_encrypt (osdp_session_key (&context, OSDP_SESSION_S_ENC),
+      context.last_calculated_in_mac, bf->work, length);
+  return (length);
+
+} /* bench_cbc_encrypt */
+
+
+int
+  bench_cbc_mac
+    (BENCH_FRAME *bf)
+
+{ /* bench_cbc_mac */
+
+  int length;
+  unsigned char mac [OSDP_KEY_OCTETS];
+
+
+  length = (bf->payload_length / OSDP_KEY_OCTETS) * OSDP_KEY_OCTETS;
+  if (length > 0)
+  {
+    osdp_cipher_cbc_mac (osdp_session_key (&context, OSDP_SESSION_S_MAC1),
+      context.last_calculated_in_mac, bf->payload, length, mac);
+    bench_sink = mac [0];
+  };
+  return (length);
+
+} /* bench_cbc_mac */
+
+
+int
+  bench_checksum
+    (BENCH_FRAME *bf)
+
+{ /* bench_checksum */
+
+  bench_sink = checksum (bf->data, bf->size);
+  return (bf->size);
+
+} /* bench_checksum */
+
+
+int
+  bench_crc
+    (BENCH_FRAME *bf)
+
+{ /* bench_crc */
+
+  bench_sink = fCrcBlk (bf->data, bf->size);
+  return (bf->size);
+
+} /* bench_crc */
+
+
+/*
+  bench_decrypt_payload - decrypts in place, so it is working on the
+  last run's output after the first; the cost is the same.
+*/
+
+int
+  bench_decrypt_payload
+    (BENCH_FRAME *bf)
+
+{ /* bench_decrypt_payload */
+
+  int length;
+  OSDP_MSG msg;
+
+
+  length = ((bf->payload_length + OSDP_KEY_OCTETS - 1) / OSDP_KEY_OCTETS) *
+    OSDP_KEY_OCTETS;
+  memset (&msg, 0, sizeof (msg));
+  msg.data_payload = bf->work;
+  msg.data_length = length;
+  msg.security_block_type = OSDP_SEC_SCS_17;
+  if (length > 0)
+    (void)osdp_decrypt_payload (&context, &msg);
+  return (length);
+
+} /* bench_decrypt_payload */
+
+
+int
+  bench_encrypt_payload
+    (BENCH_FRAME *bf)
+
+{ /* bench_encrypt_payload */
+
+  int padded_length;
+  int padding;
+
+
+  padded_length = sizeof (bf->work);
+  padding = 0;
+  if (bf->payload_length > 0)
+    (void)osdp_encrypt_payload (&context, bf->payload, bf->payload_length,
+      bf->work, &padded_length, &padding);
+  return (bf->payload_length);
+
+} /* bench_encrypt_payload */
+
+
+/*
+  bench_hash_check - MAC over the whole frame.  it won't match (the
+  check fails after doing all the work.)
+*/
+
+int
+  bench_hash_check
+    (BENCH_FRAME *bf)
+
+{ /* bench_hash_check */
+
+  (void)oo_hash_check (&context, bf->frame, OSDP_SEC_SCS_17,
+    bf->frame + bf->frame_length - 4, bf->frame_length);
+  return (bf->frame_length);
+
+} /* bench_hash_check */
+
+
+/*
+  bench_log_tx_message - what the sender does with the frame it built
+*/
+
+int
+  bench_log_tx_message
+    (BENCH_FRAME *bf)
+
+{ /* bench_log_tx_message */
+
+  OSDP_MSG frame;
+
+
+  frame = bf->frame_desc;
+  (void)osdp_log_tx_message (&context, OSDP_ROLE_PD, &frame);
+  return (bf->frame_length);
+
+} /* bench_log_tx_message */
+
+
+int
+  bench_make_message
+    (BENCH_FRAME *bf)
+
+{ /* bench_make_message */
+
+  char logmsg [4*1024];
+  OSDP_MSG msg;
+  int octets;
+
+
+  octets = 0;
+  if ((bf->raw_frame_length > 0) && (bf->data_length >= 4))
+  {
+    memset (&msg, 0, sizeof (msg));
+    msg.ptr = bf->raw_frame;
+    msg.lth = bf->raw_frame_length;
+    msg.data_payload = bf->raw_frame + 6;
+    msg.data_length = bf->data_length;
+    (void)oosdp_make_message (OOSDP_MSG_RAW, logmsg, &msg);
+    octets = bf->raw_frame_length;
+  };
+  return (octets);
+
+} /* bench_make_message */
+
+
+/*
+  bench_parse_message - the PD parsing the ACU's frame
+*/
+
+int
+  bench_parse_message
+    (BENCH_FRAME *bf)
+
+{ /* bench_parse_message */
+
+  OSDP_HDR hdr;
+  OSDP_MSG msg;
+
+
+  context.role = OSDP_ROLE_PD;
+  memset (&msg, 0, sizeof (msg));
+  msg.ptr = bf->frame;
+  msg.lth = bf->frame_length;
+  (void)osdp_parse_message (&context, OSDP_ROLE_PD, &msg, &hdr);
+  context.role = OSDP_ROLE_ACU;
+  return (bf->frame_length);
+
+} /* bench_parse_message */
+
+
+/*
+  send_osdp_data - nothing here is sent anywhere
+*/
+
+int
+  send_osdp_data
+    (OSDP_CONTEXT *ctx,
+    unsigned char *buf,
+    int lth)
+
+{ /* send_osdp_data */
+
+  return (ST_OK);
+
+} /* send_osdp_data */
+
@@ -359,11 +359,10 @@ typedef struct osdp_timer
 {
   int status;
   int timeout_action;
-  long current_nanoseconds;
+  struct timespec due; // when it expires (CLOCK_MONOTONIC)
 
   time_t i_sec;
   long i_nsec;
-  time_t current_seconds;
 } OSDP_TIMER;
 // possible values for status
 #define OSDP_TIMER_RUNNING   (0)
@@ -381,6 +380,172 @@ typedef struct osdp_timer
 #define OSDP_TIMER_LED_0_TEMP_OFF (4)
 #define OSDP_TIMER_IO             (5)
 
+// event loop: epoll over the serial, control and network descriptors,
+// plus a timerfd per OSDP_TIMER armed for when that timer is due.
+
+#define OSDP_LOOP_MAX_FDS (16)
+
+typedef struct osdp_event_loop
+{
+  int epoll_fd;
+  int timer_fd [OSDP_TIMER_MAX];
+  struct timespec armed [OSDP_TIMER_MAX]; // due time each timerfd is set to
+  int watched [OSDP_LOOP_MAX_FDS];
+  int watched_count;
+  int ready [OSDP_LOOP_MAX_FDS];
+  int ready_count;
+  int writable [OSDP_LOOP_MAX_FDS];
+  int writable_count;
+  int timer_ready; // a timer came due during the last wait
+} OSDP_EVENT_LOOP;
+
+// connections to the control socket.  one that starts with a JSON object
+// on a line of its own sends commands inline, a line each, and gets a line
+// back for each; anything else is a poke to read the command file.
+// see oo-control.c
+
+#define OSDP_CONTROL_MAX       (4)
+#define OSDP_CONTROL_LINE_MAX  (16384) // same as the command file
+#define OSDP_CONTROL_OUT_MAX   (4*OSDP_CONTROL_LINE_MAX) // replies not yet sent
+#define OSDP_CONTROL_UNDECIDED (0)
+#define OSDP_CONTROL_INLINE    (1)
+
+typedef struct osdp_control_conn
+{
+  int active;
+  int fd;
+  int mode;
+  int lines; // commands received
+  int lth;
+  char buf [OSDP_CONTROL_LINE_MAX];
+  int closing; // the other end is done sending, close once out is sent
+  int out_wait; // watched for output, not input, until out is sent
+  int out_lth; // replies waiting for the socket to take them
+  char out [OSDP_CONTROL_OUT_MAX];
+} OSDP_CONTROL_CONN;
+
+// a PD's secure channel: the context's fields of the same names while it
+// is the one being talked to, kept here while it isn't (osdp_sc_save,
+// osdp_sc_load.)  the key schedules are not kept, they are expanded
+// again from the session keys when those change (osdp_session_key.)
+
+typedef struct osdp_sc_state
+{
+  int saved; // 0 until saved, loads as the configured set-up
+  int secure_channel_use [4];
+  int current_key_slot;
+  unsigned char current_scbk [OSDP_KEY_OCTETS];
+  unsigned char rnd_a [8];
+  unsigned char rnd_b [8];
+  unsigned char s_enc [OSDP_KEY_OCTETS];
+  unsigned char s_mac1 [OSDP_KEY_OCTETS];
+  unsigned char s_mac2 [OSDP_KEY_OCTETS];
+  unsigned char rmac_i [OSDP_KEY_OCTETS];
+  unsigned char last_calculated_in_mac [OSDP_KEY_OCTETS];
+  unsigned char last_calculated_out_mac [OSDP_KEY_OCTETS];
+} OSDP_SC_STATE;
+
+// multi-drop: the ACU keeps a session per PD address and polls them in
+// turn, one request outstanding at a time.  The current session's state
+// lives in the context (p_card.addr, next_sequence etc.) while it is
+// being talked to.
+
+#define OSDP_BUS_MAX_PD         (0x7F) // addresses 0x00-0x7E
+#define OSDP_BUS_OFFLINE_MISSES (3) // consecutive timeouts before offline
+#define OSDP_BUS_OFFLINE_SKIP   (8) // offline PD's polled every n rounds
+
+typedef struct osdp_pd_session
+{
+  int configured;
+  int online;
+  int misses; // consecutive timeouts
+  int skip; // rounds to go before an offline PD is polled again
+  int next_sequence;
+  int last_was_processed;
+  char last_command_sent;
+  char last_nak_error;
+  char last_response_received;
+  int polls;
+  int replies;
+  int timeouts;
+  int naks;
+  int strays; // replies that arrived after the PD's turn was over
+  OSDP_SC_STATE sc;
+} OSDP_PD_SESSION;
+
+typedef struct osdp_bus
+{
+  int count; // configured PD's, 0 for the usual single PD
+  int current; // index into order of the PD being talked to
+  int active; // current has been loaded into the context
+  unsigned char order [OSDP_BUS_MAX_PD];
+  OSDP_PD_SESSION session [OSDP_BUS_MAX_PD];
+} OSDP_BUS;
+
+// line turnaround, from the end of a frame going out to the first octet in
+
+typedef struct osdp_turnaround
+{
+  struct timespec drained; // when the last frame will have gone out
+  int pending; // drained is waiting for the next octet in
+  long last; // microseconds
+  long min;
+  long max;
+  long long total;
+  int count;
+} OSDP_TURNAROUND;
+
+// prebuilt frames for the commands and replies with no payload (or the
+// one octet ID and CAP carry), one per command, address and sequence.
+// see oo-framecache.c
+
+#define OSDP_FRAME_CACHE_COMMANDS  (9)
+#define OSDP_FRAME_CACHE_FRAME_MAX (9) // header 5, command 1, data 1, CRC 2
+
+typedef struct osdp_cached_frame
+{
+  unsigned char lth; // 0 until built
+  unsigned char check; // m_check it was built with
+  unsigned char direction; // 0x80 if built as the PD
+  unsigned char data_length;
+  unsigned char data;
+  unsigned char frame [OSDP_FRAME_CACHE_FRAME_MAX];
+} OSDP_CACHED_FRAME;
+
+typedef struct osdp_frame_cache
+{
+  int hits;
+  int misses;
+  OSDP_CACHED_FRAME frame [OSDP_FRAME_CACHE_COMMANDS] [0x80] [4];
+} OSDP_FRAME_CACHE;
+
+// the ACU's last frame out, mark and all, so it can be sent again as-is
+// (same sequence number) if the response timer runs out or the PD NAK's
+// it for a bad CRC.  see oo-retransmit.c
+
+#define OSDP_RETRANSMIT_FRAME_MAX       (1+1024)
+#define OSDP_RETRANSMIT_DEFAULT_RETRIES (2)
+#define OSDP_RETRANSMIT_DEFAULT_BACKOFF (0) // milliseconds added per try
+
+#define OSDP_STATUS_RATE_DEFAULT (4) // status file writes a second
+
+typedef struct osdp_retransmit
+{
+  int lth; // 0 if there is nothing to resend
+  int tries; // resends so far
+  unsigned char frame [OSDP_RETRANSMIT_FRAME_MAX];
+} OSDP_RETRANSMIT;
+
+// serial buses.  open-osdp can drive several from one loop (see oo-port.c)
+
+#define OSDP_PORT_MAX (8)
+
+typedef struct osdp_port_config
+{
+  char device [1024];
+  char pd_addresses [1024];
+} OSDP_PORT_CONFIG;
+
 
 typedef struct osdp_context_filetransfer
 {
@@ -402,23 +567,185 @@ typedef struct osdp_command
   int command;
   int details_length; 
   int details_param_1;
+  int pd_address; // multi-drop, -1 for whichever PD's turn it is
+  int port; // -1 for the serial port being serviced
   unsigned char details [8*1024]; // must be big enough to hold OSDP_MFG_ARGS
 } OSDP_COMMAND;
 
-#define OSDP_COMMAND_QUEUE_SIZE (32)
+// queued commands.  each lane is a ring of variable length records (just
+// the details octets actually used) in its own arena; the setup lane is
+// drained before the normal one, and that before bulk.  see oo-cmdqueue.c
+
+#define OSDP_COMMAND_QUEUE_SIZE  (32) // default depth per lane
+#define OSDP_COMMAND_QUEUE_OCTETS (512) // arena per queued command, on average
+#define OSDP_COMMAND_LANES       (3)
+#define OSDP_COMMAND_LANE_SETUP  (0) // secure channel, keys, reset
+#define OSDP_COMMAND_LANE_NORMAL (1)
+#define OSDP_COMMAND_LANE_BULK   (2) // LED, text, buzzer, output, transfer
+
+typedef struct osdp_queued_command
+{
+  int lth; // whole record, rounded up
+  int command;
+  int details_length;
+  int details_param_1;
+  int pd_address;
+  int port;
+  int stored; // details octets kept, the rest were zero
+  struct timespec queued;
+} OSDP_QUEUED_COMMAND;
+
+typedef struct osdp_command_lane
+{
+  unsigned char *arena;
+  int size;
+  int head; // next record out
+  int tail; // where the next record goes
+  int wrap; // -1, or where the records stop before going back to 0
+  int count;
+  int max_count; // high water
+  int enqueued;
+  int overflow;
+  long long wait_total; // microseconds from enqueue to dequeue
+  long wait_max;
+} OSDP_COMMAND_LANE;
 
 typedef struct osdp_command_queue
 {
-  int status; // 0=empty 1=contains entry
-  OSDP_COMMAND cmd;
+  int depth; // "command-queue-depth", records per lane
+  OSDP_COMMAND_LANE lane [OSDP_COMMAND_LANES];
 } OSDP_COMMAND_QUEUE;
 
+// action hooks.  what is done with a card read (and the other events that
+// had an ACU-actions script) is a function registered by the program or a
+// plugin, called as it happens.  the scripts can still run, by default
+// from a worker process so they do not hold anything up.  see oo-hooks.c
+
+#define OSDP_ACTION_RAW      (0) // card data
+#define OSDP_ACTION_XRD_CARD (1) // extended read, card present
+#define OSDP_ACTION_XRD_APDU (2) // extended read, APDU from the card
+#define OSDP_ACTION_NAK      (3)
+#define OSDP_ACTION_MFGERRR  (4)
+#define OSDP_ACTION_ID       (5)
+#define OSDP_ACTION_PDID     (6)
+#define OSDP_ACTIONS         (7)
+
+#define OSDP_ACTION_SCRIPTS_OFF   (0)
+#define OSDP_ACTION_SCRIPTS_ASYNC (1) // default
+#define OSDP_ACTION_SCRIPTS_SYNC  (2) // system(), as it used to be
+
+#define OSDP_ACTION_PLUGIN_INIT "osdp_action_plugin_init"
+
+#define OSDP_ACTION_SCRIPT_MAX (4*1024) // longest command line, with the NUL
+#define OSDP_ACTION_STOP_MSEC  (500) // for the worker to finish before a kill
+
+typedef struct osdp_action_event
+{
+  int action;
+  int bits; // card data
+  int format; // card data, 0 raw 1 P/Data/P
+  int reader; // extended read
+  int status; // extended read
+  unsigned char *data; // card data, APDU, NAK code and data
+  int data_length;
+  char *args; // what the script is given
+} OSDP_ACTION_EVENT;
+
 // poll enable values (see context->enable_poll)
 
 #define OO_POLL_ENABLED (1) // normal polling
 #define OO_POLL_NEVER   (0) // never poll, sequence stays at 0
 #define OO_POLL_RESUME  (2) // go to normal polling after this message is sent
 
+/*
+  expanded AES key schedule for a secure channel session key, made once
+  per session by osdp_create_keys (see osdp_session_key.)  aes is laid
+  out by the cipher backend that expanded it (see oo-cipher.c.)
+*/
+#define OSDP_SESSION_S_ENC  (0)
+#define OSDP_SESSION_S_MAC1 (1)
+#define OSDP_SESSION_S_MAC2 (2)
+#define OSDP_SESSION_KEYS   (3)
+#define OSDP_AES_CTX_MAX    (2*11*16) // encrypt and decrypt round keys
+
+typedef struct osdp_key_schedule
+{
+  int valid;
+  int cipher; // the backend that expanded it
+  unsigned char key [OSDP_KEY_OCTETS]; // the key it was expanded from
+  unsigned char aes [OSDP_AES_CTX_MAX] __attribute__ ((aligned (16)));
+} OSDP_KEY_SCHEDULE;
+
+/*
+  AES-128 backends.  "cipher" is "auto" (the default: AES-NI if the
+  processor has it), "aes-ni" or "software" (tiny-AES).  a backend is
+  only used if it gives the known answers; otherwise it is software.
+*/
+#define OSDP_CIPHER_AUTO     (-1)
+#define OSDP_CIPHER_SOFTWARE  (0)
+#define OSDP_CIPHER_AESNI     (1)
+#define OSDP_CIPHER_BACKENDS  (2)
+
+typedef struct osdp_cipher
+{
+  char *name;
+  int (*available) (void);
+  void (*expand) (OSDP_KEY_SCHEDULE *schedule, unsigned char *key);
+  void (*cbc_encrypt) (OSDP_KEY_SCHEDULE *schedule, unsigned char *iv,
+    unsigned char *buffer, int length);
+  void (*cbc_decrypt) (OSDP_KEY_SCHEDULE *schedule, unsigned char *iv,
+    unsigned char *buffer, int length);
+  void (*cbc_mac) (OSDP_KEY_SCHEDULE *schedule, unsigned char *iv,
+    unsigned char *buffer, int length, unsigned char *mac);
+} OSDP_CIPHER;
+
+/*
+  live statistics, in a POSIX shared memory segment ("stats-shm", default
+  /open-osdp-ACU, -PD or -MON).  sequence is odd while the program is
+  copying its counters in; a reader copies the whole thing and tries
+  again if sequence was odd or changed.  see oo-stats.c and osdp-stats.
+*/
+#define OSDP_STATS_MAGIC   (0x4f535441) // "OSTA"
+#define OSDP_STATS_VERSION (2)
+#define OSDP_STATS_LEDS    (8)
+
+typedef struct osdp_stats
+{
+  unsigned int magic;
+  int version;
+  int size;
+  unsigned int sequence;
+  int pid;
+  int role;
+  long long updated; // time of the last copy
+  int pd_address;
+  char serial_speed [16];
+  char text [128];
+  int key_slot;
+  unsigned char scbk [OSDP_KEY_OCTETS];
+  int acu_polls;
+  int pd_acks;
+  int pd_naks;
+  int pdus_received;
+  int pdus_sent;
+  int bytes_received;
+  int dropped_octets;
+  int crc_errs;
+  int checksum_errs;
+  int seq_bad;
+  int hash_ok;
+  int hash_bad;
+  int buffer_overflows;
+  int retries;
+  int serial_write_errs;
+  int led_active [OSDP_STATS_LEDS];
+  unsigned int led_color [OSDP_STATS_LEDS]; // web color
+  int out [OSDP_MAX_OUT];
+  unsigned int xfer_offset; // file transfer progress
+  unsigned int xfer_total;
+  int xfer_send_length;
+} OSDP_STATS;
+
 typedef struct osdp_context
 {
   int process_lock; // file handle to exclusivity lock
@@ -430,13 +757,32 @@ typedef struct osdp_context
   int pdcap_select; // 0 for normal 1 for short
   char fqdn [1024];
   char log_path [1024];
+  char results_path [1024]; // "results-file", see osdp-results
   char serial_speed [1024];
+  int rs485; // 1 to have the kernel drive RS-485 direction (TIOCSRS485)
+  OSDP_PORT_CONFIG port_config [OSDP_PORT_MAX]; // "serial-ports"
+  int port_config_count;
   int trace; // 0=disabled 1=enabled
   int verbosity;
   unsigned char my_guid [128/8];
 
-  OSDP_COMMAND_QUEUE *q;
+  OSDP_COMMAND_QUEUE q;
   int cmd_q_overflow;
+  OSDP_CONTROL_CONN control [OSDP_CONTROL_MAX];
+  int (*action_hook [OSDP_ACTIONS]) (struct osdp_context *ctx, OSDP_ACTION_EVENT *event);
+  char action_plugin [1024]; // "action-plugin", a shared object
+  int action_scripts; // "action-scripts", OSDP_ACTION_SCRIPTS_...
+  int action_worker; // script worker pid, 0 if none
+  int action_socket; // to the worker
+  int actions_hooked;
+  int actions_queued;
+  int actions_dropped; // worker queue was full
+  int status_rate; // "status-rate", most status file writes a second, 0 for no limit
+  int status_dirty; // status changed since the file was written
+  struct timespec status_written;
+  char stats_name [1024]; // "stats-shm"
+  int cipher; // "cipher", OSDP_CIPHER_...
+  OSDP_STATS *stats; // NULL if there is no segment
 
   // IO context
   int current_pid;
@@ -452,6 +798,11 @@ typedef struct osdp_context
   // CP and PD context
   OSDP_LED_STATE led [OSDP_MAX_LED];
   int pd_address; // the pd to whom we are speaking
+  OSDP_BUS *bus; // multi-drop sessions of the port being serviced (ACU)
+  OSDP_BUS own_bus; // the context's own serial port's, see osdp_bus
+  struct osdp_port *port; // serial buses, if the program has them
+  int port_count;
+  int port_current; // the one loaded into the context
   int role;
   char text [1024];
   unsigned char this_message_addr;
@@ -480,8 +831,10 @@ typedef struct osdp_context
   unsigned char s_enc [16];
   unsigned char s_mac1 [16];
   unsigned char s_mac2 [16];
+  OSDP_KEY_SCHEDULE session_key [OSDP_SESSION_KEYS]; // s_enc, s_mac1, s_mac2
   int secure_channel_use [4]; // see OO_SCU_... use
   unsigned char rmac_i [OSDP_KEY_OCTETS];
+  OSDP_SC_STATE sc_configured; // as set up at start, for a PD not seen yet
 
   char new_address;
   char test_in_progress [32];
@@ -500,11 +853,21 @@ typedef struct osdp_context
   char credentials_data [1024];
   int bytes_received;
   int bytes_sent;
+  OSDP_TURNAROUND turnaround;
+  OSDP_FRAME_CACHE frame_cache;
+  OSDP_RETRANSMIT retransmit;
+  int retry_max; // "retries"
+  int retry_backoff; // "retry-backoff", milliseconds
+  int retries;
+  int retries_recovered;
+  int retries_abandoned;
   int packets_received;
   int acu_polls;
   int pd_acks;
   int sent_naks;
   int dropped_octets;
+  int resync_events;
+  int resync_skipped;
   int crc_errs;
   int checksum_errs;
   int hash_ok;
@@ -512,6 +875,7 @@ typedef struct osdp_context
   int seq_bad;
   int pdus_received;
   int pdus_sent;
+  int serial_write_errs; // frames that did not all get written
   char init_command [1024];
   int cparm;
   int cparm_v;
@@ -551,6 +915,39 @@ typedef struct osdp_context
   OSDP_CONTEXT_FILETRANSFER xferctx;
 } OSDP_CONTEXT;
 
+// command registry.  each breech command is a name, the OSDP_CMDB_ id it
+// becomes, how its parameters are found in the JSON and (if there is more
+// to it) a function to finish the job.  see oo-cmdregistry.c
+
+#define OSDP_COMMAND_HASH_SLOTS  (256) // power of 2, well over the commands
+#define OSDP_COMMAND_PARAMS_MAX  (12)
+#define OSDP_CMDREG_QUEUE        (0x01) // goes through the command queue
+
+#define OSDP_PARAM_INT8   (1) // decimal, one octet
+#define OSDP_PARAM_INT16  (2) // decimal, lsb then msb
+#define OSDP_PARAM_INT32  (3) // decimal, an int
+#define OSDP_PARAM_HEX8   (4) // hex, one octet
+#define OSDP_PARAM_HEX    (5) // hex octets, at most max of them
+#define OSDP_PARAM_STRING (6) // text, at most max characters
+
+typedef struct osdp_command_param
+{
+  char *name;
+  int type;
+  int offset; // in the command details
+  int max;
+  int initial; // int values start at this if the parameter is absent
+} OSDP_COMMAND_PARAM;
+
+typedef struct osdp_command_registry
+{
+  char *name;
+  int command;
+  int flags;
+  int (*parse) (OSDP_CONTEXT *ctx, json_t *root, OSDP_COMMAND *cmd);
+  OSDP_COMMAND_PARAM param [OSDP_COMMAND_PARAMS_MAX];
+} OSDP_COMMAND_REGISTRY;
+
 // four different details maintained about a secure channel connection,
 // stored in 4 elemenets of the secure channel status array in context.
 
@@ -658,15 +1055,73 @@ typedef struct osdp_parameters
 #define OOSDP_MSG_XWRITE       (22)
 
 
+// input buffer is a ring; OSDP_BUF_MAX must be a power of two.
+// the extra OSDP_BUF_VIEW_MAX octets past the end let a frame that
+// wraps be presented to the parser as one contiguous run.
+
 #define OSDP_BUF_MAX (8192)
+#define OSDP_BUF_MASK (OSDP_BUF_MAX-1)
+#define OSDP_BUF_VIEW_MAX (OSDP_OFFICIAL_MSG_MAX)
+
+// incremental framer, advanced over new octets as they are buffered
+
+typedef struct osdp_framer
+{
+  int state;
+  int scan; // next octet in the buffer to be examined
+  unsigned int frame_lth; // whole frame length from LEN_LSB/LEN_MSB
+  int check_size; // 1 for checksum, 2 for CRC
+  unsigned short int crc; // running CRC over the octets scanned
+  unsigned char cksum; // running sum over the octets scanned
+  int status; // check result once the frame is complete
+} OSDP_FRAMER;
+#define OSDP_FRAMER_SOM     (0)
+#define OSDP_FRAMER_ADDR    (1)
+#define OSDP_FRAMER_LEN_LSB (2)
+#define OSDP_FRAMER_LEN_MSB (3)
+#define OSDP_FRAMER_CTRL    (4)
+#define OSDP_FRAMER_BODY    (5)
+#define OSDP_FRAMER_CHECK   (6)
+#define OSDP_FRAMER_DONE    (7)
+
+#define OSDP_CRC_SEED (0x1d0f)
+
+// candidate SOM's tried per call before the input is dropped
+#define OSDP_RESYNC_MAX (16)
 
 typedef struct osdp_buffer
 {
-  unsigned char buf [OSDP_BUF_MAX];
-  int next;
+  unsigned char buf [OSDP_BUF_MAX + OSDP_BUF_VIEW_MAX];
+  unsigned int head; // oldest octet not yet consumed (free-running)
+  unsigned int tail; // where the next octet goes (free-running)
   int overflow;
+  int resync; // slid past a bad frame, still looking for a good one
+  OSDP_FRAMER framer;
 } OSDP_BUFFER;
 
+// a serial bus.  while it is being serviced its state is loaded into the
+// context (fd, response timer, current PD) and the context's bus points
+// at its sessions.  port 0's sessions are the context's own_bus.
+
+typedef struct osdp_port
+{
+  char device [1024];
+  int fd;
+  OSDP_BUFFER *input;
+  OSDP_BUS *bus;
+  OSDP_BUS own_bus;
+  OSDP_TIMER response;
+  OSDP_TURNAROUND turnaround;
+  OSDP_RETRANSMIT retransmit;
+  int addr;
+  int next_sequence;
+  int last_was_processed;
+  char last_command_sent;
+  char last_nak_error;
+  char last_response_received;
+  OSDP_SC_STATE sc;
+} OSDP_PORT;
+
 typedef struct osdp_param
 {
   char device [1024];
@@ -702,18 +1157,18 @@ typedef struct osdp_rdr_led_ctl
   unsigned char perm_on_color;
   unsigned char perm_off_color;
 } OSDP_RDR_LED_CTL;
-
-#define OSDP_LED_TEMP_NOP    (0)
-#define OSDP_LED_TEMP_CANCEL (1)
-#define OSDP_LED_TEMP_SET    (2)
-
-#define OSDP_LED_NOP (0)
-#define OSDP_LED_SET (1)
-#define OSDP_LEDCOLOR_BLACK (0)
-#define OSDP_LEDCOLOR_RED (1)
-#define OSDP_LEDCOLOR_GREEN (2)
-#define OSDP_LEDCOLOR_AMBER (3)
-#define OSDP_LEDCOLOR_BLUE (4)
+
+#define OSDP_LED_TEMP_NOP    (0)
+#define OSDP_LED_TEMP_CANCEL (1)
+#define OSDP_LED_TEMP_SET    (2)
+
+#define OSDP_LED_NOP (0)
+#define OSDP_LED_SET (1)
+#define OSDP_LEDCOLOR_BLACK (0)
+#define OSDP_LEDCOLOR_RED (1)
+#define OSDP_LEDCOLOR_GREEN (2)
+#define OSDP_LEDCOLOR_AMBER (3)
+#define OSDP_LEDCOLOR_BLUE (4)
 
 typedef struct osdp_mfg_args
 {
@@ -817,6 +1272,7 @@ typedef struct osdp_msg
   int security_block_type;
   int security_block_length;
   int payload_decrypted;
+  int check_verified; // CRC/checksum already validated by the framer
 } OSDP_MSG;
 
 typedef struct __attribute__((packed)) osdp_multi_hdr_iec
@@ -926,6 +1382,22 @@ typedef struct __attribute__((packed)) osdp_multi_hdr_iec
 #define ST_OSDP_UNSUPPORTED_AUTH_PAYLOAD ( 87)
 #define ST_OSDP_PAYLOAD_TOO_SHORT        ( 88)
 #define ST_MSG_TOO_LONG                  ( 89)
+#define ST_MSG_BAD_LENGTH                ( 90)
+#define ST_EVENT_LOOP_ERROR              ( 91)
+#define ST_BUS_BAD_ADDRESS               ( 92)
+#define ST_PORT_TOO_MANY                 ( 93)
+#define ST_OSDP_COMMAND_QUEUE_ALLOC      ( 94)
+#define ST_OSDP_ACTION_PLUGIN            ( 95)
+#define ST_OSDP_ACTION_INDEX             ( 96)
+#define ST_OSDP_ACTION_WORKER            ( 97)
+#define ST_OSDP_RESULTS_MAP              ( 98)
+#define ST_OSDP_STATS_SHM                ( 99)
+#define ST_OSDP_CIPHER_KAT               (100)
+#define ST_SERIAL_OUT                    (101)
+#define ST_OSDP_ACTION_TOO_LONG          (102)
+#define ST_CONTROL_OUT                   (103)
+#define ST_BUS_WAIT                      (104)
+#define ST_PORT_BAD_INDEX                (105)
 
 int
   m_version_minor;
@@ -981,22 +1453,43 @@ int oo_load_parameters(OSDP_CONTEXT *ctx, char *filename);
 char * oo_lookup_nak_text(int nak_code);
 unsigned char oo_response_address(OSDP_CONTEXT *ctx, unsigned char from_addr);
 int oo_save_parameters(OSDP_CONTEXT *ctx, char *filename, unsigned char *scbk);
+int oo_status_publish (OSDP_CONTEXT *ctx);
+int oo_status_wait_ms (OSDP_CONTEXT *ctx);
+int oo_status_write (OSDP_CONTEXT *ctx);
 int oo_write_status (OSDP_CONTEXT *ctx);
+int osdp_action (OSDP_CONTEXT *ctx, OSDP_ACTION_EVENT *event, char *script);
+int osdp_action_plugin_load (OSDP_CONTEXT *ctx);
+int osdp_action_register (OSDP_CONTEXT *ctx, int action, int (*hook) (OSDP_CONTEXT *ctx, OSDP_ACTION_EVENT *event));
+void osdp_action_script (OSDP_CONTEXT *ctx, char *script);
 void osdp_array_to_doubleByte (unsigned char a [2], unsigned short int *i);
 void osdp_array_to_quadByte (unsigned char a [4], unsigned int *i);
 int osdp_awaiting_response(OSDP_CONTEXT *ctx);
 int osdp_build_message (unsigned char *buf, int *updated_length,
   unsigned char command, int dest_addr, int sequence, int data_length,
-  unsigned char *data, int security);
+  unsigned char *data, int security, OSDP_MSG *frame);
+int osdp_build_message_cached (OSDP_CONTEXT *ctx, unsigned char *buf,
+  int *updated_length, unsigned char command, int dest_addr, int sequence,
+  int data_length, unsigned char *data, OSDP_MSG *frame);
 int osdp_build_secure_message (OSDP_CONTEXT *ctx, unsigned char *buf, int *updated_length,
   unsigned char command, int dest_addr, int sequence, int data_length,
   unsigned char *data, int sec_blk_type, int sec_blk_lth,
-  unsigned char *sec_blk);
+  unsigned char *sec_blk, OSDP_MSG *frame);
 int osdp_check_command_reply(int role, int command, OSDP_MSG *m, char *tlogmsg2);
+int osdp_command_dequeue (OSDP_CONTEXT *ctx, OSDP_COMMAND *cmd);
+int osdp_command_enqueue (OSDP_CONTEXT *ctx, OSDP_COMMAND *cmd, int lane_index);
+int osdp_command_lane (int command);
+OSDP_COMMAND_REGISTRY *osdp_command_lookup (char *name);
 int osdp_command_match (OSDP_CONTEXT *ctx, json_t *root, char *command, int *command_id);
+int osdp_command_params (OSDP_CONTEXT *ctx, OSDP_COMMAND_REGISTRY *entry, json_t *root, OSDP_COMMAND *cmd);
+int osdp_command_parse (OSDP_CONTEXT *ctx, char *json_string, OSDP_COMMAND *cmd);
+int osdp_command_queue_count (OSDP_CONTEXT *ctx);
+int osdp_control_accept (OSDP_CONTEXT *ctx, OSDP_EVENT_LOOP *loop, int ufd);
+int osdp_control_service (OSDP_CONTEXT *ctx, OSDP_EVENT_LOOP *loop, int *processed);
 char *osdp_command_reply_to_string (unsigned char cmdrep, int role);
 void osdp_create_client_cryptogram (OSDP_CONTEXT *context, OSDP_SC_CCRYPT *ccrypt_response);
 void osdp_create_keys (OSDP_CONTEXT *ctx);
+void osdp_describe_frame (OSDP_MSG *frame, unsigned char *buf, int lth,
+  unsigned char *cmd_ptr, int data_length, int sec_block_type, int sec_block_length);
 void osdp_doubleByte_to_array(unsigned short int i, unsigned char a [2]);
 int osdp_encrypt_payload(OSDP_CONTEXT *ctx, unsigned char *data, int data_length, unsigned char *enc_buf,
   int *padded_length, int *padding);
@@ -1004,14 +1497,53 @@ void osdp_quadByte_to_array(unsigned int i, unsigned char a [2]);
 
 int osdp_get_key_slot (OSDP_CONTEXT *ctx, OSDP_MSG *msg, int *key_slot);
 int osdp_filetransfer_validate (OSDP_CONTEXT *ctx, OSDP_HDR_FILETRANSFER *msg, unsigned short int *fragsize, unsigned int *offset);
+int osdp_buffer_append (OSDP_BUFFER *ob, unsigned char *octets, int lth);
+void osdp_buffer_consume (OSDP_BUFFER *ob, int lth);
+int osdp_buffer_count (OSDP_BUFFER *ob);
+unsigned char osdp_buffer_octet (OSDP_BUFFER *ob, int offset);
+void osdp_buffer_produce (OSDP_BUFFER *ob, int lth);
+void osdp_buffer_reset (OSDP_BUFFER *ob);
+int osdp_buffer_resync (OSDP_BUFFER *ob);
+int osdp_buffer_skip_to_som (OSDP_BUFFER *ob);
+unsigned char *osdp_buffer_tailroom (OSDP_BUFFER *ob, int *space);
+unsigned char *osdp_buffer_view (OSDP_BUFFER *ob, int *lth);
+int osdp_bus_add (OSDP_BUS *bus, int addr);
+int osdp_bus_add_list (OSDP_BUS *bus, char *addresses);
+OSDP_BUS *osdp_bus (OSDP_CONTEXT *ctx);
+int osdp_bus_next (OSDP_CONTEXT *ctx);
+int osdp_bus_route (OSDP_CONTEXT *ctx, int addr);
+int osdp_bus_select (OSDP_CONTEXT *ctx, int addr);
+int osdp_framer_scan (OSDP_BUFFER *osdpbuf);
 int osdp_ftstat_validate (OSDP_CONTEXT *ctx, OSDP_HDR_FTSTAT *msg);
 char *osdp_led_color_lookup(unsigned char led_color_number);
+int osdp_log_tx_message (OSDP_CONTEXT *ctx, int role, OSDP_MSG *frame);
 int osdp_log_summary(OSDP_CONTEXT *ctx);
+int osdp_loop_init (OSDP_EVENT_LOOP *loop);
+int osdp_loop_interest (OSDP_EVENT_LOOP *loop, int fd, int input, int output);
+int osdp_loop_ready (OSDP_EVENT_LOOP *loop, int fd);
+int osdp_loop_unwatch (OSDP_EVENT_LOOP *loop, int fd);
+int osdp_loop_wait (OSDP_EVENT_LOOP *loop, OSDP_CONTEXT *ctx, int timeout_ms);
+int osdp_loop_watch (OSDP_EVENT_LOOP *loop, int fd);
+int osdp_loop_writable (OSDP_EVENT_LOOP *loop, int fd);
 int osdp_parse_message (OSDP_CONTEXT *context, int role, OSDP_MSG *m, OSDP_HDR *h);
+int osdp_port_due (OSDP_CONTEXT *ctx, int index, struct timespec *now);
+int osdp_port_open (OSDP_CONTEXT *ctx, OSDP_PORT *port);
+void osdp_port_select (OSDP_CONTEXT *ctx, int index);
+int osdp_port_target (OSDP_CONTEXT *ctx, int index, int addr);
+int osdp_port_wait_ms (OSDP_CONTEXT *ctx);
 char *osdp_pdcap_function(int func);
 void osdp_reset_background_timer (OSDP_CONTEXT *ctx);
 void osdp_reset_secure_channel (OSDP_CONTEXT *ctx);
+int osdp_retransmit (OSDP_CONTEXT *ctx);
+int osdp_retransmit_reply (OSDP_CONTEXT *ctx, int reply);
+void osdp_retransmit_save (OSDP_CONTEXT *ctx, unsigned char *wire, int lth);
+void osdp_sc_load (OSDP_CONTEXT *ctx, OSDP_SC_STATE *sc);
+void osdp_sc_save (OSDP_CONTEXT *ctx, OSDP_SC_STATE *sc);
 char *osdp_sec_block_dump (unsigned char *sec_block);
+int osdp_secure_open (OSDP_CONTEXT *ctx, OSDP_MSG *msg,
+  int security_block_type, int hashable_length);
+int osdp_secure_seal (OSDP_CONTEXT *ctx, unsigned char *frame,
+  int payload_offset, int *payload_length, int *frame_length);
 int osdp_send_filetransfer (OSDP_CONTEXT *ctx);
 int osdp_send_ftstat (OSDP_CONTEXT *ctx, OSDP_HDR_FTSTAT *response);
 int osdp_setup_scbk (OSDP_CONTEXT *ctx, OSDP_MSG *msg);
@@ -1042,8 +1574,22 @@ int oosdp_print_message_SCRYPT(OSDP_CONTEXT *ctx, OSDP_MSG *osdp_msg, char *tlog
 int oosdp_print_message_TEXT(OSDP_CONTEXT *ctx, OSDP_MSG *osdp_msg, char *tlogmsg);
 int oosdp_print_message_XRD(OSDP_CONTEXT *ctx,
   OSDP_MSG *osdp_msg, char *tlogmsg);
-int osdp_test_set_status(char *test, int test_status);
-int osdp_test_set_status_ex(char *test, int test_status, char *aux);
+int osdp_cipher_available (int cipher);
+void osdp_cipher_cbc_decrypt (OSDP_KEY_SCHEDULE *schedule, unsigned char *iv, unsigned char *buffer, int length);
+void osdp_cipher_cbc_encrypt (OSDP_KEY_SCHEDULE *schedule, unsigned char *iv, unsigned char *buffer, int length);
+void osdp_cipher_cbc_mac (OSDP_KEY_SCHEDULE *schedule, unsigned char *iv, unsigned char *buffer, int length, unsigned char *mac);
+void osdp_cipher_expand (OSDP_KEY_SCHEDULE *schedule, unsigned char *key);
+int osdp_cipher_kat (int cipher);
+char *osdp_cipher_name (void);
+int osdp_cipher_select (OSDP_CONTEXT *ctx);
+OSDP_KEY_SCHEDULE *osdp_session_key (OSDP_CONTEXT *ctx, int key);
+int osdp_stats_open (OSDP_CONTEXT *ctx);
+void osdp_stats_publish (OSDP_CONTEXT *ctx);
+OSDP_STATS *osdp_stats_map (char *name);
+void osdp_stats_print (FILE *f, OSDP_STATS *s);
+int osdp_stats_read (OSDP_STATS *s, OSDP_STATS *copy);
+int osdp_test_set_status(int test, int test_status);
+int osdp_test_set_status_ex(int test, int test_status, char *aux);
 void preserve_current_command (void);
 int process_command (int command, OSDP_CONTEXT *context, unsigned int details_length, int details_param_1, char *details);
 int process_command_from_queue(OSDP_CONTEXT *ctx);
@@ -1069,6 +1615,7 @@ int send_secure_message (OSDP_CONTEXT *context, int command, int dest_addr,
   int sec_blk_lth, unsigned char *sec_blk);
 void signal_callback_handler (int signum);
 unsigned short int fCrcBlk (unsigned char *pData, unsigned short int nLength);
+unsigned short int fCrcByte (unsigned short int nCrc, unsigned char nData);
 
 #include <oo-api.h>
 
@@ -96,6 +96,72 @@ typedef struct osdp_conform
 #define OOC_SYMBOL_resp_mfgerrr       "070-24-01"
 #define OOC_SYMBOL_resp_ftstat        "070-25-01"
 
+// integer IDs for the tests above, for osdp_test_set_status.  0 is no test.
+
+#define OOC_ID_physical_interface     (1)
+#define OOC_ID_signalling             (2)
+#define OOC_ID_multibyte_data_encoding (3)
+#define OOC_ID_packet_format          (4)
+#define OOC_ID_seq_zero               (5)
+#define OOC_ID_SOM                    (6)
+#define OOC_ID_LEN                    (7)
+#define OOC_ID_CTRL                   (8)
+#define OOC_ID_CMND_REPLY             (9)
+#define OOC_ID_SOM_sent               (10)
+#define OOC_ID_cmd_poll               (11)
+#define OOC_ID_poll_lstatr            (12)
+#define OOC_ID_cmd_id                 (13)
+#define OOC_ID_cmd_cap                (14)
+#define OOC_ID_cmd_lstat              (15)
+#define OOC_ID_cmd_istat              (16)
+#define OOC_ID_cmd_ostat              (17)
+#define OOC_ID_cmd_rstat              (18)
+#define OOC_ID_cmd_out                (19)
+#define OOC_ID_cmd_led_red            (20)
+#define OOC_ID_cmd_led_green          (21)
+#define OOC_ID_cmd_led_amber          (22)
+#define OOC_ID_cmd_buz                (23)
+#define OOC_ID_cmd_text               (24)
+#define OOC_ID_cmd_comset             (25)
+#define OOC_ID_cmd_bioread            (26)
+#define OOC_ID_cmd_biomatch           (27)
+#define OOC_ID_cmd_keyset             (28)
+#define OOC_ID_cmd_chlng              (29)
+#define OOC_ID_cmd_scrypt             (30)
+#define OOC_ID_cmd_mfg                (31)
+#define OOC_ID_cmd_acurxsize          (32)
+#define OOC_ID_cmd_keepactive         (33)
+#define OOC_ID_cmd_pivdata            (34)
+#define OOC_ID_cmd_genauth            (35)
+#define OOC_ID_060_24_02              (36)
+#define OOC_ID_cmd_crauth             (37)
+#define OOC_ID_060_25_02              (38)
+#define OOC_ID_cmd_filetransfer       (39)
+#define OOC_ID_cmd_xwr                (40)
+#define OOC_ID_rep_ack                (41)
+#define OOC_ID_resp_ostat_ack         (42)
+#define OOC_ID_rep_nak                (43)
+#define OOC_ID_rep_device_ident       (44)
+#define OOC_ID_rep_pdid_check         (45)
+#define OOC_ID_rep_device_capas       (46)
+#define OOC_ID_resp_lstatr            (47)
+#define OOC_ID_resp_lstatr_tamper     (48)
+#define OOC_ID_resp_lstatr_power      (49)
+#define OOC_ID_resp_istatr            (50)
+#define OOC_ID_resp_ostatr            (51)
+#define OOC_ID_resp_rstatr            (52)
+#define OOC_ID_rep_raw                (53)
+#define OOC_ID_resp_com               (54)
+#define OOC_ID_resp_ccrypt            (55)
+#define OOC_ID_resp_rmac_i            (56)
+#define OOC_ID_resp_busy              (57)
+#define OOC_ID_resp_pivdatar          (58)
+#define OOC_ID_resp_genauthr          (59)
+#define OOC_ID_resp_crauthr           (60)
+#define OOC_ID_resp_mfgerrr           (61)
+#define OOC_ID_resp_ftstat            (62)
+#define OOC_ID_MAX                    (63)
+
 typedef struct osdp_interop_assessment
 {
   int pass;
@@ -218,6 +284,40 @@ typedef struct osdp_interop_assessment
 
 #define PARAM_MMT (8) // minimum message thresshold
 
+/*
+  the results file.  one record per test, updated in place (it is mapped
+  by the running program), rendered by osdp-results.  records below
+  OSDP_RESULTS_ADHOC belong to the test_control entries in order, the
+  rest are found by name.
+*/
+#define OSDP_RESULTS_FILE     "/opt/osdp-conformance/results/osdp-results.dat"
+#define OSDP_RESULTS_MAGIC    (0x4f524553) // "ORES"
+#define OSDP_RESULTS_VERSION  (1)
+#define OSDP_RESULTS_MAX      (192)
+#define OSDP_RESULTS_ADHOC    (160)
+#define OSDP_RESULTS_AUX_MAX  (4096)
+
+typedef struct osdp_results_record
+{
+  unsigned int sequence; // odd while the record is being changed
+  int status; // OCONFORM_
+  long long changed; // time of the last change, 0 if never set
+  char test [16];
+  char description [64];
+  char aux [OSDP_RESULTS_AUX_MAX]; // name/value pairs, each with a trailing comma
+} OSDP_RESULTS_RECORD;
+
+typedef struct osdp_results
+{
+  unsigned int magic;
+  int version;
+  int record_size;
+  int role;
+  int pid;
+  long long started;
+  OSDP_RESULTS_RECORD record [OSDP_RESULTS_MAX];
+} OSDP_RESULTS;
+
 #define SET_PASS(ctx,testnum) \
   { \
     (void) osdp_conform_confirm (testnum); \
@@ -260,4 +360,14 @@ int
   osdp_conform_fail
     (char
       *test);
+int
+  osdp_results_open
+    (OSDP_CONTEXT *ctx);
+int
+  osdp_results_set
+    (int idx,
+    char *test,
+    char *description,
+    int test_status,
+    char *aux);
 
@@ -22,7 +22,6 @@ extern int pending_response_length;
 
 
 #include <stdio.h>
-#include <sys/select.h>
 #include <memory.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -32,6 +31,7 @@ extern int pending_response_length;
 #include <errno.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/ioctl.h>
 #include <fcntl.h>
 #include <termios.h>
 
@@ -51,6 +51,21 @@ OSDP_PARAMETERS p_card;
 char tag [1024]; // PD or CP as a string
 char trace_in_buffer [4*OSDP_OFFICIAL_MSG_MAX];
 char trace_out_buffer [4*OSDP_OFFICIAL_MSG_MAX];
+OSDP_PORT port [OSDP_PORT_MAX];
+OSDP_BUFFER port_input [OSDP_PORT_MAX];
+
+int
+  init_ports
+    (void);
+int
+  next_request
+    (void);
+int
+  process_serial
+    (OSDP_BUFFER *ob);
+int
+  read_serial
+    (OSDP_BUFFER *ob);
 
 
 unsigned char
@@ -85,6 +100,146 @@ void
 
 }
 
+/*
+  skip_noise - discard octets ahead of the first SOM in the input buffer
+*/
+
+void
+  skip_noise
+    (OSDP_BUFFER *ob)
+
+{ /* skip_noise */
+
+  context.dropped_octets = context.dropped_octets +
+    osdp_buffer_skip_to_som (ob);
+
+} /* skip_noise */
+
+
+/*
+  trace_octets - append octets to a trace buffer, as hex.
+
+  stops appending if the trace buffer is full; it is emptied each time a
+  message is logged.
+*/
+
+void
+  trace_octets
+    (char *trace,
+    int trace_size,
+    unsigned char *octets,
+    int lth)
+
+{ /* trace_octets */
+
+  static char hex [] = "0123456789abcdef";
+  int i;
+  int trace_lth;
+
+
+  trace_lth = strlen (trace);
+  for (i=0; (i<lth) && (trace_lth+4 < trace_size); i++)
+  {
+    trace [trace_lth] = ' ';
+    trace [trace_lth+1] = hex [octets [i] >> 4];
+    trace [trace_lth+2] = hex [octets [i] & 0x0f];
+    trace_lth = trace_lth + 3;
+  };
+  trace [trace_lth] = 0;
+  if (context.verbosity > 9)
+    fprintf(stderr, "DEBUG: trace now %s\n", trace);
+
+} /* trace_octets */
+
+
+/*
+  turnaround_sample - time from the last frame leaving the line to the
+  first octet of what came back
+
+  when the frame left is worked out in send_osdp_data; an answer that
+  beats that (a pseudo-tty has no UART) counts as no time at all.
+*/
+
+void
+  turnaround_sample
+    (OSDP_CONTEXT *ctx)
+
+{ /* turnaround_sample */
+
+  long delta;
+  struct timespec now;
+
+
+  if (ctx->turnaround.pending)
+  {
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    delta = (now.tv_sec - ctx->turnaround.drained.tv_sec) * 1000000l +
+      (now.tv_nsec - ctx->turnaround.drained.tv_nsec) / 1000l;
+    if (delta < 0)
+      delta = 0;
+    ctx->turnaround.last = delta;
+    if ((ctx->turnaround.count EQUALS 0) || (delta < ctx->turnaround.min))
+      ctx->turnaround.min = delta;
+    if (delta > ctx->turnaround.max)
+      ctx->turnaround.max = delta;
+    ctx->turnaround.total = ctx->turnaround.total + delta;
+    ctx->turnaround.count ++;
+    ctx->turnaround.pending = 0;
+  };
+
+} /* turnaround_sample */
+
+
+/*
+  init_ports - set up the serial buses
+
+  the one already opened (serial_device, or the first of serial-ports) is
+  port 0 and is loaded in the context.  the rest of serial-ports are
+  opened here.  only the ACU drives more than one.
+*/
+
+int
+  init_ports
+    (void)
+
+{ /* init_ports */
+
+  int i;
+  int status;
+
+
+  status = ST_OK;
+  memset (port, 0, sizeof (port));
+  strcpy (port [0].device, p_card.filename);
+  port [0].fd = context.fd;
+  port [0].input = &osdp_buf;
+  port [0].bus = osdp_bus (&context);
+  context.port = port;
+  context.port_count = 1;
+  context.port_current = 0;
+  if ((context.port_config_count > 1) && (context.role != OSDP_ROLE_ACU))
+    fprintf (stderr, "Only the ACU drives more than one serial port, using %s\n",
+      p_card.filename);
+  if (context.role EQUALS OSDP_ROLE_ACU)
+  {
+    for (i=1; (status EQUALS ST_OK) && (i<context.port_config_count); i++)
+    {
+      strcpy (port [i].device, context.port_config [i].device);
+      port [i].input = &(port_input [i]);
+      port [i].bus = &(port [i].own_bus);
+      status = osdp_bus_add_list (port [i].bus,
+        context.port_config [i].pd_addresses);
+      if (status EQUALS ST_OK)
+        status = osdp_port_open (&context, &(port [i]));
+      if (status EQUALS ST_OK)
+        context.port_count ++;
+    };
+  };
+  return (status);
+
+} /* init_ports */
+
+
 int
   initialize
     (int argc,
@@ -144,6 +299,10 @@ fprintf(stderr, "DEBUG: main context is 0x%lx\n", (unsigned long)(&context));
     status = init_serial (&context, p_card.filename);
   };
   if (status EQUALS ST_OK)
+  {
+    status = init_ports ();
+  };
+  if (status EQUALS ST_OK)
   {
     if (context.role EQUALS OSDP_ROLE_ACU)
       fprintf (stderr, "Role: ACU\n");
@@ -165,19 +324,16 @@ int
 
 { /* main for open-osdp */
 
-  int c1;
+  int commands;
   int done;
-  fd_set exceptfds;
-  char octet [1024]; // used for text version of byte in tracing
-  fd_set readfds;
-  int scount;
-  const sigset_t sigmask;
+  int fd;
+  int i;
+  OSDP_EVENT_LOOP loop;
   int status;
-  int status_io;
+  int status_ms;
   int status_select;
-  struct timespec timeout;
   int ufd;
-  fd_set writefds;
+  int wait_ms;
 
 
   status = ST_OK;
@@ -225,6 +381,19 @@ int
     };
     check_serial (&context);
   };
+
+  // wait on the serial port, the command socket and the timers together
+
+  if (!done)
+  {
+    status = osdp_loop_init (&loop);
+    for (i=0; (status EQUALS ST_OK) && (i<context.port_count); i++)
+      status = osdp_loop_watch (&loop, port [i].fd);
+    if ((status EQUALS ST_OK) && (ufd != -1))
+      status = osdp_loop_watch (&loop, ufd);
+    if (status != ST_OK)
+      done = 1;
+  };
 fprintf(stderr, "DEBUG: timer %d i_sec %ld. i_nsec %ld.\n",
   OSDP_TIMER_STATISTICS, context.timer[OSDP_TIMER_STATISTICS].i_sec, context.timer[OSDP_TIMER_STATISTICS].i_nsec);
 fprintf(stderr, "DEBUG: timer %d i_sec %ld. i_nsec %ld.\n",
@@ -236,26 +405,13 @@ fprintf(stderr, "DEBUG: timer %d i_sec %ld. i_nsec %ld.\n",
   {
     fflush (context.log);
 
-    // do a select waiting for RS-485 serial input (or a HUP)
-
-    FD_ZERO (&readfds);
-    FD_SET (ufd, &readfds);
-    FD_SET (context.fd, &readfds);
-    if (ufd > context.fd)
-      scount = ufd+1;
-    else
-      scount = context.fd+1;
-    FD_ZERO (&writefds);
-    FD_ZERO (&exceptfds);
-
-    // todo: switch over to OSDP_TIMER_IO and add a tunable parameter.
+    // wait for RS-485 serial input, a command, or the next timer to come due
 
-    timeout.tv_sec = 0;
-    timeout.tv_nsec = 100000000;
-    // to slow things way down set the select timeout to e.g. half a second:
-
-    status_select = pselect (scount, &readfds, &writefds, &exceptfds,
-      &timeout, &sigmask);
+    wait_ms = osdp_port_wait_ms (&context);
+    status_ms = oo_status_wait_ms (&context);
+    if ((status_ms >= 0) && ((wait_ms EQUALS -1) || (status_ms < wait_ms)))
+      wait_ms = status_ms;
+    status_select = osdp_loop_wait (&loop, &context, wait_ms);
 
     if (status_select EQUALS -1)
     {
@@ -274,7 +430,7 @@ fprintf(stderr, "DEBUG: timer %d i_sec %ld. i_nsec %ld.\n",
         fprintf (stderr, "errno at select error %d\n", errno);
       };
     };
-    if (status_select EQUALS 0)
+    if (loop.timer_ready)
     {
       status = ST_OK;
       if (osdp_timeout (&context, &last_time_check_ex))
@@ -299,111 +455,83 @@ fprintf(stderr, "DEBUG: timer %d i_sec %ld. i_nsec %ld.\n",
       };
     };
 
+    // the other buses' response timers (this one's is in the context)
+
+    if (context.port_count > 1)
+    {
+      struct timespec now;
+
+      clock_gettime (CLOCK_MONOTONIC, &now);
+      for (i=0; i<context.port_count; i++)
+      {
+        if (osdp_port_due (&context, i, &now))
+        {
+          osdp_port_select (&context, i);
+          if (osdp_timeout (&context, &last_time_check_ex))
+            status = background (&context);
+        };
+      };
+    };
+
     // if there was data at the 485 file descriptor, process it.
     // if we got kicked in the unix socket, process the waiting command
 
     if (status_select > 0)
     {
       if (context.verbosity > 10)
-        fprintf (stderr, "%d descriptors from pselect\n",
+        fprintf (stderr, "%d descriptors from the event loop\n",
           status_select);
 
-      // check for command input (unix socket activity pokes us to check)
+      // check for command input (a poke to read the command file, or
+      // commands inline on a control connection)
 
-      if (FD_ISSET (ufd, &readfds))
+      if (osdp_loop_ready (&loop, ufd))
       {
-        char cmdbuf [2];
-        c1 = accept (ufd, NULL, NULL);
         if (context.verbosity > 9)
-          fprintf (stderr, "ufd socket(%d) was selected in READ (new fd %d)\n",
-            ufd, c1);
-        if (c1 != -1)
-        {
-          status_io = read (c1, cmdbuf, sizeof (cmdbuf));
-          if (status_io > 0)
-          {
-            close (c1);
-
-            status = process_current_command(&context);
-            if (status EQUALS ST_OK)
-              preserve_current_command ();
-            check_for_command = 0;
-            status = ST_OK;
-          };
-        };       
+          fprintf (stderr, "ufd socket(%d) was selected in READ\n", ufd);
+        (void)osdp_control_accept (&context, &loop, ufd);
       };
+      (void)osdp_control_service (&context, &loop, &commands);
+      if (commands > 0)
+        check_for_command = 0;
+
+      // each bus with input is loaded into the context and serviced in turn
 
-      if (FD_ISSET (context.fd, &readfds))
+      for (i=0; i<context.port_count; i++)
       {
-        unsigned char buffer [2];
-        status_io = read (context.fd, buffer, 1);
-        if (status_io < 1)
+        fd = port [i].fd;
+        if (i EQUALS context.port_current)
+          fd = context.fd;
+        if (osdp_loop_ready (&loop, fd))
         {
-          // continue if it was a serial error
-          status = ST_OK;
-        }
-        else
-        {
-          if (context.trace & 1)
-          {
-            sprintf(octet, " %02x", buffer [0]);
-            strcat(trace_in_buffer, octet);
-if (context.verbosity > 9)
-{
-  fprintf(stderr, "DEBUG: trace in now %s\n", trace_in_buffer);
-};
-          };
-          if (context.verbosity > 10)
-            fprintf (stderr, "485 read returned %d bytes\n",
-              status_io);
-
-          status = ST_SERIAL_IN;
-          if (osdp_buf.next < sizeof (osdp_buf.buf))
-          {
-            osdp_buf.buf [osdp_buf.next] = buffer [0];
-            osdp_buf.next ++;
-
-          // if we're reading noise dump bytes until a clean header starts
-
-          // messages start with SOM, anything else is noise.
-          // (checksum mechanism copes with SOM's in the middle of a msg.)
-
-          if (osdp_buf.next EQUALS 1)
-          {
-            if (!(osdp_buf.buf [0] EQUALS C_SOM))
-            {
-              context.dropped_octets = context.dropped_octets + osdp_buf.next;
-              osdp_buf.next = 0;
-// zzz move up one byte
-            };
-          };
-        }
-        else
-        {
-          fprintf(context.log, "Serial Overflow, resetting input buffer\n");
-          context.dropped_octets = context.dropped_octets + osdp_buf.next;
-          osdp_buf.overflow ++;
-          osdp_buf.next = 0; 
+          osdp_port_select (&context, i);
+          status = read_serial (port [i].input);
+
+          // if there was input, extract every complete message in the buffer
+
+          if (status EQUALS ST_SERIAL_IN)
+            status = process_serial (port [i].input);
+          if (context.port_count > 1)
+            if (!osdp_awaiting_response(&context))
+              status = next_request ();
         };
       };
-    };
     }; // select returned nonzero number of fd's
 
-    // if there was input, process the message
-    if (status EQUALS ST_SERIAL_IN)
-    {
-      status = process_osdp_input (&osdp_buf);
-      // if it's too short so far it'll be 'serial_in' so ignore that
-      if (status EQUALS ST_SERIAL_IN)
-        status = ST_OK;
-    };
-
     // if we're not waiting for a response process the command queue
 
     if (!osdp_awaiting_response(&context))
-    {
-      status = process_command_from_queue(&context);
-    };
+      status = next_request ();
+
+    // a frame that could not be written has been counted; it is resent
+    // or abandoned like one that got no answer, so keep going
+
+    if (status EQUALS ST_SERIAL_OUT)
+      status = ST_OK;
+
+    // a status change that was held back for the rate limit
+    if (status EQUALS ST_OK)
+      status = oo_status_publish (&context);
 
     if (status != ST_OK)
       done = 1;
@@ -422,6 +550,121 @@ if (context.verbosity > 9)
 } /* main for open-osdp */
 
 
+/*
+  next_request - send what's next on the bus, nothing being outstanding
+
+  a queued command if there is one.  on a multi-drop bus don't wait out
+  the poll interval, as soon as the PD has answered go on to the next one.
+*/
+
+int
+  next_request
+    (void)
+
+{ /* next_request */
+
+  int status;
+
+
+  status = process_command_from_queue(&context);
+  if ((status EQUALS ST_OK) && (osdp_bus (&context)->count > 1))
+    if (!osdp_awaiting_response(&context))
+      status = background (&context);
+  return (status);
+
+} /* next_request */
+
+
+/*
+  process_serial - extract every complete message in the input buffer
+*/
+
+int
+  process_serial
+    (OSDP_BUFFER *ob)
+
+{ /* process_serial */
+
+  int previous_count;
+  int status;
+
+
+  do
+  {
+    // messages start with SOM, anything else is noise.
+    // (checksum mechanism copes with SOM's in the middle of a msg.)
+
+    skip_noise (ob);
+    previous_count = osdp_buffer_count (ob);
+    status = ST_OK;
+    if (previous_count > 0)
+      status = process_osdp_input (ob);
+
+    // if it's too short so far it'll be 'serial_in' so ignore that
+    if (status EQUALS ST_SERIAL_IN)
+      status = ST_OK;
+  } while ((status EQUALS ST_OK) && (osdp_buffer_count (ob) > 0) &&
+    (osdp_buffer_count (ob) < previous_count));
+  return (status);
+
+} /* process_serial */
+
+
+/*
+  read_serial - drain everything the tty has into the input buffer
+
+  the descriptor is non-blocking so read stops at EAGAIN.  returns
+  ST_SERIAL_IN if anything was read.
+*/
+
+int
+  read_serial
+    (OSDP_BUFFER *ob)
+
+{ /* read_serial */
+
+  int space;
+  int status;
+  int status_io;
+  unsigned char *tail;
+
+
+  status = ST_OK;
+  if (osdp_buffer_count (ob) >= OSDP_BUF_MAX)
+  {
+    fprintf(context.log, "Serial Overflow, resetting input buffer\n");
+    context.dropped_octets = context.dropped_octets + osdp_buffer_count (ob);
+    ob->overflow ++;
+    osdp_buffer_reset (ob);
+  };
+  status_io = 1;
+  space = 1;
+  while ((status_io > 0) && (space > 0))
+  {
+    // read straight into the ring, up to the wrap point
+
+    tail = osdp_buffer_tailroom (ob, &space);
+    status_io = 0;
+    if (space > 0)
+      status_io = read (context.fd, tail, space);
+    if (status_io > 0)
+    {
+      turnaround_sample (&context);
+      if (context.trace & 1)
+        trace_octets (trace_in_buffer, sizeof (trace_in_buffer),
+          tail, status_io);
+      if (context.verbosity > 10)
+        fprintf (stderr, "485 read returned %d bytes\n",
+          status_io);
+      osdp_buffer_produce (ob, status_io);
+      status = ST_SERIAL_IN;
+    };
+  };
+  return (status);
+
+} /* read_serial */
+
+
 int
   send_osdp_data
     (OSDP_CONTEXT *context,
@@ -430,6 +673,14 @@ int
 
 { /* send_osdp_data */
 
+  int baud;
+  long long line_ns;
+  int queued;
+  int status;
+  int status_io;
+
+
+  status = ST_OK;
   if (context->verbosity > 9)
   {
     int idx;
@@ -442,20 +693,40 @@ int
     fprintf (stderr, "\n");
   };
   if (context->trace & 1)
-  {
-    char octet [4];
-    int i;
+    trace_octets (trace_out_buffer, sizeof (trace_out_buffer), buf, lth);
 
-    octet [2] = 0;
-    for (i=0; i<lth; i++)
-    {
-      sprintf(octet, " %02x", buf [i]);
-      strcat(trace_out_buffer, octet);
-    };
+  // mark and frame go out in one write.  rather than wait in tcdrain
+  // for the UART to empty, work out when it will have from what is still
+  // queued (TIOCOUTQ, else the whole frame) at 10 bits an octet, so the
+  // turnaround to the first octet back can be measured from then.  the
+  // time is kept per port with the rest of the turnaround.
+
+  status_io = write (context->fd, buf, lth);
+  if (status_io != lth)
+  {
+    status = ST_SERIAL_OUT;
+    context->serial_write_errs ++;
+    if (context->verbosity > 2)
+      fprintf (stderr, "serial write returned %d (%d) for %d octets\n",
+        status_io, errno, lth);
+  }
+  else
+  {
+    context->bytes_sent = context->bytes_sent + lth;
+    if (ioctl (context->fd, TIOCOUTQ, &queued) != 0)
+      queued = lth;
+    baud = atoi (context->serial_speed);
+    if (baud <= 0)
+      baud = 9600;
+    line_ns = (queued * 10ll * 1000000000ll) / baud;
+    clock_gettime (CLOCK_MONOTONIC, &(context->turnaround.drained));
+    line_ns = line_ns + context->turnaround.drained.tv_nsec;
+    context->turnaround.drained.tv_sec = context->turnaround.drained.tv_sec +
+      line_ns / 1000000000ll;
+    context->turnaround.drained.tv_nsec = line_ns % 1000000000ll;
+    context->turnaround.pending = 1;
   };
-  write (context->fd, buf, lth);
-  
-  return (ST_OK);
+  return (status);
 
 } /* send_osdp_data */
 
@@ -34,7 +34,7 @@ int
 
   // whatever else we think, the PD saw the CRAUTH
 
-  osdp_test_set_status(OOC_SYMBOL_cmd_crauth, OCONFORM_EXERCISED);
+  osdp_test_set_status(OOC_ID_cmd_crauth, OCONFORM_EXERCISED);
 
   crauth_header = (OSDP_MULTI_HDR_IEC *)(msg->data_payload);
   crauth_payload = (char *)&(crauth_header->algo_payload);
@@ -118,11 +118,11 @@ fprintf(ctx->log, "  crauthr payload %02x%02x%02x...\n",
       sprintf(response_payload+(2*i), "%02x", (unsigned)*(crauthr_payload+i));
     };
     sprintf(details, "\"crauthr-response\":\"%s\",", response_payload);
-    osdp_test_set_status_ex(OOC_SYMBOL_resp_crauthr, OCONFORM_EXERCISED, details);
+    osdp_test_set_status_ex(OOC_ID_resp_crauthr, OCONFORM_EXERCISED, details);
   }
   else
   {
-    osdp_test_set_status_ex(OOC_SYMBOL_resp_crauthr, OCONFORM_FAIL, details);
+    osdp_test_set_status_ex(OOC_ID_resp_crauthr, OCONFORM_FAIL, details);
   };
 
   return(status);
@@ -171,11 +171,11 @@ fprintf(ctx->log, "  genauthr payload %02x%02x%02x...\n",
       sprintf(response_payload+(2*i), "%02x", (unsigned)*(genauthr_payload+i));
     };
     sprintf(details, "\"genauthr-response\":\"%s\",", response_payload);
-    osdp_test_set_status_ex(OOC_SYMBOL_resp_genauthr, OCONFORM_EXERCISED, details);
+    osdp_test_set_status_ex(OOC_ID_resp_genauthr, OCONFORM_EXERCISED, details);
   }
   else
   {
-    osdp_test_set_status_ex(OOC_SYMBOL_resp_genauthr, OCONFORM_FAIL, details);
+    osdp_test_set_status_ex(OOC_ID_resp_genauthr, OCONFORM_FAIL, details);
   };
 
   return(status);
@@ -205,7 +205,7 @@ int
   dump_buffer_log(ctx, "action_osdp_PIVDATAR ", msg->data_payload, msg->data_length);
   sprintf(details, "\"payload-length\":\"%d\",\"payload-first-3\":\"%02x%02x%02x\",",
     msg->data_length, (msg->data_payload)[0], (msg->data_payload)[1], (msg->data_payload)[2]);
-  osdp_test_set_status_ex(OOC_SYMBOL_resp_pivdatar, OCONFORM_EXERCISED, details);
+  osdp_test_set_status_ex(OOC_ID_resp_pivdatar, OCONFORM_EXERCISED, details);
   return(status);
 
 } /* action_osdp_PIVDATAR */
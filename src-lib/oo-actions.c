@@ -227,8 +227,8 @@ int
 
 
   status = ST_OK;
-  osdp_test_set_status(OOC_SYMBOL_cmd_filetransfer, OCONFORM_EXERCISED);
-  osdp_test_set_status(OOC_SYMBOL_resp_ftstat, OCONFORM_EXERCISED);
+  osdp_test_set_status(OOC_ID_cmd_filetransfer, OCONFORM_EXERCISED);
+  osdp_test_set_status(OOC_ID_resp_ftstat, OCONFORM_EXERCISED);
   ftstat_message = (OSDP_HDR_FTSTAT *)(msg->data_payload);
 
   status = osdp_ftstat_validate(ctx, ftstat_message);
@@ -373,19 +373,25 @@ int
 
 { /* action_osdp_MFGERRR */
 
+  char args [1024];
   char cmd [2*1024];
+  OSDP_ACTION_EVENT event;
 
 
   fprintf(ctx->log, "MFGERRR received\n");
 
   // run the action routine with the bytes,bit count,format
 
-  sprintf(cmd,
-    "/opt/osdp-conformance/run/ACU-actions/osdp_MFGERRR %d. %02x",
-    msg->data_length, *(msg->data_payload));
-  system(cmd);
+  sprintf(args, "%d. %02x", msg->data_length, *(msg->data_payload));
+  memset (&event, 0, sizeof (event));
+  event.action = OSDP_ACTION_MFGERRR;
+  event.data = msg->data_payload;
+  event.data_length = msg->data_length;
+  event.args = args;
+  sprintf(cmd, "/opt/osdp-conformance/run/ACU-actions/osdp_MFGERRR %s", args);
+  (void)osdp_action (ctx, &event, cmd);
 
-  osdp_test_set_status(OOC_SYMBOL_resp_mfgerrr, OCONFORM_EXERCISED);
+  osdp_test_set_status(OOC_ID_resp_mfgerrr, OCONFORM_EXERCISED);
   return(ST_OK);
 
 } /* action_osdp_MFGERRR */
@@ -399,13 +405,12 @@ int
 { /* action_osdp_PDCAP */
 
   char aux [4096];
-  FILE *capf;
   OSDP_PDCAP_ENTRY *entry;
   int i;
   int max_multipart;
   int num_entries;
   unsigned char *ptr;
-  char results_filename [1024];
+  char results_test [1024];
   int status;
   char temp_string [1024];
 
@@ -423,13 +428,13 @@ int
   entry = (OSDP_PDCAP_ENTRY *)ptr;
   for (i=0; i<num_entries; i++)
   {
-    // create results json files
+    // a result for each function
 
-    sprintf(results_filename, "/opt/osdp-conformance/results/070-05-%02d-results.json", 1+entry->function_code);
-    capf = fopen(results_filename, "w");
-    fprintf(capf, "{\"test\":\"070-05-%02d\",\"pdcap-function\":\"%d\",\"pdcap-compliance\":\"%d\",\"pdcap-number\":\"%d\"}\n",
-      entry->function_code+1, entry->function_code, entry->compliance, entry->number_of);
-    fclose(capf);
+    sprintf(results_test, "070-05-%02d", 1+entry->function_code);
+    sprintf(temp_string, "\"pdcap-function\":\"%d\",\"pdcap-compliance\":\"%d\",\"pdcap-number\":\"%d\",",
+      entry->function_code, entry->compliance, entry->number_of);
+    (void)osdp_results_set(-1, results_test, "Response: PDCAP (function)",
+      OCONFORM_EXERCISED, temp_string);
 
     sprintf(temp_string, "{\"function\":\"%02x\",\"compliance\":\"%02x\",\"number-of\":\"%02x\"},",
       entry->function_code, entry->compliance, entry->number_of);
@@ -558,9 +563,9 @@ int
   };
   fprintf(ctx->log, "PD Capabilities response processing complete.\n\n");
   if (ctx->last_command_sent EQUALS OSDP_CAP)
-    osdp_test_set_status(OOC_SYMBOL_cmd_cap, OCONFORM_EXERCISED);
+    osdp_test_set_status(OOC_ID_cmd_cap, OCONFORM_EXERCISED);
   strcat(aux, "\"#\":\"#\"},\n");
-  osdp_test_set_status_ex(OOC_SYMBOL_rep_device_capas, OCONFORM_EXERCISED, aux);
+  osdp_test_set_status_ex(OOC_ID_rep_device_capas, OCONFORM_EXERCISED, aux);
 
   status = oosdp_make_message (OOSDP_MSG_PD_CAPAS, tlogmsg, msg);
   fprintf (ctx->log, "%s\n", tlogmsg);
@@ -588,7 +593,7 @@ int
   done = 0;
 
   // i.e. we GOT a poll
-  osdp_test_set_status(OOC_SYMBOL_cmd_poll, OCONFORM_EXERCISED);
+  osdp_test_set_status(OOC_ID_cmd_poll, OCONFORM_EXERCISED);
 
   /*
     poll response can be many things.  we do one and then return, which
@@ -641,20 +646,20 @@ int
     if (ctx->tamper)
     {
       strcat(details, "Tamper");
-      osdp_test_set_status(OOC_SYMBOL_resp_lstatr_tamper, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_resp_lstatr_tamper, OCONFORM_EXERCISED);
 
-      osdp_test_set_status(OOC_SYMBOL_poll_lstatr, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_poll_lstatr, OCONFORM_EXERCISED);
     };
     if (ctx->power_report)
     {
       if (strlen(details) > 0)
         strcat(details, " ");
       strcat(details, "Power");
-      osdp_test_set_status(OOC_SYMBOL_resp_lstatr_power, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_resp_lstatr_power, OCONFORM_EXERCISED);
 
       // and that's an lstatr response to a poll, too.
 
-      osdp_test_set_status(OOC_SYMBOL_poll_lstatr, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_poll_lstatr, OCONFORM_EXERCISED);
     };
     osdp_lstat_response_data [ 0] = ctx->tamper;
     osdp_lstat_response_data [ 1] = ctx->power_report;
@@ -705,7 +710,7 @@ dump_buffer_log(ctx, "card data message(fixed 32)", osdp_raw_data, 32);
       status = send_message_ex (ctx,
         OSDP_RAW, p_card.addr, &current_length, raw_lth, osdp_raw_data,
         OSDP_SEC_SCS_18, 0, NULL);
-      osdp_test_set_status(OOC_SYMBOL_rep_raw, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_rep_raw, OCONFORM_EXERCISED);
       if (ctx->verbosity > 2)
       {
         sprintf (tlogmsg, "Responding with cardholder data (%d bits)",
@@ -785,8 +790,8 @@ dump_buffer_log(ctx, "card data message(fixed 32)", osdp_raw_data, 32);
     status = send_message_ex
       (ctx, OSDP_ACK, p_card.addr, &current_length, 0, NULL,
       OSDP_SEC_SCS_16, 0, NULL);
-    osdp_test_set_status(OOC_SYMBOL_cmd_poll, OCONFORM_EXERCISED);
-    osdp_test_set_status(OOC_SYMBOL_rep_ack, OCONFORM_EXERCISED);
+    osdp_test_set_status(OOC_ID_cmd_poll, OCONFORM_EXERCISED);
+    osdp_test_set_status(OOC_ID_rep_ack, OCONFORM_EXERCISED);
     if (ctx->verbosity > 9)
     {
       sprintf (tlogmsg, "Responding with OSDP_ACK");
@@ -810,9 +815,11 @@ int
 
 { /* action_osdp_RAW */
 
+  char args [1024+32];
   int bits;
   char cmd [2*1024];
   int display;
+  OSDP_ACTION_EVENT event;
   char hstr [1024]; // hex string of raw card data payload
   unsigned char *raw_data;
   int status;
@@ -825,7 +832,7 @@ int
     (void)oosdp_make_message (OOSDP_MSG_RAW, tlogmsg, msg);
     fprintf(ctx->log, "%s\n", tlogmsg); fflush(ctx->log); tlogmsg [0] = 0;
 
-    osdp_test_set_status(OOC_SYMBOL_rep_raw, OCONFORM_EXERCISED);
+    osdp_test_set_status(OOC_ID_rep_raw, OCONFORM_EXERCISED);
     osdp_conformance.cmd_poll_raw.test_status = OCONFORM_EXERCISED;
     raw_data = msg->data_payload + 4;
     dump_buffer_log(ctx, "osdp_RAW data", msg->data_payload, msg->data_length);
@@ -876,6 +883,19 @@ int
         fprintf(ctx->log, "%s\n", hstr);
 
         memcpy (ctx->last_raw_read_data, raw_data, octets);
+
+        // the hook gets it before the status file is written
+
+        sprintf (args, "%s %d %d", hstr, bits, *(msg->data_payload+1));
+        memset (&event, 0, sizeof (event));
+        event.action = OSDP_ACTION_RAW;
+        event.bits = bits;
+        event.format = *(msg->data_payload+1);
+        event.reader = *(msg->data_payload+0);
+        event.data = raw_data;
+        event.data_length = octets;
+        event.args = args;
+        (void)osdp_action (ctx, &event, NULL);
       };
 
       status = oo_write_status (ctx);
@@ -908,9 +928,8 @@ int bits_to_print;
       // run the action routine with the bytes,bit count,format
 
       sprintf(cmd,
-        "/opt/osdp-conformance/run/ACU-actions/osdp_RAW %s %d %d",
-        hstr, bits, *(msg->data_payload+1));
-      system(cmd);
+        "/opt/osdp-conformance/run/ACU-actions/osdp_RAW %s", args);
+      osdp_action_script (ctx, cmd);
     }; // not encrypted
   };
 
@@ -1004,8 +1023,8 @@ int
 
 
   status = ST_OK;
-  osdp_test_set_status(OOC_SYMBOL_cmd_rstat, OCONFORM_EXERCISED);
-  osdp_test_set_status(OOC_SYMBOL_resp_rstatr, OCONFORM_EXERCISED);
+  osdp_test_set_status(OOC_ID_cmd_rstat, OCONFORM_EXERCISED);
+  osdp_test_set_status(OOC_ID_resp_rstatr, OCONFORM_EXERCISED);
   osdp_rstat_response_data [ 0] = 1; //hard code to "not connected"
   current_length = 0;
   status = send_message (ctx, OSDP_RSTATR, p_card.addr,
@@ -1036,7 +1055,7 @@ int
 
 
   status = ST_OK;
-  osdp_test_set_status(OOC_SYMBOL_cmd_text, OCONFORM_EXERCISED);
+  osdp_test_set_status(OOC_ID_cmd_text, OCONFORM_EXERCISED);
 
   memset (ctx->text, 0, sizeof (ctx->text));
   text_length = (unsigned char) *(msg->data_payload+5);
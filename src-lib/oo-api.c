@@ -31,6 +31,10 @@
 extern OSDP_CONTEXT
   context;
 
+/*
+  enqueue_command - queue a command, in the lane its kind goes in
+*/
+
 int
   enqueue_command
     (OSDP_CONTEXT *ctx,
@@ -38,44 +42,13 @@ int
 
 { /* enqueue_command */
 
-  int done;
-  int i;
   int status;
 
 
-  status = ST_OK;
   if (ctx->verbosity > 3)
     fprintf(ctx->log, "DEBUG: enqueue_command: top, cmd->command %02x\n",
       cmd->command);
-
-  // if the last entry is active it's full
-
-  if (ctx->q [OSDP_COMMAND_QUEUE_SIZE-1].status != 0)
-  {
-    ctx->cmd_q_overflow ++;
-    status = ST_OSDP_COMMAND_OVERFLOW;
-  }
-  else
-  {
-    i = 0;
-    done = 0;
-    while (!done)
-    {
-      if (ctx->q [i].status EQUALS 0)
-      {
-        done = 1;
-      }
-      else
-      {
-        i++;
-      };
-    };
-    if (i > 0)
-      fprintf(ctx->log, "enqueue cmd to entry %2d\n", i);
-    memcpy(&(ctx->q [i].cmd), cmd, sizeof(ctx->q [0].cmd));
-    ctx->q [i].status = 1;
-  };
-
+  status = osdp_command_enqueue (ctx, cmd, osdp_command_lane (cmd->command));
   return(status);
 
 } /* enqueue_command */
@@ -91,6 +64,8 @@ int
   int status;
 
 
+  // cleared so only the details actually set get queued
+  memset (&cmd, 0, sizeof (cmd));
   status = read_command (&context, &cmd);
   if (status EQUALS ST_OK)
   {
@@ -118,17 +93,9 @@ int
   status = ST_OK;
   if (ctx->verbosity > 9)
     fprintf(ctx->log, "process_command_from_queue: top\n");
-  if (!(osdp_awaiting_response(ctx)) && (ctx->q [0].status != 0)) // meaning there's at least one command in the queue
+  if (!(osdp_awaiting_response(ctx)) && osdp_command_dequeue(ctx, &extracted))
   {
-    memcpy(&extracted, &(ctx->q [0].cmd), sizeof(extracted));
     cmd = &extracted;
-
-    // move all commands up one position
-    memcpy(ctx->q, ctx->q+1, (OSDP_COMMAND_QUEUE_SIZE-1)*sizeof(ctx->q [0]));
-
-    // noop out the last queue entry
-    ctx->q [OSDP_COMMAND_QUEUE_SIZE-1].status = 0;
-
     if (ctx->verbosity > 3)
       fprintf(ctx->log, "process_command_from_queue: processing command %d.\n", cmd->command);
     status = process_command(cmd->command, ctx,
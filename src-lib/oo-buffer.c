@@ -0,0 +1,287 @@
+/*
+  oo-buffer - ring buffer for OSDP input
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  head and tail run free and are masked with OSDP_BUF_MASK when used as
+  indices, so tail-head is always the number of octets buffered.
+  Consuming a frame only advances head; nothing is copied.
+*/
+
+
+#include <stdio.h>
+#include <memory.h>
+
+
+#include <open-osdp.h>
+
+
+/*
+  osdp_buffer_append - copy octets in at the tail
+
+  returns the number of octets stored, which is less than lth if
+  the buffer filled up (that is counted as an overflow.)
+*/
+
+int
+  osdp_buffer_append
+    (OSDP_BUFFER *ob,
+    unsigned char *octets,
+    int lth)
+
+{ /* osdp_buffer_append */
+
+  int done;
+  unsigned char *p;
+  int space;
+
+
+  done = 0;
+  space = 1;
+  while ((done < lth) && (space > 0))
+  {
+    p = osdp_buffer_tailroom (ob, &space);
+    if (space > (lth - done))
+      space = lth - done;
+    memcpy (p, octets + done, space);
+    osdp_buffer_produce (ob, space);
+    done = done + space;
+  };
+  if (done < lth)
+    ob->overflow ++;
+  return (done);
+
+} /* osdp_buffer_append */
+
+
+/*
+  osdp_buffer_consume - discard lth octets at the head
+
+  the framer works relative to the head so it starts over.
+*/
+
+void
+  osdp_buffer_consume
+    (OSDP_BUFFER *ob,
+    int lth)
+
+{ /* osdp_buffer_consume */
+
+  if (lth > osdp_buffer_count (ob))
+    lth = osdp_buffer_count (ob);
+  ob->head = ob->head + lth;
+
+  // when empty go back to the start so reads stay contiguous
+
+  if (ob->head EQUALS ob->tail)
+  {
+    ob->head = 0;
+    ob->tail = 0;
+  };
+  memset (&(ob->framer), 0, sizeof (ob->framer));
+
+} /* osdp_buffer_consume */
+
+
+int
+  osdp_buffer_count
+    (OSDP_BUFFER *ob)
+
+{ /* osdp_buffer_count */
+
+  return ((int)(ob->tail - ob->head));
+
+} /* osdp_buffer_count */
+
+
+unsigned char
+  osdp_buffer_octet
+    (OSDP_BUFFER *ob,
+    int offset)
+
+{ /* osdp_buffer_octet */
+
+  return (ob->buf [(ob->head + offset) & OSDP_BUF_MASK]);
+
+} /* osdp_buffer_octet */
+
+
+/*
+  osdp_buffer_produce - account for lth octets written at the tail
+  (see osdp_buffer_tailroom.)
+*/
+
+void
+  osdp_buffer_produce
+    (OSDP_BUFFER *ob,
+    int lth)
+
+{ /* osdp_buffer_produce */
+
+  ob->tail = ob->tail + lth;
+
+} /* osdp_buffer_produce */
+
+
+void
+  osdp_buffer_reset
+    (OSDP_BUFFER *ob)
+
+{ /* osdp_buffer_reset */
+
+  ob->head = 0;
+  ob->tail = 0;
+  ob->resync = 0;
+  memset (&(ob->framer), 0, sizeof (ob->framer));
+
+} /* osdp_buffer_reset */
+
+
+/*
+  osdp_buffer_resync - slide past a frame that did not check out
+
+  the SOM at the head is dropped along with anything up to the next
+  candidate SOM.  The length octets may be what was damaged so the
+  declared length is not trusted.  returns the number of octets skipped.
+*/
+
+int
+  osdp_buffer_resync
+    (OSDP_BUFFER *ob)
+
+{ /* osdp_buffer_resync */
+
+  int skipped;
+
+
+  skipped = 0;
+  if (osdp_buffer_count (ob) > 0)
+  {
+    osdp_buffer_consume (ob, 1);
+    skipped = 1 + osdp_buffer_skip_to_som (ob);
+  };
+  ob->resync = 1;
+  return (skipped);
+
+} /* osdp_buffer_resync */
+
+
+/*
+  osdp_buffer_skip_to_som - discard octets ahead of the first SOM
+
+  returns the number of octets discarded.
+*/
+
+int
+  osdp_buffer_skip_to_som
+    (OSDP_BUFFER *ob)
+
+{ /* osdp_buffer_skip_to_som */
+
+  int count;
+  unsigned char *p;
+  int run;
+  unsigned char *som;
+  int skip;
+
+
+  // search the ring as (at most) two contiguous runs
+
+  count = osdp_buffer_count (ob);
+  skip = 0;
+  som = NULL;
+  while ((som EQUALS NULL) && (skip < count))
+  {
+    p = ob->buf + ((ob->head + skip) & OSDP_BUF_MASK);
+    run = OSDP_BUF_MAX - ((ob->head + skip) & OSDP_BUF_MASK);
+    if (run > (count - skip))
+      run = count - skip;
+    som = memchr (p, C_SOM, run);
+    if (som EQUALS NULL)
+      skip = skip + run;
+    else
+      skip = skip + (som - p);
+  };
+  if (skip > 0)
+    osdp_buffer_consume (ob, skip);
+  return (skip);
+
+} /* osdp_buffer_skip_to_som */
+
+
+/*
+  osdp_buffer_tailroom - where to write new octets
+
+  returns a pointer to the tail and sets space to the number of octets
+  that can be written there without wrapping or overrunning the head.
+*/
+
+unsigned char *
+  osdp_buffer_tailroom
+    (OSDP_BUFFER *ob,
+    int *space)
+
+{ /* osdp_buffer_tailroom */
+
+  int contiguous;
+  int free_space;
+  int index;
+
+
+  free_space = OSDP_BUF_MAX - osdp_buffer_count (ob);
+  index = ob->tail & OSDP_BUF_MASK;
+  contiguous = OSDP_BUF_MAX - index;
+  if (contiguous > free_space)
+    contiguous = free_space;
+  *space = contiguous;
+  return (ob->buf + index);
+
+} /* osdp_buffer_tailroom */
+
+
+/*
+  osdp_buffer_view - contiguous view of the octets at the head
+
+  lth is the number of octets wanted; it is trimmed to what is buffered
+  and to OSDP_BUF_VIEW_MAX.  If the run wraps the start of the ring is
+  copied past the end (only the wrapped part, and only then.)
+*/
+
+unsigned char *
+  osdp_buffer_view
+    (OSDP_BUFFER *ob,
+    int *lth)
+
+{ /* osdp_buffer_view */
+
+  int index;
+  int wrapped;
+
+
+  if (*lth > osdp_buffer_count (ob))
+    *lth = osdp_buffer_count (ob);
+  if (*lth > OSDP_BUF_VIEW_MAX)
+    *lth = OSDP_BUF_VIEW_MAX;
+  index = ob->head & OSDP_BUF_MASK;
+  wrapped = index + *lth - OSDP_BUF_MAX;
+  if (wrapped > 0)
+    memcpy (ob->buf + OSDP_BUF_MAX, ob->buf, wrapped);
+  return (ob->buf + index);
+
+} /* osdp_buffer_view */
+
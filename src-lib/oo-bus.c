@@ -0,0 +1,379 @@
+/*
+  oo-bus - multi-drop poll scheduling for the ACU
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  The PD's on the bus are polled round-robin with one request outstanding.
+  Everything else in the library talks to p_card.addr with the sequence
+  number etc. in the context, so the session for the PD whose turn it is
+  is loaded into the context and saved back when its turn is over (the
+  reply came in or the response timer ran out.)  That includes its
+  secure channel (osdp_sc_load, osdp_sc_save), so each PD has its own
+  keys and MAC chain and secure polls take turns like the others.  The
+  sessions themselves stay with the port; the context only points at them
+  (osdp_bus).  A queued command for a particular PD takes that PD's turn
+  when it comes off the queue (osdp_bus_select) unless a transfer or
+  secure channel set-up with the current one is under way, in which case
+  it waits.  A PD that keeps timing out is only polled every
+  OSDP_BUS_OFFLINE_SKIP rounds so it does not eat the bus.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+
+
+#include <open-osdp.h>
+
+
+extern OSDP_PARAMETERS p_card;
+
+
+void
+  osdp_bus_load
+    (OSDP_CONTEXT *ctx);
+void
+  osdp_bus_save
+    (OSDP_CONTEXT *ctx);
+
+
+/*
+  osdp_bus - the multi-drop sessions of the port being serviced
+
+  a context no port has been loaded into (one serial port, or a tool that
+  never calls initialize_osdp) uses its own.
+*/
+
+OSDP_BUS
+  *osdp_bus
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_bus */
+
+  if (ctx->bus EQUALS NULL)
+    ctx->bus = &(ctx->own_bus);
+  return (ctx->bus);
+
+} /* osdp_bus */
+
+
+/*
+  osdp_bus_add - add a PD address to the poll rotation
+
+  adding one that is already there does nothing.
+*/
+
+int
+  osdp_bus_add
+    (OSDP_BUS *bus,
+    int addr)
+
+{ /* osdp_bus_add */
+
+  OSDP_PD_SESSION *s;
+  int status;
+
+
+  status = ST_OK;
+  if ((addr < 0) || (addr >= OSDP_BUS_MAX_PD))
+    status = ST_BUS_BAD_ADDRESS;
+  if (status EQUALS ST_OK)
+  {
+    s = &(bus->session [addr]);
+    if (!(s->configured))
+    {
+      memset (s, 0, sizeof (*s));
+      s->configured = 1;
+      s->online = 1;
+      s->last_was_processed = 1;
+      bus->order [bus->count] = addr;
+      bus->count ++;
+    };
+  };
+  if (status != ST_OK)
+    fprintf (stderr, "bad PD address for the bus: %d\n", addr);
+  return (status);
+
+} /* osdp_bus_add */
+
+
+/*
+  osdp_bus_add_list - add PD addresses given as e.g. "0,1,2,5"
+*/
+
+int
+  osdp_bus_add_list
+    (OSDP_BUS *bus,
+    char *addresses)
+
+{ /* osdp_bus_add_list */
+
+  int i;
+  int status;
+  char *token;
+  char vstr [1024];
+
+
+  status = ST_OK;
+  strncpy (vstr, addresses, sizeof (vstr)-1);
+  vstr [sizeof (vstr)-1] = 0;
+  token = strtok (vstr, ", ");
+  while ((token != NULL) && (status EQUALS ST_OK))
+  {
+    i = -1;
+    sscanf (token, "%d", &i);
+    status = osdp_bus_add (bus, i);
+    token = strtok (NULL, ", ");
+  };
+  return (status);
+
+} /* osdp_bus_add_list */
+
+
+/*
+  osdp_bus_load - make the current session the one the context talks to
+*/
+
+void
+  osdp_bus_load
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_bus_load */
+
+  int addr;
+  OSDP_BUS *bus;
+  OSDP_PD_SESSION *s;
+
+
+  bus = osdp_bus (ctx);
+  addr = bus->order [bus->current];
+  s = &(bus->session [addr]);
+  p_card.addr = addr;
+  ctx->pd_address = addr;
+  ctx->next_sequence = s->next_sequence;
+  ctx->last_was_processed = s->last_was_processed;
+  ctx->last_command_sent = s->last_command_sent;
+  ctx->last_nak_error = s->last_nak_error;
+  ctx->last_response_received = s->last_response_received;
+  osdp_sc_load (ctx, &(s->sc));
+  bus->active = 1;
+
+} /* osdp_bus_load */
+
+
+/*
+  osdp_bus_next - end the current PD's turn and start the next one's
+
+  call when nothing is outstanding.  returns the address now loaded.
+*/
+
+int
+  osdp_bus_next
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_bus_next */
+
+  int addr;
+  OSDP_BUS *bus;
+  int done;
+  int i;
+  OSDP_PD_SESSION *s;
+
+
+  bus = osdp_bus (ctx);
+  if (bus->active)
+    osdp_bus_save (ctx);
+
+  // next in line, passing over offline PD's that are sitting out a round.
+  // if they all are the one after the current is used.
+
+  done = 0;
+  for (i=1; (!done) && (i<=bus->count); i++)
+  {
+    addr = bus->order [(bus->current + i) % bus->count];
+    s = &(bus->session [addr]);
+    if (s->online || (s->skip EQUALS 0))
+    {
+      bus->current = (bus->current + i) % bus->count;
+      done = 1;
+    }
+    else
+      s->skip --;
+  };
+  if (!done)
+    bus->current = (bus->current + 1) % bus->count;
+  osdp_bus_load (ctx);
+
+  s = &(bus->session [p_card.addr]);
+  if (!(s->online))
+    s->skip = OSDP_BUS_OFFLINE_SKIP;
+  s->polls ++;
+  return (p_card.addr);
+
+} /* osdp_bus_next */
+
+
+/*
+  osdp_bus_route - match a reply to its PD's session
+
+  only the PD whose turn it is gets processed; anything else is a late
+  reply (or a stranger) and is counted and passed over as not ours.
+*/
+
+int
+  osdp_bus_route
+    (OSDP_CONTEXT *ctx,
+    int addr)
+
+{ /* osdp_bus_route */
+
+  OSDP_BUS *bus;
+  OSDP_PD_SESSION *s;
+  int status;
+
+
+  status = ST_NOT_MY_ADDR;
+  bus = osdp_bus (ctx);
+  s = NULL;
+  if ((addr >= 0) && (addr < OSDP_BUS_MAX_PD))
+    s = &(bus->session [addr]);
+  if (s != NULL)
+  {
+    if (s->configured)
+    {
+      if ((bus->active) && (addr EQUALS p_card.addr))
+      {
+        status = ST_OK;
+        s->replies ++;
+        s->misses = 0;
+        if (!(s->online) && (ctx->verbosity > 2))
+          fprintf (ctx->log, "PD %02x back online\n", addr);
+        s->online = 1;
+      }
+      else
+        s->strays ++;
+    };
+  };
+  if ((status != ST_OK) && (ctx->verbosity > 3))
+    fprintf (stderr, "reply from %02x while talking to %02x\n",
+      addr, p_card.addr);
+  return (status);
+
+} /* osdp_bus_route */
+
+
+/*
+  osdp_bus_save - put the context's state back in the current session
+*/
+
+void
+  osdp_bus_save
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_bus_save */
+
+  OSDP_BUS *bus;
+  OSDP_PD_SESSION *s;
+
+
+  bus = osdp_bus (ctx);
+  s = &(bus->session [bus->order [bus->current]]);
+  if (ctx->last_was_processed)
+  {
+    if (ctx->last_response_received EQUALS OSDP_NAK)
+      s->naks ++;
+  }
+  else
+  {
+    s->timeouts ++;
+    s->misses ++;
+    if ((s->online) && (s->misses >= OSDP_BUS_OFFLINE_MISSES))
+    {
+      s->online = 0;
+      if (ctx->verbosity > 2)
+        fprintf (ctx->log, "PD %02x offline after %d timeouts\n",
+          bus->order [bus->current], s->misses);
+    };
+  };
+  s->next_sequence = ctx->next_sequence;
+  s->last_was_processed = 1;
+  s->last_command_sent = ctx->last_command_sent;
+  s->last_nak_error = ctx->last_nak_error;
+  s->last_response_received = ctx->last_response_received;
+  osdp_sc_save (ctx, &(s->sc));
+
+} /* osdp_bus_save */
+
+
+/*
+  osdp_bus_select - talk to a particular PD now
+
+  for a command addressed to one PD.  returns ST_OK if the context is
+  talking to it (-1 is whichever PD it is already), ST_BUS_WAIT if the
+  current PD's transfer, secure channel set-up or reply has to finish
+  first, ST_BUS_BAD_ADDRESS if it is not on the bus.
+*/
+
+int
+  osdp_bus_select
+    (OSDP_CONTEXT *ctx,
+    int addr)
+
+{ /* osdp_bus_select */
+
+  OSDP_BUS *bus;
+  int i;
+  int status;
+
+
+  status = ST_OK;
+  bus = osdp_bus (ctx);
+  if (addr >= 0)
+  {
+    if (bus->count EQUALS 0)
+    {
+      if (addr != p_card.addr)
+        status = ST_BUS_BAD_ADDRESS;
+    }
+    else
+    {
+      if ((addr >= OSDP_BUS_MAX_PD) || !(bus->session [addr].configured))
+        status = ST_BUS_BAD_ADDRESS;
+      if ((status EQUALS ST_OK) &&
+        !((bus->active) && (addr EQUALS p_card.addr)))
+      {
+        if ((ctx->xferctx.total_length != 0) ||
+          (ctx->secure_channel_use [OO_SCU_ENAB] & 0x80) ||
+          osdp_awaiting_response (ctx))
+          status = ST_BUS_WAIT;
+        if (status EQUALS ST_OK)
+        {
+          if (bus->active)
+            osdp_bus_save (ctx);
+          for (i=0; i<bus->count; i++)
+            if (bus->order [i] EQUALS addr)
+              bus->current = i;
+          osdp_bus_load (ctx);
+        };
+      };
+    };
+  };
+  return (status);
+
+} /* osdp_bus_select */
+
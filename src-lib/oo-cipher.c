@@ -0,0 +1,802 @@
+/*
+  oo-cipher - AES-128 for the secure channel, in software or with AES-NI
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  The secure channel only needs AES-128 CBC: encrypt and decrypt for the
+  payload and key derivation, and CBC-MAC (the last block, leaving the
+  data alone) for the message authentication.  There are two backends,
+  tiny-AES ("software") and the processor's AES instructions ("aes-ni",
+  x86 only, used when CPUID says they are there.)  osdp_cipher_select
+  picks one from "cipher" and runs the known answer tests on it; if they
+  do not all match, software is used.  A key schedule remembers which
+  backend expanded it and is always used with that one.
+
+  The known answers are FIPS-197 C.1, SP 800-38A F.2.1/F.2.2, and an
+  SCBK-D session (RND.A "12345678", RND.B "abcdefgh"): the session key
+  derivation, SCS_15 and SCS_16 MACs, and an SCS_17 and an SCS_18 frame's
+  payload and MAC blocks, each chained from the one before.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+
+
+#include <aes.h>
+
+
+#include <open-osdp.h>
+
+
+#if defined (__x86_64__) || defined (__i386__)
+#define OSDP_CIPHER_HAS_AESNI
+#include <cpuid.h>
+#include <wmmintrin.h>
+#endif
+
+
+#define OSDP_CIPHER_KAT_ENCRYPT (0)
+#define OSDP_CIPHER_KAT_DECRYPT (1)
+#define OSDP_CIPHER_KAT_MAC     (2) // out is the last block
+
+typedef struct osdp_cipher_kat_vector
+{
+  char *name;
+  int operation;
+  int length;
+  char *key;
+  char *iv;
+  char *in;
+  char *out;
+} OSDP_CIPHER_KAT_VECTOR;
+
+
+// the software backend keeps a struct AES_ctx in the schedule
+
+typedef char osdp_aes_ctx_fits [(sizeof (struct AES_ctx) <= OSDP_AES_CTX_MAX) ? 1 : -1];
+
+
+int
+  osdp_cipher_aesni_available
+    (void);
+void
+  osdp_cipher_aesni_cbc_decrypt
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length);
+void
+  osdp_cipher_aesni_cbc_encrypt
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length);
+void
+  osdp_cipher_aesni_cbc_mac
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length,
+    unsigned char *mac);
+void
+  osdp_cipher_aesni_expand
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *key);
+int
+  osdp_cipher_software_available
+    (void);
+void
+  osdp_cipher_software_cbc_decrypt
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length);
+void
+  osdp_cipher_software_cbc_encrypt
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length);
+void
+  osdp_cipher_software_cbc_mac
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length,
+    unsigned char *mac);
+void
+  osdp_cipher_software_expand
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *key);
+
+
+OSDP_CIPHER osdp_ciphers [OSDP_CIPHER_BACKENDS] =
+{
+  {"software", osdp_cipher_software_available,
+    osdp_cipher_software_expand, osdp_cipher_software_cbc_encrypt,
+    osdp_cipher_software_cbc_decrypt, osdp_cipher_software_cbc_mac},
+  {"aes-ni", osdp_cipher_aesni_available,
+    osdp_cipher_aesni_expand, osdp_cipher_aesni_cbc_encrypt,
+    osdp_cipher_aesni_cbc_decrypt, osdp_cipher_aesni_cbc_mac},
+};
+int osdp_cipher_current = OSDP_CIPHER_AUTO; // none selected yet
+
+OSDP_CIPHER_KAT_VECTOR osdp_cipher_kat_vectors [] =
+{
+  {"FIPS-197 C.1", OSDP_CIPHER_KAT_ENCRYPT, 16,
+    "\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f",
+    "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00",
+    "\x00\x11\x22\x33\x44\x55\x66\x77\x88\x99\xaa\xbb\xcc\xdd\xee\xff",
+    "\x69\xc4\xe0\xd8\x6a\x7b\x04\x30\xd8\xcd\xb7\x80\x70\xb4\xc5\x5a",
+  },
+  {"SP800-38A F.2.1", OSDP_CIPHER_KAT_ENCRYPT, 64,
+    "\x2b\x7e\x15\x16\x28\xae\xd2\xa6\xab\xf7\x15\x88\x09\xcf\x4f\x3c",
+    "\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f",
+    "\x6b\xc1\xbe\xe2\x2e\x40\x9f\x96\xe9\x3d\x7e\x11\x73\x93\x17\x2a"
+    "\xae\x2d\x8a\x57\x1e\x03\xac\x9c\x9e\xb7\x6f\xac\x45\xaf\x8e\x51"
+    "\x30\xc8\x1c\x46\xa3\x5c\xe4\x11\xe5\xfb\xc1\x19\x1a\x0a\x52\xef"
+    "\xf6\x9f\x24\x45\xdf\x4f\x9b\x17\xad\x2b\x41\x7b\xe6\x6c\x37\x10",
+    "\x76\x49\xab\xac\x81\x19\xb2\x46\xce\xe9\x8e\x9b\x12\xe9\x19\x7d"
+    "\x50\x86\xcb\x9b\x50\x72\x19\xee\x95\xdb\x11\x3a\x91\x76\x78\xb2"
+    "\x73\xbe\xd6\xb8\xe3\xc1\x74\x3b\x71\x16\xe6\x9e\x22\x22\x95\x16"
+    "\x3f\xf1\xca\xa1\x68\x1f\xac\x09\x12\x0e\xca\x30\x75\x86\xe1\xa7",
+  },
+  {"SP800-38A F.2.2", OSDP_CIPHER_KAT_DECRYPT, 64,
+    "\x2b\x7e\x15\x16\x28\xae\xd2\xa6\xab\xf7\x15\x88\x09\xcf\x4f\x3c",
+    "\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f",
+    "\x76\x49\xab\xac\x81\x19\xb2\x46\xce\xe9\x8e\x9b\x12\xe9\x19\x7d"
+    "\x50\x86\xcb\x9b\x50\x72\x19\xee\x95\xdb\x11\x3a\x91\x76\x78\xb2"
+    "\x73\xbe\xd6\xb8\xe3\xc1\x74\x3b\x71\x16\xe6\x9e\x22\x22\x95\x16"
+    "\x3f\xf1\xca\xa1\x68\x1f\xac\x09\x12\x0e\xca\x30\x75\x86\xe1\xa7",
+    "\x6b\xc1\xbe\xe2\x2e\x40\x9f\x96\xe9\x3d\x7e\x11\x73\x93\x17\x2a"
+    "\xae\x2d\x8a\x57\x1e\x03\xac\x9c\x9e\xb7\x6f\xac\x45\xaf\x8e\x51"
+    "\x30\xc8\x1c\x46\xa3\x5c\xe4\x11\xe5\xfb\xc1\x19\x1a\x0a\x52\xef"
+    "\xf6\x9f\x24\x45\xdf\x4f\x9b\x17\xad\x2b\x41\x7b\xe6\x6c\x37\x10",
+  },
+  {"S-ENC from SCBK-D", OSDP_CIPHER_KAT_ENCRYPT, 16,
+    "\x30\x31\x32\x33\x34\x35\x36\x37\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f",
+    "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00",
+    "\x01\x82\x31\x32\x33\x34\x35\x36\x00\x00\x00\x00\x00\x00\x00\x00",
+    "\x51\xff\x62\x60\x0f\x42\x64\x70\x5b\xff\x3c\xfd\xb0\xcf\x0c\xba",
+  },
+  {"S-MAC1 from SCBK-D", OSDP_CIPHER_KAT_ENCRYPT, 16,
+    "\x30\x31\x32\x33\x34\x35\x36\x37\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f",
+    "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00",
+    "\x01\x01\x31\x32\x33\x34\x35\x36\x00\x00\x00\x00\x00\x00\x00\x00",
+    "\xe9\xbe\x3d\xf5\x50\x47\xe6\x4f\x25\x01\xce\xe3\xf2\x5c\x37\x84",
+  },
+  {"S-MAC2 from SCBK-D", OSDP_CIPHER_KAT_ENCRYPT, 16,
+    "\x30\x31\x32\x33\x34\x35\x36\x37\x38\x39\x3a\x3b\x3c\x3d\x3e\x3f",
+    "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00",
+    "\x01\x02\x31\x32\x33\x34\x35\x36\x00\x00\x00\x00\x00\x00\x00\x00",
+    "\x46\x0e\x25\xef\xd9\x48\xc9\x40\x57\xb4\x64\x42\x0d\x1f\x36\xe5",
+  },
+  {"SCS_15 POLL MAC", OSDP_CIPHER_KAT_MAC, 16,
+    "\x46\x0e\x25\xef\xd9\x48\xc9\x40\x57\xb4\x64\x42\x0d\x1f\x36\xe5",
+    "\x24\xae\x06\x05\xf0\x23\x70\x18\x42\x1b\x3c\xdc\x30\x9e\x79\xab",
+    "\x53\x00\x0e\x00\x0c\x02\x15\x60\x80\x00\x00\x00\x00\x00\x00\x00",
+    "\xe4\x0d\xd3\x46\x34\x4d\xcd\xc2\x0c\x75\xb5\x8a\x65\x4b\x48\x40",
+  },
+  {"SCS_16 ACK MAC", OSDP_CIPHER_KAT_MAC, 16,
+    "\x46\x0e\x25\xef\xd9\x48\xc9\x40\x57\xb4\x64\x42\x0d\x1f\x36\xe5",
+    "\xe4\x0d\xd3\x46\x34\x4d\xcd\xc2\x0c\x75\xb5\x8a\x65\x4b\x48\x40",
+    "\x53\x80\x0e\x00\x0c\x02\x16\x40\x80\x00\x00\x00\x00\x00\x00\x00",
+    "\x3e\xbe\x3e\xbf\x04\xf4\x7e\xa7\xcf\xe5\xa1\x22\x8d\x1e\x1a\x83",
+  },
+  {"SCS_17 payload", OSDP_CIPHER_KAT_ENCRYPT, 16,
+    "\x51\xff\x62\x60\x0f\x42\x64\x70\x5b\xff\x3c\xfd\xb0\xcf\x0c\xba",
+    "\xc1\x41\xc1\x40\xfb\x0b\x81\x58\x30\x1a\x5e\xdd\x72\xe1\xe5\x7c",
+    "\x00\x01\x00\x00\x00\x05\x48\x45\x4c\x4c\x80\x00\x00\x00\x00\x00",
+    "\xdd\x0d\x8d\xaa\xbc\x8b\x32\xaa\xc5\xf9\x49\x43\x4b\x05\xa6\xe4",
+  },
+  {"SCS_17 MAC, S-MAC1 blocks", OSDP_CIPHER_KAT_MAC, 16,
+    "\xe9\xbe\x3d\xf5\x50\x47\xe6\x4f\x25\x01\xce\xe3\xf2\x5c\x37\x84",
+    "\x3e\xbe\x3e\xbf\x04\xf4\x7e\xa7\xcf\xe5\xa1\x22\x8d\x1e\x1a\x83",
+    "\x53\x00\x1e\x00\x0d\x02\x17\x6b\xdd\x0d\x8d\xaa\xbc\x8b\x32\xaa",
+    "\xca\xcd\x51\xfa\xeb\xcc\x59\xd1\xf7\x2f\xc3\x9b\xcd\x12\xee\xc8",
+  },
+  {"SCS_17 MAC, S-MAC2 block", OSDP_CIPHER_KAT_MAC, 16,
+    "\x46\x0e\x25\xef\xd9\x48\xc9\x40\x57\xb4\x64\x42\x0d\x1f\x36\xe5",
+    "\xca\xcd\x51\xfa\xeb\xcc\x59\xd1\xf7\x2f\xc3\x9b\xcd\x12\xee\xc8",
+    "\xc5\xf9\x49\x43\x4b\x05\xa6\xe4\x80\x00\x00\x00\x00\x00\x00\x00",
+    "\xe2\x19\x73\xd4\x35\x7a\x44\x3e\xdf\xfa\x9c\x13\x16\x53\x6d\x87",
+  },
+  {"SCS_18 payload", OSDP_CIPHER_KAT_DECRYPT, 16,
+    "\x51\xff\x62\x60\x0f\x42\x64\x70\x5b\xff\x3c\xfd\xb0\xcf\x0c\xba",
+    "\x1d\xe6\x8c\x2b\xca\x85\xbb\xc1\x20\x05\x63\xec\xe9\xac\x92\x78",
+    "\x05\xb4\x26\x24\x21\x79\x48\xdc\x26\xf4\x79\x69\x39\xc5\x15\x5f",
+    "\x00\x00\x80\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00",
+  },
+  {"SCS_18 MAC, S-MAC1 blocks", OSDP_CIPHER_KAT_MAC, 16,
+    "\xe9\xbe\x3d\xf5\x50\x47\xe6\x4f\x25\x01\xce\xe3\xf2\x5c\x37\x84",
+    "\xe2\x19\x73\xd4\x35\x7a\x44\x3e\xdf\xfa\x9c\x13\x16\x53\x6d\x87",
+    "\x53\x80\x1e\x00\x0d\x02\x18\x48\x05\xb4\x26\x24\x21\x79\x48\xdc",
+    "\x62\x9b\x03\xba\x5c\x8d\x77\x6c\xbb\x76\xb0\xa4\xea\x32\xa5\x16",
+  },
+  {"SCS_18 MAC, S-MAC2 block", OSDP_CIPHER_KAT_MAC, 16,
+    "\x46\x0e\x25\xef\xd9\x48\xc9\x40\x57\xb4\x64\x42\x0d\x1f\x36\xe5",
+    "\x62\x9b\x03\xba\x5c\x8d\x77\x6c\xbb\x76\xb0\xa4\xea\x32\xa5\x16",
+    "\x26\xf4\x79\x69\x39\xc5\x15\x5f\x80\x00\x00\x00\x00\x00\x00\x00",
+    "\x61\x73\x29\x71\x09\x6e\x6c\xfa\x65\x11\x4a\x15\xa2\x62\x4a\x52",
+  },
+
+  // the same with 4 octets past the block, which every backend leaves out
+
+  {"CBC-MAC, partial block ignored", OSDP_CIPHER_KAT_MAC, 20,
+    "\x46\x0e\x25\xef\xd9\x48\xc9\x40\x57\xb4\x64\x42\x0d\x1f\x36\xe5",
+    "\x62\x9b\x03\xba\x5c\x8d\x77\x6c\xbb\x76\xb0\xa4\xea\x32\xa5\x16",
+    "\x26\xf4\x79\x69\x39\xc5\x15\x5f\x80\x00\x00\x00\x00\x00\x00\x00"
+    "\x5a\xa5\x5a\xa5",
+    "\x61\x73\x29\x71\x09\x6e\x6c\xfa\x65\x11\x4a\x15\xa2\x62\x4a\x52",
+  },
+};
+
+
+/*
+  osdp_cipher_available - can this processor run the backend
+*/
+
+int
+  osdp_cipher_available
+    (int cipher)
+
+{ /* osdp_cipher_available */
+
+  int available;
+
+
+  available = 0;
+  if ((cipher >= 0) && (cipher < OSDP_CIPHER_BACKENDS))
+    available = (*(osdp_ciphers [cipher].available)) ();
+  return (available);
+
+} /* osdp_cipher_available */
+
+
+void
+  osdp_cipher_cbc_decrypt
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length)
+
+{ /* osdp_cipher_cbc_decrypt */
+
+  (*(osdp_ciphers [schedule->cipher].cbc_decrypt)) (schedule, iv, buffer, length);
+
+} /* osdp_cipher_cbc_decrypt */
+
+
+void
+  osdp_cipher_cbc_encrypt
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length)
+
+{ /* osdp_cipher_cbc_encrypt */
+
+  (*(osdp_ciphers [schedule->cipher].cbc_encrypt)) (schedule, iv, buffer, length);
+
+} /* osdp_cipher_cbc_encrypt */
+
+
+/*
+  osdp_cipher_cbc_mac - CBC-MAC: the last block of the CBC encryption of
+  buffer (whole blocks), which is left as it was
+*/
+
+void
+  osdp_cipher_cbc_mac
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length,
+    unsigned char *mac)
+
+{ /* osdp_cipher_cbc_mac */
+
+  (*(osdp_ciphers [schedule->cipher].cbc_mac)) (schedule, iv, buffer, length, mac);
+
+} /* osdp_cipher_cbc_mac */
+
+
+/*
+  osdp_cipher_expand - expand a key with the selected backend
+*/
+
+void
+  osdp_cipher_expand
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *key)
+
+{ /* osdp_cipher_expand */
+
+  if (osdp_cipher_current EQUALS OSDP_CIPHER_AUTO)
+    (void)osdp_cipher_select (NULL);
+  schedule->cipher = osdp_cipher_current;
+  (*(osdp_ciphers [schedule->cipher].expand)) (schedule, key);
+  memcpy (schedule->key, key, OSDP_KEY_OCTETS);
+  schedule->valid = 1;
+
+} /* osdp_cipher_expand */
+
+
+/*
+  osdp_cipher_kat - run the known answer tests on a backend
+*/
+
+int
+  osdp_cipher_kat
+    (int cipher)
+
+{ /* osdp_cipher_kat */
+
+  unsigned char buffer [64];
+  int i;
+  unsigned char mac [OSDP_KEY_OCTETS];
+  OSDP_KEY_SCHEDULE schedule;
+  int status;
+  OSDP_CIPHER_KAT_VECTOR *v;
+
+
+  status = ST_OK;
+  if ((cipher < 0) || (cipher >= OSDP_CIPHER_BACKENDS))
+    status = ST_OSDP_CIPHER_KAT;
+  if (status EQUALS ST_OK)
+    if (!(*(osdp_ciphers [cipher].available)) ())
+      status = ST_OSDP_CIPHER_KAT;
+  for (i=0; (status EQUALS ST_OK) &&
+    (i < sizeof (osdp_cipher_kat_vectors)/sizeof (osdp_cipher_kat_vectors [0]));
+    i++)
+  {
+    v = &(osdp_cipher_kat_vectors [i]);
+    memset (&schedule, 0, sizeof (schedule));
+    schedule.cipher = cipher;
+    (*(osdp_ciphers [cipher].expand)) (&schedule, (unsigned char *)(v->key));
+    memcpy (buffer, v->in, v->length);
+    switch (v->operation)
+    {
+    case OSDP_CIPHER_KAT_ENCRYPT:
+      osdp_cipher_cbc_encrypt (&schedule, (unsigned char *)(v->iv),
+        buffer, v->length);
+      if (0 != memcmp (buffer, v->out, v->length))
+        status = ST_OSDP_CIPHER_KAT;
+
+      // and back again
+
+      osdp_cipher_cbc_decrypt (&schedule, (unsigned char *)(v->iv),
+        buffer, v->length);
+      if (0 != memcmp (buffer, v->in, v->length))
+        status = ST_OSDP_CIPHER_KAT;
+      break;
+    case OSDP_CIPHER_KAT_DECRYPT:
+      osdp_cipher_cbc_decrypt (&schedule, (unsigned char *)(v->iv),
+        buffer, v->length);
+      if (0 != memcmp (buffer, v->out, v->length))
+        status = ST_OSDP_CIPHER_KAT;
+      break;
+    case OSDP_CIPHER_KAT_MAC:
+      osdp_cipher_cbc_mac (&schedule, (unsigned char *)(v->iv),
+        buffer, v->length, mac);
+      if ((0 != memcmp (mac, v->out, OSDP_KEY_OCTETS)) ||
+        (0 != memcmp (buffer, v->in, v->length)))
+        status = ST_OSDP_CIPHER_KAT;
+      break;
+    };
+  };
+  return (status);
+
+} /* osdp_cipher_kat */
+
+
+char
+  *osdp_cipher_name
+    (void)
+
+{ /* osdp_cipher_name */
+
+  if (osdp_cipher_current EQUALS OSDP_CIPHER_AUTO)
+    (void)osdp_cipher_select (NULL);
+  return (osdp_ciphers [osdp_cipher_current].name);
+
+} /* osdp_cipher_name */
+
+
+/*
+  osdp_cipher_select - pick the backend ("cipher"; with ctx NULL, "auto")
+*/
+
+int
+  osdp_cipher_select
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_cipher_select */
+
+  int cipher;
+  int requested;
+  int status;
+
+
+  requested = OSDP_CIPHER_AUTO;
+  if (ctx != NULL)
+    requested = ctx->cipher;
+  cipher = OSDP_CIPHER_SOFTWARE;
+  if ((requested EQUALS OSDP_CIPHER_AUTO) || (requested EQUALS OSDP_CIPHER_AESNI))
+  {
+    if ((*(osdp_ciphers [OSDP_CIPHER_AESNI].available)) ())
+      cipher = OSDP_CIPHER_AESNI;
+    else
+      if ((ctx != NULL) && (requested EQUALS OSDP_CIPHER_AESNI))
+        fprintf (ctx->log, "Cipher aes-ni is not available on this processor\n");
+  };
+  status = osdp_cipher_kat (cipher);
+  if ((status != ST_OK) && (cipher != OSDP_CIPHER_SOFTWARE))
+  {
+    if (ctx != NULL)
+      fprintf (ctx->log, "Cipher %s failed the known answer tests\n",
+        osdp_ciphers [cipher].name);
+    cipher = OSDP_CIPHER_SOFTWARE;
+    status = osdp_cipher_kat (cipher);
+  };
+  osdp_cipher_current = cipher;
+  if (ctx != NULL)
+    fprintf (ctx->log, "Cipher %s%s\n", osdp_ciphers [cipher].name,
+      (status EQUALS ST_OK) ? "" : " (failed the known answer tests)");
+  return (status);
+
+} /* osdp_cipher_select */
+
+
+/*
+  the software backend, tiny-AES
+*/
+
+int
+  osdp_cipher_software_available
+    (void)
+
+{ /* osdp_cipher_software_available */
+
+  return (1);
+
+} /* osdp_cipher_software_available */
+
+
+void
+  osdp_cipher_software_cbc_decrypt
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length)
+
+{ /* osdp_cipher_software_cbc_decrypt */
+
+  struct AES_ctx *aes_context;
+
+
+  aes_context = (struct AES_ctx *)(schedule->aes);
+  AES_ctx_set_iv (aes_context, iv);
+  AES_CBC_decrypt_buffer (aes_context, buffer, length);
+
+} /* osdp_cipher_software_cbc_decrypt */
+
+
+void
+  osdp_cipher_software_cbc_encrypt
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length)
+
+{ /* osdp_cipher_software_cbc_encrypt */
+
+  struct AES_ctx *aes_context;
+
+
+  aes_context = (struct AES_ctx *)(schedule->aes);
+  AES_ctx_set_iv (aes_context, iv);
+  AES_CBC_encrypt_buffer (aes_context, buffer, length);
+
+} /* osdp_cipher_software_cbc_encrypt */
+
+
+void
+  osdp_cipher_software_cbc_mac
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length,
+    unsigned char *mac)
+
+{ /* osdp_cipher_software_cbc_mac */
+
+  unsigned char block [OSDP_KEY_OCTETS];
+  int i;
+  int offset;
+
+
+  // whole blocks only, as aes-ni does; a partial one at the end is ignored
+
+  memcpy (block, iv, OSDP_KEY_OCTETS);
+  for (offset=0; offset+OSDP_KEY_OCTETS <= length;
+    offset=offset+OSDP_KEY_OCTETS)
+  {
+    for (i=0; i<OSDP_KEY_OCTETS; i++)
+      block [i] = block [i] ^ buffer [offset+i];
+    AES_ECB_encrypt ((struct AES_ctx *)(schedule->aes), block);
+  };
+  memcpy (mac, block, OSDP_KEY_OCTETS);
+
+} /* osdp_cipher_software_cbc_mac */
+
+
+void
+  osdp_cipher_software_expand
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *key)
+
+{ /* osdp_cipher_software_expand */
+
+  AES_init_ctx ((struct AES_ctx *)(schedule->aes), key);
+
+} /* osdp_cipher_software_expand */
+
+
+/*
+  the AES-NI backend.  the schedule is the 11 encryption round keys then
+  the 11 decryption (inverse mix columns) round keys.  the functions are
+  compiled for AES-NI whatever the build flags, and only called when
+  CPUID says the processor has it.
+*/
+
+#ifdef OSDP_CIPHER_HAS_AESNI
+
+#define OSDP_AESNI __attribute__ ((target ("aes,sse2")))
+
+#define OSDP_AESNI_EXPAND(i, rcon) \
+  rk [i] = osdp_cipher_aesni_expand_step (rk [i-1], \
+    _mm_aeskeygenassist_si128 (rk [i-1], rcon))
+
+
+static inline OSDP_AESNI __m128i
+  osdp_cipher_aesni_expand_step
+    (__m128i key,
+    __m128i assist)
+
+{ /* osdp_cipher_aesni_expand_step */
+
+  assist = _mm_shuffle_epi32 (assist, 0xff);
+  key = _mm_xor_si128 (key, _mm_slli_si128 (key, 4));
+  key = _mm_xor_si128 (key, _mm_slli_si128 (key, 4));
+  key = _mm_xor_si128 (key, _mm_slli_si128 (key, 4));
+  return (_mm_xor_si128 (key, assist));
+
+} /* osdp_cipher_aesni_expand_step */
+
+
+static inline OSDP_AESNI __m128i
+  osdp_cipher_aesni_encrypt_block
+    (__m128i *rk,
+    __m128i block)
+
+{ /* osdp_cipher_aesni_encrypt_block */
+
+  int round;
+
+
+  block = _mm_xor_si128 (block, rk [0]);
+  for (round=1; round<10; round++)
+    block = _mm_aesenc_si128 (block, rk [round]);
+  return (_mm_aesenclast_si128 (block, rk [10]));
+
+} /* osdp_cipher_aesni_encrypt_block */
+
+
+int
+  osdp_cipher_aesni_available
+    (void)
+
+{ /* osdp_cipher_aesni_available */
+
+  int available;
+  unsigned int eax;
+  unsigned int ebx;
+  unsigned int ecx;
+  unsigned int edx;
+
+
+  available = 0;
+  if (__get_cpuid (1, &eax, &ebx, &ecx, &edx))
+    if (ecx & bit_AES)
+      available = 1;
+  return (available);
+
+} /* osdp_cipher_aesni_available */
+
+
+/*
+  decryption is four blocks at a time, as each block's decryption only
+  needs the ciphertext
+*/
+
+OSDP_AESNI void
+  osdp_cipher_aesni_cbc_decrypt
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length)
+
+{ /* osdp_cipher_aesni_cbc_decrypt */
+
+  __m128i b [4];
+  __m128i c [4];
+  __m128i dk [11];
+  int i;
+  int offset;
+  __m128i previous;
+  int round;
+
+
+  for (i=0; i<11; i++)
+    dk [i] = _mm_loadu_si128 ((__m128i *)(schedule->aes + (11+i)*16));
+  previous = _mm_loadu_si128 ((__m128i *)iv);
+  offset = 0;
+  for (; offset+4*16 <= length; offset=offset+4*16)
+  {
+    for (i=0; i<4; i++)
+    {
+      c [i] = _mm_loadu_si128 ((__m128i *)(buffer + offset + i*16));
+      b [i] = _mm_xor_si128 (c [i], dk [0]);
+    };
+    for (round=1; round<10; round++)
+      for (i=0; i<4; i++)
+        b [i] = _mm_aesdec_si128 (b [i], dk [round]);
+    for (i=0; i<4; i++)
+    {
+      b [i] = _mm_aesdeclast_si128 (b [i], dk [10]);
+      b [i] = _mm_xor_si128 (b [i], (i EQUALS 0) ? previous : c [i-1]);
+      _mm_storeu_si128 ((__m128i *)(buffer + offset + i*16), b [i]);
+    };
+    previous = c [3];
+  };
+  for (; offset+16 <= length; offset=offset+16)
+  {
+    c [0] = _mm_loadu_si128 ((__m128i *)(buffer + offset));
+    b [0] = _mm_xor_si128 (c [0], dk [0]);
+    for (round=1; round<10; round++)
+      b [0] = _mm_aesdec_si128 (b [0], dk [round]);
+    b [0] = _mm_xor_si128 (_mm_aesdeclast_si128 (b [0], dk [10]), previous);
+    _mm_storeu_si128 ((__m128i *)(buffer + offset), b [0]);
+    previous = c [0];
+  };
+
+} /* osdp_cipher_aesni_cbc_decrypt */
+
+
+OSDP_AESNI void
+  osdp_cipher_aesni_cbc_encrypt
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length)
+
+{ /* osdp_cipher_aesni_cbc_encrypt */
+
+  __m128i block;
+  int i;
+  int offset;
+  __m128i rk [11];
+
+
+  for (i=0; i<11; i++)
+    rk [i] = _mm_loadu_si128 ((__m128i *)(schedule->aes + i*16));
+  block = _mm_loadu_si128 ((__m128i *)iv);
+  for (offset=0; offset+16 <= length; offset=offset+16)
+  {
+    block = _mm_xor_si128 (block,
+      _mm_loadu_si128 ((__m128i *)(buffer + offset)));
+    block = osdp_cipher_aesni_encrypt_block (rk, block);
+    _mm_storeu_si128 ((__m128i *)(buffer + offset), block);
+  };
+
+} /* osdp_cipher_aesni_cbc_encrypt */
+
+
+OSDP_AESNI void
+  osdp_cipher_aesni_cbc_mac
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *iv,
+    unsigned char *buffer,
+    int length,
+    unsigned char *mac)
+
+{ /* osdp_cipher_aesni_cbc_mac */
+
+  __m128i block;
+  int i;
+  int offset;
+  __m128i rk [11];
+
+
+  for (i=0; i<11; i++)
+    rk [i] = _mm_loadu_si128 ((__m128i *)(schedule->aes + i*16));
+  block = _mm_loadu_si128 ((__m128i *)iv);
+  for (offset=0; offset+16 <= length; offset=offset+16)
+  {
+    block = _mm_xor_si128 (block,
+      _mm_loadu_si128 ((__m128i *)(buffer + offset)));
+    block = osdp_cipher_aesni_encrypt_block (rk, block);
+  };
+  _mm_storeu_si128 ((__m128i *)mac, block);
+
+} /* osdp_cipher_aesni_cbc_mac */
+
+
+OSDP_AESNI void
+  osdp_cipher_aesni_expand
+    (OSDP_KEY_SCHEDULE *schedule,
+    unsigned char *key)
+
+{ /* osdp_cipher_aesni_expand */
+
+  int i;
+  __m128i rk [11];
+
+
+  rk [0] = _mm_loadu_si128 ((__m128i *)key);
+  OSDP_AESNI_EXPAND (1, 0x01);
+  OSDP_AESNI_EXPAND (2, 0x02);
+  OSDP_AESNI_EXPAND (3, 0x04);
+  OSDP_AESNI_EXPAND (4, 0x08);
+  OSDP_AESNI_EXPAND (5, 0x10);
+  OSDP_AESNI_EXPAND (6, 0x20);
+  OSDP_AESNI_EXPAND (7, 0x40);
+  OSDP_AESNI_EXPAND (8, 0x80);
+  OSDP_AESNI_EXPAND (9, 0x1b);
+  OSDP_AESNI_EXPAND (10, 0x36);
+  for (i=0; i<11; i++)
+    _mm_storeu_si128 ((__m128i *)(schedule->aes + i*16), rk [i]);
+
+  // decryption uses them last to first, inner ones through InvMixColumns
+
+  _mm_storeu_si128 ((__m128i *)(schedule->aes + 11*16), rk [10]);
+  for (i=1; i<10; i++)
+    _mm_storeu_si128 ((__m128i *)(schedule->aes + (11+i)*16),
+      _mm_aesimc_si128 (rk [10-i]));
+  _mm_storeu_si128 ((__m128i *)(schedule->aes + 21*16), rk [0]);
+
+} /* osdp_cipher_aesni_expand */
+
+#else
+
+// not x86: never available, so never called
+
+int osdp_cipher_aesni_available (void) { return (0); }
+void osdp_cipher_aesni_cbc_decrypt (OSDP_KEY_SCHEDULE *schedule,
+  unsigned char *iv, unsigned char *buffer, int length) { }
+void osdp_cipher_aesni_cbc_encrypt (OSDP_KEY_SCHEDULE *schedule,
+  unsigned char *iv, unsigned char *buffer, int length) { }
+void osdp_cipher_aesni_cbc_mac (OSDP_KEY_SCHEDULE *schedule,
+  unsigned char *iv, unsigned char *buffer, int length, unsigned char *mac) { }
+void osdp_cipher_aesni_expand (OSDP_KEY_SCHEDULE *schedule,
+  unsigned char *key) { }
+
+#endif
+
@@ -17,9 +17,18 @@
   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
   See the License for the specific language governing permissions and
   limitations under the License.
+
+  Each command is an entry in osdp_command_registry (at the end): its
+  name, the OSDP_CMDB_ code, its parameters and, if they are not the
+  whole story, an osdp_breech_ function run after they are filled in.
+  Those marked OSDP_CMDREG_QUEUE are queued, the rest are processed as
+  soon as they are read.
 */
 
 
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 
@@ -34,6 +43,13 @@
 extern OSDP_OUT_CMD current_output_command [];
 extern OSDP_PARAMETERS p_card; 
 
+/*
+  read_command - read the command file and parse it
+
+  the file is the original command breech: a script writes it and pokes
+  the control socket.
+*/
+
 int
   read_command
     (OSDP_CONTEXT *ctx,
@@ -41,27 +57,10 @@ int
 
 { /* read_command */
 
-  unsigned short buffer_length;
   FILE *cmdf;
-  char command [1024];
-  char current_command [1024];
-  char current_options [1024];
-  int i;
   char json_string [16384];
-  OSDP_MFG_ARGS *mfg_args;
-  json_t *parameter;
-  json_t *root;
-  int set_led_temp;
-  json_error_t status_json;
   int status;
   int status_io;
-  unsigned char temp_buffer [6];
-  unsigned short int temp_buffer_length;
-  char *test_command;
-  char this_command [1024];
-  json_t *value;
-  json_t *value2;
-  char vstr [1024];
 
 
   status = ST_CMD_PATH;
@@ -76,1088 +75,788 @@ int
       status = ST_CMD_OVERFLOW;
     if (status_io <= 0)
       status = ST_CMD_UNDERFLOW;
+    fclose (cmdf);
   };
   if (status EQUALS ST_OK)
-  {
-    root = json_loads (json_string, 0, &status_json);
-    if (!root)
-    {
-      fprintf (stderr, "JSON parser failed.  String was ->\n%s<-\n",
-        json_string);
-      status = ST_CMD_ERROR;
-    };
-  };
-  if (status EQUALS ST_OK)
-  {
-    status = osdp_command_match(ctx, root, current_command, &(cmd->command));
-    if (ctx->verbosity > 3)
-      fprintf (stderr, "command was %s\n", current_command);
-  };
-  switch (cmd->command)
-  {
-  // command bio_read send bio read template command
+    status = osdp_command_parse (ctx, json_string, cmd);
+  if (status != ST_OK)
+    fprintf(stderr, "Status %d at read_command.\n", status);
+  return (status);
 
-  case OSDP_CMDB_BIOREAD:
-    cmd->command = OSDP_CMD_BIOREAD;
-    break;
+} /* read_command */
 
-  case OSDP_CMDB_BIOMATCH:
-    cmd->command = OSDP_CMD_BIOMATCH;
-    status = ST_OK;
-    break;
 
-  case OSDP_CMDB_FACTORY_DEFAULT:
-    fprintf(ctx->log, "***RESET TO FACTORY DEFAULT***\n");
-    sprintf(command, "rm -f %s", OSDP_SAVED_PARAMETERS);
-    system(command);
-    status = ST_OK;
-    break;
+/*
+  osdp_command_parse - set up a command from its JSON
+
+  commands that go through the queue are queued here and cmd is left a
+  no-op; the rest are left in cmd for process_command.  A queued command
+  may name the serial port ("port" : "1", in the order of serial-ports)
+  and the PD on its multi-drop bus ("pd-address" : "2") it is for, else
+  it goes to whichever port and PD's turn it is when it comes off the
+  queue.
+*/
 
-  case OSDP_CMDB_NOOP:
-    // command parser no-op so OK command no-op
-    cmd->command = OSDP_CMD_NOOP;
-    status = ST_OK;
-    break;
+int
+  osdp_command_parse
+    (OSDP_CONTEXT *ctx,
+    char *json_string,
+    OSDP_COMMAND *cmd)
 
-  // getpiv object-id=zzzzzz offset=0000 data-element=qq
+{ /* osdp_command_parse */
 
-  case OSDP_CMDB_PIVDATA:
-    cmd->command = OSDP_CMDB_PIVDATA;
+  OSDP_BUS *bus;
+  char current_command [1024];
+  OSDP_COMMAND_REGISTRY *entry;
+  json_t *root;
+  json_error_t status_json;
+  int status;
+  json_t *value;
 
-    // details:
-    // first 3 octets are the object id
-    // fourth octet is the data element
-    // fifth element is 2 bytes, offset into data element.
 
-    parameter = json_object_get(root, "object-id");
-    if (json_is_string(parameter))
-    {
-      strcpy(vstr, json_string_value(parameter));
-      temp_buffer_length = sizeof(temp_buffer);
-      status = osdp_string_to_buffer(ctx, vstr, temp_buffer, &temp_buffer_length);
-      memcpy(cmd->details, temp_buffer, 3); // it's the 3-byte oid
-    };
-    parameter = json_object_get(root, "data-element");
-    if (json_is_string(parameter))
-    {
-      strcpy (vstr, json_string_value (parameter));
-      sscanf (vstr, "%x", &i);
-      cmd->details [3] = i;
-    };
-    parameter = json_object_get(root, "offset");
-    if (json_is_string(parameter))
+  status = ST_OK;
+  entry = NULL;
+  cmd->pd_address = -1;
+  cmd->port = -1;
+  root = json_loads (json_string, 0, &status_json);
+  if (!root)
+  {
+    fprintf (stderr, "JSON parser failed.  String was ->\n%s<-\n",
+      json_string);
+    status = ST_CMD_ERROR;
+  };
+  if (status EQUALS ST_OK)
+  {
+    status = osdp_command_match (ctx, root, current_command, &(cmd->command));
+    if (status EQUALS ST_CMD_UNKNOWN)
+      fprintf (ctx->log, "Command %s unknown.\n", current_command);
+  };
+  if (status EQUALS ST_OK)
+  {
+    fprintf (ctx->log, "Command %s received.\n", current_command);
+    entry = osdp_command_lookup (current_command);
+    status = osdp_command_params (ctx, entry, root, cmd);
+  };
+  if ((status EQUALS ST_OK) && (entry->parse != NULL))
+    status = (*(entry->parse)) (ctx, root, cmd);
+  bus = osdp_bus (ctx);
+  if (status EQUALS ST_OK)
+  {
+    value = json_object_get (root, "port");
+    if (value != NULL)
     {
-      strcpy(vstr, json_string_value(parameter));
-      temp_buffer_length = sizeof(temp_buffer);
-      status = osdp_string_to_buffer(ctx, vstr, temp_buffer, &temp_buffer_length);
-      memcpy((cmd->details)+4, temp_buffer, 2);
+      if (!json_is_string (value) ||
+        (1 != sscanf (json_string_value (value), "%d", &(cmd->port))))
+        status = ST_CMD_INVALID;
+      if ((status EQUALS ST_OK) &&
+        ((cmd->port < 0) || (cmd->port >= ctx->port_count)))
+        status = ST_PORT_BAD_INDEX;
+      if (status EQUALS ST_OK)
+        bus = ctx->port [cmd->port].bus;
+      if (status != ST_OK)
+        fprintf (ctx->log, "Command %s: bad port\n", current_command);
     };
-    if (status EQUALS ST_OK)
+  };
+  if (status EQUALS ST_OK)
+  {
+    value = json_object_get (root, "pd-address");
+    if (value != NULL)
     {
-      status = enqueue_command(ctx, cmd);
-      cmd->command = OSDP_CMD_NOOP;
+      if (!json_is_string (value) ||
+        (1 != sscanf (json_string_value (value), "%d", &(cmd->pd_address))))
+        status = ST_CMD_INVALID;
+      if ((status EQUALS ST_OK) && ((cmd->pd_address < 0) ||
+        (cmd->pd_address >= OSDP_BUS_MAX_PD) ||
+        ((bus->count > 0) && !(bus->session [cmd->pd_address].configured))))
+        status = ST_BUS_BAD_ADDRESS;
+      if (status != ST_OK)
+        fprintf (ctx->log, "Command %s: bad pd-address\n", current_command);
     };
-    break;
+  };
+  if ((status EQUALS ST_OK) && (entry->flags & OSDP_CMDREG_QUEUE) &&
+    (cmd->command != OSDP_CMD_NOOP))
+  {
+    status = enqueue_command (ctx, cmd);
+    cmd->command = OSDP_CMD_NOOP;
+  };
+  if (status != ST_OK)
+    cmd->command = OSDP_CMD_NOOP;
 
-  // "polling" toggles polling enabled and sets sequence to 0
-  // polling action=reset always sends seq 0
-  // polling action=resume resumes sequence numbers after next message goes out the door
+  if (root != NULL)
+    json_decref (root);
+  return (status);
 
-  case OSDP_CMDB_POLLING:
-    {
-      parameter = json_object_get(root, "action");
-      if (json_is_string(parameter))
-      {
-        if (0 EQUALS strcmp("reset", json_string_value(parameter)))
-        {
-          fprintf(ctx->log, "Polling: resetting sequence number to 0\n");
-          ctx->next_sequence = 0;
-          ctx->enable_poll = OO_POLL_ENABLED;
-        };
-        if (0 EQUALS strcmp("resume", json_string_value(parameter)))
-        {
-          fprintf(ctx->log, "Polling: resuming sequence numbering\n");
-          ctx->enable_poll = OO_POLL_RESUME;
-        };
-      }
-      else
-      {
-        // toggle it (used to be just 1 and 0)
+} /* osdp_command_parse */
 
-        if (ctx->enable_poll EQUALS OO_POLL_ENABLED)
-          ctx->enable_poll = OO_POLL_NEVER;
-        else
-          ctx->enable_poll = OO_POLL_ENABLED;
 
-        ctx->next_sequence = 0;
-        fprintf(ctx->log, "enable_polling now %x, sequence reset to 0\n", ctx->enable_poll);
-      };
+// bio-match is not done (process_command would exit) so it stays unknown
 
-      cmd->command = OSDP_CMD_NOOP;
-    };
-    break;
+int
+  osdp_breech_bio_match
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-  // command reset - reset "link" i.e. sequence number
+{ /* osdp_breech_bio_match */
 
-  case OSDP_CMDB_RESET:
-    ctx->next_sequence = 0;
-    cmd->command = OSDP_CMD_NOOP;
-    break;
+  cmd->command = OSDP_CMD_BIOMATCH;
+  return (ST_OK);
 
-  case OSDP_CMDB_TRACE:
-    ctx->trace = 1 ^ ctx->trace; // toggle low order bit
-    fprintf(ctx->log, "Tracing set to %d\n", ctx->trace);
-    cmd->command = OSDP_CMD_NOOP;
-    break;
+} /* osdp_breech_bio_match */
 
-  default:
-    if (ctx->verbosity > 3)
-      fprintf(stderr, "command not processed in switch (%d.)\n", cmd->command);
-    status = ST_OK; // ok to proceed with old way
-    break;
-  };
-  value = json_object_get (root, "command");
-  if (!json_is_string (value)) status = ST_CMD_INVALID;
-  if (status EQUALS ST_OK)
-  {
-    strcpy (current_command, json_string_value (value));
 
-    fprintf(ctx->log, "Command %s received.\n", current_command);
-  };
+int
+  osdp_breech_comset
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-  // command acurxsize.  Sends the proper value (as the ACU)
+{ /* osdp_breech_comset */
 
-  if (status EQUALS ST_OK)
-  {
-    if (0 EQUALS strcmp(current_command, "acurxsize"))
-    {
-      cmd->command = OSDP_CMDB_ACURXSIZE;
-    };
-  };
+  int speed;
 
-  // command busy
 
-  if (status EQUALS ST_OK)
-  {
-    if (0 EQUALS strcmp (current_command, "busy"))
-    {
-      cmd->command = OSDP_CMDB_BUSY;
-    };
-  };
+  memcpy (&speed, cmd->details+4, sizeof (speed));
+  if (ctx->verbosity > 2)
+    fprintf (stderr, "Command COMSET Address %d Speed %d\n",
+      (int) (cmd->details [0]), speed);
+  return (ST_OK);
 
-  // command buzz
+} /* osdp_breech_comset */
 
-  if (status EQUALS ST_OK)
-  {
-    if (0 EQUALS strcmp (current_command, "buzz"))
-    {
-      cmd->command = OSDP_CMDB_BUZZ;
 
-      // set default on, off, repeat timers
+int
+  osdp_breech_conform_2_6_1
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-      cmd->details [0] = 15;
-      cmd->details [1] = 15;
-      cmd->details [2] = 3;
+{ /* osdp_breech_conform_2_6_1 */
 
-      // also use off_time if it's present
+  strcpy (ctx->text,
+" ***OSDP CONFORMANCE TEST*** 45678901234567890123456789012345678901234567890123456789012345678901234567890");
+  return (ST_OK);
 
-      parameter = json_object_get (root, "off_time");
-      if (json_is_string (parameter))
-      {
-        strcpy (vstr, json_string_value (parameter));
-        sscanf (vstr, "%d", &i);
-        cmd->details [1] = i;
-      };
+} /* osdp_breech_conform_2_6_1 */
 
-      // also use on_time if it's present
 
-      parameter = json_object_get (root, "on_time");
-      if (json_is_string (parameter))
-      {
-        strcpy (vstr, json_string_value (parameter));
-        sscanf (vstr, "%d", &i);
-        cmd->details [0] = i;
-      };
+// conform_3_14_2 - corrupted COMSET, sent from here
 
-      // also use repeat if it's present
+int
+  osdp_breech_conform_3_14_2
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-      parameter = json_object_get (root, "repeat");
-      if (json_is_string (parameter))
-      {
-        strcpy (vstr, json_string_value (parameter));
-        sscanf (vstr, "%d", &i);
-        cmd->details [2] = i;
-      };
-    };
-  }; 
+{ /* osdp_breech_conform_3_14_2 */
 
-  // command capabilities
+  cmd->command = OSDP_CMD_NOOP;
+  return (send_comset (ctx, p_card.addr, 0, "999999"));
 
-  if (status EQUALS ST_OK)
-  {
-    if (0 EQUALS strcmp (current_command, "capabilities"))
-    {
-      cmd->command = OSDP_CMDB_CAPAS;
-    };
-  }; 
+} /* osdp_breech_conform_3_14_2 */
 
-  // COMSET.  takes two option arguments, "new_address" and "new_speed".
-  // default for new_address is 0x00, default for new_speed is 9600
 
-  if (status EQUALS ST_OK)
-  {
+int
+  osdp_breech_factory_default
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-    if (0 EQUALS strcmp (current_command, "comset"))
-    {
-      cmd->command = OSDP_CMDB_COMSET;
+{ /* osdp_breech_factory_default */
 
-      value = json_object_get (root, "new_address");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        cmd->details [0] = i;
-      };
-      value = json_object_get (root, "new_speed");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        *(int *) &(cmd->details [4]) = i; // by convention bytes 4,5,6,7 are the speed.
-      };
-      if (ctx->verbosity > 2)
-        fprintf (stderr, "Command COMSET Address %d Speed %d\n",
-          (int) (cmd->details [0]),
-          *(int *) &(cmd->details [4]));
-    };
-  }; 
+  char command [1024];
 
-  // command conform_2_2_1
 
-  if (status EQUALS ST_OK) {
-    if (0 EQUALS strcmp (current_command, "conform_2_2_1")) {
-      cmd->command = OSDP_CMDB_CONFORM_2_2_1; }; };
+  fprintf(ctx->log, "***RESET TO FACTORY DEFAULT***\n");
+  sprintf(command, "rm -f %s", OSDP_SAVED_PARAMETERS);
+  system(command);
+  cmd->command = OSDP_CMD_NOOP;
+  return (ST_OK);
 
-  // command conform_2_2_2
+} /* osdp_breech_factory_default */
 
-  if (status EQUALS ST_OK) {
-    if (0 EQUALS strcmp (current_command, "conform_2_2_2")) {
-      cmd->command = OSDP_CMDB_CONFORM_2_2_2; }; };
 
-  // command conform_2_2_3
+/*
+  command "genauth"
+
+  example:
+    "command" : "genauth"
+    "template" : "witness" or "challenge" or "060-24-02" 0r "060-25-02"
+    "keyref" : "9E" 
+      (or "9e" meaning card auth key - SP800-73-4 Part 1 Page 19 Table 4b.)
+    "algoref" : "07"
+      (07 is RSA; or 11 for ECC P-256 or 14 for ECC curve P-384 per
+      SP800-78-4 Table 6-2 page 12)
+    "payload" : "(hex bytes)" (which should be a well-formed Dynamic Authentication Template)
+
+  details [0] is algoref, [1] keyref (from the registry), [2-n] the payload.
+*/
 
-  if (status EQUALS ST_OK) {
-    if (0 EQUALS strcmp (current_command, "conform_2_2_3")) {
-      cmd->command = OSDP_CMDB_CONFORM_2_2_3; }; };
+int
+  osdp_breech_genauth
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-  // command conform_2_2_4
+{ /* osdp_breech_genauth */
 
-  if (status EQUALS ST_OK) {
-    if (0 EQUALS strcmp (current_command, "conform_2_2_4")) {
-      cmd->command = OSDP_CMDB_CONFORM_2_2_4; }; };
+  unsigned short int lth;
+  int status;
+  json_t *value;
 
-  // command conform_2_6_1
 
-  if (status EQUALS ST_OK)
+  status = ST_OK;
+  value = json_object_get (root, "template");
+  if (json_is_string (value))
   {
-    if (0 EQUALS strcmp (current_command, "conform_2_6_1"))
-    {
-      cmd->command = OSDP_CMDB_CONFORM_2_6_1;
-      strcpy (ctx->text,
-" ***OSDP CONFORMANCE TEST*** 45678901234567890123456789012345678901234567890123456789012345678901234567890");
-    };
+    if (0 EQUALS strcmp("060-24-02", json_string_value (value)))
+      cmd->command = OSDP_CMDB_CONFORM_060_24_02; // challenge-after-raw
+    if (0 EQUALS strcmp("060-25-02", json_string_value (value)))
+      cmd->command = OSDP_CMDB_CONFORM_060_25_02; // witness-after-raw
+    if (0 EQUALS strcmp("challenge", json_string_value (value)))
+      cmd->command = OSDP_CMDB_CHALLENGE;
   };
 
-  // command conform_2_11_3 - send an ID on the all-stations PD address
+  // only RSA so far
 
-  if (status EQUALS ST_OK)
+  value = json_object_get (root, "algoref");
+  if (json_is_string (value))
+    if (0 EQUALS strcmp("07", json_string_value (value)))
+      cmd->details [0] = 0x07;
+
+  value = json_object_get (root, "payload");
+  if (json_is_string (value))
   {
-    if (0 EQUALS strcmp (current_command, "conform_2_11_3"))
+    lth = sizeof(cmd->details) - 2;
+    if (strlen (json_string_value (value)) > 2*lth)
+      status = ST_CMD_OVERFLOW;
+    else
     {
-      cmd->command = OSDP_CMDB_CONFORM_2_11_3;
+      status = osdp_string_to_buffer(ctx, (char *)json_string_value(value), cmd->details+2,  &lth);
+      cmd->details_length = 2+lth; //algoref, keyref, payload
     };
   };
+  return (status);
 
+} /* osdp_breech_genauth */
 
-  // command conform_3_14_2 - corrupted COMSET
 
-  if (status EQUALS ST_OK)
-  {
-    if (0 EQUALS strcmp (current_command, "conform_3_14_2"))
-    {
-      cmd->command = OSDP_CMD_NOOP; // nothing other than what's here so no-op
+int
+  osdp_breech_init_secure
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-      status = send_comset (ctx, p_card.addr, 0, "999999");
-    };
+{ /* osdp_breech_init_secure */
+
+  json_t *parameter;
+
+
+  cmd->details_param_1 = 0;
+  parameter = json_object_get(root, "key-slot");
+  if (json_is_string (parameter))
+  {
+    if (0 EQUALS strcmp("1", json_string_value(parameter)))
+      cmd->details_param_1 = 1;
   };
+  if (ctx->verbosity > 3)
+    fprintf(ctx->log, "Enqueue: initiate-secure-channel %d\n",
+      cmd->details_param_1);
+  return (ST_OK);
 
-  // command conform_2-14-3: rogue secure poll
+} /* osdp_breech_init_secure */
 
-  if (status EQUALS ST_OK) {
-    if (0 EQUALS strcmp (current_command, "conform_2_14_3")) {
-      cmd->command = OSDP_CMDB_CONFORM_2_14_3; }; };
 
-  // command conform_3_20_1 - MFG
+/*
+  osdp_breech_led - temp-control follows from the other temp values
 
-  if (status EQUALS ST_OK) {
-    if (0 EQUALS strcmp (current_command, "conform_3_20_1")) {
-      cmd->command = OSDP_CMDB_CONFORM_3_20_1; }; };
+  any temp value set (non-zero) means a temporary setting, unless
+  "temp-control" says otherwise.
+*/
 
-  // command induce-NAK
+int
+  osdp_breech_led
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-  if (status EQUALS ST_OK) {
-    if (0 EQUALS strcmp (current_command, "induce-NAK")) {
-      cmd->command = OSDP_CMDB_INDUCE_NAK; }; };
+{ /* osdp_breech_led */
 
-  // command keep-active
-  // argument is time in milliseconds "milliseconds".  default is 7000;
+  OSDP_RDR_LED_CTL *led_ctl;
+  int set_led_temp;
 
-  if (status EQUALS ST_OK)
-  {
-    if (0 EQUALS strcmp (current_command, "keep-active"))
-    {
-      int i;
-      i = 7000;
-      cmd->command = OSDP_CMDB_KEEPACTIVE;
-      cmd->details [0] = (i & 0xff); // lsb
-      cmd->details [1] = (i/0x100); // msb
-      parameter = json_object_get (root, "milliseconds");
-      if (json_is_string (parameter))
-      {
-        strcpy (vstr, json_string_value (parameter));
-        sscanf (vstr, "%d", &i);
-        cmd->details [0] = (i & 0xff); // lsb
-        cmd->details [1] = (i/0x100); // msb
-      };
-    };
-  };
 
+  led_ctl = (OSDP_RDR_LED_CTL *)(cmd->details);
+  set_led_temp = 0;
+  if ((json_object_get (root, "temp-off-color") != NULL) && (led_ctl->temp_off_color > 0))
+    set_led_temp = 1;
+  if ((json_object_get (root, "temp-off-time") != NULL) && (led_ctl->temp_off > 0))
+    set_led_temp = 1;
+  if ((json_object_get (root, "temp-on-time") != NULL) && (led_ctl->temp_on > 0))
+    set_led_temp = 1;
+  if ((json_object_get (root, "temp-on-color") != NULL) && (led_ctl->temp_on_color > 0))
+    set_led_temp = 1;
+  if ((json_object_get (root, "temp-timer") != NULL) &&
+    ((led_ctl->temp_timer_lsb > 0) || (led_ctl->temp_timer_msb > 0)))
+    set_led_temp = 1;
+  if (json_object_get (root, "temp-control") != NULL)
+    set_led_temp = 0; // NOT the implied control
+  if (set_led_temp)
+    led_ctl->temp_control = OSDP_LED_TEMP_SET;
+  return (ST_OK);
+
+} /* osdp_breech_led */
 
-  // command MFG.  Arguments are OUI, command-id, command-specific-data.
-  // c-s-d is is 2-hexit bytes, length inferred.
 
-  if (status EQUALS ST_OK) {
-    if (0 EQUALS strcmp(current_command, "mfg")) {
-      cmd->command = OSDP_CMDB_MFG; 
-      mfg_args = (OSDP_MFG_ARGS *)(cmd->details);
-      memset(mfg_args, 0, sizeof (*mfg_args));
-      parameter = json_object_get(root, "command-id");
-      if (json_is_string(parameter))
-      {
-        int i;
-        sscanf(json_string_value(parameter), "%d", &i);
-        mfg_args->command_ID = i;
-      };
-      parameter = json_object_get(root, "command-specific-data");
-      if (json_is_string(parameter))
-      {
-        strcpy(mfg_args->c_s_d, json_string_value(parameter));
-      };
-      parameter = json_object_get(root, "oui");
-      if (json_is_string(parameter))
-      {
-        strcpy(mfg_args->oui, json_string_value(parameter));
-      };
-fprintf(stderr, "test: queuing MFG %d\n", cmd->command);
-status = enqueue_command(ctx, cmd);
-cmd->command = OSDP_CMD_NOOP;
-    };
-  };
+int
+  osdp_breech_operator_confirm
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-  // command text
+{ /* osdp_breech_operator_confirm */
 
-  if (status EQUALS ST_OK)
-  {
-    if (0 EQUALS strcmp (current_command, "text"))
-    {
-      char
-        field [1024];
-      json_t
-        *value;
-      strcpy (field, "message");
-      value = json_object_get (root, field);
-      if (json_is_string (value))
-      {
-        strcpy (ctx->text, json_string_value (value));
-        cmd->command = OSDP_CMDB_TEXT;
-      };
-    };
-  };
+  char current_options [1024];
+  int status;
+  json_t *value;
 
-  // command transfer
 
-  if (status EQUALS ST_OK)
+  status = ST_OK;
+  cmd->command = OSDP_CMD_NOOP; // nothing other than what's here so no-op
+  value = json_object_get (root, "test");
+  if (json_is_string (value))
   {
-    if (0 EQUALS strcmp (current_command, "transfer"))
-    {
-      cmd->command = OSDP_CMDB_TRANSFER;
-    };
-
-    // if there's a "file" argument use that
-    parameter = json_object_get (root, "file");
-    if (json_is_string (parameter))
-    {
-      strcpy ((char *)cmd->details, json_string_value (parameter));
-    };
-fprintf(stderr, "DEBUG: queuing TRANSFER %d\n", cmd->command);
-    status = enqueue_command(ctx, cmd);
-    cmd->command = OSDP_CMD_NOOP;
+    strncpy (current_options, json_string_value (value), sizeof (current_options)-1);
+    current_options [sizeof (current_options)-1] = 0;
+    status = osdp_conform_confirm (current_options);
   };
+  return (status);
 
-  // command dump_status
+} /* osdp_breech_operator_confirm */
 
-  if (status EQUALS ST_OK)
-  {
-    strcpy (this_command, json_string_value (value));
-    test_command = "dump_status";
-    if (0 EQUALS strncmp (this_command, test_command, strlen (test_command)))
-    {
-      cmd->command = OSDP_CMDB_DUMP_STATUS;
-      if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
-    };
-  }; 
-
-  /*
-    command "genauth"
-
-    example:
-      "command" : "genauth"
-      "template" : "witness" or "challenge" or "060-24-02" 0r "060-25-02"
-      "keyref" : "9E" 
-        (or "9e" meaning card auth key - SP800-73-4 Part 1 Page 19 Table 4b.)
-      "algoref" : "07"
-        (07 is RSA; or 11 for ECC P-256 or 14 for ECC curve P-384 per
-        SP800-78-4 Table 6-2 page 12)
-      "payload" : "(hex bytes)" (which should be a well-formed Dynamic Authentication Template)
-  */
-  if (status EQUALS ST_OK)
-  {
-    if (0 EQUALS strcmp (current_command, "genauth"))
-    {
-      if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
-      cmd->command = OSDP_CMDB_WITNESS;
-      value = json_object_get (root, "template");
-      if (json_is_string (value))
-      {
-        if (0 EQUALS strcmp("060-24-02", json_string_value (value)))
-        {
-          cmd->command = OSDP_CMDB_CONFORM_060_24_02; // challenge-after-raw
-        };
-        if (0 EQUALS strcmp("060-25-02", json_string_value (value)))
-        {
-          cmd->command = OSDP_CMDB_CONFORM_060_25_02; // witness-after-raw
-        };
-        if (0 EQUALS strcmp("challenge", json_string_value (value)))
-        {
-          cmd->command = OSDP_CMDB_CHALLENGE;
-        };
-      };
 
-      // details [0] is algoref
+// output - the registry put output number, control code and timer in details
 
-      value = json_object_get (root, "algoref");
-      status = ST_OSDP_BAD_GENAUTH_1;
-      if (json_is_string (value))
-      {
-        if (0 EQUALS strcmp("07", json_string_value (value)))
-        {
-          cmd->details [0] = 0x07;
-          status = ST_OK;
-        };
-      };
+int
+  osdp_breech_output
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-      // details [1] is keyref
+{ /* osdp_breech_output */
 
-      value = json_object_get (root, "keyref");
-      status = ST_OSDP_BAD_GENAUTH_2;
-      if (json_is_string (value))
-      {
-        int i;
+  memcpy (&(current_output_command [0]), cmd->details,
+    sizeof (current_output_command [0]));
+  if (ctx->verbosity > 3)
+    fprintf (ctx->log, "output %d control code %d timer %d\n",
+      current_output_command [0].output_number,
+      current_output_command [0].control_code,
+      current_output_command [0].timer);
+  return (ST_OK);
 
-        sscanf(json_string_value(value), "%x", &i);
-        cmd->details [1] = (unsigned char)i;
-        status = ST_OK;
-      };
+} /* osdp_breech_output */
 
-      // details [2-n] is genauth payload
-      // cmd->details_length = 2 + payload length
 
-      value = json_object_get (root, "payload");
-      status = ST_OSDP_BAD_GENAUTH_3;
-      if (json_is_string (value))
-      {
-        unsigned short int lth;
+/*
+  "polling" toggles polling enabled and sets sequence to 0
+  polling action=reset always sends seq 0
+  polling action=resume resumes sequence numbers after next message goes out the door
+*/
 
-        lth = sizeof(cmd->details) - 2;
-        status = osdp_string_to_buffer(ctx, (char *)json_string_value(value), cmd->details+2,  &lth);
-        cmd->details_length = 2+lth; //algoref, keyref, payload
-      };
+int
+  osdp_breech_polling
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-fprintf(stderr, "DEBUG: enqueue %d\n", cmd->command);
-      status = enqueue_command(ctx, cmd);
-      cmd->command = OSDP_CMD_NOOP;
-    };
-  };
+{ /* osdp_breech_polling */
 
-  // identify command - send an osdp_ID
+  json_t *parameter;
 
-  if (status EQUALS ST_OK)
+
+  parameter = json_object_get(root, "action");
+  if (json_is_string(parameter))
   {
-    strcpy (this_command, json_string_value (value));
-    test_command = "identify";
-    if (0 EQUALS strncmp (this_command, test_command, strlen (test_command)))
+    if (0 EQUALS strcmp("reset", json_string_value(parameter)))
     {
-      cmd->command = OSDP_CMDB_IDENT;
-      if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
-fprintf(stderr, "test: queuing %d\n", cmd->command);
-status = enqueue_command(ctx, cmd);
-cmd->command = OSDP_CMD_NOOP;
+      fprintf(ctx->log, "Polling: resetting sequence number to 0\n");
+      ctx->next_sequence = 0;
+      ctx->enable_poll = OO_POLL_ENABLED;
     };
-  }; 
-
-  // initiate secure channel
-
-  if (status EQUALS ST_OK)
-  {
-    strcpy (this_command, json_string_value (value));
-    test_command = "initiate-secure-channel";
-    if (0 EQUALS strncmp (this_command, test_command, strlen (test_command)))
+    if (0 EQUALS strcmp("resume", json_string_value(parameter)))
     {
-      cmd->command = OSDP_CMDB_INIT_SECURE;
-      cmd->details_param_1 = 0;
+      fprintf(ctx->log, "Polling: resuming sequence numbering\n");
+      ctx->enable_poll = OO_POLL_RESUME;
+    };
+  }
+  else
+  {
+    // toggle it (used to be just 1 and 0)
 
-      parameter = json_object_get(root, "key-slot");
-      if (json_is_string (parameter))
-      {
-        if (0 EQUALS strcmp("1", json_string_value(parameter)))
-          cmd->details_param_1 = 1;
-      };
+    if (ctx->enable_poll EQUALS OO_POLL_ENABLED)
+      ctx->enable_poll = OO_POLL_NEVER;
+    else
+      ctx->enable_poll = OO_POLL_ENABLED;
 
-      status = enqueue_command(ctx, cmd);
-      cmd->command = OSDP_CMD_NOOP;
-      if (ctx->verbosity > 3)
-      {
-        fprintf(ctx->log, "Enqueue: %s %d\n", test_command, cmd->details_param_1);
-      };
-    };
-  }; 
+    ctx->next_sequence = 0;
+    fprintf(ctx->log, "enable_polling now %x, sequence reset to 0\n", ctx->enable_poll);
+  };
+  cmd->command = OSDP_CMD_NOOP;
+  return (ST_OK);
 
-  // command "input_status" - request input status
+} /* osdp_breech_polling */
 
-  if (status EQUALS ST_OK)
-  {
-    strcpy (this_command, json_string_value (value));
-    test_command = "input_status";
-    if (0 EQUALS strncmp (this_command, test_command, strlen (test_command)))
-    {
-      cmd->command = OSDP_CMDB_ISTAT;
-      if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
-    };
-  }; 
 
-  // command "keypad" - send keyboard input
+/*
+  present_card - provide card data for osdp_RAW response
 
-  if (status EQUALS ST_OK)
-  {
-    if (0 EQUALS strcmp (current_command, "keypad"))
-    {
-      cmd->command = OSDP_CMDB_KEYPAD;
+  the preset card unless there's "raw" (hex, 26 bits unless "bits" says.)
+  "format" is raw or p-data-p.
+*/
 
-      value = json_object_get (root, "digits");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        if (strlen (vstr) > 9)
-        {
-          fprintf (stderr, "Too many digits in keypad input, truncating to first 9\n");
-          vstr [9] = 0;
-        };
-        memcpy (cmd->details, vstr, 9);
-      };
-    };
-  };
+int
+  osdp_breech_present_card
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-  // command "keyset" to send a KEYSET using the supplied key
-  if (status EQUALS ST_OK)
-  {
-    if (0 EQUALS strcmp (current_command, "keyset"))
-    {
-      cmd->command = OSDP_CMDB_KEYSET;
+{ /* osdp_breech_present_card */
 
-      value = json_object_get (root, "psk-hex");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        memcpy (cmd->details, vstr, OSDP_KEY_OCTETS*2);
-      };
-      status = enqueue_command(ctx, cmd);
-      cmd->command = OSDP_CMD_NOOP;
-      if (ctx->verbosity > 3)
-      {
-        fprintf(ctx->log, "Enqueue: keyset key %s\n", cmd->details);
-      };
-    };
-  };
+  unsigned short int buffer_length;
+  int i;
+  json_t *option;
+  int status;
 
-  // command "local_status" - request local status
 
-  if (status EQUALS ST_OK)
+  status = ST_OK;
+  cmd->details_length = p_card.value_len;
+  cmd->details_param_1 = p_card.bits;
+  memcpy(cmd->details, p_card.value, p_card.value_len);
+
+  option = json_object_get (root, "raw");
+  if (json_is_string (option))
   {
-    strcpy (this_command, json_string_value (value));
-    test_command = "local_status";
-    if (0 EQUALS strncmp (this_command, test_command, strlen (test_command)))
+    buffer_length = sizeof(cmd->details);
+    if (strlen (json_string_value (option)) > 2*buffer_length)
+      status = ST_CMD_OVERFLOW;
+    else
     {
-      cmd->command = OSDP_CMDB_LSTAT;
-      if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
+      status = osdp_string_to_buffer(ctx, (char *)json_string_value (option), cmd->details, &buffer_length);
+      cmd->details_length = buffer_length;
+      cmd->details_param_1 = 26;  // assume 26 bits unless otherwise specified
     };
-  }; 
+  };
 
-  // command "led"
+  option = json_object_get (root, "bits");
+  if (json_is_string (option))
+  {
+    if (1 EQUALS sscanf(json_string_value (option), "%d", &i))
+      cmd->details_param_1 = i;
+  };
 
-  if (status EQUALS ST_OK)
+  option = json_object_get (root, "format");
+  if (json_is_string (option))
   {
-    if (0 EQUALS strcmp (current_command, "led"))
-    {
-      OSDP_RDR_LED_CTL *led_ctl;
-
-      cmd->command = OSDP_CMDB_LED;
-      /*
-        "details" is an OSDP_RDR_LED_CTL structure.
-        set up details with the default values (and then tune that if there
-        are parameters with the command.)
-      */
-      led_ctl = (OSDP_RDR_LED_CTL *)(cmd->details);
-      set_led_temp = 0;
-      led_ctl->led           = 0;
-      led_ctl->perm_control  = OSDP_LED_SET;
-      led_ctl->perm_off_time = 0;
-      led_ctl->perm_off_color = OSDP_LEDCOLOR_BLACK;
-      led_ctl->perm_on_color  = OSDP_LEDCOLOR_GREEN;
-      led_ctl->perm_on_time   = 30;
-      led_ctl->reader         = 0;
-      led_ctl->temp_control   = OSDP_LED_TEMP_NOP;
-      led_ctl->temp_off       = 3;
-      led_ctl->temp_off_color = OSDP_LEDCOLOR_GREEN;
-      led_ctl->temp_on        = 3;
-      led_ctl->temp_on_color  = OSDP_LEDCOLOR_RED;
-      led_ctl->temp_timer_lsb = 30;
-      led_ctl->temp_timer_msb = 0;
+    if (0 EQUALS strcmp(json_string_value (option), "p-data-p"))
+      ctx->card_format = 1;
+    else
+      ctx->card_format = 0;
+  };
 
-      if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
+  if (ctx->verbosity > 3)
+    if (cmd->details_length > 0)
+      fprintf(ctx->log, "present_card: raw (%d. bytes, %d. bits, fmt %d)\n",
+        cmd->details_length, cmd->details_param_1, ctx->card_format);
+  return (status);
 
-      value = json_object_get (root, "led-number");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        led_ctl->led = i;
-      };
-      value = json_object_get (root, "perm-control");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        led_ctl->perm_control = i;
-      };
-      value = json_object_get (root, "perm-off-time");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        led_ctl->perm_off_time = i;
-fprintf(ctx->log, "DEBUG: perf_off_time %d.\n", led_ctl->perm_off_time);
-      };
-      value = json_object_get (root, "perm-off-color");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        led_ctl->perm_off_color = i;
-      };
-      value = json_object_get (root, "perm-on-time");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        led_ctl->perm_on_time = i;
-      };
-      value = json_object_get (root, "perm-on-color");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        led_ctl->perm_on_color = i;
-      };
-      value = json_object_get (root, "temp-off-color");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        led_ctl->temp_off_color = i;
-        if (i > 0)
-          set_led_temp = 1;
-      };
-      value = json_object_get (root, "temp-off-time");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        led_ctl->temp_off = i;
-        if (i > 0)
-          set_led_temp = 1;
-      };
-      value = json_object_get (root, "temp-on-time");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        led_ctl->temp_on = i;
-        if (i > 0)
-          set_led_temp = 1;
-      };
-      value = json_object_get (root, "temp-on-color");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        led_ctl->temp_on_color = i;
-        if (i > 0)
-          set_led_temp = 1;
-      };
-      value = json_object_get (root, "temp-timer");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        led_ctl->temp_timer_lsb = i & 0xff;
-        led_ctl->temp_timer_msb = i >> 8;
-        if (i > 0)
-          set_led_temp = 1;
-      };
+} /* osdp_breech_present_card */
 
-      // lastly look for "temp-control".  If it's set it overrides the
-      // implicit temp-control from other values being set.
 
-      value = json_object_get (root, "temp-control");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        set_led_temp = 0; // NOT the implied control
-        led_ctl->temp_control = i;
-      };
-      if (set_led_temp)
-      {
-        led_ctl->temp_control = OSDP_LED_TEMP_SET;
-      };
-    };
-  }; 
-  if (status EQUALS ST_OK)
-  {
-    if (0 EQUALS strcmp (current_command, "operator_confirm"))
-    {
-      cmd->command = OSDP_CMD_NOOP; // nothing other than what's here so no-op
-      value = json_object_get (root, "test");
-      if (json_is_string (value))
-      {
-        strcpy (current_options, json_string_value (value));
-        status = osdp_conform_confirm (current_options);
-      };
-    };
-  };
+// reset - reset "link" i.e. sequence number
 
-  // output (digital bits out)
+int
+  osdp_breech_reset
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-  if (status EQUALS ST_OK)
-  {
-    int
-      i;
-    char
-      vstr [1024];
+{ /* osdp_breech_reset */
 
-    test_command = "output";
-    if (0 EQUALS strcmp (current_command, test_command))
-    {
-      cmd->command = OSDP_CMDB_OUT;
-      if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
+  ctx->next_sequence = 0;
+  cmd->command = OSDP_CMD_NOOP;
+  return (ST_OK);
 
-      // default values in case some are missing
+} /* osdp_breech_reset */
 
-      current_output_command [0].output_number = 0;
-      current_output_command [0].control_code = 2; // permanent on immediate
-      current_output_command [0].timer = 0; // forever
 
-      // the output command takes arguments: output_number, control_code
+int
+  osdp_breech_text
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-      value = json_object_get (root, "output-number");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        current_output_command [0].output_number = i;
-fprintf(stderr, "DEBUG: output-number set to %d\n", 
-  current_output_command [0].output_number);
-      };
-      value = json_object_get (root, "control-code");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        current_output_command [0].control_code = i;
-      };
-      value = json_object_get (root, "timer");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        current_output_command [0].timer = i;
-      };
-    };
-  }; 
+{ /* osdp_breech_text */
+
+  json_t *value;
 
-  // request output status
 
-  if (status EQUALS ST_OK)
+  cmd->command = OSDP_CMD_NOOP; // no message, nothing to send
+  value = json_object_get (root, "message");
+  if (json_is_string (value))
   {
-    if (0 EQUALS strcmp (current_command, "output_status"))
-    {
-      cmd->command = OSDP_CMDB_OSTAT;
-      if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
-    };
-  }; 
+    strncpy (ctx->text, json_string_value (value), sizeof (ctx->text)-1);
+    ctx->text [sizeof (ctx->text)-1] = 0;
+    cmd->command = OSDP_CMDB_TEXT;
+  };
+  return (ST_OK);
 
-  // present_card - provide card data for osdp_RAW response
+} /* osdp_breech_text */
 
-  if (status EQUALS ST_OK)
-  {
-    json_t *option;
 
-    value = json_object_get (root, "command");
+int
+  osdp_breech_trace
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-    strcpy (this_command, json_string_value (value));
-    test_command = "present_card";
-    if (0 EQUALS strncmp (this_command, test_command, strlen (test_command)))
-    {
-      cmd->command = OSDP_CMDB_PRESENT_CARD;
-      if (ctx->verbosity > 3)
-        fprintf(ctx->log, "Command %s submitted\n", test_command);
+{ /* osdp_breech_trace */
 
-      // if no options are given, use preset value
-      cmd->details_length = p_card.value_len;
-      cmd->details_param_1 = p_card.bits;
-      memcpy(cmd->details, p_card.value, p_card.value_len);
+  ctx->trace = 1 ^ ctx->trace; // toggle low order bit
+  fprintf(ctx->log, "Tracing set to %d\n", ctx->trace);
+  cmd->command = OSDP_CMD_NOOP;
+  return (ST_OK);
 
-      // if there's a "raw" option it's the data to use.  bits are also specified.
+} /* osdp_breech_trace */
 
-      option = json_object_get (root, "raw");
-      if (json_is_string (option))
-      {
-        strcpy (vstr, json_string_value (option));
-        buffer_length = sizeof(cmd->details);
-        status = osdp_string_to_buffer(ctx, vstr, cmd->details, &buffer_length);
-        cmd->details_length = buffer_length;
-        cmd->details_param_1 = 26;  // assume 26 bits unless otherwise specified
-      };
 
-      option = json_object_get (root, "bits");
-      if (json_is_string (option))
-      {
-        strcpy (vstr, json_string_value (option));
-        sscanf(vstr, "%d", &i);
-        cmd->details_param_1 = i;
-      };
+// verbosity - arg level, range 0-9
 
-      // format can be specified (raw or p/data/p)
-      option = json_object_get (root, "format");
-      if (json_is_string (option))
-      {
-        strcpy (vstr, json_string_value (option));
-        if (0 EQUALS strcmp(vstr, "p-data-p"))
-          ctx->card_format = 1;
-        else
-          ctx->card_format = 0;
-      };
+int
+  osdp_breech_verbosity
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
 
-      if (ctx->verbosity > 3)
-        if (cmd->details_length > 0)
-          fprintf(ctx->log, "present_card: raw (%d. bytes, %d. bits, fmt %d): %s\n",
-            cmd->details_length, cmd->details_param_1, ctx->card_format, vstr);
-    };
-  }; 
+{ /* osdp_breech_verbosity */
 
-  // request (attached) reader status
+  int i;
+  int status;
+  json_t *value;
 
-  if (status EQUALS ST_OK)
-  {
-    strcpy (this_command, json_string_value (value));
-    test_command = "reader_status";
-    if (0 EQUALS strncmp (this_command, test_command, strlen (test_command)))
-    {
-      cmd->command = OSDP_CMDB_RSTAT;
-      if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
-    };
-  }; 
 
-  if (status EQUALS ST_OK)
-  {
-    strcpy (this_command, json_string_value (value));
-    test_command = "reset_power";
-    if (0 EQUALS strncmp (this_command, test_command, strlen (test_command)))
-    {
-      cmd->command = OSDP_CMDB_RESET_POWER;
-      if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
-    };
-  }; 
-  if (status EQUALS ST_OK)
+  status = ST_OK;
+  cmd->command = OSDP_CMD_NOOP; // nothing other than what's here so no-op
+  value = json_object_get (root, "level");
+  if (json_is_string (value))
   {
-    strcpy (this_command, json_string_value (value));
-    test_command = "send_poll";
-    if (0 EQUALS strncmp (this_command, test_command, strlen (test_command)))
+    if (1 EQUALS sscanf (json_string_value (value), "%d", &i))
     {
-      cmd->command = OSDP_CMDB_SEND_POLL;
+      ctx->verbosity = i;
       if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
-    };
-  }; 
-  if (status EQUALS ST_OK)
-  {
-    test_command = "stop";
-    if (0 EQUALS strncmp(json_string_value(value), test_command, strlen(test_command)))
-      cmd->command = OSDP_CMDB_STOP;
+        ctx->trace = 1; // turn on tracing (should be stricter about low-order bit.)
+      else
+        ctx->trace = 0; // turn off tracing (should be stricter about low-order bit.)
+    }
+    else
+      status = ST_CMD_INVALID;
   };
-  if (status EQUALS ST_OK)
-  {
-    strcpy (this_command, json_string_value (value));
-    test_command = "tamper";
-    if (0 EQUALS strncmp (this_command, test_command, strlen (test_command)))
-    {
-      cmd->command = OSDP_CMDB_TAMPER;
-      if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
-    };
-  }; 
+  return (status);
 
-  // command verbosity
-  // arg level - range 0-9
+} /* osdp_breech_verbosity */
 
-  if (status EQUALS ST_OK)
-  {
-    if (0 EQUALS strcmp (current_command, "verbosity"))
-    {
-      int
-        i;
-      char
-        vstr [1024];
 
-      cmd->command = OSDP_CMD_NOOP; // nothing other than what's here so no-op
-      if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
+/*
+  command "xwrite"
 
-      value = json_object_get (root, "level");
-      if (json_is_string (value))
-      {
-        strcpy (vstr, json_string_value (value));
-        sscanf (vstr, "%d", &i);
-        ctx->verbosity = i;
-        if (ctx->verbosity > 3)
-          ctx->trace = 1; // turn on tracing (should be stricter about low-order bit.)
-        else
-          ctx->trace = 0; // turn off tracing (should be stricter about low-order bit.)
-      };
-    };
-  }; 
+  example:
+    { "command" : "xwrite", "action" : "get-mode" }
 
-  // command "xwrite"
-  /*
-    example:
-      { "command" : "xwrite", "action" : "get-mode" }
-  */
-  if (status EQUALS ST_OK)
+  apdu takes a "payload", which goes in details after its (short) length.
+*/
+
+int
+  osdp_breech_xwrite
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    OSDP_COMMAND *cmd)
+
+{ /* osdp_breech_xwrite */
+
+  char *action;
+  unsigned short int payload_length;
+  short int payload_short;
+  int status;
+  json_t *value;
+
+
+  status = ST_OK;
+  value = json_object_get (root, "action");
+  if (json_is_string (value))
   {
-    if (0 EQUALS strcmp (current_command, "xwrite"))
+    action = (char *)json_string_value (value);
+    if (0 EQUALS strcmp(action, "get-mode"))
+      cmd->details [0] = 1; // 1 in byte 0 is get-mode
+    if (0 EQUALS strcmp(action, "scan"))
+      cmd->details [0] = 3; // 3 in byte 0 is scan (for smart card)
+    if (0 EQUALS strcmp(action, "set-mode"))
+      cmd->details [0] = 2; // 2 in byte 0 is set-mode
+    if (0 EQUALS strcmp(action, "set-zero"))
+      cmd->details [0] = 4; // 4 in byte 0 is set mode 0
+    if (0 EQUALS strcmp(action, "done"))
+      cmd->details [0] = 5;
+    if (0 EQUALS strcmp(action, "apdu"))
     {
-      cmd->command = OSDP_CMDB_XWRITE;
-      if (ctx->verbosity > 3)
-        fprintf (stderr, "command was %s\n",
-          this_command);
+      cmd->details [0] = 6;
 
-      value = json_object_get (root, "action");
+      // if there's a "payload" fill it in after the command in details
+
+      value = json_object_get (root, "payload");
       if (json_is_string (value))
       {
-        if (0 EQUALS strcmp(json_string_value(value), "get-mode"))
-        {
-          cmd->details [0] = 1; // 1 in byte 0 is get-mode
-        };
-        if (0 EQUALS strcmp(json_string_value(value), "scan"))
-        {
-          cmd->details [0] = 3; // 3 in byte 0 is scan (for smart card)
-        };
-        if (0 EQUALS strcmp(json_string_value(value), "set-mode"))
-        {
-          cmd->details [0] = 2; // 2 in byte 0 is set-mode
-        };
-        if (0 EQUALS strcmp(json_string_value(value), "set-zero"))
-        {
-          cmd->details [0] = 4; // 4 in byte 0 is set mode 0
-        };
-        if (0 EQUALS strcmp(json_string_value(value), "done"))
-        {
-          cmd->details [0] = 5;
-        };
-        if (0 EQUALS strcmp(json_string_value(value), "apdu"))
+        payload_length = sizeof(cmd->details) - 3;
+        if (strlen (json_string_value (value)) > 2*payload_length)
+          status = ST_CMD_OVERFLOW;
+        else
         {
-          unsigned short int payload_length;
-          char payload_value [1024];
-
-          cmd->details [0] = 6;
-
-          // if there's a "payload" fill it in after the command in details
-
-          value2 = json_object_get (root, "payload");
-          if (json_is_string (value2))
-          {
-            payload_length = sizeof(cmd->details);
-            strcpy(payload_value, json_string_value(value2));
-            status = osdp_string_to_buffer
-              (ctx, payload_value, cmd->details+3, &payload_length);
-            *(short int *)(cmd->details+1) = payload_length;
-          };
+          status = osdp_string_to_buffer
+            (ctx, (char *)json_string_value (value), cmd->details+3, &payload_length);
+          payload_short = payload_length;
+          memcpy (cmd->details+1, &payload_short, sizeof (payload_short));
         };
       };
-fprintf(stderr, "test: queuing XWR %d\n", cmd->command);
-status = enqueue_command(ctx, cmd);
-cmd->command = OSDP_CMD_NOOP;
     };
-  }; 
-
-  if (cmdf != NULL)
-    fclose (cmdf);
-  if (status != ST_OK)
-    fprintf(stderr, "Status %d at read_command.\n", status);
+  };
   return (status);
 
-} /* read_command */
+} /* osdp_breech_xwrite */
+
+
+/*
+  the commands, by name.  int parameters are decimal strings unless they
+  are HEX8; offsets are into the command details.
+*/
+
+OSDP_COMMAND_REGISTRY osdp_command_registry [] =
+{
+  { "acurxsize", OSDP_CMDB_ACURXSIZE, OSDP_CMDREG_QUEUE, NULL },
+  { "bio-match", OSDP_CMDB_BIOMATCH, OSDP_CMDREG_QUEUE, osdp_breech_bio_match },
+  { "bio-read", OSDP_CMDB_BIOREAD, OSDP_CMDREG_QUEUE, NULL },
+  { "busy", OSDP_CMDB_BUSY, OSDP_CMDREG_QUEUE, NULL },
+  { "buzz", OSDP_CMDB_BUZZ, OSDP_CMDREG_QUEUE, NULL,
+    {
+      { "on_time", OSDP_PARAM_INT8, 0, 0, 15 },
+      { "off_time", OSDP_PARAM_INT8, 1, 0, 15 },
+      { "repeat", OSDP_PARAM_INT8, 2, 0, 3 },
+    }
+  },
+  { "capabilities", OSDP_CMDB_CAPAS, OSDP_CMDREG_QUEUE, NULL },
+
+  // comset: new_address defaults to 0; by convention octets 4-7 are the speed
+
+  { "comset", OSDP_CMDB_COMSET, OSDP_CMDREG_QUEUE, osdp_breech_comset,
+    {
+      { "new_address", OSDP_PARAM_INT8, 0, 0, 0 },
+      { "new_speed", OSDP_PARAM_INT32, 4, 0, 0 },
+    }
+  },
+  { "conform_2_11_3", OSDP_CMDB_CONFORM_2_11_3, OSDP_CMDREG_QUEUE, NULL },
+  { "conform_2_14_3", OSDP_CMDB_CONFORM_2_14_3, OSDP_CMDREG_QUEUE, NULL },
+  { "conform_2_2_1", OSDP_CMDB_CONFORM_2_2_1, OSDP_CMDREG_QUEUE, NULL },
+  { "conform_2_2_2", OSDP_CMDB_CONFORM_2_2_2, OSDP_CMDREG_QUEUE, NULL },
+  { "conform_2_2_3", OSDP_CMDB_CONFORM_2_2_3, OSDP_CMDREG_QUEUE, NULL },
+  { "conform_2_2_4", OSDP_CMDB_CONFORM_2_2_4, OSDP_CMDREG_QUEUE, NULL },
+  { "conform_2_6_1", OSDP_CMDB_CONFORM_2_6_1, OSDP_CMDREG_QUEUE, osdp_breech_conform_2_6_1 },
+  { "conform_3_14_2", OSDP_CMD_NOOP, 0, osdp_breech_conform_3_14_2 },
+  { "conform_3_20_1", OSDP_CMDB_CONFORM_3_20_1, OSDP_CMDREG_QUEUE, NULL },
+  { "dump_status", OSDP_CMDB_DUMP_STATUS, 0, NULL },
+  { "factory-default", OSDP_CMDB_FACTORY_DEFAULT, 0, osdp_breech_factory_default },
+  { "genauth", OSDP_CMDB_WITNESS, OSDP_CMDREG_QUEUE, osdp_breech_genauth,
+    {
+      { "keyref", OSDP_PARAM_HEX8, 1, 0, 0 },
+    }
+  },
+  { "identify", OSDP_CMDB_IDENT, OSDP_CMDREG_QUEUE, NULL },
+  { "induce-NAK", OSDP_CMDB_INDUCE_NAK, OSDP_CMDREG_QUEUE, NULL },
+  { "initiate-secure-channel", OSDP_CMDB_INIT_SECURE, OSDP_CMDREG_QUEUE, osdp_breech_init_secure },
+  { "input_status", OSDP_CMDB_ISTAT, 0, NULL },
+  { "keep-active", OSDP_CMDB_KEEPACTIVE, OSDP_CMDREG_QUEUE, NULL,
+    {
+      { "milliseconds", OSDP_PARAM_INT16, 0, 0, 7000 },
+    }
+  },
+  { "keypad", OSDP_CMDB_KEYPAD, 0, NULL,
+    {
+      { "digits", OSDP_PARAM_STRING, 0, 9, 0 },
+    }
+  },
+  { "keyset", OSDP_CMDB_KEYSET, OSDP_CMDREG_QUEUE, NULL,
+    {
+      { "psk-hex", OSDP_PARAM_STRING, 0, OSDP_KEY_OCTETS*2, 0 },
+    }
+  },
+  { "led", OSDP_CMDB_LED, 0, osdp_breech_led,
+    {
+      { "led-number", OSDP_PARAM_INT8, offsetof (OSDP_RDR_LED_CTL, led), 0, 0 },
+      { "perm-control", OSDP_PARAM_INT8, offsetof (OSDP_RDR_LED_CTL, perm_control), 0, OSDP_LED_SET },
+      { "perm-off-time", OSDP_PARAM_INT8, offsetof (OSDP_RDR_LED_CTL, perm_off_time), 0, 0 },
+      { "perm-off-color", OSDP_PARAM_INT8, offsetof (OSDP_RDR_LED_CTL, perm_off_color), 0, OSDP_LEDCOLOR_BLACK },
+      { "perm-on-time", OSDP_PARAM_INT8, offsetof (OSDP_RDR_LED_CTL, perm_on_time), 0, 30 },
+      { "perm-on-color", OSDP_PARAM_INT8, offsetof (OSDP_RDR_LED_CTL, perm_on_color), 0, OSDP_LEDCOLOR_GREEN },
+      { "temp-control", OSDP_PARAM_INT8, offsetof (OSDP_RDR_LED_CTL, temp_control), 0, OSDP_LED_TEMP_NOP },
+      { "temp-off-color", OSDP_PARAM_INT8, offsetof (OSDP_RDR_LED_CTL, temp_off_color), 0, OSDP_LEDCOLOR_GREEN },
+      { "temp-off-time", OSDP_PARAM_INT8, offsetof (OSDP_RDR_LED_CTL, temp_off), 0, 3 },
+      { "temp-on-color", OSDP_PARAM_INT8, offsetof (OSDP_RDR_LED_CTL, temp_on_color), 0, OSDP_LEDCOLOR_RED },
+      { "temp-on-time", OSDP_PARAM_INT8, offsetof (OSDP_RDR_LED_CTL, temp_on), 0, 3 },
+      { "temp-timer", OSDP_PARAM_INT16, offsetof (OSDP_RDR_LED_CTL, temp_timer_lsb), 0, 30 },
+    }
+  },
+  { "local_status", OSDP_CMDB_LSTAT, 0, NULL },
+
+  // mfg: c-s-d is 2-hexit bytes, length inferred
+
+  { "mfg", OSDP_CMDB_MFG, OSDP_CMDREG_QUEUE, NULL,
+    {
+      { "command-id", OSDP_PARAM_INT8, offsetof (OSDP_MFG_ARGS, command_ID), 0, 0 },
+      { "command-specific-data", OSDP_PARAM_STRING, offsetof (OSDP_MFG_ARGS, c_s_d), 2*1024-1, 0 },
+      { "oui", OSDP_PARAM_STRING, offsetof (OSDP_MFG_ARGS, oui), 1024-1, 0 },
+    }
+  },
+  { "operator_confirm", OSDP_CMD_NOOP, 0, osdp_breech_operator_confirm },
+  { "output", OSDP_CMDB_OUT, 0, osdp_breech_output,
+    {
+      { "output-number", OSDP_PARAM_INT32, offsetof (OSDP_OUT_CMD, output_number), 0, 0 },
+      { "control-code", OSDP_PARAM_INT32, offsetof (OSDP_OUT_CMD, control_code), 0, 2 }, // permanent on immediate
+      { "timer", OSDP_PARAM_INT32, offsetof (OSDP_OUT_CMD, timer), 0, 0 }, // forever
+    }
+  },
+  { "output_status", OSDP_CMDB_OSTAT, 0, NULL },
+
+  // pivdata: 3 octet object id, data element, 2 octet offset into it
+
+  { "pivdata", OSDP_CMDB_PIVDATA, OSDP_CMDREG_QUEUE, NULL,
+    {
+      { "object-id", OSDP_PARAM_HEX, 0, 3, 0 },
+      { "data-element", OSDP_PARAM_HEX8, 3, 0, 0 },
+      { "offset", OSDP_PARAM_HEX, 4, 2, 0 },
+    }
+  },
+  { "polling", OSDP_CMDB_POLLING, 0, osdp_breech_polling },
+  { "present_card", OSDP_CMDB_PRESENT_CARD, 0, osdp_breech_present_card },
+  { "reader_status", OSDP_CMDB_RSTAT, 0, NULL },
+  { "reset", OSDP_CMDB_RESET, 0, osdp_breech_reset },
+  { "reset_power", OSDP_CMDB_RESET_POWER, 0, NULL },
+  { "send_poll", OSDP_CMDB_SEND_POLL, 0, NULL },
+  { "stop", OSDP_CMDB_STOP, 0, NULL },
+  { "tamper", OSDP_CMDB_TAMPER, 0, NULL },
+  { "text", OSDP_CMDB_TEXT, OSDP_CMDREG_QUEUE, osdp_breech_text },
+  { "trace", OSDP_CMDB_TRACE, 0, osdp_breech_trace },
+  { "transfer", OSDP_CMDB_TRANSFER, OSDP_CMDREG_QUEUE, NULL,
+    {
+      { "file", OSDP_PARAM_STRING, 0, 1024-1, 0 },
+    }
+  },
+  { "verbosity", OSDP_CMD_NOOP, 0, osdp_breech_verbosity },
+  { "xwrite", OSDP_CMDB_XWRITE, OSDP_CMDREG_QUEUE, osdp_breech_xwrite },
+  { NULL }
+};
 
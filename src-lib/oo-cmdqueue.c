@@ -0,0 +1,330 @@
+/*
+  oo-cmdqueue - the queue of commands waiting for the bus
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  An OSDP_COMMAND carries 8K of details but most use a few octets, so a
+  queued command is kept as a record holding only the details up to the
+  last non-zero octet.  Each lane is a ring of these records in an arena
+  allocated the first time it is used: records go in at the tail and
+  come out at the head, and one that does not fit before the end of the
+  arena starts back at the beginning (wrap marks where the records
+  stopped.)  Setup commands go ahead of normal ones, and those ahead of
+  bulk LED/text/transfer traffic.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+#include <open-osdp.h>
+
+
+#define OSDP_QUEUED_ALIGN (8)
+
+
+int
+  osdp_command_lane_alloc
+    (OSDP_COMMAND_QUEUE *q,
+    OSDP_COMMAND_LANE *lane);
+
+
+/*
+  osdp_command_dequeue - take the next command off the queue
+
+  returns 1 and fills in cmd if there was one, 0 if the queue is empty
+  or the next command is for a port or PD that has to wait for its turn
+  (it stays at the head so the order is kept.)  One for a port or PD that
+  is not there comes off as a no-op.
+*/
+
+int
+  osdp_command_dequeue
+    (OSDP_CONTEXT *ctx,
+    OSDP_COMMAND *cmd)
+
+{ /* osdp_command_dequeue */
+
+  int found;
+  int held;
+  int i;
+  OSDP_COMMAND_LANE *lane;
+  struct timespec now;
+  OSDP_QUEUED_COMMAND *rec;
+  int status;
+  long wait;
+
+
+  found = 0;
+  held = 0;
+  for (i=0; (!found) && (!held) && (i<OSDP_COMMAND_LANES); i++)
+  {
+    lane = &(ctx->q.lane [i]);
+    if (lane->count > 0)
+    {
+      if (lane->head EQUALS lane->wrap)
+      {
+        lane->head = 0;
+        lane->wrap = -1;
+      };
+      rec = (OSDP_QUEUED_COMMAND *)(lane->arena + lane->head);
+      status = osdp_port_target (ctx, rec->port, rec->pd_address);
+      if (status EQUALS ST_BUS_WAIT)
+        held = 1;
+      else
+        found = 1;
+    };
+    if (found)
+    {
+      cmd->command = rec->command;
+      if (status != ST_OK)
+      {
+        fprintf (ctx->log,
+          "command %d for port %d PD %02x not on the bus, dropped\n",
+          rec->command, rec->port, rec->pd_address);
+        cmd->command = OSDP_CMD_NOOP;
+      };
+      cmd->details_length = rec->details_length;
+      cmd->details_param_1 = rec->details_param_1;
+      cmd->pd_address = rec->pd_address;
+      cmd->port = rec->port;
+      memcpy (cmd->details, (unsigned char *)(rec+1), rec->stored);
+      memset (cmd->details + rec->stored, 0,
+        sizeof (cmd->details) - rec->stored);
+
+      clock_gettime (CLOCK_MONOTONIC, &now);
+      wait = (now.tv_sec - rec->queued.tv_sec) * 1000000l +
+        (now.tv_nsec - rec->queued.tv_nsec) / 1000;
+      lane->wait_total = lane->wait_total + wait;
+      if (wait > lane->wait_max)
+        lane->wait_max = wait;
+
+      lane->head = lane->head + rec->lth;
+      lane->count --;
+
+      // empty, so the whole arena is free again
+      if (lane->count EQUALS 0)
+      {
+        lane->head = 0;
+        lane->tail = 0;
+        lane->wrap = -1;
+      };
+    };
+  };
+  return (found);
+
+} /* osdp_command_dequeue */
+
+
+/*
+  osdp_command_enqueue - add a command to the end of a lane
+*/
+
+int
+  osdp_command_enqueue
+    (OSDP_CONTEXT *ctx,
+    OSDP_COMMAND *cmd,
+    int lane_index)
+
+{ /* osdp_command_enqueue */
+
+  int at;
+  OSDP_COMMAND_LANE *lane;
+  int lth;
+  OSDP_QUEUED_COMMAND *rec;
+  int status;
+  int stored;
+
+
+  status = ST_OK;
+  if ((lane_index < 0) || (lane_index >= OSDP_COMMAND_LANES))
+    lane_index = OSDP_COMMAND_LANE_NORMAL;
+  lane = &(ctx->q.lane [lane_index]);
+  if (lane->arena EQUALS NULL)
+    status = osdp_command_lane_alloc (&(ctx->q), lane);
+
+  // keep the details up to the last octet that was set
+
+  stored = sizeof (cmd->details);
+  while ((stored > 0) && (cmd->details [stored-1] EQUALS 0))
+    stored --;
+  if ((cmd->details_length > stored) &&
+    (cmd->details_length <= sizeof (cmd->details)))
+    stored = cmd->details_length;
+  lth = sizeof (*rec) + stored;
+  lth = (lth + OSDP_QUEUED_ALIGN - 1) & ~(OSDP_QUEUED_ALIGN - 1);
+
+  // it goes at the tail if it fits before the head (or the end of the
+  // arena), else at the beginning if that is clear up to the head.
+
+  at = -1;
+  if (status EQUALS ST_OK)
+  {
+    if (lane->count < ctx->q.depth)
+    {
+      if ((lane->count EQUALS 0) || (lane->tail > lane->head))
+      {
+        if (lane->tail + lth <= lane->size)
+          at = lane->tail;
+        else
+          if (lth <= lane->head)
+          {
+            lane->wrap = lane->tail;
+            at = 0;
+          };
+      }
+      else
+      {
+        if (lane->tail + lth <= lane->head)
+          at = lane->tail;
+      };
+    };
+    if (at < 0)
+    {
+      lane->overflow ++;
+      ctx->cmd_q_overflow ++;
+      status = ST_OSDP_COMMAND_OVERFLOW;
+    };
+  };
+  if (status EQUALS ST_OK)
+  {
+    rec = (OSDP_QUEUED_COMMAND *)(lane->arena + at);
+    rec->lth = lth;
+    rec->command = cmd->command;
+    rec->details_length = cmd->details_length;
+    rec->details_param_1 = cmd->details_param_1;
+    rec->pd_address = cmd->pd_address;
+    rec->port = cmd->port;
+    rec->stored = stored;
+    clock_gettime (CLOCK_MONOTONIC, &(rec->queued));
+    memcpy ((unsigned char *)(rec+1), cmd->details, stored);
+    lane->tail = at + lth;
+    lane->count ++;
+    lane->enqueued ++;
+    if (lane->count > lane->max_count)
+      lane->max_count = lane->count;
+    if ((ctx->verbosity > 3) && (lane->count > 1))
+      fprintf (ctx->log, "enqueue cmd %d lane %d depth %d\n",
+        cmd->command, lane_index, lane->count);
+  };
+  return (status);
+
+} /* osdp_command_enqueue */
+
+
+/*
+  osdp_command_lane - which lane a (command breech) command goes in
+*/
+
+int
+  osdp_command_lane
+    (int command)
+
+{ /* osdp_command_lane */
+
+  int lane;
+
+
+  lane = OSDP_COMMAND_LANE_NORMAL;
+  switch (command)
+  {
+  case OSDP_CMDB_COMSET:
+  case OSDP_CMDB_INIT_SECURE:
+  case OSDP_CMDB_KEEPACTIVE:
+  case OSDP_CMDB_KEYSET:
+  case OSDP_CMDB_POLLING:
+  case OSDP_CMDB_RESET:
+  case OSDP_CMDB_STOP:
+    lane = OSDP_COMMAND_LANE_SETUP;
+    break;
+  case OSDP_CMDB_BUZZ:
+  case OSDP_CMDB_LED:
+  case OSDP_CMDB_OUT:
+  case OSDP_CMDB_TEXT:
+  case OSDP_CMDB_TRANSFER:
+    lane = OSDP_COMMAND_LANE_BULK;
+    break;
+  };
+  return (lane);
+
+} /* osdp_command_lane */
+
+
+/*
+  osdp_command_lane_alloc - set up a lane's arena
+
+  big enough for depth average commands and at least two of the largest.
+*/
+
+int
+  osdp_command_lane_alloc
+    (OSDP_COMMAND_QUEUE *q,
+    OSDP_COMMAND_LANE *lane)
+
+{ /* osdp_command_lane_alloc */
+
+  int size;
+  int status;
+
+
+  status = ST_OK;
+  if (q->depth <= 0)
+    q->depth = OSDP_COMMAND_QUEUE_SIZE;
+  size = q->depth * OSDP_COMMAND_QUEUE_OCTETS;
+  if (size < 2 * (sizeof (OSDP_QUEUED_COMMAND) + sizeof (((OSDP_COMMAND *)0)->details)))
+    size = 2 * (sizeof (OSDP_QUEUED_COMMAND) + sizeof (((OSDP_COMMAND *)0)->details));
+  lane->arena = malloc (size);
+  if (lane->arena EQUALS NULL)
+    status = ST_OSDP_COMMAND_QUEUE_ALLOC;
+  if (status EQUALS ST_OK)
+  {
+    lane->size = size;
+    lane->head = 0;
+    lane->tail = 0;
+    lane->wrap = -1;
+    lane->count = 0;
+  };
+  return (status);
+
+} /* osdp_command_lane_alloc */
+
+
+/*
+  osdp_command_queue_count - commands waiting, all lanes
+*/
+
+int
+  osdp_command_queue_count
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_command_queue_count */
+
+  int count;
+  int i;
+
+
+  count = 0;
+  for (i=0; i<OSDP_COMMAND_LANES; i++)
+    count = count + ctx->q.lane [i].count;
+  return (count);
+
+} /* osdp_command_queue_count */
+
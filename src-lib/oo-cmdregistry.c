@@ -0,0 +1,305 @@
+/*
+  oo-cmdregistry - find a breech command by name and pick up its parameters
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  The commands themselves are listed in osdp_command_registry (in
+  oo-cmdbreech.c.)  The first lookup picks a hash seed that puts every
+  name in a slot of its own, so finding a command is one hash and one
+  strcmp however many there are, and a new entry in the table needs
+  nothing else done.  A parameter that is there but is not a string, or
+  does not convert, makes the command invalid.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+
+
+#include <jansson.h>
+
+
+#include <open-osdp.h>
+
+
+extern OSDP_COMMAND_REGISTRY osdp_command_registry [];
+
+int osdp_command_hash_seed;
+short int osdp_command_hash_slot [OSDP_COMMAND_HASH_SLOTS];
+
+
+unsigned int
+  osdp_command_hash
+    (char *name,
+    unsigned int seed);
+int
+  osdp_command_hash_build
+    (void);
+
+
+/*
+  osdp_command_hash - FNV-1a of the name, started from the seed
+*/
+
+unsigned int
+  osdp_command_hash
+    (char *name,
+    unsigned int seed)
+
+{ /* osdp_command_hash */
+
+  unsigned int h;
+
+
+  h = 2166136261u ^ (seed * 16777619u);
+  while (*name)
+  {
+    h = h ^ (unsigned char)*name;
+    h = h * 16777619u;
+    name ++;
+  };
+  return (h & (OSDP_COMMAND_HASH_SLOTS - 1));
+
+} /* osdp_command_hash */
+
+
+/*
+  osdp_command_hash_build - find a seed with no two names in one slot
+
+  returns the seed (1 or more), or 0 if the table is too full to manage.
+*/
+
+int
+  osdp_command_hash_build
+    (void)
+
+{ /* osdp_command_hash_build */
+
+  int clash;
+  int i;
+  int seed;
+  unsigned int slot;
+
+
+  clash = 1;
+  for (seed=1; clash && (seed<100000); seed++)
+  {
+    clash = 0;
+    memset (osdp_command_hash_slot, 0xff, sizeof (osdp_command_hash_slot));
+    for (i=0; (!clash) && (osdp_command_registry [i].name != NULL); i++)
+    {
+      slot = osdp_command_hash (osdp_command_registry [i].name, seed);
+      if (osdp_command_hash_slot [slot] != -1)
+        clash = 1;
+      else
+        osdp_command_hash_slot [slot] = i;
+    };
+  };
+  osdp_command_hash_seed = 0;
+  if (!clash)
+    osdp_command_hash_seed = seed - 1;
+  return (osdp_command_hash_seed);
+
+} /* osdp_command_hash_build */
+
+
+/*
+  osdp_command_lookup - the registry entry for a command name, or NULL
+*/
+
+OSDP_COMMAND_REGISTRY
+  *osdp_command_lookup
+    (char *name)
+
+{ /* osdp_command_lookup */
+
+  OSDP_COMMAND_REGISTRY *entry;
+  int i;
+
+
+  entry = NULL;
+  if (osdp_command_hash_seed EQUALS 0)
+    (void)osdp_command_hash_build ();
+  if (osdp_command_hash_seed > 0)
+  {
+    i = osdp_command_hash_slot [osdp_command_hash (name, osdp_command_hash_seed)];
+    if (i >= 0)
+      if (0 EQUALS strcmp (name, osdp_command_registry [i].name))
+        entry = &(osdp_command_registry [i]);
+  }
+  else
+  {
+    // no seed would do.  slow, but still right
+
+    for (i=0; (entry EQUALS NULL) && (osdp_command_registry [i].name != NULL); i++)
+      if (0 EQUALS strcmp (name, osdp_command_registry [i].name))
+        entry = &(osdp_command_registry [i]);
+  };
+  return (entry);
+
+} /* osdp_command_lookup */
+
+
+/*
+  osdp_command_match - the OSDP_CMDB_ code for a JSON command
+
+  command (1024 octets) is set to the name.  ST_CMD_UNKNOWN (and
+  OSDP_CMDB_NOOP) if it is not in the registry.
+*/
+
+int
+  osdp_command_match
+    (OSDP_CONTEXT *ctx,
+    json_t *root,
+    char *command,
+    int *command_id)
+
+{ /* osdp_command_match */
+
+  OSDP_COMMAND_REGISTRY *entry;
+  int ret_cmd;
+  int status;
+  json_t *value;
+
+
+  status = ST_CMD_UNKNOWN;
+  ret_cmd = OSDP_CMDB_NOOP; // no-op if not known
+  command [0] = 0;
+  value = json_object_get (root, "command");
+  if (!json_is_string (value))
+    status = ST_CMD_INVALID;
+  else
+  {
+    status = ST_OK;
+    strncpy (command, json_string_value (value), 1023);
+    command [1023] = 0;
+  };
+
+  if (status EQUALS ST_OK)
+  {
+    status = ST_CMD_UNKNOWN;
+    entry = osdp_command_lookup (command);
+    if (entry != NULL)
+    {
+      ret_cmd = entry->command;
+      status = ST_OK;
+    };
+  };
+
+  *command_id = ret_cmd;
+  return(status);
+
+} /* osdp_command_match */
+
+
+/*
+  osdp_command_params - fill in the details from the command's parameters
+
+  int parameters that are not given are set to their initial value; the
+  others are left as they were.
+*/
+
+int
+  osdp_command_params
+    (OSDP_CONTEXT *ctx,
+    OSDP_COMMAND_REGISTRY *entry,
+    json_t *root,
+    OSDP_COMMAND *cmd)
+
+{ /* osdp_command_params */
+
+  unsigned short int buffer_length;
+  int i;
+  int lth;
+  OSDP_COMMAND_PARAM *param;
+  int status;
+  char *string;
+  int value;
+  json_t *value_json;
+
+
+  status = ST_OK;
+  for (i=0; (status EQUALS ST_OK) && (i<OSDP_COMMAND_PARAMS_MAX) &&
+    (entry->param [i].name != NULL); i++)
+  {
+    param = &(entry->param [i]);
+    value = param->initial;
+    string = NULL;
+    value_json = json_object_get (root, param->name);
+    if (value_json != NULL)
+    {
+      if (!json_is_string (value_json))
+        status = ST_CMD_INVALID;
+      else
+        string = (char *)json_string_value (value_json);
+    };
+    if ((status EQUALS ST_OK) && (string != NULL))
+    {
+      switch (param->type)
+      {
+      case OSDP_PARAM_INT8:
+      case OSDP_PARAM_INT16:
+      case OSDP_PARAM_INT32:
+        if (1 != sscanf (string, "%d", &value))
+          status = ST_CMD_INVALID;
+        break;
+      case OSDP_PARAM_HEX8:
+        if (1 != sscanf (string, "%x", &value))
+          status = ST_CMD_INVALID;
+        break;
+      case OSDP_PARAM_HEX:
+        if (strlen (string) > 2 * param->max)
+          status = ST_CMD_OVERFLOW;
+        else
+          status = osdp_string_to_buffer (ctx, string,
+            cmd->details + param->offset, &buffer_length);
+        break;
+      case OSDP_PARAM_STRING:
+        lth = strlen (string);
+        if (lth > param->max)
+          lth = param->max;
+        memcpy (cmd->details + param->offset, string, lth);
+        cmd->details [param->offset + lth] = 0;
+        break;
+      };
+      if (status != ST_OK)
+        fprintf (ctx->log, "Command %s: bad %s (%s)\n",
+          entry->name, param->name, string);
+    };
+    if (status EQUALS ST_OK)
+    {
+      switch (param->type)
+      {
+      case OSDP_PARAM_INT8:
+      case OSDP_PARAM_HEX8:
+        cmd->details [param->offset] = value;
+        break;
+      case OSDP_PARAM_INT16:
+        cmd->details [param->offset] = value & 0xff; // lsb
+        cmd->details [param->offset+1] = (value >> 8) & 0xff; // msb
+        break;
+      case OSDP_PARAM_INT32:
+        memcpy (cmd->details + param->offset, &value, sizeof (value));
+        break;
+      };
+    };
+  };
+  return (status);
+
+} /* osdp_command_params */
+
@@ -17,6 +17,11 @@
   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
   See the License for the specific language governing permissions and
   limitations under the License.
+
+  Code marks a test with osdp_test_set_status and its OOC_ID_ number,
+  which finds it in test_control straight away.  That happens several
+  times a message, so its record in the results file (see oo-results.c)
+  is only touched when the test's status (or details) actually change.
 */
 
 
@@ -36,11 +41,20 @@ int
   osdp_report
     (OSDP_CONTEXT
       *ctx);
+int
+  osdp_test_lookup
+    (char *test);
+int
+  osdp_test_update
+    (int idx,
+    int test_status,
+    char *aux);
 
 
 extern OSDP_INTEROP_ASSESSMENT osdp_conformance;
 char log_string [1024];
 OSDP_CONTEXT context;
+short int osdp_test_index [OOC_ID_MAX];
 
 // test control info
 typedef struct osdp_conformance_test
@@ -53,8 +67,11 @@ typedef struct osdp_conformance_test
   int test_for_xpm;
   int test_for_transparent;
   char *description;
+  int id; // OOC_ID_ (0 if it has no symbol)
 } OSDP_CONFORMANCE_TEST;
 
+#define OOC_TESTS (sizeof (test_control) / sizeof (test_control [0]))
+
 OSDP_CONFORMANCE_TEST
   test_control [] =
   {
@@ -63,85 +80,85 @@ OSDP_CONFORMANCE_TEST
     {         OOC_SYMBOL_cmd_crauth,
       &(osdp_conformance.cmd_crauth.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_CRAUTH"},
+                        "Command: osdp_CRAUTH", OOC_ID_cmd_crauth},
     {         OOC_SYMBOL_cmd_genauth,
       &(osdp_conformance.cmd_genauth.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_GENAUTH"},
+                        "Command: osdp_GENAUTH", OOC_ID_cmd_genauth},
     {         OOC_SYMBOL_cmd_istat,
       &(osdp_conformance.cmd_istat.test_status),
       1, 0, 0, 0, 0,
-                        "Command: ISTAT"},
+                        "Command: ISTAT", OOC_ID_cmd_istat},
     {         OOC_SYMBOL_cmd_lstat,
       &(osdp_conformance.cmd_lstat.test_status),
       1, 0, 0, 0, 0,
-                        "Command: LSTAT"},
+                        "Command: LSTAT", OOC_ID_cmd_lstat},
     {         OOC_SYMBOL_cmd_ostat,
       &(osdp_conformance.cmd_ostat.test_status),
       1, 0, 0, 0, 0,
-                        "Command: OSTAT"},
+                        "Command: OSTAT", OOC_ID_cmd_ostat},
     {         OOC_SYMBOL_cmd_poll,
       &(osdp_conformance.cmd_poll.test_status),
       1, 0, 0, 0, 0,
-                        "Command: POLL"},
+                        "Command: POLL", OOC_ID_cmd_poll},
     {         OOC_SYMBOL_cmd_rstat,
       &(osdp_conformance.cmd_rstat.test_status),
       1, 0, 0, 0, 0,
-                        "Command: RSTAT"},
+                        "Command: RSTAT", OOC_ID_cmd_rstat},
     {         OOC_SYMBOL_cmd_text,
       &(osdp_conformance.cmd_text.test_status),
       1, 0, 0, 0, 0,
-                        "Command: TEXT"},
+                        "Command: TEXT", OOC_ID_cmd_text},
     {         OOC_SYMBOL_multibyte_data_encoding,
       &(osdp_conformance.multibyte_data_encoding.test_status),
       0, 0, 0, 0, 0,
-                        "    Multibyte"},
+                        "    Multibyte", OOC_ID_multibyte_data_encoding},
     { "3-12-1", &(osdp_conformance.cmd_text.test_status),
       0, 0, 0, 0, 0, "---" },
     {         OOC_SYMBOL_physical_interface,
       &(osdp_conformance.physical_interface.test_status),
       1, 0, 0, 0, 0,
-                        "physical interface"},
+                        "physical interface", OOC_ID_physical_interface},
     {         OOC_SYMBOL_poll_lstatr,
       &(osdp_conformance.poll_lstatr.test_status),
       0, 0, 0, 0, 0,
-                        "LSTATR to Poll"},
+                        "LSTATR to Poll", OOC_ID_poll_lstatr},
     {         OOC_SYMBOL_rep_ack,
       &(osdp_conformance.rep_ack.test_status),
       1, 1, 1, 1, 0,
-                        "Response: ACK" },
+                        "Response: ACK", OOC_ID_rep_ack },
     {         OOC_SYMBOL_resp_crauthr,
       &(osdp_conformance.resp_crauthr.test_status),
       0, 0, 0, 0, 0,
-                        "Response: osdp_CRAUTHR"},
+                        "Response: osdp_CRAUTHR", OOC_ID_resp_crauthr},
     {         OOC_SYMBOL_resp_genauthr,
       &(osdp_conformance.resp_genauthr.test_status),
       0, 0, 0, 0, 0,
-                        "Response: osdp_GENAUTHR"},
+                        "Response: osdp_GENAUTHR", OOC_ID_resp_genauthr},
     {         OOC_SYMBOL_resp_istatr,
       &(osdp_conformance.resp_istatr.test_status),
       1, 1, 1, 1, 0,
-                        "Response: ISTATR"},
+                        "Response: ISTATR", OOC_ID_resp_istatr},
     {         OOC_SYMBOL_resp_lstatr,
       &(osdp_conformance.resp_lstatr.test_status),
       1, 1, 1, 1, 0,
-                        "Response: LSTATR"},
+                        "Response: LSTATR", OOC_ID_resp_lstatr},
     {         OOC_SYMBOL_resp_ostatr,
       &(osdp_conformance.resp_ostatr.test_status),
       1, 1, 1, 1, 0,
-                        "Response: OSTATR"},
+                        "Response: OSTATR", OOC_ID_resp_ostatr},
     {         OOC_SYMBOL_resp_rstatr,
       &(osdp_conformance.resp_rstatr.test_status),
       1, 1, 1, 1, 0,
-                        "Response: RSTATR"},
+                        "Response: RSTATR", OOC_ID_resp_rstatr},
     {         OOC_SYMBOL_resp_mfgerrr,
       &(osdp_conformance.resp_mfgerrr.test_status),
       1, 1, 1, 1, 0,
-                        "Response: MFGERRR"},
+                        "Response: MFGERRR", OOC_ID_resp_mfgerrr},
     {         OOC_SYMBOL_signalling,
       &(osdp_conformance.signalling.test_status),
       1, 0, 0, 0, 0,
-                        "signalling"},
+                        "signalling", OOC_ID_signalling},
 
     // old tag names
 
@@ -182,19 +199,19 @@ OSDP_CONFORMANCE_TEST
     {         OOC_SYMBOL_packet_format,
       &(osdp_conformance.packet_format.test_status),
       1, 0, 0, 0, 0,
-                        "seq_zero"},
+                        "seq_zero", OOC_ID_packet_format},
     {         OOC_SYMBOL_seq_zero,
       &(osdp_conformance.seq_zero.test_status),
       1, 0, 0, 0, 0,
-                        "seq_zero"},
+                        "seq_zero", OOC_ID_seq_zero},
     {         OOC_SYMBOL_SOM,
       &(osdp_conformance.SOM.test_status),
       1, 0, 0, 0, 0,
-                        "SOM" },
+                        "SOM", OOC_ID_SOM },
     {         OOC_SYMBOL_SOM_sent,
       &(osdp_conformance.SOM_sent.test_status),
       1, 0, 0, 0, 0,
-                        "SOM_sent" },
+                        "SOM_sent", OOC_ID_SOM_sent },
     { "2-11-1", &(osdp_conformance.ADDR.test_status),
       1, 0, 0, 0, 0, "---" }, // ??
     { "2-11-2", &(osdp_conformance.address_2.test_status),
@@ -204,11 +221,11 @@ OSDP_CONFORMANCE_TEST
     {         OOC_SYMBOL_LEN,
       &(osdp_conformance.LEN.test_status),
       1, 0, 0, 0, 0,
-                        "LEN" },
+                        "LEN", OOC_ID_LEN },
     {         OOC_SYMBOL_CTRL,
       &(osdp_conformance.CTRL.test_status),
       1, 0, 0, 0, 0,
-                        "CTRL" },
+                        "CTRL", OOC_ID_CTRL },
     { "2-13-2", &(osdp_conformance.control_2.test_status),
       1, 0, 0, 0, 0, "---" }, // ??
     { "2-13-3", &(osdp_conformance.ctl_seq.test_status),
@@ -222,7 +239,7 @@ OSDP_CONFORMANCE_TEST
     {         OOC_SYMBOL_CMND_REPLY,
       &(osdp_conformance.CMND_REPLY.test_status),
       1, 0, 0, 0, 0,
-                        "Command/Reply"},
+                        "Command/Reply", OOC_ID_CMND_REPLY},
     { "2-15-2", &(osdp_conformance.invalid_command.test_status),
       1, 0, 0, 0, 0, "---" }, // ??
     { "2-16-1", &(osdp_conformance.CHKSUM_CRC16.test_status),
@@ -239,17 +256,17 @@ OSDP_CONFORMANCE_TEST
     {         OOC_SYMBOL_cmd_id,
       &(osdp_conformance.cmd_id.test_status),
       1, 0, 0, 0, 0,
-                        "Command: ID"},
+                        "Command: ID", OOC_ID_cmd_id},
     {         OOC_SYMBOL_cmd_cap,
       &(osdp_conformance.cmd_cap.test_status),
       1, 0, 0, 0, 0,
-                        "Command: PDCAP"},
+                        "Command: PDCAP", OOC_ID_cmd_cap},
     { "3-4-1", &(osdp_conformance.cmd_diag.test_status),
       1, 0, 0, 0, 0, "---" }, // optional in all cases
     {         OOC_SYMBOL_cmd_lstat,
       &(osdp_conformance.cmd_lstat.test_status),
       1, 0, 0, 0, 0,
-                        "Command: LSTAT"},
+                        "Command: LSTAT", OOC_ID_cmd_lstat},
     { "3-7-1", &(osdp_conformance.cmd_ostat.test_status),
       1, 0, 0, 0, 0, "---" },
     { "3-7-2", &(osdp_conformance.cmd_ostat_ack.test_status),
@@ -261,31 +278,31 @@ OSDP_CONFORMANCE_TEST
     {         OOC_SYMBOL_cmd_led_red,
       &(osdp_conformance.cmd_led_red.test_status),
       0, 0, 0, 0, 0,
-                        "Command: LED(Red)"},
+                        "Command: LED(Red)", OOC_ID_cmd_led_red},
     {         OOC_SYMBOL_cmd_led_green,
       &(osdp_conformance.cmd_led_green.test_status),
       0, 0, 0, 0, 0,
-                        "Command: LED(Green)"},
+                        "Command: LED(Green)", OOC_ID_cmd_led_green},
     {         OOC_SYMBOL_cmd_buz,
       &(osdp_conformance.cmd_buz.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_BUZ"},
+                        "Command: osdp_BUZ", OOC_ID_cmd_buz},
     {         OOC_SYMBOL_cmd_comset,
       &(osdp_conformance.cmd_comset.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_COMSET"},
+                        "Command: osdp_COMSET", OOC_ID_cmd_comset},
     {         OOC_SYMBOL_cmd_keyset,
       &(osdp_conformance.cmd_keyset.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_KEYSET"},
+                        "Command: osdp_KEYSET", OOC_ID_cmd_keyset},
     {         OOC_SYMBOL_cmd_chlng,
       &(osdp_conformance.cmd_chlng.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_CHLNG"},
+                        "Command: osdp_CHLNG", OOC_ID_cmd_chlng},
     {         OOC_SYMBOL_cmd_scrypt,
       &(osdp_conformance.cmd_scrypt.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_SCRYPT"},
+                        "Command: osdp_SCRYPT", OOC_ID_cmd_scrypt},
     { "3-16-1", &(osdp_conformance.cmd_prompt.test_status),
       0, 0, 0, 0, 0, "---" },
     { "3-17-1", &(osdp_conformance.cmd_bioread.test_status),
@@ -295,11 +312,11 @@ OSDP_CONFORMANCE_TEST
     {         OOC_SYMBOL_cmd_bioread,
       &(osdp_conformance.cmd_bioread.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_BIOREAD"},
+                        "Command: osdp_BIOREAD", OOC_ID_cmd_bioread},
     {         OOC_SYMBOL_cmd_biomatch,
       &(osdp_conformance.cmd_biomatch.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_BIOMATCH"},
+                        "Command: osdp_BIOMATCH", OOC_ID_cmd_biomatch},
     { "3-21-1", &(osdp_conformance.cmd_stop_multi.test_status),
       0, 0, 0, 0, 0, "---" },
     { "3-22-1", &(osdp_conformance.cmd_max_rec.test_status),
@@ -310,65 +327,65 @@ OSDP_CONFORMANCE_TEST
     {         OOC_SYMBOL_cmd_acurxsize,
       &(osdp_conformance.cmd_acurxsize.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_ACURXSIZE"},
+                        "Command: osdp_ACURXSIZE", OOC_ID_cmd_acurxsize},
     {         OOC_SYMBOL_cmd_filetransfer,
       &(osdp_conformance.cmd_filetransfer.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_FILETRANSFER"},
+                        "Command: osdp_FILETRANSFER", OOC_ID_cmd_filetransfer},
     {         OOC_SYMBOL_resp_istatr,
       &(osdp_conformance.resp_istatr.test_status),
       1, 1, 1, 1, 0,
-                        "Response: LSTATR (power)"},
+                        "Response: LSTATR (power)", OOC_ID_resp_istatr},
     {         OOC_SYMBOL_cmd_keepactive,
       &(osdp_conformance.cmd_keepactive.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_KEEPACTIVE"},
+                        "Command: osdp_KEEPACTIVE", OOC_ID_cmd_keepactive},
     {         OOC_SYMBOL_cmd_mfg,
       &(osdp_conformance.cmd_mfg.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_MFG"},
+                        "Command: osdp_MFG", OOC_ID_cmd_mfg},
     {         OOC_SYMBOL_cmd_pivdata,
       &(osdp_conformance.cmd_pivdata.test_status),
       0, 0, 0, 0, 0,
-                        "Command: osdp_PIVDATA"},
+                        "Command: osdp_PIVDATA", OOC_ID_cmd_pivdata},
 
 
     {         OOC_SYMBOL_rep_device_ident,
       &(osdp_conformance.rep_device_ident.test_status),
       1, 1, 1, 1, 0,
-                        "rep_device_ident"},
+                        "rep_device_ident", OOC_ID_rep_device_ident},
     {         OOC_SYMBOL_rep_pdid_check,
       &(osdp_conformance.rep_pdid_check.test_status),
       1, 1, 1, 1, 0,
-                        "Response: PDID (check)"},
+                        "Response: PDID (check)", OOC_ID_rep_pdid_check},
     {         OOC_SYMBOL_resp_ftstat,
       &(osdp_conformance.resp_ftstat.test_status),
       0, 0, 0, 0, 0,
-                        "Response: osdp_FTSTAT"},
+                        "Response: osdp_FTSTAT", OOC_ID_resp_ftstat},
     {         OOC_SYMBOL_rep_nak,
       &(osdp_conformance.rep_nak.test_status),
       1, 1, 1, 1, 0,
-                        "Response: NAK" },
+                        "Response: NAK", OOC_ID_rep_nak },
     {         OOC_SYMBOL_resp_pivdatar,
       &(osdp_conformance.resp_pivdatar.test_status),
       0, 0, 0, 0, 0,
-                        "Response: osdp_PIVDATAR"},
+                        "Response: osdp_PIVDATAR", OOC_ID_resp_pivdatar},
 
     {         OOC_SYMBOL_rep_device_capas,
       &(osdp_conformance.rep_device_capas.test_status),
       1, 1, 1, 1, 0,
-                        "Response: PDCAP" },
+                        "Response: PDCAP", OOC_ID_rep_device_capas },
     { "4-4-2", &(osdp_conformance.rep_capas_consistent.test_status),
       1, 1, 1, 1, 0,
                         "Response: PDCAP (check)" },
     {         OOC_SYMBOL_resp_lstatr_tamper,
       &(osdp_conformance.resp_lstatr_tamper.test_status),
       1, 1, 1, 1, 0,
-                        "Response: LSTATR (tamper)"},
+                        "Response: LSTATR (tamper)", OOC_ID_resp_lstatr_tamper},
     {         OOC_SYMBOL_resp_lstatr_power,
       &(osdp_conformance.resp_lstatr_power.test_status),
       1, 1, 1, 1, 0,
-                        "Response: LSTATR (power)"},
+                        "Response: LSTATR (power)", OOC_ID_resp_lstatr_power},
     { "4-6-2", &(osdp_conformance.resp_input_consistent.test_status),
       1, 0, 0, 0, 0, "---" },
     { "4-7-2", &(osdp_conformance.resp_ostatr_poll.test_status),
@@ -380,7 +397,7 @@ OSDP_CONFORMANCE_TEST
     {         OOC_SYMBOL_rep_raw,
       &(osdp_conformance.rep_raw.test_status),
       0, 0, 0, 0, 0,
-                        "Response: osdp_RAW"},
+                        "Response: osdp_RAW", OOC_ID_rep_raw},
     { "4-10-1", &(osdp_conformance.rep_formatted.test_status),
       0, 0, 0, 0, 0, "---" },
     { "4-11-1", &(osdp_conformance.resp_keypad.test_status),
@@ -390,7 +407,7 @@ OSDP_CONFORMANCE_TEST
     {         OOC_SYMBOL_resp_com,
       &(osdp_conformance.resp_com.test_status),
       0, 0, 0, 0, 0,
-                        "Response: osdp_COM"},
+                        "Response: osdp_COM", OOC_ID_resp_com},
     { "4-13-1", &(osdp_conformance.rep_scan_send.test_status),
       0, 0, 0, 0, 0, "---" },
     { "4-14-1", &(osdp_conformance.rep_scan_match.test_status),
@@ -400,14 +417,20 @@ OSDP_CONFORMANCE_TEST
     {         OOC_SYMBOL_resp_busy,
       &(osdp_conformance.resp_busy.test_status),
       0, 0, 0, 0, 0,
-                        "Response: osdp_BUSY"},
+                        "Response: osdp_BUSY", OOC_ID_resp_busy},
     { OOC_SYMBOL_resp_ccrypt, &(osdp_conformance.resp_ccrypt.test_status),
-      0, 0, 0, 0, 0, "Response: osdp_CCRYPT" },
+      0, 0, 0, 0, 0, "Response: osdp_CCRYPT", OOC_ID_resp_ccrypt },
     { OOC_SYMBOL_resp_rmac_i, &(osdp_conformance.resp_rmac_i.test_status),
-      0, 0, 0, 0, 0, "Response: osdp_RMAC_I" },
+      0, 0, 0, 0, 0, "Response: osdp_RMAC_I", OOC_ID_resp_rmac_i },
     { NULL, NULL, 0, 0, 0, 0, 0, "---" }
   };
 
+// each test has the results record with its index, below the ones added
+// by name
+
+_Static_assert (OOC_TESTS <= OSDP_RESULTS_ADHOC,
+  "test_control has outgrown the results records (OSDP_RESULTS_ADHOC)");
+
 // code to configure tests to skip
 #include <oo-SKIP.c>
 
@@ -480,15 +503,15 @@ void
 
   if (oconf->conforming_messages >= PARAM_MMT)
   {
-    osdp_test_set_status(OOC_SYMBOL_physical_interface, OCONFORM_EXERCISED);
+    osdp_test_set_status(OOC_ID_physical_interface, OCONFORM_EXERCISED);
     if (0 EQUALS strcmp (ctx->serial_speed, "9600"))
-      osdp_test_set_status(OOC_SYMBOL_signalling, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_signalling, OCONFORM_EXERCISED);
       //oconf->signalling.test_status = OCONFORM_EXERCISED;
-    osdp_test_set_status(OOC_SYMBOL_SOM, OCONFORM_EXERCISED);
-    osdp_test_set_status(OOC_SYMBOL_packet_format, OCONFORM_EXERCISED);
-    osdp_test_set_status(OOC_SYMBOL_SOM_sent, OCONFORM_EXERCISED);
-    osdp_test_set_status(OOC_SYMBOL_LEN, OCONFORM_EXERCISED);
-    osdp_test_set_status(OOC_SYMBOL_CTRL, OCONFORM_EXERCISED);
+    osdp_test_set_status(OOC_ID_SOM, OCONFORM_EXERCISED);
+    osdp_test_set_status(OOC_ID_packet_format, OCONFORM_EXERCISED);
+    osdp_test_set_status(OOC_ID_SOM_sent, OCONFORM_EXERCISED);
+    osdp_test_set_status(OOC_ID_LEN, OCONFORM_EXERCISED);
+    osdp_test_set_status(OOC_ID_CTRL, OCONFORM_EXERCISED);
     oconf->CHKSUM_CRC16.test_status =
       OCONFORM_EXERCISED;
   };
@@ -794,7 +817,7 @@ int
 
 { /* osdp_conform_confirm */
 
-  return(osdp_test_set_status(test, OCONFORM_EXERCISED));
+  return (osdp_test_update (osdp_test_lookup (test), OCONFORM_EXERCISED, NULL));
 
 } /* osdp_conform_confirm */
 
@@ -804,7 +827,7 @@ int
     (char
       *test)
 {
-  return (osdp_test_set_status (test, OCONFORM_FAIL));
+  return (osdp_test_update (osdp_test_lookup (test), OCONFORM_FAIL, NULL));
 }
 
 
@@ -933,147 +956,109 @@ OSDP_SCORE_COUNTERS
 } /* osdp_report */
 
 
+/*
+  osdp_test_lookup - the test_control index for a test name, -1 if none
+*/
+
+int
+  osdp_test_lookup
+    (char *test)
+
+{ /* osdp_test_lookup */
+
+  int i;
+  int idx;
+
+
+  idx = -1;
+  for (i=0; (idx EQUALS -1) && (test_control [i].name != NULL); i++)
+    if (strcmp (test_control [i].name, test) EQUALS 0)
+      idx = i;
+  if (idx EQUALS -1)
+    fprintf (stderr, "Cannot find test %s, not updated.\n", test);
+  return (idx);
+
+} /* osdp_test_lookup */
+
+
+/*
+  osdp_test_set_status - record a test's result, by OOC_ID_
+
+  the first time through the test_control index of each ID is found.
+*/
+
 int
   osdp_test_set_status
-    (char *test,
+    (int test,
     int test_status)
 
 { /* osdp_test_set_status */
 
-  int done;
-  int idx;
-  FILE *rf;
-  char results_filename [1024];
-  int status;
+  return (osdp_test_set_status_ex (test, test_status, NULL));
 
+} /* osdp_test_set_status */
 
-  status = ST_OK;
-  idx = 0;
-  done = 0;
-  while (!done)
-  {
-    //DEBUG
-    if (0) // (context.verbosity > 9)
-    {
-      fprintf(context.log, "osdp_test_set_status: checking %d.\n", idx);
-      fflush(context.log);
-      fprintf(context.log, "osdp_test_set_status: name %s\n", test_control [idx].name);
-      fflush(context.log);
-    };
-    if (test_control [idx].name != NULL)
-    {
-      if (strcmp (test_control [idx].name, test) EQUALS 0)
-    {
-      *(test_control [idx].conformance) = test_status;
-      sprintf(results_filename, "/opt/osdp-conformance/results/%s-results.json",
-        test);
-      rf = fopen(results_filename, "w");
-      if (rf)
-      {
-        time_t current_time;
-        char test_time [1024];
-
-        current_time = time(NULL);
-        strcpy(test_time, asctime(localtime(&current_time)));
-        if (test_time [strlen(test_time)-1] == '\n')
-          test_time [strlen(test_time)-1] = 0;
-        fprintf(rf, "{\"test\":\"%s\",\"test-status\":\"%d\",\n",
-          test, test_status);
-        fprintf(rf, " \"test-time\":\"%s\",\"test-description\":\"%s\"}\n",
-          test_time, test_control [idx].description);
-        fclose(rf);
-      }
-      else
-      {
-        fprintf(context.log, "Error writing results for %s\n", test);
-      };
-      done = 1;
-    };
-    };
-    if (test_control [idx].name EQUALS NULL)
-    {
-      fprintf (stderr, "Cannot find test %s, not updated.\n",
-        test);
-      done = 1;
-    };
-    // yes, if we find nothing we'll still return OK
-    idx++;
-  };
-  return (status);
 
-} /* osdp_test_set_status */
+/*
+  osdp_test_set_status_ex - record a test's result and some details
 
+  aux is JSON name/value pairs, each with a trailing comma.  NULL or ""
+  for none.
+*/
 
 int
   osdp_test_set_status_ex
-    (char *test,
+    (int test,
     int test_status,
     char *aux)
 
-{ /* osdp_test_set-status_ex */
+{ /* osdp_test_set_status_ex */
 
-  int done;
+  int i;
   int idx;
-  char results_filename [1024];
-  FILE *rf;
-  int status;
+  static int indexed;
 
 
-  status = ST_OK;
-  idx = 0;
-  done = 0;
-  while (!done)
+  if (!indexed)
   {
-    if (context.verbosity > 9)
-    {
-      fprintf(context.log, "osdp_test_set_status: checking %d.\n", idx);
-      fflush(context.log);
-      fprintf(context.log, "osdp_test_set_status: name %s\n", test_control [idx].name);
-      fflush(context.log);
-    };
-    if (test_control [idx].name != NULL)
-    {
-      if (strcmp (test_control [idx].name, test) EQUALS 0)
-      {
-        *(test_control [idx].conformance) = test_status;
-        sprintf(results_filename, "/opt/osdp-conformance/results/%s-results.json",
-          test);
-        rf = fopen(results_filename, "w");
-        if (rf)
-        {
-          time_t current_time;
-          char test_time [1024];
-
-        current_time = time(NULL);
-        strcpy(test_time, asctime(localtime(&current_time)));
-        if (test_time [strlen(test_time)-1] == '\n')
-          test_time [strlen(test_time)-1] = 0;
-        fprintf(rf, "{\"test\":\"%s\",\"test-status\":\"%d\",\n",
-          test, test_status);
-        fprintf(rf, " \"test-time\":\"%s\",\"test-description\":\"%s\",\n",
-          test_time, test_control [idx].description);
-        if (strlen(aux) > 0)
-          fprintf(rf, "%s", aux);
-        fprintf(rf, "\"_\":\"_\"}\n");
-        fclose(rf);
-      }
-      else
-      {
-        fprintf(context.log, "Error writing results for %s\n", test);
-      };
-      done = 1;
-    };
-    };
-    if (test_control [idx].name EQUALS NULL)
-    {
-      fprintf (stderr, "Cannot find test %s, not updated.\n",
-        test);
-      done = 1;
-    };
-    // yes, if we find nothing we'll still return OK
-    idx++;
+    // entry number plus one, so 0 is "not in the table"
+
+    for (i=OOC_TESTS-1; i>=0; i--)
+      if ((test_control [i].id > 0) && (test_control [i].id < OOC_ID_MAX))
+        osdp_test_index [test_control [i].id] = i + 1;
+    indexed = 1;
   };
-  return (status);
+  idx = -1;
+  if ((test > 0) && (test < OOC_ID_MAX))
+    idx = osdp_test_index [test] - 1;
+  if (idx EQUALS -1)
+    fprintf (stderr, "Cannot find test %d, not updated.\n", test);
+  return (osdp_test_update (idx, test_status, aux));
 
-} /* osdp_test_set_status */
+} /* osdp_test_set_status_ex */
+
+
+/*
+  osdp_test_update - set a test's status, and its record in the results file
+
+  returns ST_OK even if there is no such test.
+*/
+
+int
+  osdp_test_update
+    (int idx,
+    int test_status,
+    char *aux)
+
+{ /* osdp_test_update */
+
+  if (idx >= 0)
+  {
+    *(test_control [idx].conformance) = test_status;
+    (void)osdp_results_set (idx, test_control [idx].name,
+      test_control [idx].description, test_status, aux);
+  };
+  return (ST_OK);
+
+} /* osdp_test_update */
 
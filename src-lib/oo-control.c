@@ -0,0 +1,406 @@
+/*
+  oo-control - commands over the control socket
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  The command breech was: write open_osdp_command.json, then poke the
+  control socket.  That still works.  A connection whose first line is a
+  whole JSON object is taken as a stream of commands instead, one JSON
+  object per line, as many as it likes.  Each gets a line back:
+
+    {"line":"1","status":"0","queued":"0"}
+
+  (status is the ST_ code, queued the commands waiting in the queue.)
+  The replies for everything that arrived in one read go back in one
+  write.  Anything else (e.g. open-osdp-kick's "00", or a multi-line
+  command file) is a poke, and the command file is read as before.
+
+  Replies the socket does not take at once are kept (conn->out) and sent
+  as the socket becomes writable; meanwhile no more is read from that
+  connection.  One that falls OSDP_CONTROL_OUT_MAX behind is closed.
+*/
+
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+
+#include <jansson.h>
+
+
+#include <open-osdp.h>
+
+
+void
+  osdp_control_close
+    (OSDP_EVENT_LOOP *loop,
+    OSDP_CONTROL_CONN *conn);
+int
+  osdp_control_flush
+    (OSDP_EVENT_LOOP *loop,
+    OSDP_CONTROL_CONN *conn);
+int
+  osdp_control_line
+    (OSDP_CONTEXT *ctx,
+    OSDP_CONTROL_CONN *conn,
+    char *line,
+    char *reply);
+int
+  osdp_control_reply
+    (OSDP_CONTEXT *ctx,
+    OSDP_CONTROL_CONN *conn,
+    char *reply);
+
+
+/*
+  osdp_control_accept - take a connection on the control socket
+*/
+
+int
+  osdp_control_accept
+    (OSDP_CONTEXT *ctx,
+    OSDP_EVENT_LOOP *loop,
+    int ufd)
+
+{ /* osdp_control_accept */
+
+  int c1;
+  OSDP_CONTROL_CONN *conn;
+  int i;
+  int status;
+
+
+  status = ST_OK;
+  conn = NULL;
+  c1 = accept (ufd, NULL, NULL);
+  if (c1 != -1)
+  {
+    for (i=0; (conn EQUALS NULL) && (i<OSDP_CONTROL_MAX); i++)
+      if (!(ctx->control [i].active))
+        conn = &(ctx->control [i]);
+    if (conn != NULL)
+      status = osdp_loop_watch (loop, c1);
+    if ((conn EQUALS NULL) || (status != ST_OK))
+    {
+      fprintf (ctx->log, "control connection refused, %d already open\n",
+        OSDP_CONTROL_MAX);
+      close (c1);
+      status = ST_OK;
+    }
+    else
+    {
+      (void)fcntl (c1, F_SETFL, fcntl (c1, F_GETFL, 0) | O_NONBLOCK);
+      conn->active = 1;
+      conn->fd = c1;
+      conn->mode = OSDP_CONTROL_UNDECIDED;
+      conn->lines = 0;
+      conn->lth = 0;
+      conn->closing = 0;
+      conn->out_wait = 0;
+      conn->out_lth = 0;
+      if (ctx->verbosity > 9)
+        fprintf (stderr, "control connection %d\n", c1);
+    };
+  };
+  return (status);
+
+} /* osdp_control_accept */
+
+
+void
+  osdp_control_close
+    (OSDP_EVENT_LOOP *loop,
+    OSDP_CONTROL_CONN *conn)
+
+{ /* osdp_control_close */
+
+  (void)osdp_loop_unwatch (loop, conn->fd);
+  close (conn->fd);
+  conn->active = 0;
+  conn->out_lth = 0;
+
+} /* osdp_control_close */
+
+
+/*
+  osdp_control_flush - send the replies the socket will take
+
+  the rest are kept and the connection is watched for output (and not
+  input) until they are all sent.  returns ST_CONTROL_OUT if the other end
+  is gone.
+*/
+
+int
+  osdp_control_flush
+    (OSDP_EVENT_LOOP *loop,
+    OSDP_CONTROL_CONN *conn)
+
+{ /* osdp_control_flush */
+
+  int done;
+  int sent;
+  int status;
+  int status_io;
+
+
+  status = ST_OK;
+  done = 0;
+  sent = 0;
+  while ((!done) && (sent < conn->out_lth))
+  {
+    status_io = send (conn->fd, conn->out + sent, conn->out_lth - sent,
+      MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (status_io > 0)
+      sent = sent + status_io;
+    else
+      if (errno != EINTR)
+      {
+        // full (the rest goes when it's writable) or gone
+
+        done = 1;
+        if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+          status = ST_CONTROL_OUT;
+      };
+  };
+  if (sent > 0)
+  {
+    conn->out_lth = conn->out_lth - sent;
+    memmove (conn->out, conn->out + sent, conn->out_lth);
+  };
+
+  // only change what the loop waits for when it goes to or from a backlog
+
+  if ((status EQUALS ST_OK) && ((conn->out_lth > 0) != conn->out_wait))
+  {
+    conn->out_wait = (conn->out_lth > 0);
+    status = osdp_loop_interest (loop, conn->fd, !(conn->out_wait),
+      conn->out_wait);
+  };
+  return (status);
+
+} /* osdp_control_flush */
+
+
+/*
+  osdp_control_line - run one inline command, putting its reply in reply
+*/
+
+int
+  osdp_control_line
+    (OSDP_CONTEXT *ctx,
+    OSDP_CONTROL_CONN *conn,
+    char *line,
+    char *reply)
+
+{ /* osdp_control_line */
+
+  OSDP_COMMAND cmd;
+  int status;
+
+
+  conn->lines ++;
+  memset (&cmd, 0, sizeof (cmd));
+  status = osdp_command_parse (ctx, line, &cmd);
+  if ((status EQUALS ST_OK) && (cmd.command != OSDP_CMD_NOOP))
+    status = process_command (cmd.command, ctx, cmd.details_length,
+      cmd.details_param_1, (char *)cmd.details);
+  sprintf (reply,
+    "{\"line\":\"%d\",\"status\":\"%d\",\"queued\":\"%d\"}\n",
+    conn->lines, status, osdp_command_queue_count (ctx));
+  return (status);
+
+} /* osdp_control_line */
+
+
+/*
+  osdp_control_reply - add a reply to what goes back on a connection
+
+  returns ST_CONTROL_OUT if there is no room; the connection has fallen
+  too far behind and is to be closed.
+*/
+
+int
+  osdp_control_reply
+    (OSDP_CONTEXT *ctx,
+    OSDP_CONTROL_CONN *conn,
+    char *reply)
+
+{ /* osdp_control_reply */
+
+  int lth;
+  int status;
+
+
+  status = ST_OK;
+  lth = strlen (reply);
+  if ((conn->out_lth + lth) > sizeof (conn->out))
+  {
+    fprintf (ctx->log,
+      "control connection %d closed, %d octets of replies not taken\n",
+      conn->fd, conn->out_lth);
+    status = ST_CONTROL_OUT;
+  }
+  else
+  {
+    memcpy (conn->out + conn->out_lth, reply, lth);
+    conn->out_lth = conn->out_lth + lth;
+  };
+  return (status);
+
+} /* osdp_control_reply */
+
+
+/*
+  osdp_control_service - read what the control connections sent and act on it
+
+  processed is set to the number of commands run (a poke counts as one.)
+*/
+
+int
+  osdp_control_service
+    (OSDP_CONTEXT *ctx,
+    OSDP_EVENT_LOOP *loop,
+    int *processed)
+
+{ /* osdp_control_service */
+
+  OSDP_CONTROL_CONN *conn;
+  int done;
+  char *eol;
+  int i;
+  int poke;
+  char reply [1024];
+  json_t *root;
+  char *start;
+  int status;
+  int status_io;
+
+
+  status = ST_OK;
+  *processed = 0;
+  for (i=0; i<OSDP_CONTROL_MAX; i++)
+  {
+    conn = &(ctx->control [i]);
+    if (conn->active && (osdp_loop_ready (loop, conn->fd) ||
+      osdp_loop_writable (loop, conn->fd)))
+    {
+      done = 0;
+      poke = 0;
+
+      // nothing is read while there are replies waiting to go
+
+      if ((!conn->closing) && (!conn->out_wait) &&
+        osdp_loop_ready (loop, conn->fd))
+      {
+        status_io = recv (conn->fd, conn->buf + conn->lth,
+          sizeof (conn->buf) - 2 - conn->lth, MSG_DONTWAIT);
+        if (status_io > 0)
+          conn->lth = conn->lth + status_io;
+        else
+          if ((status_io EQUALS 0) ||
+            ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)))
+          {
+            // closed.  a last line with no newline still counts
+            conn->closing = 1;
+            if ((conn->lth > 0) && (conn->buf [conn->lth-1] != '\n'))
+            {
+              conn->buf [conn->lth] = '\n';
+              conn->lth ++;
+            };
+          };
+      };
+      conn->buf [conn->lth] = 0;
+      start = conn->buf;
+      eol = strchr (start, '\n');
+      while ((!done) && (!poke) && (eol != NULL))
+      {
+        *eol = 0;
+        if (conn->mode EQUALS OSDP_CONTROL_UNDECIDED)
+        {
+          root = json_loads (start, 0, NULL);
+          if (json_is_object (root))
+            conn->mode = OSDP_CONTROL_INLINE;
+          else
+            poke = 1;
+          if (root != NULL)
+            json_decref (root);
+        };
+        if ((conn->mode EQUALS OSDP_CONTROL_INLINE) && (strlen (start) > 0))
+        {
+          (void)osdp_control_line (ctx, conn, start, reply);
+          if (osdp_control_reply (ctx, conn, reply) != ST_OK)
+            done = 1;
+          (*processed) ++;
+
+          // the replies go out in one write unless there are lots of them
+          if ((!done) && (conn->out_lth > sizeof (conn->out) / 2))
+            if (osdp_control_flush (loop, conn) != ST_OK)
+              done = 1;
+        };
+        start = eol + 1;
+        eol = strchr (start, '\n');
+      };
+      if (poke)
+      {
+        status = process_current_command (ctx);
+        if (status EQUALS ST_OK)
+          preserve_current_command ();
+        status = ST_OK;
+        (*processed) ++;
+        done = 1;
+      }
+      else
+      {
+        // keep the part line for next time.  one too long to ever end is
+        // refused.
+
+        conn->lth = conn->lth - (start - conn->buf);
+        memmove (conn->buf, start, conn->lth);
+        if ((!done) && (conn->lth >= sizeof (conn->buf) - 2))
+        {
+          conn->lines ++;
+          sprintf (reply,
+            "{\"line\":\"%d\",\"status\":\"%d\",\"queued\":\"%d\"}\n",
+            conn->lines, ST_CMD_OVERFLOW, osdp_command_queue_count (ctx));
+          if (osdp_control_reply (ctx, conn, reply) != ST_OK)
+            done = 1;
+          conn->lth = 0;
+        };
+      };
+      if (!done)
+        if (osdp_control_flush (loop, conn) != ST_OK)
+          done = 1;
+
+      // once the other end is done sending it's closed when all its
+      // replies are gone
+
+      if (conn->closing && (conn->out_lth EQUALS 0))
+        done = 1;
+      if (done)
+        osdp_control_close (loop, conn);
+    };
+  };
+  return (status);
+
+} /* osdp_control_service */
+
@@ -82,3 +82,16 @@ unsigned short int
   return nCrc;
 }
 
+
+
+// same table, one octet at a time, for a CRC kept running as octets arrive
+unsigned short int
+  fCrcByte
+  (unsigned short int
+    nCrc,
+  unsigned char
+    nData)
+
+{
+  return (unsigned short int)((nCrc<<8) ^ CrcTable[ ((nCrc>>8) ^ nData) & 0xFF]);
+}
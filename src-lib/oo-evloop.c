@@ -0,0 +1,345 @@
+/*
+  oo-evloop - epoll/timerfd event loop
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Each OSDP_TIMER gets a timerfd armed (absolute, CLOCK_MONOTONIC) for
+  its due time, so the loop wakes exactly when the response timer or the
+  statistics/summary timers expire instead of on a fixed tick.  The
+  timerfd is only re-armed when the timer's due time changes.
+
+  Descriptors are watched for input.  One with output waiting (a control
+  connection whose replies the socket did not take all of) is watched for
+  output as well until it drains; see osdp_loop_interest.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+
+#include <open-osdp.h>
+
+
+int
+  osdp_loop_init
+    (OSDP_EVENT_LOOP *loop)
+
+{ /* osdp_loop_init */
+
+  struct epoll_event event;
+  int i;
+  int status;
+
+
+  status = ST_OK;
+  memset (loop, 0, sizeof (*loop));
+  for (i=0; i<OSDP_TIMER_MAX; i++)
+    loop->timer_fd [i] = -1;
+  loop->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+  if (loop->epoll_fd EQUALS -1)
+    status = ST_EVENT_LOOP_ERROR;
+  for (i=0; (status EQUALS ST_OK) && (i<OSDP_TIMER_MAX); i++)
+  {
+    loop->timer_fd [i] = timerfd_create (CLOCK_MONOTONIC,
+      TFD_NONBLOCK | TFD_CLOEXEC);
+    if (loop->timer_fd [i] EQUALS -1)
+      status = ST_EVENT_LOOP_ERROR;
+    if (status EQUALS ST_OK)
+    {
+      memset (&event, 0, sizeof (event));
+      event.events = EPOLLIN;
+      event.data.fd = loop->timer_fd [i];
+      if (-1 EQUALS epoll_ctl (loop->epoll_fd, EPOLL_CTL_ADD,
+        loop->timer_fd [i], &event))
+        status = ST_EVENT_LOOP_ERROR;
+    };
+  };
+  if (status != ST_OK)
+    fprintf (stderr, "event loop setup failed (%d)\n", status);
+  return (status);
+
+} /* osdp_loop_init */
+
+
+/*
+  osdp_loop_interest - what to wait for on a watched descriptor
+
+  input and output are 1 to wait for the descriptor to be readable or
+  writable.  osdp_loop_watch starts it at input only.
+*/
+
+int
+  osdp_loop_interest
+    (OSDP_EVENT_LOOP *loop,
+    int fd,
+    int input,
+    int output)
+
+{ /* osdp_loop_interest */
+
+  struct epoll_event event;
+  int status;
+
+
+  memset (&event, 0, sizeof (event));
+  if (input)
+    event.events = event.events | EPOLLIN;
+  if (output)
+    event.events = event.events | EPOLLOUT;
+  event.data.fd = fd;
+  status = ST_OK;
+  if (-1 EQUALS epoll_ctl (loop->epoll_fd, EPOLL_CTL_MOD, fd, &event))
+    status = ST_EVENT_LOOP_ERROR;
+  return (status);
+
+} /* osdp_loop_interest */
+
+
+/*
+  osdp_loop_ready - was fd readable in the last osdp_loop_wait
+*/
+
+int
+  osdp_loop_ready
+    (OSDP_EVENT_LOOP *loop,
+    int fd)
+
+{ /* osdp_loop_ready */
+
+  int i;
+  int ready;
+
+
+  ready = 0;
+  for (i=0; i<loop->ready_count; i++)
+    if (loop->ready [i] EQUALS fd)
+      ready = 1;
+  return (ready);
+
+} /* osdp_loop_ready */
+
+
+/*
+  osdp_loop_unwatch - take a descriptor out of the loop (before closing it)
+*/
+
+int
+  osdp_loop_unwatch
+    (OSDP_EVENT_LOOP *loop,
+    int fd)
+
+{ /* osdp_loop_unwatch */
+
+  int i;
+  int j;
+  int status;
+
+
+  status = ST_EVENT_LOOP_ERROR;
+  for (i=0; i<loop->watched_count; i++)
+  {
+    if (loop->watched [i] EQUALS fd)
+    {
+      (void)epoll_ctl (loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+      for (j=i+1; j<loop->watched_count; j++)
+        loop->watched [j-1] = loop->watched [j];
+      loop->watched_count --;
+      status = ST_OK;
+    };
+  };
+  for (i=0; i<loop->ready_count; i++)
+    if (loop->ready [i] EQUALS fd)
+      loop->ready [i] = -1;
+  for (i=0; i<loop->writable_count; i++)
+    if (loop->writable [i] EQUALS fd)
+      loop->writable [i] = -1;
+  return (status);
+
+} /* osdp_loop_unwatch */
+
+
+/*
+  osdp_loop_wait - arm the timers and wait for activity
+
+  timeout_ms is passed to epoll_wait (-1 waits until a descriptor or a
+  timer is ready.)  returns the number of watched descriptors that are
+  readable or writable, like pselect, or -1 with errno set.
+  loop->timer_ready is set if a timer came due; call osdp_timeout to act
+  on it.
+*/
+
+int
+  osdp_loop_wait
+    (OSDP_EVENT_LOOP *loop,
+    OSDP_CONTEXT *ctx,
+    int timeout_ms)
+
+{ /* osdp_loop_wait */
+
+  struct epoll_event events [OSDP_LOOP_MAX_FDS + OSDP_TIMER_MAX];
+  unsigned long long expirations;
+  int i;
+  int is_timer;
+  int ready;
+  struct itimerspec setting;
+  int status_epoll;
+  int t;
+  struct timespec want;
+
+
+  for (t=0; t<OSDP_TIMER_MAX; t++)
+  {
+    memset (&want, 0, sizeof (want));
+    if ((t < ctx->timer_count) &&
+      (ctx->timer [t].status != OSDP_TIMER_STOPPED) &&
+      ((ctx->timer [t].i_sec > 0) || (ctx->timer [t].i_nsec > 0)))
+    {
+      want = ctx->timer [t].due;
+
+      // a timer that was never started is due now.  (0 would disarm it.)
+      if ((want.tv_sec EQUALS 0) && (want.tv_nsec EQUALS 0))
+        want.tv_nsec = 1;
+    };
+    if ((want.tv_sec != loop->armed [t].tv_sec) ||
+      (want.tv_nsec != loop->armed [t].tv_nsec))
+    {
+      memset (&setting, 0, sizeof (setting));
+      setting.it_value = want;
+      (void)timerfd_settime (loop->timer_fd [t], TFD_TIMER_ABSTIME,
+        &setting, NULL);
+      loop->armed [t] = want;
+    };
+  };
+
+  loop->ready_count = 0;
+  loop->writable_count = 0;
+  loop->timer_ready = 0;
+  ready = 0;
+  status_epoll = epoll_wait (loop->epoll_fd, events,
+    OSDP_LOOP_MAX_FDS + OSDP_TIMER_MAX, timeout_ms);
+  for (i=0; i<status_epoll; i++)
+  {
+    is_timer = 0;
+    for (t=0; t<OSDP_TIMER_MAX; t++)
+    {
+      if (events [i].data.fd EQUALS loop->timer_fd [t])
+      {
+        // armed [t] is left alone so an unserviced timer is not re-armed
+        (void)read (loop->timer_fd [t], &expirations, sizeof (expirations));
+        loop->timer_ready = 1;
+        is_timer = 1;
+      };
+    };
+    if (!is_timer)
+    {
+      // a hangup or an error reads as input so it gets noticed
+
+      if (events [i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+      {
+        loop->ready [loop->ready_count] = events [i].data.fd;
+        loop->ready_count ++;
+      };
+      if (events [i].events & EPOLLOUT)
+      {
+        loop->writable [loop->writable_count] = events [i].data.fd;
+        loop->writable_count ++;
+      };
+      ready ++;
+    };
+  };
+  if (status_epoll != -1)
+    status_epoll = ready;
+  return (status_epoll);
+
+} /* osdp_loop_wait */
+
+
+/*
+  osdp_loop_watch - add a descriptor to the loop (for input)
+
+  watching one that is already watched does nothing.
+*/
+
+int
+  osdp_loop_watch
+    (OSDP_EVENT_LOOP *loop,
+    int fd)
+
+{ /* osdp_loop_watch */
+
+  int already;
+  struct epoll_event event;
+  int i;
+  int status;
+
+
+  status = ST_OK;
+  already = 0;
+  for (i=0; i<loop->watched_count; i++)
+    if (loop->watched [i] EQUALS fd)
+      already = 1;
+  if (!already)
+  {
+    if ((fd EQUALS -1) || (loop->watched_count >= OSDP_LOOP_MAX_FDS))
+      status = ST_EVENT_LOOP_ERROR;
+  };
+  if ((status EQUALS ST_OK) && (!already))
+  {
+    memset (&event, 0, sizeof (event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (-1 EQUALS epoll_ctl (loop->epoll_fd, EPOLL_CTL_ADD, fd, &event))
+      status = ST_EVENT_LOOP_ERROR;
+  };
+  if ((status EQUALS ST_OK) && (!already))
+  {
+    loop->watched [loop->watched_count] = fd;
+    loop->watched_count ++;
+  };
+  return (status);
+
+} /* osdp_loop_watch */
+
+
+/*
+  osdp_loop_writable - was fd writable in the last osdp_loop_wait
+*/
+
+int
+  osdp_loop_writable
+    (OSDP_EVENT_LOOP *loop,
+    int fd)
+
+{ /* osdp_loop_writable */
+
+  int i;
+  int writable;
+
+
+  writable = 0;
+  for (i=0; i<loop->writable_count; i++)
+    if (loop->writable [i] EQUALS fd)
+      writable = 1;
+  return (writable);
+
+} /* osdp_loop_writable */
+
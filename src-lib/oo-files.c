@@ -405,12 +405,84 @@ int
 } /* osdp_send_filetransfer */
 
 
+/*
+  oo_status_publish - write osdp-status.json if it changed and it is time
+
+  at most status_rate times a second.  the main loop calls this so a
+  change that came too soon after the last write still goes out.  the
+  statistics segment is only memory so it is updated every time.
+*/
+
 int
-  oo_write_status
+  oo_status_publish
+    (OSDP_CONTEXT *ctx)
+
+{ /* oo_status_publish */
+
+  int status;
+
+
+  status = ST_OK;
+  osdp_stats_publish (ctx);
+  if (ctx->status_dirty && (oo_status_wait_ms (ctx) EQUALS 0))
+  {
+    ctx->status_dirty = 0;
+    clock_gettime (CLOCK_MONOTONIC, &(ctx->status_written));
+    status = oo_status_write (ctx);
+  };
+  return (status);
+
+} /* oo_status_publish */
+
+
+/*
+  oo_status_wait_ms - milliseconds until the status file is due
+
+  0 if it can be written now, -1 if it has not changed.
+*/
+
+int
+  oo_status_wait_ms
+    (OSDP_CONTEXT *ctx)
+
+{ /* oo_status_wait_ms */
+
+  long ms;
+  struct timespec now;
+
+
+  ms = -1;
+  if (ctx->status_dirty)
+  {
+    ms = 0;
+    if (ctx->status_rate > 0)
+    {
+      clock_gettime (CLOCK_MONOTONIC, &now);
+      ms = 1000l / ctx->status_rate -
+        ((now.tv_sec - ctx->status_written.tv_sec) * 1000l +
+        (now.tv_nsec - ctx->status_written.tv_nsec) / 1000000l);
+      if (ms < 0)
+        ms = 0;
+    };
+  };
+  return (ms);
+
+} /* oo_status_wait_ms */
+
+
+/*
+  oo_status_write - write osdp-status.json
+
+  it is written to a temporary file that is then renamed, so a reader
+  sees the old file or the new one, never part of one.
+*/
+
+int
+  oo_status_write
     (OSDP_CONTEXT
       *ctx)
 
-{ /* write_status */
+{ /* oo_status_write */
 
   char current_date_string [1024];
   time_t current_time;
@@ -422,6 +494,7 @@ int
   char statfile [2*1024];
   int status;
   char tag [1024];
+  char tempfile [2*1024+8];
   char val [1024];
 
 
@@ -438,7 +511,8 @@ int
     strcpy (tag, "MON");
   sprintf (statfile, "/opt/osdp-conformance/run/%s/osdp-status.json",
     tag);
-  sf = fopen (statfile, "w");
+  sprintf (tempfile, "%s.tmp", statfile);
+  sf = fopen (tempfile, "w");
   if (sf != NULL)
   {
     current_time = time (NULL);
@@ -479,6 +553,8 @@ int
     fprintf(sf,
 "\"dropped\" : \"%d\",\"octets\":\"%d\",", ctx->dropped_octets, ctx->bytes_received);
     fprintf(sf,
+"\"resync\" : \"%d\",\"resync-skipped\":\"%d\",", ctx->resync_events, ctx->resync_skipped);
+    fprintf(sf,
 "\"seq-bad\" : \"%d\",", ctx->seq_bad);
     fprintf (sf,
 "\"hash-ok\" : \"%d\", \"hash-bad\" : \"%d\",\n", ctx->hash_ok, ctx->hash_bad);
@@ -487,8 +563,65 @@ int
     fprintf (sf,
 "\"checksum_errs\" : \"%d\",", ctx->checksum_errs);
     fprintf(sf,
-"\"buffer-overflows\" : \"%d\",\n",
-      osdp_buf.overflow);
+"\"buffer-overflows\" : \"%d\", \"serial-write-errs\" : \"%d\",\n",
+      osdp_buf.overflow, ctx->serial_write_errs);
+    fprintf(sf,
+"\"turnaround-usec\" : \"%ld\", \"turnaround-min\" : \"%ld\", \"turnaround-avg\" : \"%lld\", \"turnaround-max\" : \"%ld\",\n",
+      ctx->turnaround.last, ctx->turnaround.min,
+      ctx->turnaround.count ? ctx->turnaround.total / ctx->turnaround.count : 0,
+      ctx->turnaround.max);
+    fprintf(sf,
+"\"frame-cache-hits\" : \"%d\", \"frame-cache-misses\" : \"%d\",\n",
+      ctx->frame_cache.hits, ctx->frame_cache.misses);
+    fprintf(sf,
+"\"retries\" : \"%d\", \"retries-recovered\" : \"%d\", \"retries-abandoned\" : \"%d\",\n",
+      ctx->retries, ctx->retries_recovered, ctx->retries_abandoned);
+    fprintf(sf,
+"\"actions-hooked\" : \"%d\", \"actions-queued\" : \"%d\", \"actions-dropped\" : \"%d\",\n",
+      ctx->actions_hooked, ctx->actions_queued, ctx->actions_dropped);
+    for (i=0; i<OSDP_COMMAND_LANES; i++)
+    {
+      OSDP_COMMAND_LANE *lane;
+      char *lane_name [OSDP_COMMAND_LANES] = {"setup", "normal", "bulk"};
+
+      lane = &(ctx->q.lane [i]);
+      fprintf(sf,
+"\"cmd-q-%s\" : \"%d\", \"cmd-q-%s-max\" : \"%d\", \"cmd-q-%s-overflow\" : \"%d\", \"cmd-q-%s-wait-avg-usec\" : \"%lld\", \"cmd-q-%s-wait-max-usec\" : \"%ld\",\n",
+        lane_name [i], lane->count, lane_name [i], lane->max_count,
+        lane_name [i], lane->overflow, lane_name [i],
+        (lane->enqueued - lane->count) ?
+          lane->wait_total / (lane->enqueued - lane->count) : 0,
+        lane_name [i], lane->wait_max);
+    };
+    for (i=0; (i EQUALS 0) || (i<ctx->port_count); i++)
+    {
+      OSDP_BUS *bus;
+      char prefix [16];
+
+      // without ports there is only the context's own bus.  ports past the
+      // first are tagged with their number.
+
+      bus = osdp_bus (ctx);
+      if (ctx->port_count > 0)
+        bus = ctx->port [i].bus;
+      prefix [0] = 0;
+      if (i > 0)
+      {
+        sprintf (prefix, "p%d-", i);
+        fprintf (sf, " \"port-%d\" : \"%s\",\n", i, ctx->port [i].device);
+      };
+      for (j=0; j<bus->count; j++)
+      {
+        OSDP_PD_SESSION *pd;
+
+        pd = &(bus->session [bus->order [j]]);
+        fprintf(sf,
+" \"%spd-%02x\" : \"online=%d polls=%d replies=%d timeouts=%d naks=%d strays=%d secure=%d\",\n",
+          prefix, bus->order [j], pd->online, pd->polls, pd->replies,
+          pd->timeouts, pd->naks, pd->strays,
+          (pd->sc.secure_channel_use [OO_SCU_ENAB] EQUALS OO_SCS_OPERATIONAL));
+      };
+    };
     for (j=0; j<OSDP_MAX_LED; j++)
     {
       if (ctx->led [j].state EQUALS OSDP_LED_ACTIVATED)
@@ -554,7 +687,8 @@ int
     fprintf(sf, "\"_#\" : \"_end\" ");
     fprintf (sf, "}\n");
 
-    fclose (sf);
+    if ((fclose (sf) != 0) || (rename (tempfile, statfile) != 0))
+      fprintf(ctx->log, "Error writing to %s\n", statfile);
   }
   else
   {
@@ -562,5 +696,22 @@ int
   };
   return (status);
 
+} /* oo_status_write */
+
+
+/*
+  oo_write_status - the status changed, write osdp-status.json (soon)
+*/
+
+int
+  oo_write_status
+    (OSDP_CONTEXT
+      *ctx)
+
+{ /* oo_write_status */
+
+  ctx->status_dirty = 1;
+  return (oo_status_publish (ctx));
+
 } /* oo_write_status */
 
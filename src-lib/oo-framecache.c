@@ -0,0 +1,122 @@
+/*
+  oo-framecache - prebuilt frames for POLL, ACK and the other fixed ones
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Most of what goes on the bus is POLL and ACK, and every one of them is
+  the same few octets given the address, sequence number, CRC/checksum
+  and direction.  The first time one of the commands below is sent with
+  a given address and sequence it is built as usual and kept; after that
+  it is copied out.  An entry built with a different check type,
+  direction or data octet is rebuilt (and replaced.)
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+
+
+#include <open-osdp.h>
+
+
+// what can be cached.  ID and CAP carry one octet, the rest none.
+
+int osdp_frame_cache_commands [OSDP_FRAME_CACHE_COMMANDS] =
+{
+  OSDP_POLL, OSDP_ACK, OSDP_ID, OSDP_CAP, OSDP_LSTAT, OSDP_ISTAT,
+  OSDP_OSTAT, OSDP_RSTAT, OSDP_BUSY
+};
+
+
+/*
+  osdp_build_message_cached - osdp_build_message, from the cache if it can
+
+  same arguments and results as osdp_build_message (cleartext only.)
+*/
+
+int
+  osdp_build_message_cached
+    (OSDP_CONTEXT *ctx,
+    unsigned char *buf,
+    int *updated_length,
+    unsigned char command,
+    int dest_addr,
+    int sequence,
+    int data_length,
+    unsigned char *data,
+    OSDP_MSG *frame)
+
+{ /* osdp_build_message_cached */
+
+  unsigned char data_octet;
+  unsigned char direction;
+  OSDP_CACHED_FRAME *entry;
+  int i;
+  int status;
+
+
+  status = ST_OK;
+  entry = NULL;
+  data_octet = 0;
+  if ((data_length EQUALS 1) && (data != NULL))
+    data_octet = *data;
+  if ((data_length >= 0) && (data_length <= 1) &&
+    (dest_addr >= 0) && (dest_addr < 0x80) &&
+    (sequence >= 0) && (sequence < 4))
+  {
+    for (i=0; i<OSDP_FRAME_CACHE_COMMANDS; i++)
+      if (command EQUALS osdp_frame_cache_commands [i])
+        entry = &(ctx->frame_cache.frame [i] [dest_addr] [sequence]);
+  };
+
+  direction = 0;
+  if (ctx->role EQUALS OSDP_ROLE_PD)
+    direction = 0x80;
+  if ((entry != NULL) && (entry->lth > 0) && (entry->check EQUALS m_check) &&
+    (entry->direction EQUALS direction) &&
+    (entry->data_length EQUALS data_length) && (entry->data EQUALS data_octet))
+  {
+    memcpy (buf, entry->frame, entry->lth);
+    *updated_length = *updated_length + entry->lth;
+    if (frame != NULL)
+      osdp_describe_frame (frame, buf, entry->lth, buf+5, data_length,
+        OSDP_SEC_NOT_SCS, 0);
+    ctx->frame_cache.hits ++;
+  }
+  else
+  {
+    i = *updated_length;
+    status = osdp_build_message (buf, updated_length, command, dest_addr,
+      sequence, data_length, data, 0, frame);
+    i = *updated_length - i;
+    if ((status EQUALS ST_OK) && (entry != NULL) &&
+      (i <= OSDP_FRAME_CACHE_FRAME_MAX))
+    {
+      memcpy (entry->frame, buf, i);
+      entry->lth = i;
+      entry->check = m_check;
+      entry->direction = 0x80 & buf [1];
+      entry->data_length = data_length;
+      entry->data = data_octet;
+      ctx->frame_cache.misses ++;
+    };
+  };
+  return (status);
+
+} /* osdp_build_message_cached */
+
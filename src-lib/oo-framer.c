@@ -0,0 +1,141 @@
+/*
+  oo-framer - incremental OSDP frame assembly
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <memory.h>
+
+
+#include <open-osdp.h>
+
+
+/*
+  osdp_framer_scan - advance the framer over newly buffered octets
+
+  Each octet is examined once: SOM, ADDR, LEN_LSB, LEN_MSB, CTRL, then the
+  body with the CRC (or checksum) kept running, then the check octets.
+  The frame under construction always starts at the head of the ring;
+  the framer is reset whenever the head moves (see osdp_buffer_consume.)
+
+  returns ST_SERIAL_IN if the first frame is not complete yet,
+  ST_OK if it is complete and the check matched,
+  ST_BAD_CRC or ST_BAD_CHECKSUM if it is complete and the check failed,
+  ST_MSG_BAD_SOM, ST_MSG_TOO_LONG or ST_MSG_BAD_LENGTH if the header is bad.
+*/
+
+int
+  osdp_framer_scan
+    (OSDP_BUFFER *osdpbuf)
+
+{ /* osdp_framer_scan */
+
+  OSDP_FRAMER *f;
+  unsigned char octet;
+  int status;
+  unsigned short int wire_crc;
+
+
+  f = &(osdpbuf->framer);
+  status = ST_SERIAL_IN;
+  if (f->state EQUALS OSDP_FRAMER_DONE)
+    status = f->status;
+  while ((status EQUALS ST_SERIAL_IN) && (f->scan < osdp_buffer_count (osdpbuf)))
+  {
+    octet = osdp_buffer_octet (osdpbuf, f->scan);
+    f->scan ++;
+    switch (f->state)
+    {
+    case OSDP_FRAMER_SOM:
+      if (octet != C_SOM)
+        status = ST_MSG_BAD_SOM;
+      f->crc = OSDP_CRC_SEED;
+      f->cksum = 0;
+      f->state = OSDP_FRAMER_ADDR;
+      break;
+
+    case OSDP_FRAMER_ADDR:
+      f->state = OSDP_FRAMER_LEN_LSB;
+      break;
+
+    case OSDP_FRAMER_LEN_LSB:
+      f->frame_lth = octet;
+      f->state = OSDP_FRAMER_LEN_MSB;
+      break;
+
+    case OSDP_FRAMER_LEN_MSB:
+      f->frame_lth = f->frame_lth + (octet << 8);
+      if (f->frame_lth > OSDP_OFFICIAL_MSG_MAX)
+        status = ST_MSG_TOO_LONG;
+      f->state = OSDP_FRAMER_CTRL;
+      break;
+
+    case OSDP_FRAMER_CTRL:
+      f->check_size = 1;
+      if (octet & OSDP_CONTROLBIT_CRC)
+        f->check_size = 2;
+
+      // must hold at least the header, a command and the check
+      if (f->frame_lth < sizeof (OSDP_HDR) + f->check_size)
+        status = ST_MSG_BAD_LENGTH;
+      f->state = OSDP_FRAMER_BODY;
+      break;
+
+    case OSDP_FRAMER_BODY:
+      break;
+
+    case OSDP_FRAMER_CHECK:
+      break;
+    };
+
+    // everything up to the check octets goes into the running check
+
+    if (f->state != OSDP_FRAMER_CHECK)
+    {
+      f->crc = fCrcByte (f->crc, octet);
+      f->cksum = f->cksum + octet;
+      if ((f->state EQUALS OSDP_FRAMER_BODY) &&
+        (f->scan EQUALS (f->frame_lth - f->check_size)))
+        f->state = OSDP_FRAMER_CHECK;
+    };
+
+    if ((f->state EQUALS OSDP_FRAMER_CHECK) && (f->scan EQUALS f->frame_lth))
+    {
+      f->state = OSDP_FRAMER_DONE;
+      status = ST_OK;
+      if (f->check_size EQUALS 2)
+      {
+        wire_crc = osdp_buffer_octet (osdpbuf, f->frame_lth-2) |
+          (osdp_buffer_octet (osdpbuf, f->frame_lth-1) << 8);
+        if (wire_crc != f->crc)
+          status = ST_BAD_CRC;
+      }
+      else
+      {
+        if (0xff & (f->cksum + osdp_buffer_octet (osdpbuf, f->frame_lth-1)))
+          status = ST_BAD_CHECKSUM;
+      };
+      f->status = status;
+    };
+  };
+  return (status);
+
+} /* osdp_framer_scan */
+
@@ -0,0 +1,352 @@
+/*
+  oo-hooks - action hooks, and the worker that runs the action scripts
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  A card read (and NAK, MFGERRR, ID, PDID and extended read events) used
+  to mean a fork and exec of /bin/sh to run the ACU-actions script before
+  anything else happened.  Now the program can register a function for
+  each kind of event with osdp_action_register, or name a shared object
+  in "action-plugin" whose osdp_action_plugin_init does the registering.
+  The function is called straight away with the decoded event.
+
+  The scripts still run unless "action-scripts" is "off".  By default
+  ("async") they are handed to a worker process, started the first time
+  there is one, which runs them in order.  The queue to the worker is a
+  local socket's buffer, so it is bounded; a script that does not fit is
+  dropped and counted rather than waited for, as is one longer than
+  OSDP_ACTION_SCRIPT_MAX.  "sync" runs them with system() as before.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+
+#include <open-osdp.h>
+
+
+int
+  osdp_action_queue
+    (OSDP_CONTEXT *ctx,
+    char *script);
+int
+  osdp_action_worker_start
+    (OSDP_CONTEXT *ctx);
+void
+  osdp_action_worker_stop
+    (OSDP_CONTEXT *ctx);
+
+
+/*
+  osdp_action - an event happened: call its hook, and run its script
+
+  script is the whole command line (NULL to leave it to the caller, see
+  osdp_action_script), args in the event are its arguments.  returns what
+  the hook returned (ST_OK if there is none.)
+*/
+
+int
+  osdp_action
+    (OSDP_CONTEXT *ctx,
+    OSDP_ACTION_EVENT *event,
+    char *script)
+
+{ /* osdp_action */
+
+  int status;
+
+
+  status = ST_OK;
+  if ((event->action >= 0) && (event->action < OSDP_ACTIONS))
+  {
+    if (ctx->action_hook [event->action] != NULL)
+    {
+      ctx->actions_hooked ++;
+      status = (*(ctx->action_hook [event->action])) (ctx, event);
+      if ((status != ST_OK) && (ctx->verbosity > 2))
+        fprintf (ctx->log, "action %d hook returned %d\n",
+          event->action, status);
+    };
+  };
+  if (script != NULL)
+    osdp_action_script (ctx, script);
+  return (status);
+
+} /* osdp_action */
+
+
+/*
+  osdp_action_plugin_load - load "action-plugin" and let it register hooks
+
+  the plugin has an osdp_action_plugin_init (OSDP_CONTEXT *ctx) that calls
+  osdp_action_register and returns ST_OK.
+*/
+
+int
+  osdp_action_plugin_load
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_action_plugin_load */
+
+  void *handle;
+  int (*plugin_init) (OSDP_CONTEXT *ctx);
+  int status;
+
+
+  status = ST_OK;
+  plugin_init = NULL;
+  handle = dlopen (ctx->action_plugin, RTLD_NOW | RTLD_GLOBAL);
+  if (handle EQUALS NULL)
+    status = ST_OSDP_ACTION_PLUGIN;
+  if (status EQUALS ST_OK)
+  {
+    *(void **)(&plugin_init) = dlsym (handle, OSDP_ACTION_PLUGIN_INIT);
+    if (plugin_init EQUALS NULL)
+      status = ST_OSDP_ACTION_PLUGIN;
+  };
+  if (status EQUALS ST_OK)
+    status = (*plugin_init) (ctx);
+  if (status EQUALS ST_OK)
+    fprintf (ctx->log, "Action plugin %s loaded\n", ctx->action_plugin);
+  else
+  {
+    fprintf (ctx->log, "Action plugin %s not loaded (%d): %s\n",
+      ctx->action_plugin, status, (handle EQUALS NULL) ? dlerror () : "");
+    if (handle != NULL)
+      dlclose (handle);
+  };
+  return (status);
+
+} /* osdp_action_plugin_load */
+
+
+/*
+  osdp_action_queue - give a script to the worker, without waiting
+*/
+
+int
+  osdp_action_queue
+    (OSDP_CONTEXT *ctx,
+    char *script)
+
+{ /* osdp_action_queue */
+
+  int lth;
+  int status;
+  int status_io;
+
+
+  status = ST_OK;
+  lth = strlen (script) + 1;
+  if (lth > OSDP_ACTION_SCRIPT_MAX)
+    status = ST_OSDP_ACTION_TOO_LONG;
+  if ((status EQUALS ST_OK) && (ctx->action_worker EQUALS 0))
+    status = osdp_action_worker_start (ctx);
+  if (status EQUALS ST_OK)
+  {
+    status_io = send (ctx->action_socket, script, lth,
+      MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (status_io EQUALS lth)
+      ctx->actions_queued ++;
+    else
+    {
+      status = ST_OSDP_ACTION_WORKER;
+
+      // full, or the worker has gone (in which case start another next time)
+
+      if ((status_io EQUALS -1) && (errno != EAGAIN) && (errno != ENOBUFS))
+        osdp_action_worker_stop (ctx);
+    };
+  };
+  if (status != ST_OK)
+  {
+    ctx->actions_dropped ++;
+    if (ctx->verbosity > 2)
+      fprintf (ctx->log, "action script dropped: %s\n", script);
+  };
+  return (status);
+
+} /* osdp_action_queue */
+
+
+/*
+  osdp_action_register - set (or with NULL, clear) the hook for an action
+*/
+
+int
+  osdp_action_register
+    (OSDP_CONTEXT *ctx,
+    int action,
+    int (*hook) (OSDP_CONTEXT *ctx, OSDP_ACTION_EVENT *event))
+
+{ /* osdp_action_register */
+
+  int status;
+
+
+  status = ST_OSDP_ACTION_INDEX;
+  if ((action >= 0) && (action < OSDP_ACTIONS))
+  {
+    ctx->action_hook [action] = hook;
+    status = ST_OK;
+  };
+  return (status);
+
+} /* osdp_action_register */
+
+
+/*
+  osdp_action_script - run an action script the way "action-scripts" says
+*/
+
+void
+  osdp_action_script
+    (OSDP_CONTEXT *ctx,
+    char *script)
+
+{ /* osdp_action_script */
+
+  switch (ctx->action_scripts)
+  {
+  case OSDP_ACTION_SCRIPTS_ASYNC:
+    (void)osdp_action_queue (ctx, script);
+    break;
+  case OSDP_ACTION_SCRIPTS_SYNC:
+    system (script);
+    break;
+  };
+
+} /* osdp_action_script */
+
+
+/*
+  osdp_action_worker_start - fork the process that runs the scripts
+
+  it runs each script it is sent, one at a time, and leaves when the
+  socket closes (i.e. when this process does.)  osdp_action_queue keeps
+  them to OSDP_ACTION_SCRIPT_MAX; anything longer would arrive cut short
+  and is not run.
+*/
+
+int
+  osdp_action_worker_start
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_action_worker_start */
+
+  char buffer [OSDP_ACTION_SCRIPT_MAX];
+  int fd;
+  pid_t pid;
+  int pair [2];
+  int status;
+  int status_io;
+
+
+  status = ST_OK;
+  if (socketpair (AF_UNIX, SOCK_SEQPACKET, 0, pair) != 0)
+    status = ST_OSDP_ACTION_WORKER;
+  if (status EQUALS ST_OK)
+  {
+    pid = fork ();
+    if (pid EQUALS 0)
+    {
+      // the worker.  keep nothing of the parent's open but stdio
+
+      for (fd=3; fd<1024; fd++)
+        if (fd != pair [1])
+          close (fd);
+      status_io = 1;
+      while (status_io > 0)
+      {
+        // MSG_TRUNC gives the length as sent, even if it did not fit
+
+        status_io = recv (pair [1], buffer, sizeof (buffer), MSG_TRUNC);
+        if ((status_io > 0) && (status_io <= (int)sizeof (buffer)))
+        {
+          buffer [status_io - 1] = 0; // it was sent with its NUL
+          system (buffer);
+        };
+      };
+      _exit (0);
+    };
+    close (pair [1]);
+    if (pid EQUALS -1)
+    {
+      close (pair [0]);
+      status = ST_OSDP_ACTION_WORKER;
+    }
+    else
+    {
+      ctx->action_socket = pair [0];
+      ctx->action_worker = pid;
+      if (ctx->verbosity > 3)
+        fprintf (ctx->log, "action script worker %d started\n", pid);
+    };
+  };
+  return (status);
+
+} /* osdp_action_worker_start */
+
+
+void
+  osdp_action_worker_stop
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_action_worker_stop */
+
+  pid_t done;
+  struct timespec pause;
+  int waited;
+
+
+  // with the socket closed it leaves once the script it is running (if
+  // any) is done.  it is given a little while and then killed.
+
+  close (ctx->action_socket);
+  pause.tv_sec = 0;
+  pause.tv_nsec = 10 * 1000000l;
+  done = 0;
+  for (waited=0; (done EQUALS 0) && (waited<OSDP_ACTION_STOP_MSEC);
+    waited=waited+10)
+  {
+    done = waitpid (ctx->action_worker, NULL, WNOHANG);
+    if (done EQUALS 0)
+      nanosleep (&pause, NULL);
+  };
+  if (done EQUALS 0)
+  {
+    if (ctx->verbosity > 2)
+      fprintf (ctx->log, "action script worker %d killed\n",
+        ctx->action_worker);
+    kill (ctx->action_worker, SIGKILL);
+    (void)waitpid (ctx->action_worker, NULL, 0);
+  };
+  ctx->action_worker = 0;
+
+} /* osdp_action_worker_stop */
+
@@ -31,6 +31,8 @@
 #include <time.h>
 #include <unistd.h>
 #include <sys/file.h>
+#include <sys/ioctl.h>
+#include <linux/serial.h>
 
 
 #define _OO_INITIALIZE_
@@ -43,8 +45,6 @@ char multipart_message_buffer_1 [64*1024];
 extern OSDP_INTEROP_ASSESSMENT osdp_conformance;
 extern OSDP_PARAMETERS p_card;
 
-OSDP_COMMAND_QUEUE osdp_command_queue [OSDP_COMMAND_QUEUE_SIZE];
-
 int
   init_serial
     (OSDP_CONTEXT *context,
@@ -149,6 +149,24 @@ fprintf (stderr, "tcsetattr raw returned %d\n", status_io);
 };
   };
 
+  // let the driver turn the line around (RTS high while sending) rather
+  // than waiting on it here.  not every UART can, so carry on without.
+
+  if ((status EQUALS ST_OK) && (context->rs485))
+  {
+    struct serial_rs485 rs485;
+
+    memset (&rs485, 0, sizeof (rs485));
+    rs485.flags = SER_RS485_ENABLED | SER_RS485_RTS_ON_SEND;
+    status_io = ioctl (context->fd, TIOCSRS485, &rs485);
+    if (status_io != 0)
+      fprintf (stderr, "RS-485 mode not available on %s (errno %d)\n",
+        device, errno);
+    else
+      if (context->verbosity > 3)
+        fprintf (stderr, "RS-485 direction control enabled on %s\n", device);
+  };
+
   return (status);
 
 } /* init_serial */
@@ -208,7 +226,11 @@ int
 
     context->verbosity = 3;
 
-    context->q = osdp_command_queue;
+    context->q.depth = OSDP_COMMAND_QUEUE_SIZE;
+    context->action_scripts = OSDP_ACTION_SCRIPTS_ASYNC;
+    context->status_rate = OSDP_STATUS_RATE_DEFAULT;
+    context->cipher = OSDP_CIPHER_AUTO;
+    strcpy (context->results_path, OSDP_RESULTS_FILE);
     context->enable_poll = OO_POLL_ENABLED;
 
     context->current_key_slot = -1;
@@ -254,6 +276,8 @@ int
   context->timer [OSDP_TIMER_RESPONSE].timeout_action = OSDP_TIMER_RESTART_NONE;
   context->timer [OSDP_TIMER_RESPONSE].i_sec = 0;
   context->timer [OSDP_TIMER_RESPONSE].i_nsec = 200000000l;
+  context->retry_max = OSDP_RETRANSMIT_DEFAULT_RETRIES;
+  context->retry_backoff = OSDP_RETRANSMIT_DEFAULT_BACKOFF;
   context->timer [OSDP_TIMER_SUMMARY].timeout_action = OSDP_TIMER_RESTART_ALWAYS;
   context->timer [OSDP_TIMER_SUMMARY].i_sec = 60;
   { 
@@ -277,8 +301,9 @@ int
       try to get configuration from configuration file open_osdp.cfg
     */
     status = read_config (context);
-    if (!(context->keep_results))
-      system("rm -vf /opt/osdp-conformance/results/*");
+    (void)osdp_results_open (context);
+    (void)osdp_stats_open (context);
+    (void)osdp_cipher_select (context);
 
     if (context->verbosity > 4)
     {
@@ -286,6 +311,11 @@ int
       fprintf (stderr, "read_config returned %d\n", status);
     };
     status = ST_OK; // doesn't matter if config reading failed
+
+    // nor if the plugin did not load (it's logged)
+
+    if (context->action_plugin [0] != 0)
+      (void)osdp_action_plugin_load (context);
   };
 
   if (status EQUALS ST_OK)
@@ -418,6 +448,10 @@ int
   if (status EQUALS ST_OK)
     context->last_was_processed = 1;
 
+  // the secure channel as configured, for each PD the first time it's used
+  if (status EQUALS ST_OK)
+    osdp_sc_save (context, &(context->sc_configured));
+
   if (status EQUALS ST_OK)
     status = oo_write_status (context);
   if (status != ST_OK)
@@ -336,9 +336,15 @@ if (ctx->verbosity > 9)
     print_enable, strlen(trace_out_buffer), strlen(trace_in_buffer));
 }
 
-  clock_gettime (CLOCK_REALTIME, &current_time_fine);
-  tf = fopen(OSDP_TRACE_FILE, "a+");
-//tf = NULL;
+  // nothing traced (tracing is off, or it was already written) means
+  // nothing to write, so don't open the trace file.
+
+  tf = NULL;
+  if ((trace_out_buffer [0] != 0) || (trace_in_buffer [0] != 0))
+  {
+    clock_gettime (CLOCK_REALTIME, &current_time_fine);
+    tf = fopen(OSDP_TRACE_FILE, "a+");
+  };
   if (tf)
   {
     char *tag;
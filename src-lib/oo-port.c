@@ -0,0 +1,276 @@
+/*
+  oo-port - several serial buses in one process
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  The library talks to the bus through the context (fd, the multi-drop
+  sessions, the response timer, the PD being polled) so the port being
+  serviced is loaded into the context and the one it replaces is saved
+  back to its OSDP_PORT, the secure channel of the PD being polled with
+  it.  The sessions are not copied; the context's bus is pointed at the
+  port's.  Everything else in the context (configuration, statistics and
+  so on) is shared by all the ports.  A queued command can name its port
+  ("port" : "1"); it is loaded when the command comes off the queue
+  (osdp_port_target.)
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+#include <open-osdp.h>
+
+
+extern OSDP_PARAMETERS p_card;
+
+
+void
+  osdp_port_load
+    (OSDP_CONTEXT *ctx,
+    OSDP_PORT *port);
+void
+  osdp_port_save
+    (OSDP_CONTEXT *ctx,
+    OSDP_PORT *port);
+
+
+/*
+  osdp_port_due - has a port's response timer run out
+
+  the current port's timer is in the context and is checked by
+  osdp_timeout as usual so this is only for the others.
+*/
+
+int
+  osdp_port_due
+    (OSDP_CONTEXT *ctx,
+    int index,
+    struct timespec *now)
+
+{ /* osdp_port_due */
+
+  int due;
+  OSDP_TIMER *t;
+
+
+  due = 0;
+  if (index != ctx->port_current)
+  {
+    t = &(ctx->port [index].response);
+    if (t->status != OSDP_TIMER_STOPPED)
+      if ((now->tv_sec > t->due.tv_sec) ||
+        ((now->tv_sec EQUALS t->due.tv_sec) && (now->tv_nsec >= t->due.tv_nsec)))
+        due = 1;
+  };
+  return (due);
+
+} /* osdp_port_due */
+
+
+void
+  osdp_port_load
+    (OSDP_CONTEXT *ctx,
+    OSDP_PORT *port)
+
+{ /* osdp_port_load */
+
+  ctx->fd = port->fd;
+  ctx->bus = port->bus;
+  ctx->timer [OSDP_TIMER_RESPONSE] = port->response;
+  ctx->turnaround = port->turnaround;
+  ctx->retransmit = port->retransmit;
+  p_card.addr = port->addr;
+  ctx->pd_address = port->addr;
+  ctx->next_sequence = port->next_sequence;
+  ctx->last_was_processed = port->last_was_processed;
+  ctx->last_command_sent = port->last_command_sent;
+  ctx->last_nak_error = port->last_nak_error;
+  ctx->last_response_received = port->last_response_received;
+  osdp_sc_load (ctx, &(port->sc));
+
+} /* osdp_port_load */
+
+
+/*
+  osdp_port_open - open a port's serial device and set it up idle
+
+  the context's own serial port is left alone.
+*/
+
+int
+  osdp_port_open
+    (OSDP_CONTEXT *ctx,
+    OSDP_PORT *port)
+
+{ /* osdp_port_open */
+
+  int saved_fd;
+  int status;
+
+
+  saved_fd = ctx->fd;
+  ctx->fd = -1;
+  status = init_serial (ctx, port->device);
+  port->fd = ctx->fd;
+  ctx->fd = saved_fd;
+
+  // same response timeout as the context, nothing outstanding.  the timer
+  // is due now so the first poll goes out straight away.
+
+  port->response = ctx->timer [OSDP_TIMER_RESPONSE];
+  port->response.status = OSDP_TIMER_RUNNING;
+  memset (&(port->response.due), 0, sizeof (port->response.due));
+  port->addr = p_card.addr;
+  if (port->bus->count > 0)
+    port->addr = port->bus->order [0];
+  port->next_sequence = 0;
+  port->last_was_processed = 1;
+  return (status);
+
+} /* osdp_port_open */
+
+
+void
+  osdp_port_save
+    (OSDP_CONTEXT *ctx,
+    OSDP_PORT *port)
+
+{ /* osdp_port_save */
+
+  port->fd = ctx->fd;
+  port->response = ctx->timer [OSDP_TIMER_RESPONSE];
+  port->turnaround = ctx->turnaround;
+  port->retransmit = ctx->retransmit;
+  port->addr = p_card.addr;
+  port->next_sequence = ctx->next_sequence;
+  port->last_was_processed = ctx->last_was_processed;
+  port->last_command_sent = ctx->last_command_sent;
+  port->last_nak_error = ctx->last_nak_error;
+  port->last_response_received = ctx->last_response_received;
+  osdp_sc_save (ctx, &(port->sc));
+
+} /* osdp_port_save */
+
+
+/*
+  osdp_port_select - load a port into the context (saving the current one)
+*/
+
+void
+  osdp_port_select
+    (OSDP_CONTEXT *ctx,
+    int index)
+
+{ /* osdp_port_select */
+
+  if (index != ctx->port_current)
+  {
+    osdp_port_save (ctx, &(ctx->port [ctx->port_current]));
+    osdp_port_load (ctx, &(ctx->port [index]));
+    ctx->port_current = index;
+  };
+
+} /* osdp_port_select */
+
+
+/*
+  osdp_port_target - load the port and PD a queued command is for
+
+  -1 is the one already loaded.  returns ST_OK if the context is talking
+  to them, ST_BUS_WAIT if the port's reply (or a file transfer, which is
+  not kept per port) has to finish first, ST_PORT_BAD_INDEX or
+  ST_BUS_BAD_ADDRESS if there is no such port or PD.
+*/
+
+int
+  osdp_port_target
+    (OSDP_CONTEXT *ctx,
+    int index,
+    int addr)
+
+{ /* osdp_port_target */
+
+  int status;
+
+
+  status = ST_OK;
+  if ((index >= 0) && (index != ctx->port_current))
+  {
+    if (index >= ctx->port_count)
+      status = ST_PORT_BAD_INDEX;
+    if ((status EQUALS ST_OK) && (ctx->xferctx.total_length != 0))
+      status = ST_BUS_WAIT;
+    if (status EQUALS ST_OK)
+    {
+      osdp_port_select (ctx, index);
+      if (osdp_awaiting_response (ctx))
+        status = ST_BUS_WAIT;
+    };
+  };
+  if (status EQUALS ST_OK)
+    status = osdp_bus_select (ctx, addr);
+  return (status);
+
+} /* osdp_port_target */
+
+
+/*
+  osdp_port_wait_ms - how long until another port's response timer runs out
+
+  returns -1 if none is running (wait indefinitely), for osdp_loop_wait.
+*/
+
+int
+  osdp_port_wait_ms
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_port_wait_ms */
+
+  long ms;
+  struct timespec now;
+  int i;
+  OSDP_TIMER *t;
+  int wait_ms;
+
+
+  wait_ms = -1;
+  if (ctx->port_count > 1)
+  {
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    for (i=0; i<ctx->port_count; i++)
+    {
+      t = &(ctx->port [i].response);
+      if ((i != ctx->port_current) && (t->status != OSDP_TIMER_STOPPED))
+      {
+        // round up so the wait doesn't end just before it is due
+
+        ms = (t->due.tv_sec - now.tv_sec) * 1000l +
+          (t->due.tv_nsec - now.tv_nsec + 999999l) / 1000000l;
+        if (ms < 0)
+          ms = 0;
+        if ((wait_ms EQUALS -1) || (ms < wait_ms))
+          wait_ms = ms;
+      };
+    };
+  };
+  return (wait_ms);
+
+} /* osdp_port_wait_ms */
+
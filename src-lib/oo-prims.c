@@ -145,59 +145,6 @@ int
 } /* osdp_awaiting_response */
 
 
-int
-  osdp_command_match
-    (OSDP_CONTEXT *ctx,
-    json_t *root,
-    char *command,
-    int *command_id)
-
-{ /* osdp_command_match */
-
-  int ret_cmd;
-  int status;
-  json_t *value;
-
-
-  status = ST_CMD_UNKNOWN;
-  ret_cmd = OSDP_CMDB_NOOP; // no-op if not known
-  value = json_object_get (root, "command");
-  if (!json_is_string (value))
-    status = ST_CMD_INVALID;
-  else
-  {
-    status = ST_OK;
-    strcpy (command, json_string_value (value));
-  };
-
-  if (status EQUALS ST_OK)
-  {
-    ret_cmd = OSDP_CMDB_NOOP;
-    status = ST_CMD_UNKNOWN;
-    if (0 EQUALS strcmp(command, "bio-read"))
-      ret_cmd = OSDP_CMDB_BIOREAD;
-    if (0 EQUALS strcmp(command, "bio-match"))
-      ret_cmd = OSDP_CMDB_BIOMATCH;
-    if (0 EQUALS strcmp(command, "factory-default"))
-      ret_cmd = OSDP_CMDB_FACTORY_DEFAULT;
-    if (0 EQUALS strcmp(command, "pivdata"))
-      ret_cmd = OSDP_CMDB_PIVDATA;
-    if (0 EQUALS strcmp(command, "polling"))
-      ret_cmd = OSDP_CMDB_POLLING;
-    if (0 EQUALS strcmp(command, "reset"))
-      ret_cmd = OSDP_CMDB_RESET;
-    if (0 EQUALS strcmp(command, "trace"))
-      ret_cmd = OSDP_CMDB_TRACE;
-    if (ret_cmd != -1)
-      status = ST_OK;
-  };
-
-  *command_id = ret_cmd;
-  return(status);
-
-} /* osdp_command_match */
-
-
 // direction is the CP/PD bit e.g. 0 or 128
 
 char
@@ -328,8 +275,8 @@ int
 
 
   status = ST_OK;
-  osdp_test_set_status(OOC_SYMBOL_cmd_filetransfer, OCONFORM_EXERCISED);
-  osdp_test_set_status(OOC_SYMBOL_resp_ftstat, OCONFORM_EXERCISED);
+  osdp_test_set_status(OOC_ID_cmd_filetransfer, OCONFORM_EXERCISED);
+  osdp_test_set_status(OOC_ID_resp_ftstat, OCONFORM_EXERCISED);
 
   to_send = sizeof(*response);
   current_length = 0;
@@ -379,7 +326,7 @@ int osdp_string_to_buffer
 } /* osdp_string_to_buffer */
 
 
-// osdp_timer_start - start a timer.  uses preset values
+// osdp_timer_start - start a timer.  uses preset values, due that long from now
 
 int osdp_timer_start
    (OSDP_CONTEXT *ctx,
@@ -387,23 +334,28 @@ int osdp_timer_start
 
 { /* osdp_timer_start */
 
+  struct timespec now;
   int status;
+  OSDP_TIMER *t;
 
 
   status = ST_OK;
-  if ((timer_index < 0) || (timer_index > OSDP_TIMER_MAX))
+  if ((timer_index < 0) || (timer_index >= OSDP_TIMER_MAX))
     status = ST_OSDP_BAD_TIMER;
   if (status EQUALS ST_OK)
   {
-    if (ctx->timer [timer_index].i_sec > 0)
-    {
-      ctx->timer [timer_index].current_seconds = ctx->timer [timer_index].i_sec;
-      ctx->timer [timer_index].status = OSDP_TIMER_RESTARTED;
-    };
-    if (ctx->timer [timer_index].i_nsec > 0)
+    t = &(ctx->timer [timer_index]);
+    if ((t->i_sec > 0) || (t->i_nsec > 0))
     {
-      ctx->timer [timer_index].current_nanoseconds = ctx->timer [timer_index].i_nsec;
-      ctx->timer [timer_index].status = OSDP_TIMER_RESTARTED;
+      clock_gettime (CLOCK_MONOTONIC, &now);
+      t->due.tv_sec = now.tv_sec + t->i_sec;
+      t->due.tv_nsec = now.tv_nsec + t->i_nsec;
+      while (t->due.tv_nsec >= 1000000000l)
+      {
+        t->due.tv_sec ++;
+        t->due.tv_nsec = t->due.tv_nsec - 1000000000l;
+      };
+      t->status = OSDP_TIMER_RESTARTED;
     };
   };
 
@@ -40,25 +40,95 @@ extern OSDP_CONTEXT
 extern OSDP_PARAMETERS
   p_card;
 
+int
+  process_osdp_frame
+    (OSDP_BUFFER *osdp_buf,
+    int check_verified);
+int
+  resync_wanted
+    (OSDP_BUFFER *osdp_buf,
+    int status);
+
+
+/*
+  process_osdp_input - process the first frame in the input buffer
+
+  octets are run through the framer as they arrive; the frame is parsed
+  and dispatched only once it is complete.  A bad header means the SOM
+  was not really the start of a frame, so resynchronize on the next SOM
+  in the buffer (up to OSDP_RESYNC_MAX tries) rather than drop it all.
+*/
+
 int
   process_osdp_input
     (OSDP_BUFFER *osdp_buf)
 
 { /* process_osdp_input */
 
+  int attempts;
+  int status;
+
+
+  attempts = 0;
+  status = osdp_framer_scan (osdp_buf);
+  while (resync_wanted (osdp_buf, status) && (attempts < OSDP_RESYNC_MAX))
+  {
+    context.resync_events ++;
+    context.resync_skipped = context.resync_skipped +
+      osdp_buffer_resync (osdp_buf);
+    attempts ++;
+    status = osdp_framer_scan (osdp_buf);
+  };
+
+  // still nothing that looks like a frame, give up on what's buffered
+
+  if (resync_wanted (osdp_buf, status))
+  {
+    context.dropped_octets = context.dropped_octets + osdp_buffer_count (osdp_buf);
+    osdp_buffer_reset (osdp_buf);
+    status = ST_SERIAL_IN;
+  };
+  if (status != ST_SERIAL_IN)
+    status = process_osdp_frame (osdp_buf, (status EQUALS ST_OK));
+  return (status);
+
+} /* process_osdp_input */
+
+
+int
+  process_osdp_frame
+    (OSDP_BUFFER *osdp_buf,
+    int check_verified)
+
+{ /* process_osdp_frame */
+
   OSDP_MSG msg;
   OSDP_HDR parsed_msg;
   int status;
-  OSDP_BUFFER temp_buffer;
+  int view_lth;
 
 
   // assume all incoming commands are ok until we see a bad one.
-  osdp_test_set_status(OOC_SYMBOL_CMND_REPLY, OCONFORM_EXERCISED);
+  osdp_test_set_status(OOC_ID_CMND_REPLY, OCONFORM_EXERCISED);
 
   memset (&msg, 0, sizeof (msg));
 
-  msg.lth = osdp_buf->next;
-  msg.ptr = osdp_buf->buf;
+  msg.check_verified = check_verified;
+
+  // if more than one message is buffered show the parser just the first one
+
+  view_lth = osdp_buffer_count (osdp_buf);
+  if (view_lth >= 4)
+  {
+    int frame_lth;
+
+    frame_lth = osdp_buffer_octet (osdp_buf, 2) +
+      (osdp_buffer_octet (osdp_buf, 3) << 8);
+    if ((frame_lth > 0) && (frame_lth < view_lth))
+      view_lth = frame_lth;
+  };
+  msg.ptr = osdp_buffer_view (osdp_buf, &view_lth);
+  msg.lth = view_lth;
   status = osdp_parse_message (&context, context.role, &msg, &parsed_msg);
 
   /*
@@ -66,8 +136,8 @@ int
   */
   if ((status EQUALS ST_MSG_TOO_LONG) || (status EQUALS ST_MSG_BAD_SOM))
   {
-    context.dropped_octets = context.dropped_octets + osdp_buf->next;
-    osdp_buf->next = 0;
+    context.dropped_octets = context.dropped_octets + osdp_buffer_count (osdp_buf);
+    osdp_buffer_reset (osdp_buf);
     status = ST_MSG_TOO_SHORT;
   };
   if ((status != ST_OK) && (status != ST_MSG_TOO_SHORT) &&
@@ -137,7 +207,7 @@ int
   if (status EQUALS ST_OK)
   {
     // the message was good.  update conformance status.
-    osdp_test_set_status(OOC_SYMBOL_multibyte_data_encoding, OCONFORM_EXERCISED);
+    osdp_test_set_status(OOC_ID_multibyte_data_encoding, OCONFORM_EXERCISED);
     if (!(parsed_msg.ctrl & 0x08))
       osdp_conformance.scb_absent.test_status =
         OCONFORM_EXERCISED;
@@ -149,7 +219,7 @@ int
         msg.lth);
       for (i=0; i<msg.lth; i++)
       {
-        fprintf (stderr, " %02x", osdp_buf->buf [i]);
+        fprintf (stderr, " %02x", msg.ptr [i]);
         fflush (stderr);
        };
       fprintf (stderr, "\n");
@@ -216,8 +286,9 @@ int
     };
   };
 
-  // move the existing buffer up to the front if it was unknown, not mine,
-  // monitor only, or processed
+  // consume the frame (advance the head) if it was unknown, not mine,
+  // monitor only, or processed.  If the CRC or checksum was bad the length
+  // can't be trusted so resynchronize on the next SOM instead.
 
   if ((status EQUALS ST_PARSE_UNKNOWN_CMD) || \
     (status EQUALS ST_BAD_CRC) || \
@@ -229,16 +300,54 @@ int
     (status EQUALS ST_OK))
   {
     int length;
-    length = (parsed_msg.len_msb << 8) + parsed_msg.len_lsb;
-    memcpy (temp_buffer.buf, osdp_buf->buf+length, osdp_buf->next-length);
-    temp_buffer.next = osdp_buf->next-length;
-    memcpy (osdp_buf->buf, temp_buffer.buf, temp_buffer.next);
-    osdp_buf->next = temp_buffer.next;
+    if ((status EQUALS ST_BAD_CRC) || (status EQUALS ST_BAD_CHECKSUM))
+    {
+      context.resync_events ++;
+      context.resync_skipped = context.resync_skipped +
+        osdp_buffer_resync (osdp_buf);
+    }
+    else
+    {
+      length = (parsed_msg.len_msb << 8) + parsed_msg.len_lsb;
+      osdp_buffer_consume (osdp_buf, length);
+      osdp_buf->resync = 0;
+    };
     if (status != ST_OK)
       // if we experienced an error we just reset things and continue
       status = ST_SERIAL_IN;
   };
   return (status);
 
-} /* process_osdp_input */
+} /* process_osdp_frame */
+
+
+/*
+  resync_wanted - is the framer result one to slide past
+
+  a bad header always is.  A bad CRC or checksum is too while
+  resynchronizing; the candidate was most likely a stray SOM and the parser
+  never sees it.  (The first one goes to the parser so it is counted and
+  NAK'd.)
+*/
+
+int
+  resync_wanted
+    (OSDP_BUFFER *osdp_buf,
+    int status)
+
+{ /* resync_wanted */
+
+  int wanted;
+
+
+  wanted = 0;
+  if ((status EQUALS ST_MSG_BAD_SOM) || (status EQUALS ST_MSG_TOO_LONG) ||
+    (status EQUALS ST_MSG_BAD_LENGTH))
+    wanted = 1;
+  if (((status EQUALS ST_BAD_CRC) || (status EQUALS ST_BAD_CHECKSUM)) &&
+    (osdp_buf->resync))
+    wanted = 1;
+  return (wanted);
+
+} /* resync_wanted */
 
@@ -0,0 +1,194 @@
+/*
+  oo-results - the conformance results file
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  All the test results are in one file of fixed size records ("results-
+  file", default OSDP_RESULTS_FILE) instead of a JSON file per test.  It
+  is mapped shared, so marking a test is a store into memory and the file
+  is always current for osdp-results to render.  A record's sequence is
+  odd while it is being changed so a reader can tell to try again.  At
+  start-up the records are cleared, unless "results" is "keep" and the
+  file is one this version wrote.  If the file cannot be mapped the
+  results are kept in memory only.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+
+#include <open-osdp.h>
+#include <osdp_conformance.h>
+
+
+OSDP_RESULTS *osdp_results;
+
+
+/*
+  osdp_results_open - map the results file (or with ctx NULL, memory)
+*/
+
+int
+  osdp_results_open
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_results_open */
+
+  int fd;
+  int keep;
+  OSDP_RESULTS *r;
+  int status;
+
+
+  status = ST_OK;
+  r = NULL;
+  keep = 0;
+  if (ctx != NULL)
+  {
+    keep = ctx->keep_results;
+    fd = open (ctx->results_path, O_RDWR | O_CREAT, 0644);
+    if (fd EQUALS -1)
+      status = ST_OSDP_RESULTS_MAP;
+    if (status EQUALS ST_OK)
+    {
+      if (ftruncate (fd, sizeof (*r)) != 0)
+        status = ST_OSDP_RESULTS_MAP;
+      if (status EQUALS ST_OK)
+      {
+        r = mmap (NULL, sizeof (*r), PROT_READ | PROT_WRITE, MAP_SHARED,
+          fd, 0);
+        if (r EQUALS MAP_FAILED)
+        {
+          r = NULL;
+          status = ST_OSDP_RESULTS_MAP;
+        };
+      };
+      close (fd);
+    };
+    if (status != ST_OK)
+      fprintf (ctx->log, "Results file %s not mapped, results not saved\n",
+        ctx->results_path);
+  };
+  if (r EQUALS NULL)
+  {
+    keep = 0;
+    r = calloc (1, sizeof (*r));
+  };
+  if (r != NULL)
+  {
+    if ((r->magic != OSDP_RESULTS_MAGIC) ||
+      (r->version != OSDP_RESULTS_VERSION) ||
+      (r->record_size != sizeof (r->record [0])))
+      keep = 0;
+    if (!keep)
+    {
+      memset (r, 0, sizeof (*r));
+      r->magic = OSDP_RESULTS_MAGIC;
+      r->version = OSDP_RESULTS_VERSION;
+      r->record_size = sizeof (r->record [0]);
+    };
+    if (ctx != NULL)
+      r->role = ctx->role;
+    r->pid = getpid ();
+    r->started = time (NULL);
+  };
+  osdp_results = r;
+  return (status);
+
+} /* osdp_results_open */
+
+
+/*
+  osdp_results_set - record a test's status and details, if they changed
+
+  idx is the test_control index, or -1 to find (or add) the test by name.
+  aux NULL or "" means no details (any already there are kept.)  details
+  too long for the record are replaced by "aux-truncated".
+*/
+
+int
+  osdp_results_set
+    (int idx,
+    char *test,
+    char *description,
+    int test_status,
+    char *aux)
+
+{ /* osdp_results_set */
+
+  int i;
+  OSDP_RESULTS_RECORD *rec;
+  int status;
+
+
+  status = ST_OK;
+  if (osdp_results EQUALS NULL)
+    (void)osdp_results_open (NULL);
+  if (osdp_results EQUALS NULL)
+    status = ST_OSDP_RESULTS_MAP;
+  if ((status EQUALS ST_OK) && (idx < 0))
+  {
+    for (i=OSDP_RESULTS_ADHOC; (idx < 0) && (i<OSDP_RESULTS_MAX); i++)
+      if ((osdp_results->record [i].test [0] EQUALS 0) ||
+        (0 EQUALS strcmp (osdp_results->record [i].test, test)))
+        idx = i;
+  };
+  if ((idx < 0) || (idx >= OSDP_RESULTS_MAX))
+    status = ST_OSDP_RESULTS_MAP;
+  if (status EQUALS ST_OK)
+  {
+    rec = &(osdp_results->record [idx]);
+    if ((aux != NULL) && (strlen (aux) EQUALS 0))
+      aux = NULL;
+    if ((aux != NULL) && (strlen (aux) >= sizeof (rec->aux)))
+      aux = "\"aux-truncated\":\"1\",";
+
+    // only touch the record if something changed
+
+    if ((rec->changed EQUALS 0) || (rec->status != test_status) ||
+      (0 != strncmp (rec->test, test, sizeof (rec->test)-1)) ||
+      ((aux != NULL) && (0 != strcmp (rec->aux, aux))))
+    {
+      rec->sequence ++;
+      __sync_synchronize ();
+      if (0 != strncmp (rec->test, test, sizeof (rec->test)-1))
+      {
+        memset (rec->test, 0, sizeof (rec->test));
+        strncpy (rec->test, test, sizeof (rec->test)-1);
+        memset (rec->description, 0, sizeof (rec->description));
+        strncpy (rec->description, description, sizeof (rec->description)-1);
+        rec->aux [0] = 0;
+      };
+      rec->status = test_status;
+      rec->changed = time (NULL);
+      if (aux != NULL)
+        strcpy (rec->aux, aux);
+      __sync_synchronize ();
+      rec->sequence ++;
+    };
+  };
+  return (status);
+
+} /* osdp_results_set */
+
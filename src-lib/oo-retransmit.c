@@ -0,0 +1,235 @@
+/*
+  oo-retransmit - resend the ACU's last frame when the PD does not answer
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Every frame the ACU sends is kept as it went on the wire.  If the
+  response timer runs out with nothing processed, or the PD NAK's it with
+  a CRC error, the same octets (so the same sequence number, and for
+  secure channel the same MAC) go out again, up to "retries" times.  Each
+  try waits "retry-backoff" milliseconds longer for the answer than the
+  one before.  A frame that gets an answer after a resend is counted as
+  recovered; one that runs out of tries is abandoned and polling carries
+  on as before.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+#include <open-osdp.h>
+#include <iec-nak.h>
+
+
+extern OSDP_PARAMETERS p_card;
+
+
+int
+  osdp_retransmit_send
+    (OSDP_CONTEXT *ctx);
+
+
+/*
+  osdp_retransmit - resend the last frame if its response timer ran out
+
+  call when a timer has gone off.  returns 1 if the frame went out again
+  (so nothing else should be sent), 0 if not.
+*/
+
+int
+  osdp_retransmit
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_retransmit */
+
+  int give_up;
+  OSDP_RETRANSMIT *r;
+  int resent;
+
+
+  resent = 0;
+  r = &(ctx->retransmit);
+  if ((ctx->role EQUALS OSDP_ROLE_ACU) && (r->lth > 0) &&
+    (!(ctx->last_was_processed)) &&
+    (ctx->timer [OSDP_TIMER_RESPONSE].status EQUALS OSDP_TIMER_STOPPED))
+  {
+    give_up = 0;
+    if (r->tries >= ctx->retry_max)
+      give_up = 1;
+
+    // an offline PD on a multi-drop bus is not worth the bus time
+
+    if (osdp_bus (ctx)->count > 0)
+      if (!(osdp_bus (ctx)->session [p_card.addr].online))
+        give_up = 1;
+
+    if (give_up)
+    {
+      if (ctx->verbosity > 2)
+        fprintf (ctx->log, "No response to %02x after %d tries, abandoned\n",
+          0xff & ctx->last_command_sent, 1+r->tries);
+      ctx->retries_abandoned ++;
+      r->lth = 0;
+
+      // a secure channel set-up that got no answer is over (else nothing
+      // more is sent to the PD, and on a multi-drop bus to any PD.)
+
+      if (ctx->secure_channel_use [OO_SCU_ENAB] & 0x80)
+        osdp_reset_secure_channel (ctx);
+    }
+    else
+    {
+      if (osdp_retransmit_send (ctx) EQUALS ST_OK)
+        resent = 1;
+    };
+  };
+  return (resent);
+
+} /* osdp_retransmit */
+
+
+/*
+  osdp_retransmit_reply - account for a reply to the last frame
+
+  call once the ACU has processed a reply.  a CRC NAK gets the frame
+  sent again straight away if there are tries left.  returns 1 if it
+  was resent.
+*/
+
+int
+  osdp_retransmit_reply
+    (OSDP_CONTEXT *ctx,
+    int reply)
+
+{ /* osdp_retransmit_reply */
+
+  int crc_nak;
+  OSDP_RETRANSMIT *r;
+  int resent;
+
+
+  resent = 0;
+  r = &(ctx->retransmit);
+  if (r->lth > 0)
+  {
+    crc_nak = (reply EQUALS OSDP_NAK) &&
+      (ctx->last_nak_error EQUALS OO_NAK_CHECK_CRC);
+    if (crc_nak && (r->tries < ctx->retry_max))
+    {
+      if (osdp_retransmit_send (ctx) EQUALS ST_OK)
+        resent = 1;
+    };
+    if (!resent)
+    {
+      if (crc_nak)
+        ctx->retries_abandoned ++;
+      else
+        if (r->tries > 0)
+          ctx->retries_recovered ++;
+      r->lth = 0;
+    };
+  };
+  return (resent);
+
+} /* osdp_retransmit_reply */
+
+
+/*
+  osdp_retransmit_save - keep a frame (mark included) as it was sent
+
+  only the ACU resends.
+*/
+
+void
+  osdp_retransmit_save
+    (OSDP_CONTEXT *ctx,
+    unsigned char *wire,
+    int lth)
+
+{ /* osdp_retransmit_save */
+
+  OSDP_RETRANSMIT *r;
+
+
+  r = &(ctx->retransmit);
+  r->lth = 0;
+  r->tries = 0;
+  if ((ctx->role EQUALS OSDP_ROLE_ACU) && (lth > 0) &&
+    (lth <= OSDP_RETRANSMIT_FRAME_MAX))
+  {
+    memcpy (r->frame, wire, lth);
+    r->lth = lth;
+  };
+
+} /* osdp_retransmit_save */
+
+
+/*
+  osdp_retransmit_send - put the kept frame on the wire again
+
+  the response timer is restarted with the backoff for this try added.
+*/
+
+int
+  osdp_retransmit_send
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_retransmit_send */
+
+  OSDP_RETRANSMIT *r;
+  int status;
+  OSDP_TIMER *t;
+  long wait_msec;
+
+
+  r = &(ctx->retransmit);
+  status = send_osdp_data (ctx, r->frame, r->lth);
+
+  // a try that could not be written still counts, so a port that has gone
+  // away is given up on like a PD that does not answer
+
+  if (status != ST_OK)
+    r->tries ++;
+  if (status EQUALS ST_OK)
+  {
+    ctx->pdus_sent ++;
+    r->tries ++;
+    ctx->retries ++;
+    if (ctx->verbosity > 2)
+      fprintf (ctx->log, "Resent %02x (try %d of %d)\n",
+        0xff & ctx->last_command_sent, r->tries, ctx->retry_max);
+
+    ctx->last_was_processed = 0;
+    (void)osdp_timer_start (ctx, OSDP_TIMER_RESPONSE);
+    t = &(ctx->timer [OSDP_TIMER_RESPONSE]);
+    t->status = OSDP_TIMER_RUNNING;
+    wait_msec = (long)(ctx->retry_backoff) * r->tries;
+    t->due.tv_sec = t->due.tv_sec + wait_msec / 1000;
+    t->due.tv_nsec = t->due.tv_nsec + (wait_msec % 1000) * 1000000l;
+    while (t->due.tv_nsec >= 1000000000l)
+    {
+      t->due.tv_sec ++;
+      t->due.tv_nsec = t->due.tv_nsec - 1000000000l;
+    };
+  };
+  return (status);
+
+} /* osdp_retransmit_send */
+
@@ -24,9 +24,6 @@
 #include <memory.h>
 
 
-#include <aes.h>
-
-
 #include <osdp-tls.h>
 #include <open-osdp.h>
 #include <osdp_conformance.h>
@@ -44,7 +41,6 @@ int
 
 { /* action_osdp_CCRYPT */
 
-  struct AES_ctx aes_context_s_enc;
   OSDP_SC_CCRYPT *ccrypt_payload;
   unsigned char *client_cryptogram;
   int current_length;
@@ -89,10 +85,9 @@ if (ctx->verbosity > 8)
     fprintf (stderr, "%02x", ctx->s_enc [i]);
   fprintf (stderr, "\n");
 };
-      AES_init_ctx (&aes_context_s_enc, ctx->s_enc);
-      AES_ctx_set_iv (&aes_context_s_enc, iv);
       memcpy (message, client_cryptogram, sizeof (message));
-      AES_CBC_decrypt_buffer (&aes_context_s_enc, message, sizeof (message));
+      osdp_cipher_cbc_decrypt (osdp_session_key (ctx, OSDP_SESSION_S_ENC),
+        iv, message, sizeof (message));
 
       if (0 != memcmp (message, ctx->rnd_a, sizeof (ctx->rnd_a)))
         status = ST_OSDP_CHLNG_DECRYPT;
@@ -108,10 +103,9 @@ if (ctx->verbosity > 8)
 
       memcpy (message, ctx->rnd_b, sizeof (ctx->rnd_b));
       memcpy (message+sizeof (ctx->rnd_b), ctx->rnd_a, sizeof (ctx->rnd_a));
-      AES_ctx_set_iv (&aes_context_s_enc, iv);
       memcpy (server_cryptogram, message, sizeof (server_cryptogram));
-      AES_CBC_encrypt_buffer(&aes_context_s_enc,
-        server_cryptogram, sizeof (server_cryptogram));
+      osdp_cipher_cbc_encrypt (osdp_session_key (ctx, OSDP_SESSION_S_ENC),
+        iv, server_cryptogram, sizeof (server_cryptogram));
 
       if (ctx->enable_secure_channel EQUALS 1)
         sec_blk [0] = OSDP_KEY_SCBK;
@@ -136,8 +130,8 @@ if (ctx->verbosity > 8)
     status = ST_OK;
     osdp_reset_secure_channel (ctx);
   };
-  (void)osdp_test_set_status(OOC_SYMBOL_cmd_chlng, test_results);
-  (void)osdp_test_set_status(OOC_SYMBOL_resp_ccrypt, test_results);
+  (void)osdp_test_set_status(OOC_ID_cmd_chlng, test_results);
+  (void)osdp_test_set_status(OOC_ID_resp_ccrypt, test_results);
   return (status);
 
 } /* action_osdp_CCRYPT */
@@ -186,7 +180,7 @@ int
       OSDP_NAK, p_card.addr, &current_length,
       sizeof(osdp_nak_response_data), osdp_nak_response_data);
     ctx->sent_naks ++;
-    osdp_test_set_status(OOC_SYMBOL_rep_nak, OCONFORM_EXERCISED);
+    osdp_test_set_status(OOC_ID_rep_nak, OCONFORM_EXERCISED);
     if (ctx->verbosity > 2)
     {
       fprintf (ctx->log, "NAK(5): osdp_CHLNG but Secure Channel disabled\n");
@@ -213,7 +207,7 @@ int
         OSDP_NAK, p_card.addr, &current_length,
         1, osdp_nak_response_data);
       ctx->sent_naks ++;
-      osdp_test_set_status(OOC_SYMBOL_rep_nak, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_rep_nak, OCONFORM_EXERCISED);
       if (ctx->verbosity > 2)
       {
         fprintf (ctx->log, "NAK: SCBK not initialized");
@@ -301,7 +295,7 @@ fprintf(ctx->log, "DEBUG: action_osdp_KEYSET top\n");
     (ctx, OSDP_ACK, p_card.addr, &current_length, 0, NULL,
     OSDP_SEC_SCS_16, 0, NULL);
 
-  osdp_test_set_status(OOC_SYMBOL_cmd_keyset, OCONFORM_EXERCISED);
+  osdp_test_set_status(OOC_ID_cmd_keyset, OCONFORM_EXERCISED);
 fprintf(ctx->log, "DEBUG: action_osdp_KEYSET bottom\n");
   return (status);
 
@@ -332,8 +326,8 @@ int
     memcpy(ctx->last_calculated_in_mac, ctx->rmac_i, sizeof(ctx->last_calculated_in_mac));
     ctx->secure_channel_use [OO_SCU_ENAB] = OO_SCS_OPERATIONAL;
     fprintf (ctx->log, "*** SECURE CHANNEL OPERATIONAL***\n");
-    (void)osdp_test_set_status(OOC_SYMBOL_cmd_scrypt, OCONFORM_EXERCISED);
-    (void)osdp_test_set_status(OOC_SYMBOL_resp_rmac_i, OCONFORM_EXERCISED);
+    (void)osdp_test_set_status(OOC_ID_cmd_scrypt, OCONFORM_EXERCISED);
+    (void)osdp_test_set_status(OOC_ID_resp_rmac_i, OCONFORM_EXERCISED);
   }
   else
   {
@@ -352,9 +346,6 @@ int
 
 { /* action_osdp_SCRYPT */
 
-  struct AES_ctx aes_context_s_enc;
-  struct AES_ctx aes_context_mac1;
-  struct AES_ctx aes_context_mac2;
   int current_key_slot;
   int current_length;
   unsigned char iv [16];
@@ -378,10 +369,8 @@ int
     {
       memcpy(server_cryptogram, msg->data_payload, sizeof(message1));
 
-      AES_init_ctx (&aes_context_s_enc, ctx->s_enc);
-      AES_ctx_set_iv (&aes_context_s_enc, iv);
-      AES_CBC_decrypt_buffer (&aes_context_s_enc,
-        server_cryptogram, sizeof (server_cryptogram));
+      osdp_cipher_cbc_decrypt (osdp_session_key (ctx, OSDP_SESSION_S_ENC),
+        iv, server_cryptogram, sizeof (server_cryptogram));
       if (ctx->verbosity > 3)
       {
         dump_buffer_log(ctx,
@@ -405,16 +394,14 @@ int
       sec_blk [0] = 1; // means server cryptogram was good
 
       memcpy (message1, msg->data_payload, sizeof (server_cryptogram));
-      AES_init_ctx (&aes_context_mac1, ctx->s_mac1);
-      AES_init_ctx (&aes_context_mac2, ctx->s_mac2);
 
       memcpy (message2, message1, sizeof (message2));
-      AES_ctx_set_iv (&aes_context_mac1, iv);
-      AES_CBC_encrypt_buffer (&aes_context_mac1, message2, sizeof (message2));
+      osdp_cipher_cbc_encrypt (osdp_session_key (ctx, OSDP_SESSION_S_MAC1),
+        iv, message2, sizeof (message2));
 
       memcpy (message3, message2, sizeof (message3));
-      AES_ctx_set_iv (&aes_context_mac2, iv);
-      AES_CBC_encrypt_buffer (&aes_context_mac2, message3, sizeof (message3));
+      osdp_cipher_cbc_encrypt (osdp_session_key (ctx, OSDP_SESSION_S_MAC2),
+        iv, message3, sizeof (message3));
 
       memcpy(ctx->rmac_i, message3, sizeof(ctx->rmac_i));
       memcpy(ctx->last_calculated_in_mac, ctx->rmac_i, sizeof(ctx->last_calculated_in_mac));
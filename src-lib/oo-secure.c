@@ -28,9 +28,6 @@
 #include <unistd.h>
 
 
-#include <aes.h>
-
-
 #include <osdp-tls.h>
 #include <open-osdp.h>
 #include <osdp_conformance.h>
@@ -57,12 +54,7 @@ int
 
 { /* osdp_calculate_secure_channel_mac */
 
-  struct AES_ctx aes_context_mac1;
-  struct AES_ctx aes_context_mac2;
-  int current_lth;
-  unsigned char hashbuffer [OSDP_BUF_MAX];
   unsigned char last_iv [OSDP_KEY_OCTETS];
-  int last_part1_block_offset;
   unsigned char padded_block [OSDP_KEY_OCTETS];
   int part1_block_length;
   int status;
@@ -71,11 +63,8 @@ int
   status = ST_OK;
   if (ctx->verbosity > 9)
     dump_buffer_log(ctx, "whole msg for msg-auth:", msg_to_send, msg_lth);
-  memset(hashbuffer, 0, sizeof(hashbuffer));
   memset(padded_block, 0, sizeof(padded_block));
   part1_block_length = 0;
-  last_part1_block_offset = 0;
-  current_lth = msg_lth;
 
   if (ctx->verbosity > 3)
     fprintf(ctx->log,
@@ -95,29 +84,26 @@ int
         last_iv, OSDP_KEY_OCTETS);
     };
 
-    // if it's longer than one block calculate the partial MAC using MAC1
+    // if it's longer than one block calculate the partial MAC using MAC1.
+    // it is chained over the message where it is, only the result is kept.
+
     if (msg_lth > OSDP_KEY_OCTETS)
     {
       part1_block_length = (msg_lth/OSDP_KEY_OCTETS)*OSDP_KEY_OCTETS;
-      last_part1_block_offset = part1_block_length - OSDP_KEY_OCTETS;
-      memcpy(hashbuffer, msg_to_send, part1_block_length);
       if (ctx->verbosity > 3)
       {
         dump_buffer_log(ctx, (char *)"msg-auth part 1 input:",
-          hashbuffer, part1_block_length);
+          msg_to_send, part1_block_length);
       };
-      AES_init_ctx (&aes_context_mac1, ctx->s_mac1);
-      AES_ctx_set_iv (&aes_context_mac1, last_iv);
-      AES_CBC_encrypt_buffer(&aes_context_mac1, hashbuffer, part1_block_length);
-      current_lth = current_lth - part1_block_length;
-      memcpy(last_iv, hashbuffer+last_part1_block_offset, OSDP_KEY_OCTETS);
+      osdp_cipher_cbc_mac (osdp_session_key (ctx, OSDP_SESSION_S_MAC1),
+        last_iv, msg_to_send, part1_block_length, last_iv);
     };
 
     // use MAC2 ("for the last block")
 
     memcpy(padded_block, msg_to_send+part1_block_length,
       msg_lth-part1_block_length);
-    osdp_sc_pad(padded_block, current_lth);
+    osdp_sc_pad(padded_block, msg_lth-part1_block_length);
     if (ctx->verbosity > 8)
     {
       dump_buffer_log(ctx, (char *)"IV for last block in mac",
@@ -125,25 +111,17 @@ int
       dump_buffer_log(ctx, (char *)"padded mac block",
         padded_block, OSDP_KEY_OCTETS);
     };
-    memcpy (hashbuffer, padded_block, OSDP_KEY_OCTETS);
 
-    // IV is last received MAC or last block of part1
+    // IV is last received MAC or last block of part1.  this MAC is saved
+    // as the last sent MAC
 
-    AES_init_ctx (&aes_context_mac2, ctx->s_mac2);
-    AES_ctx_set_iv (&aes_context_mac2, last_iv);
-    memcpy (hashbuffer, padded_block, OSDP_KEY_OCTETS);
-    AES_CBC_encrypt_buffer(&aes_context_mac2, hashbuffer, OSDP_KEY_OCTETS);
+    osdp_cipher_cbc_mac (osdp_session_key (ctx, OSDP_SESSION_S_MAC2),
+      last_iv, padded_block, OSDP_KEY_OCTETS, ctx->last_calculated_out_mac);
     if (ctx->verbosity > 8)
-      dump_buffer_log(ctx, "last block encrypted for MAC:", hashbuffer, OSDP_KEY_OCTETS);
-
-    // this MAC is saved as the last sent MAC
+      dump_buffer_log(ctx, "last block encrypted for MAC:",
+        ctx->last_calculated_out_mac, OSDP_KEY_OCTETS);
 
-    memcpy(ctx->last_calculated_out_mac, hashbuffer, sizeof(ctx->last_calculated_out_mac));
-
-    mac [0] = hashbuffer [0];
-    mac [1] = hashbuffer [1];
-    mac [2] = hashbuffer [2];
-    mac [3] = hashbuffer [3];
+    memcpy (mac, ctx->last_calculated_out_mac, 4);
   }; // ok msg_lth
 
 #if 0
@@ -157,10 +135,9 @@ int
       //dump_buffer_log(ctx, "mac2", ctx->s_mac2, sizeof(ctx->s_mac2));
       //dump_buffer_log(ctx, "padded mac block", padded_block, OSDP_KEY_OCTETS);
     };
-    AES_init_ctx (&aes_context_mac2, ctx->s_mac2);
-    AES_ctx_set_iv (&aes_context_mac2, ctx->last_calculated_in_mac);
     memcpy (hashbuffer, padded_block, sizeof(hashbuffer));
-    AES_CBC_encrypt_buffer(&aes_context_mac2, hashbuffer, sizeof(hashbuffer));
+    osdp_cipher_cbc_encrypt (osdp_session_key (ctx, OSDP_SESSION_S_MAC2),
+      ctx->last_calculated_in_mac, hashbuffer, sizeof(hashbuffer));
 
     // update the out-mac for next time
     memcpy(ctx->last_calculated_out_mac, hashbuffer,
@@ -179,6 +156,13 @@ int
 } /* osdp_calculate_secure_channel_mac */
 
 
+/*
+  osdp_build_secure_message - build a secure channel frame in buf
+
+  the cleartext payload is copied into the frame once and osdp_secure_seal
+  then encrypts, MACs and checks it there.
+*/
+
 int
   osdp_build_secure_message
     (OSDP_CONTEXT *ctx,
@@ -191,70 +175,30 @@ int
     unsigned char *data,
     int sec_block_type,
     int sec_block_length,
-    unsigned char *sec_blk)
+    unsigned char *sec_blk,
+    OSDP_MSG *frame)
 
 { /* osdp_build_secure_mesage */
 
-  int check_size;
   unsigned char * cmd_ptr;
-  unsigned char *crc_check;
-  unsigned char enc_buf [OSDP_BUF_MAX];
-  int encrypt_payload;
   int new_length;
-  unsigned char * next_data;
   OSDP_HDR *p;
   int padded_length;
-  int padding;
-  unsigned short int parsed_crc;
-  unsigned char sc_mac[4];
+  int payload_offset;
   unsigned char *sp;
   int status;
-  int whole_msg_lth;
 
 
   status = ST_OK;
-  if (m_check EQUALS OSDP_CHECKSUM)
-    check_size = 1;
-  else
-    check_size = 2;
-  new_length = *updated_length;
-
   p = (OSDP_HDR *)buf;
   p->som = C_SOM;
-  new_length ++;
 
   // addr
   p->addr = dest_addr;
   if (ctx->role EQUALS OSDP_ROLE_PD)
     p->addr = p->addr | 0x80;
-  new_length ++;
-
-  /*
-    length goes in before CRC calc.
-    length is 5 (fields to CTRL) + [if no sec] 1 for CMND + data
-  */
-  whole_msg_lth = 5;
-  whole_msg_lth = whole_msg_lth + 1; //CMND
-  whole_msg_lth = whole_msg_lth + data_length;
-  whole_msg_lth = whole_msg_lth + sec_block_length +2; //contents+hdr
 
-  // if it gets a MAC suffix add in the length of that.
-
-  encrypt_payload = 0;
-  if ((sec_block_type EQUALS OSDP_SEC_SCS_17) ||
-    (sec_block_type EQUALS OSDP_SEC_SCS_18))
-    encrypt_payload = 1;
-  if ((sec_block_type EQUALS OSDP_SEC_SCS_15) ||
-    (sec_block_type EQUALS OSDP_SEC_SCS_16) ||
-    (sec_block_type EQUALS OSDP_SEC_SCS_17) ||
-    (sec_block_type EQUALS OSDP_SEC_SCS_18))
-    whole_msg_lth = whole_msg_lth + 4;
-  whole_msg_lth = whole_msg_lth + check_size; // including CRC
-
-  p->len_lsb = 0x00ff & whole_msg_lth;
-  new_length ++;
-  p->len_msb = (0xff00 & whole_msg_lth) >> 8;
-  new_length ++;
+  // length (len_lsb, len_msb) is filled in by osdp_secure_seal
 
   // control
   p->ctrl = 0;
@@ -264,11 +208,8 @@ int
   if (m_check EQUALS OSDP_CRC)
     p->ctrl = p->ctrl | 0x04;
 
-  new_length ++;
-
   // secure is bit 3 (mask 0x08)
   p->ctrl = p->ctrl | 0x08;
-  cmd_ptr = buf + 4; // assume security block is 2 bytes len=1 and type
 
   // fill in secure data.  first is length (lth,type,payload)
 
@@ -281,93 +222,33 @@ int
     memcpy (sp, sec_blk, sec_block_length);
   sp = sp + sec_block_length;
   cmd_ptr = sp;
-  new_length = new_length + 2+ sec_block_length; // account for lth/typ
-  
   *cmd_ptr = command;
-  new_length++;
-  next_data = 1+cmd_ptr;
 
-  padding = 0; // in case there's none
+  // the payload goes straight into the frame after the command
+
+  payload_offset = (cmd_ptr + 1) - buf;
+  padded_length = 0;
   if (data_length > 0)
   {
-    int i;
-    unsigned char *sptr;
-    sptr = cmd_ptr + 1;
-
-    if (encrypt_payload)
-    {
-      padded_length = sizeof(enc_buf);
-      status = osdp_encrypt_payload(ctx, data, data_length, enc_buf, &padded_length, &padding);
-    }
+    if ((payload_offset + data_length) > OSDP_BUF_MAX)
+      status = ST_OSDP_EXCEEDS_SC_MAX;
     else
     {
-      memcpy(enc_buf, data, data_length);
+      memcpy (cmd_ptr + 1, data, data_length);
       padded_length = data_length;
     };
-
-    for (i=0; i<padded_length; i++)
-    {
-      *(sptr+i) = *(i+enc_buf);
-      new_length ++;
-      next_data ++; // where crc goes (after data)
-    };
-  };
-  if (ctx->verbosity > 9)
-    dump_buffer_log(ctx, "Secure Before MAC append", buf, new_length);
-
-  // update message length to add crypto padding, add before MAC calculation
-
-  whole_msg_lth = whole_msg_lth + padding;
-  p->len_lsb = 0x00ff & whole_msg_lth;
-  p->len_msb = (0xff00 & whole_msg_lth) >> 8;
-
-  // append 4-byte partial MAC for SCS_15-18
-  if ((sec_block_type EQUALS OSDP_SEC_SCS_15) ||
-    (sec_block_type EQUALS OSDP_SEC_SCS_16) ||
-    (sec_block_type EQUALS OSDP_SEC_SCS_17) ||
-    (sec_block_type EQUALS OSDP_SEC_SCS_18))
-  {
-    if (ctx->verbosity > 3)
-      dump_buffer_log(ctx, "buffer for mac calc:", buf, new_length);
-    status = osdp_calculate_secure_channel_mac(ctx, buf, new_length, sc_mac);
-    if (status EQUALS 0)
-    {
-      memcpy(next_data, sc_mac, 4);
-      next_data = next_data + 4;
-      new_length = new_length + 4;
-    };
-  };
-  if (ctx->verbosity > 9)
-    dump_buffer_log(ctx, "Secure After MAC append", buf, new_length);
-
-  // crc
-  if (m_check EQUALS OSDP_CRC)
-  {
-    crc_check = next_data;
-    parsed_crc = fCrcBlk (buf, new_length);
-
-    // low order byte first
-    *(crc_check+1) = (0xff00 & parsed_crc) >> 8;
-    *(crc_check) = (0x00ff & parsed_crc);
-    new_length ++;
-    new_length ++;
-  }
-  else
-  {
-    unsigned char
-      cksum;
-    unsigned char *
-      pchecksum;
-
-    pchecksum = next_data;
-    cksum = checksum (buf, new_length);
-    *pchecksum = cksum;
-    new_length ++;
   };
+  new_length = 0;
+  if (status EQUALS ST_OK)
+    status = osdp_secure_seal (ctx, buf, payload_offset, &padded_length,
+      &new_length);
 
   *updated_length = new_length;
   if (ctx->verbosity > 9)
     dump_buffer_log(ctx, "buffer after build-secure:", (unsigned char *)p, *updated_length);
+  if ((frame != NULL) && (status EQUALS ST_OK))
+    osdp_describe_frame (frame, buf, new_length, cmd_ptr, padded_length,
+      sec_block_type, sec_block_length+2);
   return (status);
 
 } /* osdp_build_message */
@@ -379,7 +260,6 @@ int
 
 { /* osdp_decrypt_payload */
 
-  struct AES_ctx aes_context_decrypt;
   unsigned char *cptr;
   int cur_actual;
   unsigned char decrypt_iv [OSDP_KEY_OCTETS];
@@ -412,10 +292,8 @@ int
       dump_buffer_log(ctx, "payload key:", ctx->s_enc, OSDP_KEY_OCTETS);
       dump_buffer_log(ctx, "payload iv:", decrypt_iv, OSDP_KEY_OCTETS);
     };
-    AES_init_ctx(&aes_context_decrypt, ctx->s_enc);
-    AES_ctx_set_iv(&aes_context_decrypt, decrypt_iv);
-    AES_CBC_decrypt_buffer(&aes_context_decrypt,
-      msg->data_payload, msg->data_length);
+    osdp_cipher_cbc_decrypt (osdp_session_key (ctx, OSDP_SESSION_S_ENC),
+      decrypt_iv, msg->data_payload, msg->data_length);
     if (ctx->verbosity > 3)
       dump_buffer_log(ctx, "payload decrypted:",
         msg->data_payload, msg->data_length);
@@ -430,7 +308,8 @@ int
     done = 0;
     found_marker = 0;
     pad_blocksize = 0;
-fprintf(stderr, "DEBUG: initiating padding removal\n");
+    if (ctx->verbosity > 9)
+      fprintf(stderr, "DEBUG: initiating padding removal\n");
     while (!done)
     {
       if (*cptr != 0)
@@ -466,7 +345,8 @@ fprintf(stderr, "DEBUG: initiating padding removal\n");
       if (cptr EQUALS msg->data_payload)
         done = 1;
     };
-fprintf(stderr, "DEBUG: padding removal complete.\n");
+    if (ctx->verbosity > 9)
+      fprintf(stderr, "DEBUG: padding removal complete.\n");
 
     // if there was padding adjust the actual length.
     if (found_marker && (pad_blocksize > 0))
@@ -545,7 +425,6 @@ void
 
 { /* osdp_create_client_cryptogram */
 
-  struct AES_ctx aes_context_s_enc;
   unsigned char iv [16];
   unsigned char message [16];
 
@@ -554,10 +433,9 @@ void
   memcpy (message, ctx->rnd_a, 8);
   memcpy (message+8, ctx->rnd_b, 8);
 
-  AES_init_ctx(&aes_context_s_enc, ctx->s_enc);
-  AES_ctx_set_iv(&aes_context_s_enc, iv);
   memcpy(ccrypt_response->cryptogram, message, sizeof (ccrypt_response->cryptogram));
-  AES_CBC_encrypt_buffer(&aes_context_s_enc, ccrypt_response->cryptogram, sizeof (message));
+  osdp_cipher_cbc_encrypt (osdp_session_key (ctx, OSDP_SESSION_S_ENC),
+    iv, ccrypt_response->cryptogram, sizeof (message));
   return;
 
 } /* osdp_create_client_cryptogram */
@@ -569,9 +447,10 @@ void
 
 { /* osdp_create_keys */
 
-  struct AES_ctx aes_context_scbk;
   unsigned char cleartext [OSDP_KEY_OCTETS];
+  int i;
   unsigned char iv [OSDP_KEY_OCTETS];
+  OSDP_KEY_SCHEDULE scbk;
 
 
   fflush (ctx->log);
@@ -589,10 +468,9 @@ void
   (void) oosdp_log_key (ctx,
 "   cleartext calculating s_enc: ", cleartext);
 
-  AES_init_ctx (&aes_context_scbk, ctx->current_scbk);
-  AES_ctx_set_iv (&aes_context_scbk, iv);
+  osdp_cipher_expand (&scbk, ctx->current_scbk);
   memcpy (ctx->s_enc, cleartext, sizeof (ctx->s_enc));
-  AES_CBC_encrypt_buffer (&aes_context_scbk, ctx->s_enc, sizeof (ctx->s_enc));
+  osdp_cipher_cbc_encrypt (&scbk, iv, ctx->s_enc, sizeof (ctx->s_enc));
   //AES_CBC_encrypt_buffer (ctx->s_enc, cleartext, OSDP_KEY_OCTETS, ctx->current_scbk, iv);
 
   (void) oosdp_log_key (ctx,
@@ -606,8 +484,7 @@ void
   (void) oosdp_log_key (ctx,
 "   cleartext calculating s_mac1: ", cleartext);
   memcpy (ctx->s_mac1, cleartext, sizeof (ctx->s_mac1));
-  AES_ctx_set_iv (&aes_context_scbk, iv);
-  AES_CBC_encrypt_buffer (&aes_context_scbk, ctx->s_mac1, sizeof (ctx->s_mac1));
+  osdp_cipher_cbc_encrypt (&scbk, iv, ctx->s_mac1, sizeof (ctx->s_mac1));
   //AES_CBC_encrypt_buffer (ctx->s_mac1, cleartext, OSDP_KEY_OCTETS, ctx->current_scbk, iv);
   (void) oosdp_log_key (ctx,
 "     s_mac1 in osdp_create_keys: ", ctx->s_mac1);
@@ -620,11 +497,15 @@ void
   (void) oosdp_log_key (ctx,
 "   cleartext calculating s_mac2: ", cleartext);
   memcpy (ctx->s_mac2, cleartext, sizeof (ctx->s_mac2));
-  AES_ctx_set_iv (&aes_context_scbk, iv);
-  AES_CBC_encrypt_buffer (&aes_context_scbk, ctx->s_mac2, sizeof (ctx->s_mac1));
+  osdp_cipher_cbc_encrypt (&scbk, iv, ctx->s_mac2, sizeof (ctx->s_mac2));
   (void) oosdp_log_key (ctx,
 "     s_mac2 in osdp_create_keys: ", ctx->s_mac2);
 
+  // expand the session keys now rather than for each message
+
+  for (i=0; i<OSDP_SESSION_KEYS; i++)
+    (void) osdp_session_key (ctx, i);
+
   return;
 
 } /* osdp_create_keys */
@@ -641,7 +522,6 @@ int
 
 { /* osdp_encrypt_payload */
 
-  struct AES_ctx aes_context_encrypt;
   unsigned char encrypt_iv [OSDP_KEY_OCTETS];
   int i;
   int status;
@@ -660,28 +540,26 @@ int
     if (data_length < 1)
       status = ST_OSDP_SC_ENCRYPT_LTH_2;
     if (status EQUALS ST_OK)
-      if (*padded_length < data_length)
+      if (*padded_length <
+        ((data_length/OSDP_KEY_OCTETS)+1)*OSDP_KEY_OCTETS)
         status = ST_OSDP_SC_ENCRYPT_LTH_3;
   };
   if (status EQUALS ST_OK)
   {
-    // zeroize the whole cyphertext buffer, then copy in the plaintext.
-
-    memset(enc_buf, 0, *padded_length);
-    memcpy(enc_buf, data, data_length);
-    *padded_length = data_length; // 'cause we just encrypt it without padding;
+    // copy in the plaintext unless it's already there (osdp_secure_seal
+    // encrypts in the frame.)  only the padding is zeroed.
 
-    // if it's an even number of blocks just encrypt it.
+    if (enc_buf != data)
+      memcpy(enc_buf, data, data_length);
 
-    if (0 != (data_length % (2*OSDP_KEY_OCTETS)))
-    {
-      // needs padding.  calc padding, add the padding marker.  buffer was zeroes already.
+    // always pad, the marker and zeroes to the end of the block.  a payload
+    // that is already whole blocks gets a block of padding, else the
+    // receiver can't tell its last octets from padding.
 
-      *padded_length =
-        ((data_length+(OSDP_KEY_OCTETS-1))/OSDP_KEY_OCTETS)*OSDP_KEY_OCTETS;
-      enc_buf [data_length] = 0x80;
-      *padding = *padded_length - data_length;
-    };
+    *padded_length = ((data_length/OSDP_KEY_OCTETS)+1)*OSDP_KEY_OCTETS;
+    *padding = *padded_length - data_length;
+    enc_buf [data_length] = 0x80;
+    memset(enc_buf+data_length+1, 0, *padding-1);
   };
   if (ctx->verbosity > 3)
   {
@@ -689,17 +567,19 @@ int
       enc_buf, *padded_length);
   };
   // do encryption.  key is s-enc; iv is inverse of last rec mac
-  memcpy(encrypt_iv, ctx->last_calculated_in_mac, OSDP_KEY_OCTETS);
-  for(i=0; i<OSDP_KEY_OCTETS; i++)
-    encrypt_iv [i] = ~encrypt_iv [i];
-  if (ctx->verbosity > 3)
+  if (status EQUALS ST_OK)
   {
-    dump_buffer_log(ctx, "iv(inverted):", encrypt_iv, OSDP_KEY_OCTETS);
-    dump_buffer_log(ctx, "s_enc:", ctx->s_enc, OSDP_KEY_OCTETS);
+    memcpy(encrypt_iv, ctx->last_calculated_in_mac, OSDP_KEY_OCTETS);
+    for(i=0; i<OSDP_KEY_OCTETS; i++)
+      encrypt_iv [i] = ~encrypt_iv [i];
+    if (ctx->verbosity > 3)
+    {
+      dump_buffer_log(ctx, "iv(inverted):", encrypt_iv, OSDP_KEY_OCTETS);
+      dump_buffer_log(ctx, "s_enc:", ctx->s_enc, OSDP_KEY_OCTETS);
+    };
+    osdp_cipher_cbc_encrypt (osdp_session_key (ctx, OSDP_SESSION_S_ENC),
+      encrypt_iv, enc_buf, *padded_length);
   };
-  AES_init_ctx (&aes_context_encrypt, ctx->s_enc);
-  AES_ctx_set_iv (&aes_context_encrypt, encrypt_iv);
-  AES_CBC_encrypt_buffer(&aes_context_encrypt, enc_buf, *padded_length);
 
   if (ctx->verbosity > 3)
   {
@@ -780,6 +660,7 @@ void
   memset(ctx->rmac_i, 0, sizeof(ctx->rmac_i));
   memset (ctx->last_calculated_in_mac, 0, sizeof (ctx->last_calculated_in_mac));
   memset (ctx->last_calculated_out_mac, 0, sizeof (ctx->last_calculated_out_mac));
+  memset (ctx->session_key, 0, sizeof (ctx->session_key));
   ctx->secure_channel_use [OO_SCU_ENAB] = OO_SCS_USE_DISABLED;
   if (ctx->enable_secure_channel > 0)
   {
@@ -791,6 +672,239 @@ void
 } /* osdp_reset_secure_channel */
 
 
+/*
+  osdp_sc_load - make a PD's secure channel the one the context uses
+
+  one that was never saved is the set-up the context started with.
+*/
+
+void
+  osdp_sc_load
+    (OSDP_CONTEXT *ctx,
+    OSDP_SC_STATE *sc)
+
+{ /* osdp_sc_load */
+
+  if (!(sc->saved))
+    sc = &(ctx->sc_configured);
+  if (sc->saved)
+  {
+    memcpy (ctx->secure_channel_use, sc->secure_channel_use,
+      sizeof (ctx->secure_channel_use));
+    ctx->current_key_slot = sc->current_key_slot;
+    memcpy (ctx->current_scbk, sc->current_scbk, sizeof (ctx->current_scbk));
+    memcpy (ctx->rnd_a, sc->rnd_a, sizeof (ctx->rnd_a));
+    memcpy (ctx->rnd_b, sc->rnd_b, sizeof (ctx->rnd_b));
+    memcpy (ctx->s_enc, sc->s_enc, sizeof (ctx->s_enc));
+    memcpy (ctx->s_mac1, sc->s_mac1, sizeof (ctx->s_mac1));
+    memcpy (ctx->s_mac2, sc->s_mac2, sizeof (ctx->s_mac2));
+    memcpy (ctx->rmac_i, sc->rmac_i, sizeof (ctx->rmac_i));
+    memcpy (ctx->last_calculated_in_mac, sc->last_calculated_in_mac,
+      sizeof (ctx->last_calculated_in_mac));
+    memcpy (ctx->last_calculated_out_mac, sc->last_calculated_out_mac,
+      sizeof (ctx->last_calculated_out_mac));
+  };
+
+} /* osdp_sc_load */
+
+
+/*
+  osdp_sc_save - keep the context's secure channel for its PD
+*/
+
+void
+  osdp_sc_save
+    (OSDP_CONTEXT *ctx,
+    OSDP_SC_STATE *sc)
+
+{ /* osdp_sc_save */
+
+  memcpy (sc->secure_channel_use, ctx->secure_channel_use,
+    sizeof (sc->secure_channel_use));
+  sc->current_key_slot = ctx->current_key_slot;
+  memcpy (sc->current_scbk, ctx->current_scbk, sizeof (sc->current_scbk));
+  memcpy (sc->rnd_a, ctx->rnd_a, sizeof (sc->rnd_a));
+  memcpy (sc->rnd_b, ctx->rnd_b, sizeof (sc->rnd_b));
+  memcpy (sc->s_enc, ctx->s_enc, sizeof (sc->s_enc));
+  memcpy (sc->s_mac1, ctx->s_mac1, sizeof (sc->s_mac1));
+  memcpy (sc->s_mac2, ctx->s_mac2, sizeof (sc->s_mac2));
+  memcpy (sc->rmac_i, ctx->rmac_i, sizeof (sc->rmac_i));
+  memcpy (sc->last_calculated_in_mac, ctx->last_calculated_in_mac,
+    sizeof (sc->last_calculated_in_mac));
+  memcpy (sc->last_calculated_out_mac, ctx->last_calculated_out_mac,
+    sizeof (sc->last_calculated_out_mac));
+  sc->saved = 1;
+
+} /* osdp_sc_save */
+
+
+/*
+  osdp_secure_open - check and decrypt an inbound secure frame in place
+
+  the MAC is checked against the frame as received and the payload (SCS_17,
+  SCS_18) is decrypted where it is, at msg->data_payload.
+*/
+
+int
+  osdp_secure_open
+    (OSDP_CONTEXT *ctx,
+    OSDP_MSG *msg,
+    int security_block_type,
+    int hashable_length)
+
+{ /* osdp_secure_open */
+
+  int status;
+
+
+  status = oo_hash_check (ctx, msg->ptr, security_block_type,
+    msg->crc_check-4, hashable_length);
+  if (status EQUALS ST_OK)
+    status = osdp_decrypt_payload (ctx, msg);
+  return (status);
+
+} /* osdp_secure_open */
+
+
+/*
+  osdp_secure_seal - finish an outbound secure frame in place
+
+  frame has the header, security block, command and the cleartext payload
+  (*payload_length octets at payload_offset.)  for SCS_17 and SCS_18 the
+  payload is padded and encrypted where it is.  then the length is set and
+  the MAC (SCS_15-18) and CRC or checksum are appended.  the padded payload
+  length and the whole frame length are returned.
+*/
+
+int
+  osdp_secure_seal
+    (OSDP_CONTEXT *ctx,
+    unsigned char *frame,
+    int payload_offset,
+    int *payload_length,
+    int *frame_length)
+
+{ /* osdp_secure_seal */
+
+  int check_size;
+  int length;
+  int mac_size;
+  int padded_length;
+  int padding;
+  unsigned short int parsed_crc;
+  int sec_block_type;
+  int status;
+  int whole_msg_lth;
+
+
+  status = ST_OK;
+  if (m_check EQUALS OSDP_CHECKSUM)
+    check_size = 1;
+  else
+    check_size = 2;
+  sec_block_type = frame [6];
+  mac_size = 0;
+  if ((sec_block_type EQUALS OSDP_SEC_SCS_15) ||
+    (sec_block_type EQUALS OSDP_SEC_SCS_16) ||
+    (sec_block_type EQUALS OSDP_SEC_SCS_17) ||
+    (sec_block_type EQUALS OSDP_SEC_SCS_18))
+    mac_size = 4;
+
+  // room for a block of padding, the MAC and the check
+
+  padded_length = *payload_length;
+  if ((payload_offset + padded_length + OSDP_KEY_OCTETS + mac_size +
+    check_size) > OSDP_BUF_MAX)
+    status = ST_OSDP_EXCEEDS_SC_MAX;
+  if (status EQUALS ST_OK)
+    if ((*payload_length > 0) &&
+      ((sec_block_type EQUALS OSDP_SEC_SCS_17) ||
+      (sec_block_type EQUALS OSDP_SEC_SCS_18)))
+    {
+      padded_length = OSDP_BUF_MAX - payload_offset;
+      padding = 0;
+      status = osdp_encrypt_payload (ctx, frame+payload_offset,
+        *payload_length, frame+payload_offset, &padded_length, &padding);
+    };
+  if (status EQUALS ST_OK)
+  {
+    // length goes in before the MAC calculation
+
+    length = payload_offset + padded_length;
+    whole_msg_lth = length + mac_size + check_size;
+    frame [2] = 0x00ff & whole_msg_lth;
+    frame [3] = (0xff00 & whole_msg_lth) >> 8;
+    if (ctx->verbosity > 9)
+      dump_buffer_log(ctx, "Secure Before MAC append", frame, length);
+
+    // append 4-byte partial MAC for SCS_15-18
+    if (mac_size > 0)
+    {
+      if (ctx->verbosity > 3)
+        dump_buffer_log(ctx, "buffer for mac calc:", frame, length);
+      status = osdp_calculate_secure_channel_mac (ctx, frame, length,
+        frame+length);
+      length = length + mac_size;
+    };
+  };
+  if (status EQUALS ST_OK)
+  {
+    if (ctx->verbosity > 9)
+      dump_buffer_log(ctx, "Secure After MAC append", frame, length);
+
+    // crc, low order byte first
+    if (m_check EQUALS OSDP_CRC)
+    {
+      parsed_crc = fCrcBlk (frame, length);
+      frame [length] = (0x00ff & parsed_crc);
+      frame [length+1] = (0xff00 & parsed_crc) >> 8;
+    }
+    else
+    {
+      frame [length] = checksum (frame, length);
+    };
+    length = length + check_size;
+    *payload_length = padded_length;
+    *frame_length = length;
+  };
+  return (status);
+
+} /* osdp_secure_seal */
+
+
+/*
+  osdp_session_key - a session key's expanded schedule
+
+  key is OSDP_SESSION_S_ENC, _S_MAC1 or _S_MAC2.  the schedules are made
+  in osdp_create_keys; one is only expanded here if its key has changed
+  since then.
+*/
+
+OSDP_KEY_SCHEDULE
+  *osdp_session_key
+    (OSDP_CONTEXT *ctx,
+    int key)
+
+{ /* osdp_session_key */
+
+  unsigned char *key_value;
+  OSDP_KEY_SCHEDULE *schedule;
+
+
+  key_value = ctx->s_enc;
+  if (key EQUALS OSDP_SESSION_S_MAC1)
+    key_value = ctx->s_mac1;
+  if (key EQUALS OSDP_SESSION_S_MAC2)
+    key_value = ctx->s_mac2;
+  schedule = &(ctx->session_key [key]);
+  if ((!schedule->valid) ||
+    (0 != memcmp (schedule->key, key_value, OSDP_KEY_OCTETS)))
+    osdp_cipher_expand (schedule, key_value);
+  return (schedule);
+
+} /* osdp_session_key */
+
+
 /*
   oo_hash_check
     - calculate MAC for inbound
@@ -806,17 +920,13 @@ int
 
 { /* oo_hash_check */
 
-  struct AES_ctx aes_context_mac1;
-  struct AES_ctx aes_context_mac2;
   unsigned char current_iv [OSDP_KEY_OCTETS];
   int current_length;
   unsigned char *current_pointer;
   int first_blocks_length;
-  unsigned char hashbuffer [OSDP_KEY_OCTETS];
   unsigned char last_block [OSDP_KEY_OCTETS];
   int last_block_length;
   unsigned char *message_pointer;
-  unsigned char first_blocks_temp [OSDP_BUF_MAX];
   int status;
 
 
@@ -851,13 +961,10 @@ int
         dump_buffer_log(ctx, "iv(oo_hash_check):", current_iv, OSDP_KEY_OCTETS);
       };
 
-      AES_init_ctx(&aes_context_mac1, ctx->s_mac1);
-      AES_ctx_set_iv(&aes_context_mac1, current_iv);
-      memcpy(first_blocks_temp, current_pointer, first_blocks_length);
       if (ctx->verbosity > 3)
-        dump_buffer_log(ctx, "first blocks from wire:", first_blocks_temp, first_blocks_length);
-      AES_CBC_encrypt_buffer(&aes_context_mac1, first_blocks_temp, first_blocks_length);
-      memcpy(current_iv, first_blocks_temp + (first_blocks_length - OSDP_KEY_OCTETS), OSDP_KEY_OCTETS);
+        dump_buffer_log(ctx, "first blocks from wire:", current_pointer, first_blocks_length);
+      osdp_cipher_cbc_mac (osdp_session_key (ctx, OSDP_SESSION_S_MAC1),
+        current_iv, current_pointer, first_blocks_length, current_iv);
 
       current_pointer = message_pointer + first_blocks_length;
     };
@@ -869,27 +976,25 @@ int
     {
       osdp_sc_pad(last_block, last_block_length);
     };
-    AES_init_ctx (&aes_context_mac2, ctx->s_mac2);
-    AES_ctx_set_iv (&aes_context_mac2, current_iv);
-    memcpy (hashbuffer, last_block, sizeof(last_block));
-    AES_CBC_encrypt_buffer(&aes_context_mac2, hashbuffer, sizeof(hashbuffer));
-    memcpy(ctx->last_calculated_in_mac,
-      hashbuffer, sizeof(ctx->last_calculated_in_mac));
+    osdp_cipher_cbc_mac (osdp_session_key (ctx, OSDP_SESSION_S_MAC2),
+      current_iv, last_block, sizeof(last_block), ctx->last_calculated_in_mac);
     if (ctx->verbosity > 3)
     {
       dump_buffer_log(ctx, " rcv hash", hash, 4);
-      dump_buffer_log(ctx, "calc hash", hashbuffer, sizeof(hashbuffer));
+      dump_buffer_log(ctx, "calc hash", ctx->last_calculated_in_mac,
+        sizeof(ctx->last_calculated_in_mac));
     };
 
-    // the hash we calculated (hashbuffer) should match the hash extracted
-    // from the message (hash)
+    // the hash we calculated (last_calculated_in_mac) should match the
+    // hash extracted from the message (hash)
 
-    if (0 EQUALS memcmp(hash, hashbuffer, 4))
+    if (0 EQUALS memcmp(hash, ctx->last_calculated_in_mac, 4))
     {
       status = ST_OK;
       if (ctx->verbosity > 3)
         fprintf(ctx->log, "  ..SC MAC calculation matches %02x%02x%02x%02x\n",
-          hashbuffer [0], hashbuffer [1], hashbuffer [2], hashbuffer [3]);
+          ctx->last_calculated_in_mac [0], ctx->last_calculated_in_mac [1],
+          ctx->last_calculated_in_mac [2], ctx->last_calculated_in_mac [3]);
       ctx->hash_ok ++;
     };
   };
@@ -1087,18 +1192,24 @@ int
 
 { /* send_secure_message */
 
-  unsigned char buf [2];
+  OSDP_MSG frame;
   int old_state;
   int status;
-  unsigned char test_blk [1024];
+  unsigned char *test_blk;
   int true_dest;
+  unsigned char wire_blk [1+1024];
 
 
+  ctx->last_was_processed = 0; // as send_message, the answer is awaited
   status = ST_OK;
   fflush (ctx->log);
   true_dest = dest_addr;
   *current_length = 0;
 
+  // the frame is built just past the mark so both go out in one write
+  wire_blk [0] = C_OSDP_MARK;
+  test_blk = wire_blk + 1;
+
   // so we remember our state
   old_state = 128 + sec_block_type;
   if (ctx->secure_channel_use [OO_SCU_ENAB] != OO_SCS_OPERATIONAL)
@@ -1113,48 +1224,33 @@ int
     ctx->next_sequence,
     data_length, // data length to use
     data,
-    sec_block_type, sec_block_length, sec_blk); // security values
+    sec_block_type, sec_block_length, sec_blk, // security values
+    &frame);
 
   if (status EQUALS ST_OK)
   {
-    OSDP_MSG m;
-//    int parse_role;
-    OSDP_HDR returned_hdr;
-    int status_monitor;
-
     next_sequence(ctx);
 
-    memset (&m, 0, sizeof (m));
-    m.ptr = test_blk; // marshalled outbound message
-    m.lth = *current_length;
-
-    // parse the message for display.  role to parse is the OTHER guy
-//    parse_role = OSDP_ROLE_CP; if (ctx->role EQUALS OSDP_ROLE_CP) parse_role = OSDP_ROLE_PD;
-    status_monitor = osdp_parse_message (ctx, OSDP_ROLE_MONITOR, //parse_role,
-      &m, &returned_hdr);
-    if (ctx->verbosity > 8)
-      if (status_monitor != ST_OK)
-      {
-        sprintf (tlogmsg,"parse_message for monitoring returned %d.\n",
-          status_monitor);
-        status = oosdp_log (ctx, OSDP_LOG_STRING_CP, 1, tlogmsg);
-      };
-    (void)monitor_osdp_message (ctx, &m);
+    // log it from the builder's description (looked at as the monitor would)
+    (void)osdp_log_tx_message (ctx, OSDP_ROLE_MONITOR, &frame);
   };
   if (status EQUALS ST_OK)
   {
-    buf [0] = 0xff;
-    // send start-of-message marker (0xff)
-    send_osdp_data (ctx, &(buf[0]), 1);
-
     if (sec_block_type EQUALS OSDP_SEC_SCS_11)
       ctx->secure_channel_use [0] = 128 + OSDP_SEC_SCS_11;
 
-    send_osdp_data (ctx, test_blk, *current_length);
+    // send start-of-message marker (0xff) and the frame, kept for a resend
+    osdp_retransmit_save (ctx, wire_blk, 1 + *current_length);
+    status = send_osdp_data (ctx, wire_blk, 1 + *current_length);
 
     // keep track of the last command sent (for "secure" messages)
     ctx->last_command_sent = command;
   };
+  if (status EQUALS ST_OK)
+  {
+    (void)osdp_timer_start (ctx, OSDP_TIMER_RESPONSE);
+    ctx->timer [OSDP_TIMER_RESPONSE].status = OSDP_TIMER_RUNNING;
+  };
   return (status);
 
 } /* send_secure_message */
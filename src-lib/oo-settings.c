@@ -85,6 +85,35 @@ int
     };
   }; 
 
+  // parameter "action-plugin" - shared object with the action hooks
+
+  if (status EQUALS ST_OK)
+  {
+    value = json_object_get (root, "action-plugin");
+    if (json_is_string (value))
+    {
+      strncpy (ctx->action_plugin, json_string_value (value),
+        sizeof (ctx->action_plugin)-1);
+      ctx->action_plugin [sizeof (ctx->action_plugin)-1] = 0;
+    };
+  };
+
+  // parameter "action-scripts" - "async" (default), "sync" or "off"
+
+  if (status EQUALS ST_OK)
+  {
+    value = json_object_get (root, "action-scripts");
+    if (json_is_string (value))
+    {
+      if (0 EQUALS strcmp (json_string_value (value), "async"))
+        ctx->action_scripts = OSDP_ACTION_SCRIPTS_ASYNC;
+      if (0 EQUALS strcmp (json_string_value (value), "off"))
+        ctx->action_scripts = OSDP_ACTION_SCRIPTS_OFF;
+      if (0 EQUALS strcmp (json_string_value (value), "sync"))
+        ctx->action_scripts = OSDP_ACTION_SCRIPTS_SYNC;
+    };
+  };
+
   // parameter "address"
   // this is the PD address.
 
@@ -144,6 +173,22 @@ int
       m_check = OSDP_CRC;
   }; 
 
+  // parameter "cipher" - "auto" (default), "aes-ni" or "software"
+
+  if (status EQUALS ST_OK)
+  {
+    value = json_object_get (root, "cipher");
+    if (json_is_string (value))
+    {
+      if (0 EQUALS strcmp (json_string_value (value), "auto"))
+        ctx->cipher = OSDP_CIPHER_AUTO;
+      if (0 EQUALS strcmp (json_string_value (value), "aes-ni"))
+        ctx->cipher = OSDP_CIPHER_AESNI;
+      if (0 EQUALS strcmp (json_string_value (value), "software"))
+        ctx->cipher = OSDP_CIPHER_SOFTWARE;
+    };
+  };
+
   // parameter "disable_checking"
 
   if (status EQUALS ST_OK)
@@ -336,6 +381,45 @@ int
     };
   };
 
+  // parameter "pd-addresses"
+  // PD addresses to poll in turn on a multi-drop bus e.g. "0,1,2,5" (ACU)
+
+  if (status EQUALS ST_OK)
+  {
+    found_field = 1;
+    strcpy (field, "pd-addresses");
+    value = json_object_get (root, field);
+    if (!json_is_string (value))
+      found_field = 0;
+  };
+  if (found_field)
+  {
+    status = osdp_bus_add_list (&(ctx->own_bus),
+      (char *)json_string_value (value));
+  };
+
+  // parameter "command-queue-depth" - commands that can wait, per lane
+
+  if (status EQUALS ST_OK)
+  {
+    found_field = 1;
+    strcpy (field, "command-queue-depth");
+    value = json_object_get (root, field);
+    if (!json_is_string (value))
+      found_field = 0;
+  };
+  if (found_field)
+  {
+    char vstr [1024];
+    int i;
+    strcpy (vstr, json_string_value (value));
+    i = OSDP_COMMAND_QUEUE_SIZE;
+    sscanf (vstr, "%d", &i);
+    if (i < 1)
+      i = 1;
+    ctx->q.depth = i;
+  };
+
   // poll
 
   if (status EQUALS ST_OK)
@@ -372,6 +456,63 @@ fprintf(stderr, "DEBUG: poll deprecated\n");
     };
   };
 
+  // parameter "results-file" - where the results are kept
+
+  if (status EQUALS ST_OK)
+  {
+    value = json_object_get (root, "results-file");
+    if (json_is_string (value))
+    {
+      strncpy (ctx->results_path, json_string_value (value),
+        sizeof (ctx->results_path)-1);
+      ctx->results_path [sizeof (ctx->results_path)-1] = 0;
+    };
+  };
+
+  // parameter "retries" - times the ACU resends a frame that got no answer
+
+  if (status EQUALS ST_OK)
+  {
+    found_field = 1;
+    strcpy (field, "retries");
+    value = json_object_get (root, field);
+    if (!json_is_string (value))
+      found_field = 0;
+  };
+  if (found_field)
+  {
+    char vstr [1024];
+    int i;
+    strcpy (vstr, json_string_value (value));
+    i = OSDP_RETRANSMIT_DEFAULT_RETRIES;
+    sscanf (vstr, "%d", &i);
+    if (i < 0)
+      i = 0;
+    ctx->retry_max = i;
+  };
+
+  // parameter "retry-backoff" - milliseconds more to wait on each resend
+
+  if (status EQUALS ST_OK)
+  {
+    found_field = 1;
+    strcpy (field, "retry-backoff");
+    value = json_object_get (root, field);
+    if (!json_is_string (value))
+      found_field = 0;
+  };
+  if (found_field)
+  {
+    char vstr [1024];
+    int i;
+    strcpy (vstr, json_string_value (value));
+    i = OSDP_RETRANSMIT_DEFAULT_BACKOFF;
+    sscanf (vstr, "%d", &i);
+    if (i < 0)
+      i = 0;
+    ctx->retry_backoff = i;
+  };
+
   // secure_channel (enabled or disabled)
   // secure_install (normal or install)
   // secure_transmit (relaxed or strict)
@@ -396,6 +537,42 @@ fprintf(stderr, "DEBUG: poll deprecated\n");
     if (status EQUALS ST_OK)
       memcpy(ctx->serial_number, serial_number, sizeof(ctx->serial_number));
   };
+
+  // parameter "stats-shm" - name of the live statistics segment
+
+  if (status EQUALS ST_OK)
+  {
+    value = json_object_get (root, "stats-shm");
+    if (json_is_string (value))
+    {
+      strncpy (ctx->stats_name, json_string_value (value),
+        sizeof (ctx->stats_name)-1);
+      ctx->stats_name [sizeof (ctx->stats_name)-1] = 0;
+    };
+  };
+
+  // parameter "status-rate" - most times a second osdp-status.json is written
+
+  if (status EQUALS ST_OK)
+  {
+    found_field = 1;
+    strcpy (field, "status-rate");
+    value = json_object_get (root, field);
+    if (!json_is_string (value))
+      found_field = 0;
+  };
+  if (found_field)
+  {
+    char vstr [1024];
+    int i;
+    strcpy (vstr, json_string_value (value));
+    i = OSDP_STATUS_RATE_DEFAULT;
+    sscanf (vstr, "%d", &i);
+    if (i < 0)
+      i = 0;
+    ctx->status_rate = i;
+  };
+
   // parameter "timeout"
   // note this is timer 0 (zero)
 
@@ -520,6 +697,56 @@ fprintf (stderr, "processing value %s\n",
     strcpy (p_card.filename, this_value);
   }; 
 
+  // parameter "serial-ports"
+  // several buses: [ { "serial_device" : "...", "pd-addresses" : "0,1" }, ...]
+  // the first takes the place of serial_device and pd-addresses.
+
+  if (status EQUALS ST_OK)
+  {
+    found_field = 1;
+    strcpy (field, "serial-ports");
+    value = json_object_get (root, field);
+    if (!json_is_array (value))
+      found_field = 0;
+  };
+  if (found_field)
+  {
+    json_t *port_value;
+    json_t *port_field;
+    size_t port_index;
+
+    if (json_array_size (value) > OSDP_PORT_MAX)
+    {
+      fprintf (stderr, "too many serial ports (%d. max)\n", OSDP_PORT_MAX);
+      status = ST_PORT_TOO_MANY;
+    };
+    ctx->port_config_count = 0;
+    for (port_index=0; (status EQUALS ST_OK) &&
+      (port_index<json_array_size (value)); port_index++)
+    {
+      OSDP_PORT_CONFIG *pc;
+
+      pc = &(ctx->port_config [port_index]);
+      memset (pc, 0, sizeof (*pc));
+      port_value = json_array_get (value, port_index);
+      port_field = json_object_get (port_value, "serial_device");
+      if (json_is_string (port_field))
+        strncpy (pc->device, json_string_value (port_field),
+          sizeof (pc->device)-1);
+      port_field = json_object_get (port_value, "pd-addresses");
+      if (json_is_string (port_field))
+        strncpy (pc->pd_addresses, json_string_value (port_field),
+          sizeof (pc->pd_addresses)-1);
+      ctx->port_config_count ++;
+    };
+    if ((status EQUALS ST_OK) && (ctx->port_config_count > 0))
+    {
+      strcpy (p_card.filename, ctx->port_config [0].device);
+      status = osdp_bus_add_list (&(ctx->own_bus),
+        ctx->port_config [0].pd_addresses);
+    };
+  };
+
   // parameter "serial_speed"
   if ((status EQUALS ST_OK) || (status EQUALS ST_CMD_INVALID))
   {
@@ -535,6 +762,27 @@ fprintf (stderr, "processing value %s\n",
     strcpy (ctx->serial_speed, this_value);
   }; 
 
+  // parameter "serial-rs485"
+  // "1" to have the kernel switch the RS-485 driver (TIOCSRS485)
+
+  if (status EQUALS ST_OK)
+  {
+    found_field = 1;
+    strcpy (field, "serial-rs485");
+    value = json_object_get (root, field);
+    if (!json_is_string (value))
+      found_field = 0;
+  };
+  if (found_field)
+  {
+    char vstr [1024];
+    int i;
+    strcpy (vstr, json_string_value (value));
+    i = 0;
+    sscanf (vstr, "%d", &i);
+    ctx->rs485 = i;
+  };
+
   // parameter "raw_value"
 
   if (status EQUALS ST_OK)
@@ -0,0 +1,174 @@
+/*
+  oo-stats - live statistics in shared memory
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  The counters the status pages show are copied into an OSDP_STATS in a
+  shared memory segment each time the status is published, which is
+  memory only and so is not rate limited like osdp-status.json.  The
+  status CGIs and osdp-stats map the segment read-only and never make
+  the program wait.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+
+#include <open-osdp.h>
+#include <osdp_conformance.h>
+
+
+extern OSDP_PARAMETERS p_card;
+
+
+/*
+  osdp_stats_open - create (or reuse) the statistics segment
+
+  with no segment the program runs as before, just without live stats.
+*/
+
+int
+  osdp_stats_open
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_stats_open */
+
+  int fd;
+  OSDP_STATS *s;
+  int status;
+
+
+  status = ST_OK;
+  s = NULL;
+  if (ctx->stats_name [0] EQUALS 0)
+  {
+    if (ctx->role EQUALS OSDP_ROLE_PD)
+      strcpy (ctx->stats_name, "/open-osdp-PD");
+    else
+      if (ctx->role EQUALS OSDP_ROLE_MONITOR)
+        strcpy (ctx->stats_name, "/open-osdp-MON");
+      else
+        strcpy (ctx->stats_name, "/open-osdp-ACU");
+  };
+  fd = shm_open (ctx->stats_name, O_RDWR | O_CREAT, 0644);
+  if (fd EQUALS -1)
+    status = ST_OSDP_STATS_SHM;
+  if (status EQUALS ST_OK)
+  {
+    if (ftruncate (fd, sizeof (*s)) != 0)
+      status = ST_OSDP_STATS_SHM;
+    if (status EQUALS ST_OK)
+    {
+      s = mmap (NULL, sizeof (*s), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (s EQUALS MAP_FAILED)
+      {
+        s = NULL;
+        status = ST_OSDP_STATS_SHM;
+      };
+    };
+    close (fd);
+  };
+  if (s != NULL)
+  {
+    // a reader that is part way through keeps seeing an odd sequence
+
+    s->sequence = s->sequence | 1;
+    __sync_synchronize ();
+    s->magic = OSDP_STATS_MAGIC;
+    s->version = OSDP_STATS_VERSION;
+    s->size = sizeof (*s);
+    s->pid = getpid ();
+    s->role = ctx->role;
+    __sync_synchronize ();
+    s->sequence ++;
+  }
+  else
+  {
+    fprintf (ctx->log, "Statistics segment %s not available\n",
+      ctx->stats_name);
+  };
+  ctx->stats = s;
+  return (status);
+
+} /* osdp_stats_open */
+
+
+/*
+  osdp_stats_publish - copy the counters into the segment
+*/
+
+void
+  osdp_stats_publish
+    (OSDP_CONTEXT *ctx)
+
+{ /* osdp_stats_publish */
+
+  extern OSDP_BUFFER osdp_buf;
+  int i;
+  OSDP_STATS *s;
+
+
+  s = ctx->stats;
+  if (s != NULL)
+  {
+    s->sequence ++;
+    __sync_synchronize ();
+
+    s->updated = time (NULL);
+    s->pd_address = p_card.addr;
+    strncpy (s->serial_speed, ctx->serial_speed, sizeof (s->serial_speed)-1);
+    strncpy (s->text, ctx->text, sizeof (s->text)-1);
+    s->key_slot = ctx->current_key_slot;
+    memcpy (s->scbk, ctx->current_scbk, sizeof (s->scbk));
+    s->acu_polls = ctx->acu_polls;
+    s->pd_acks = ctx->pd_acks;
+    s->pd_naks = ctx->sent_naks;
+    s->pdus_received = ctx->pdus_received;
+    s->pdus_sent = ctx->pdus_sent;
+    s->bytes_received = ctx->bytes_received;
+    s->dropped_octets = ctx->dropped_octets;
+    s->crc_errs = ctx->crc_errs;
+    s->checksum_errs = ctx->checksum_errs;
+    s->seq_bad = ctx->seq_bad;
+    s->hash_ok = ctx->hash_ok;
+    s->hash_bad = ctx->hash_bad;
+    s->buffer_overflows = osdp_buf.overflow;
+    s->retries = ctx->retries;
+    s->serial_write_errs = ctx->serial_write_errs;
+    for (i=0; i<OSDP_STATS_LEDS; i++)
+    {
+      s->led_active [i] = (ctx->led [i].state EQUALS OSDP_LED_ACTIVATED);
+      s->led_color [i] = ctx->led [i].web_color;
+    };
+    for (i=0; i<OSDP_MAX_OUT; i++)
+      s->out [i] = ctx->out [i].current;
+    s->xfer_offset = ctx->xferctx.current_offset;
+    s->xfer_total = ctx->xferctx.total_length;
+    s->xfer_send_length = ctx->xferctx.current_send_length;
+
+    __sync_synchronize ();
+    s->sequence ++;
+  };
+
+} /* osdp_stats_publish */
+
@@ -209,7 +209,7 @@ exit(-1);
         status = send_message_ex (context, OSDP_ID, 0x7F,
           &current_length, sizeof (param), param,
           OSDP_SEC_SCS_17, 0, NULL);
-        osdp_test_set_status(OOC_SYMBOL_cmd_id, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_id, OCONFORM_EXERCISED);
         status = ST_OK;
       };
       break;
@@ -629,7 +629,7 @@ fprintf(stderr, "xfer size %d.\n", transfer_send_size);
         memcpy (&new_speed, details+4, 4);
         sprintf (context->serial_speed, "%d", new_speed);
         context->new_address = details [0];
-        osdp_test_set_status(OOC_SYMBOL_cmd_comset, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_comset, OCONFORM_EXERCISED);
         if (context->verbosity > 2)
           fprintf (stderr, "Set Comms: addr to %02x speed to %s.\n",
             context->new_address, context->serial_speed);
@@ -667,12 +667,10 @@ fprintf(stderr, "xfer size %d.\n", transfer_send_size);
       {
         int count;
         int i;
-        count = 0;
-        if (osdp_buf.next > 0)
-          count = osdp_buf.next;
+        count = osdp_buffer_count (&osdp_buf);
         fprintf (stderr, "Buffer had %d bytes\n", count);
         for (i=0; i<count; i++)
-          fprintf (stderr, " %02x", osdp_buf.buf [i]);
+          fprintf (stderr, " %02x", osdp_buffer_octet (&osdp_buf, i));
         fprintf (stderr, "\n");
         status = ST_OK;
       };
@@ -720,7 +718,7 @@ fprintf(stderr,"w:%d\n", context->last_was_processed);
 
           if (context->verbosity > 3)
             fprintf (stderr, "Requesting PD Ident\n");
-          osdp_test_set_status(OOC_SYMBOL_cmd_id, OCONFORM_EXERCISED);
+          osdp_test_set_status(OOC_ID_cmd_id, OCONFORM_EXERCISED);
         };
       };
       status = ST_OK;
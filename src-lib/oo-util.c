@@ -67,6 +67,7 @@ int
   int msg_sqn;
   OSDP_HDR *p;
   unsigned short int parsed_crc;
+  int route_status;
   int sec_blk_length;
   int sec_block_type;
   int status;
@@ -86,6 +87,7 @@ int
   };
 
   status = ST_MSG_TOO_SHORT;
+  route_status = ST_OK;
 
   m->data_payload = NULL;
   m->security_block_length = 0; // assume no security block
@@ -306,7 +308,7 @@ if (m->msg_cmd EQUALS OSDP_FILETRANSFER)
       {
         if (msg_sqn EQUALS 0)
         {
-          osdp_test_set_status(OOC_SYMBOL_seq_zero, OCONFORM_EXERCISED);
+          osdp_test_set_status(OOC_ID_seq_zero, OCONFORM_EXERCISED);
         };
       };
     };
@@ -334,7 +336,7 @@ if (m->msg_cmd EQUALS OSDP_FILETRANSFER)
           strcpy (tlogmsg2, "\?\?\?");
 
         // if we don't recognize the command/reply code it fails 2-15-1
-        osdp_test_set_status(OOC_SYMBOL_CMND_REPLY, OCONFORM_FAIL);
+        osdp_test_set_status(OOC_ID_CMND_REPLY, OCONFORM_FAIL);
       };
       break;
 
@@ -360,7 +362,7 @@ if (m->msg_cmd EQUALS OSDP_FILETRANSFER)
       msg_data_length = 0;
       if (context->verbosity > 2)
         strcpy (tlogmsg2, "osdp_BUSY");
-      osdp_test_set_status(OOC_SYMBOL_resp_busy, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_resp_busy, OCONFORM_EXERCISED);
       break;
 
     case OSDP_FTSTAT:
@@ -529,8 +531,8 @@ fprintf(stderr, "lstat 1000\n");
       msg_data_length = msg_data_length - 6 - 2; // less hdr,cmnd, crc/chk
       if (context->verbosity > 2)
         strcpy (tlogmsg2, "osdp_PDCAP");
-      osdp_test_set_status(OOC_SYMBOL_cmd_cap, OCONFORM_EXERCISED);
-      osdp_test_set_status(OOC_SYMBOL_rep_device_capas, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_cmd_cap, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_rep_device_capas, OCONFORM_EXERCISED);
       break;
 
     case OSDP_PDID:
@@ -543,9 +545,9 @@ fprintf(stderr, "lstat 1000\n");
 
       // if we had sent an osdp_ID then that worked.
       if ((context->last_command_sent EQUALS OSDP_ID))
-        osdp_test_set_status(OOC_SYMBOL_cmd_id, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_id, OCONFORM_EXERCISED);
 
-      osdp_test_set_status(OOC_SYMBOL_rep_device_ident, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_rep_device_ident, OCONFORM_EXERCISED);
       break;
 
     case OSDP_PIVDATA:
@@ -554,7 +556,7 @@ fprintf(stderr, "lstat 1000\n");
       msg_data_length = msg_data_length - 6 - 2; // less hdr,cmnd, crc/chk
       if (context->verbosity > 2)
         strcpy (tlogmsg2, "osdp_PIVDATA");
-      osdp_test_set_status(OOC_SYMBOL_cmd_pivdata, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_cmd_pivdata, OCONFORM_EXERCISED);
       break;
 
     case OSDP_PIVDATAR:
@@ -563,7 +565,7 @@ fprintf(stderr, "lstat 1000\n");
       msg_data_length = msg_data_length - 6 - 2; // less hdr,cmnd, crc/chk
       if (context->verbosity > 2)
         strcpy (tlogmsg2, "osdp_PIVDATAR");
-      osdp_test_set_status(OOC_SYMBOL_resp_pivdatar, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_resp_pivdatar, OCONFORM_EXERCISED);
       break;
 
     case OSDP_RAW:
@@ -586,10 +588,10 @@ fprintf(stderr, "lstat 1000\n");
       m->data_payload = m->cmd_payload + 1;
       msg_data_length = p->len_lsb + (p->len_msb << 8);
       msg_data_length = msg_data_length - 6 - 2; // less hdr,cmnd, crc/chk
-      osdp_test_set_status(OOC_SYMBOL_resp_rstatr, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_resp_rstatr, OCONFORM_EXERCISED);
       // if this is in response to an RSTAT then mark that too.
       if (context->last_command_sent EQUALS OSDP_RSTAT)
-        osdp_test_set_status(OOC_SYMBOL_cmd_rstat, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_rstat, OCONFORM_EXERCISED);
       if (context->verbosity > 2)
         strcpy (tlogmsg2, "osdp_RSTATR");
       break;
@@ -650,7 +652,8 @@ fprintf(stderr, "lstat 1000\n");
           (sec_block_type EQUALS OSDP_SEC_SCS_17) || (sec_block_type EQUALS OSDP_SEC_SCS_18))
         {
           if ((context->secure_channel_use [OO_SCU_ENAB] != OO_SCS_OPERATIONAL) &&
-            (context->role EQUALS OSDP_ROLE_ACU))
+            (context->role EQUALS OSDP_ROLE_ACU) &&
+            (p_card.addr EQUALS (0x7f & p->addr)))
           {
             fprintf(context->log, "sec_block_type was %x but not in secure channel, resetting\n",
               sec_block_type);
@@ -664,9 +667,13 @@ fprintf(stderr, "lstat 1000\n");
         };
       };
 
-      parsed_crc = fCrcBlk (m->ptr, msg_lth - 2);
-
       wire_crc = *(1+m->crc_check) << 8 | *(m->crc_check);
+
+      // the framer already ran the CRC as the octets arrived
+      if (m->check_verified)
+        parsed_crc = wire_crc;
+      else
+        parsed_crc = fCrcBlk (m->ptr, msg_lth - 2);
       if (parsed_crc != wire_crc)
       {
         if (context->verbosity > 2)
@@ -686,7 +693,9 @@ fprintf(stderr, "lstat 1000\n");
 
       // checksum
 
-      parsed_cksum = checksum (m->ptr, m->lth-1);
+      parsed_cksum = 0;
+      if (!(m->check_verified))
+        parsed_cksum = checksum (m->ptr, m->lth-1);
 
 // hmmm
 
@@ -709,6 +718,8 @@ if (0) //if ((p->addr & 0x80) && (m->lth == 7))
   fprintf(stderr, "\n");
 };
 wire_cksum = (unsigned char)*(m->lth -1 + m->ptr);
+      if (m->check_verified)
+        parsed_cksum = wire_cksum;
       if (context->verbosity > 99)
       {
         fprintf (stderr, "pck %04x wck %04x\n",
@@ -779,9 +790,34 @@ status = ST_OK; // tolerate checksum error and continue
       };
     };
 
+    /*
+      a frame for another PD is not ours to MAC check or decrypt, that
+      would run it through the wrong secure channel (and move its MAC
+      chain on.)  on a multi-drop bus only the PD being polled gets
+      processed.  (role is the PD when our own outbound frame is parsed
+      for display.)
+    */
+    route_status = ST_OK;
+    if (status EQUALS ST_OK)
+    {
+      if (context->role EQUALS OSDP_ROLE_PD)
+        if ((p_card.addr != (0x7f & p->addr)) &&
+          (p->addr != OSDP_CONFIGURATION_ADDRESS))
+        {
+          if (context->verbosity > 3)
+            fprintf (stderr, "addr mismatch for: %02x me: %02x\n",
+              p->addr, p_card.addr);
+          route_status = ST_NOT_MY_ADDR;
+        };
+      if ((role EQUALS OSDP_ROLE_ACU) &&
+        (context->role EQUALS OSDP_ROLE_ACU) &&
+        (osdp_bus (context)->count > 0))
+        route_status = osdp_bus_route (context, 0x7f & p->addr);
+    };
+
     // check the MAC if it's secure channel formatted
 
-    if (status EQUALS ST_OK)
+    if ((status EQUALS ST_OK) && (route_status EQUALS ST_OK))
     {
       if (msg_scb != 0)
       {
@@ -790,10 +826,8 @@ status = ST_OK; // tolerate checksum error and continue
 
         if (role != OSDP_ROLE_MONITOR)
         {
-          status = oo_hash_check(context, m->ptr, sec_block_type,
-            m->crc_check-4, hashable_length);
-          if (status EQUALS ST_OK)
-            status = osdp_decrypt_payload(context, m);
+          status = osdp_secure_open(context, m, sec_block_type,
+            hashable_length);
           if (status != ST_OK)
             fprintf(context->log,
               "Payload decryption failed, status %d.\n", status);
@@ -867,15 +901,7 @@ status = ST_OK; // tolerate checksum error and continue
       us but it's a frame.
     */
     context->packets_received ++;
-
-    if (context->role EQUALS OSDP_ROLE_PD)
-      if ((p_card.addr != (0x7f & p->addr)) && (p->addr != OSDP_CONFIGURATION_ADDRESS))
-      {
-        if (context->verbosity > 3)
-          fprintf (stderr, "addr mismatch for: %02x me: %02x\n",
-            p->addr, p_card.addr);
-        status = ST_NOT_MY_ADDR;
-      };
+    status = route_status;
     if (context->role EQUALS OSDP_ROLE_MONITOR)
     {
       // pretty print the message if there are juicy details.
@@ -910,11 +936,13 @@ int
 
 { /* process_osdp_message */
 
-  char cmd [1024];
+  char args [1024];
+  char cmd [2*1024];
   int count;
   int current_length;
   int current_security;
   char details [1024];
+  OSDP_ACTION_EVENT event;
   int i;
   char logmsg [1024];
   char nak_code;
@@ -976,7 +1004,7 @@ int
         context->max_acu_receive);
       fprintf (context->log, "%s", logmsg);
       logmsg[0]=0;
-      osdp_test_set_status(OOC_SYMBOL_cmd_acurxsize, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_cmd_acurxsize, OCONFORM_EXERCISED);
       current_length = 0;
       current_security = OSDP_SEC_SCS_15;
       status = send_message_ex(context, OSDP_ACK, p_card.addr,
@@ -1001,7 +1029,7 @@ fprintf(context->log, "DEBUG2: NAK: %d.\n", osdp_nak_response_data [0]);
         status = send_message (context,
           OSDP_NAK, p_card.addr, &current_length, 1, osdp_nak_response_data);
         context->sent_naks ++;
-        osdp_test_set_status(OOC_SYMBOL_rep_nak, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_rep_nak, OCONFORM_EXERCISED);
         if (context->verbosity > 2)
         {
           fprintf (context->log, "Responding with OSDP NAK\n");
@@ -1026,7 +1054,7 @@ fprintf(context->log, "DEBUG2: NAK: %d.\n", osdp_nak_response_data [0]);
         fprintf (stderr, "%s", logmsg);
         logmsg[0]=0;
       };
-      osdp_test_set_status(OOC_SYMBOL_cmd_buz, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_cmd_buz, OCONFORM_EXERCISED);
       current_length = 0;
       current_security = OSDP_SEC_SCS_15;
       status = send_message_ex(context, OSDP_ACK, p_card.addr,
@@ -1098,8 +1126,8 @@ fprintf(context->log, "DEBUG2: NAK: %d.\n", osdp_nak_response_data [0]);
           OSDP_PDCAP, p_card.addr, &current_length,
             response_length, response_cap,
             current_security, 0, NULL);
-        osdp_test_set_status(OOC_SYMBOL_cmd_cap, OCONFORM_EXERCISED);
-        osdp_test_set_status(OOC_SYMBOL_rep_device_capas, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_cap, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_rep_device_capas, OCONFORM_EXERCISED);
       };
       break;
 
@@ -1146,17 +1174,20 @@ fprintf(context->log, "DEBUG2: NAK: %d.\n", osdp_nak_response_data [0]);
           current_security = OSDP_SEC_STAND_DOWN;
         status = send_message_ex(context, OSDP_PDID, oo_response_address(context, oh->addr),
           &current_length, sizeof(osdp_pdid_response_data), osdp_pdid_response_data, current_security, 0, NULL);
-        osdp_test_set_status(OOC_SYMBOL_cmd_id, OCONFORM_EXERCISED);
-        osdp_test_set_status(OOC_SYMBOL_rep_device_ident, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_id, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_rep_device_ident, OCONFORM_EXERCISED);
         if (context->verbosity > 2)
         {
           sprintf (logmsg, "Responding with OSDP_PDID");
           fprintf (context->log, "%s\n", logmsg);
         };
       }
+      memset (&event, 0, sizeof (event));
+      event.action = OSDP_ACTION_ID;
+      event.args = "";
       sprintf(cmd,
         "/opt/osdp-conformance/run/ACU-actions/osdp_ID");
-      system(cmd);
+      (void)osdp_action (context, &event, cmd);
     break;
 
     case OSDP_ISTAT:
@@ -1168,8 +1199,8 @@ fprintf(context->log, "DEBUG2: NAK: %d.\n", osdp_nak_response_data [0]);
         // hard code to show all inputs in '0' state.
 
         memset (osdp_istat_response_data, 0, sizeof (osdp_istat_response_data));
-        osdp_test_set_status(OOC_SYMBOL_cmd_istat, OCONFORM_EXERCISED);
-        osdp_test_set_status(OOC_SYMBOL_resp_istatr, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_istat, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_resp_istatr, OCONFORM_EXERCISED);
         current_length = 0;
         status = send_message (context, OSDP_ISTATR, p_card.addr,
           &current_length, sizeof (osdp_istat_response_data), osdp_istat_response_data);
@@ -1233,11 +1264,11 @@ fprintf(context->log, "DEBUG2: NAK: %d.\n", osdp_nak_response_data [0]);
               // for conformance tests 3-10-1/3-10-2 we specifically look for LED 0 Color 1 (Red) or Color 2 (Green)
 
               if (led_ctl->perm_on_color EQUALS 1)
-                osdp_test_set_status(OOC_SYMBOL_cmd_led_red, OCONFORM_EXERCISED);
+                osdp_test_set_status(OOC_ID_cmd_led_red, OCONFORM_EXERCISED);
               if (led_ctl->perm_on_color EQUALS 2)
-                osdp_test_set_status(OOC_SYMBOL_cmd_led_green, OCONFORM_EXERCISED);
+                osdp_test_set_status(OOC_ID_cmd_led_green, OCONFORM_EXERCISED);
               if (led_ctl->perm_on_color EQUALS 3)
-                osdp_test_set_status(OOC_SYMBOL_cmd_led_amber, OCONFORM_EXERCISED);
+                osdp_test_set_status(OOC_ID_cmd_led_amber, OCONFORM_EXERCISED);
             };
           led_ctl = led_ctl + sizeof(OSDP_RDR_LED_CTL);
         };
@@ -1273,8 +1304,8 @@ fprintf(stderr, "lstat 1684\n");
       unsigned char
         osdp_lstat_response_data [2];
 
-      osdp_test_set_status(OOC_SYMBOL_cmd_lstat, OCONFORM_EXERCISED);
-      osdp_test_set_status(OOC_SYMBOL_resp_lstatr, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_cmd_lstat, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_resp_lstatr, OCONFORM_EXERCISED);
       osdp_lstat_response_data [ 0] = context->tamper;
       osdp_lstat_response_data [ 1] = context->power_report; // report power failure
       current_length = 0;
@@ -1339,7 +1370,7 @@ fprintf(context->log, "DEBUG3: NAK: %d.\n", osdp_nak_response_data [0]);
         status = send_message (context,
           OSDP_NAK, p_card.addr, &current_length, nak_length, osdp_nak_response_data);
         context->sent_naks ++;
-        osdp_test_set_status(OOC_SYMBOL_rep_nak, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_rep_nak, OCONFORM_EXERCISED);
         if (context->verbosity > 2)
         {
           fprintf (stderr, "CMD %02x Unknown\n", msg->msg_cmd);
@@ -1432,16 +1463,24 @@ fprintf(context->log, "DEBUG3: NAK: %d.\n", osdp_nak_response_data [0]);
       context->sent_naks ++;
       context->last_nak_error = *(0+msg->data_payload);
 
+      count = oh->len_lsb + (oh->len_msb << 8);
+      count = count - 6 - 2; // less header less CRC
+      nak_code = *(msg->data_payload);
+      nak_data = 0;
+      if (count > 1)
+        nak_data = *(1+msg->data_payload);
+      sprintf (args, "%x %x", nak_code, nak_data);
+      memset (&event, 0, sizeof (event));
+      event.action = OSDP_ACTION_NAK;
+      event.data = msg->data_payload;
+      event.data_length = msg->data_length;
+      event.args = args;
+      (void)osdp_action (context, &event, NULL);
+
       if (context->verbosity > 2)
       {
-        count = oh->len_lsb + (oh->len_msb << 8);
-        count = count - 6 - 2; // less header less CRC
-
-        nak_code = *(msg->data_payload);
-        nak_data = 0;
         if (count > 1)
         {
-          nak_data = *(1+msg->data_payload);
           sprintf (tlogmsg, "osdp_NAK: Error Code %02x Data %02x",
             nak_code, *(1+msg->data_payload));
         }
@@ -1451,9 +1490,8 @@ fprintf(context->log, "DEBUG3: NAK: %d.\n", osdp_nak_response_data [0]);
         };
 
         sprintf(cmd,
-          "/opt/osdp-conformance/run/ACU-actions/osdp_NAK %x %x",
-          nak_code, nak_data);
-        system(cmd);
+          "/opt/osdp-conformance/run/ACU-actions/osdp_NAK %s", args);
+        osdp_action_script (context, cmd);
 
         fprintf (context->log, "%s\n", tlogmsg);
         switch(*(0+msg->data_payload))
@@ -1484,17 +1522,17 @@ fprintf(context->log, "DEBUG3: NAK: %d.\n", osdp_nak_response_data [0]);
 
         };
       };
-      osdp_test_set_status(OOC_SYMBOL_rep_nak, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_rep_nak, OCONFORM_EXERCISED);
 
       // if the PD NAK'd a BIOREAD fail the test.
       if (context->last_command_sent EQUALS OSDP_BIOREAD)
       {
-        osdp_test_set_status(OOC_SYMBOL_cmd_bioread, OCONFORM_FAIL);
+        osdp_test_set_status(OOC_ID_cmd_bioread, OCONFORM_FAIL);
       };
       // if the PD NAK'd a BIOMATCH fail the test.
       if (context->last_command_sent EQUALS OSDP_BIOMATCH)
       {
-        osdp_test_set_status(OOC_SYMBOL_cmd_biomatch, OCONFORM_FAIL);
+        osdp_test_set_status(OOC_ID_cmd_biomatch, OCONFORM_FAIL);
       };
       // if the PD NAK'd an ID fail the test.
       if (context->last_command_sent EQUALS OSDP_ID)
@@ -1511,12 +1549,12 @@ fprintf(context->log, "DEBUG3: NAK: %d.\n", osdp_nak_response_data [0]);
       // if the PD NAK'd a KEYSET fail the test.
       if (context->last_command_sent EQUALS OSDP_KEYSET)
       {
-        osdp_test_set_status(OOC_SYMBOL_cmd_keyset, OCONFORM_FAIL);
+        osdp_test_set_status(OOC_ID_cmd_keyset, OCONFORM_FAIL);
       };
       // if the PD NAK'd an LSTAT fail the test.
       if (context->last_command_sent EQUALS OSDP_LSTAT)
       {
-        osdp_test_set_status(OOC_SYMBOL_cmd_lstat, OCONFORM_FAIL);
+        osdp_test_set_status(OOC_ID_cmd_lstat, OCONFORM_FAIL);
       };
       // if the PD NAK'd a CAP fail the test.
       if (context->last_command_sent EQUALS OSDP_CAP)
@@ -1533,7 +1571,7 @@ fprintf(context->log, "DEBUG3: NAK: %d.\n", osdp_nak_response_data [0]);
 
     case OSDP_COM:
       status = ST_OK;
-      osdp_test_set_status(OOC_SYMBOL_resp_com, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_resp_com, OCONFORM_EXERCISED);
       if (context->verbosity > 2)
       {
         fprintf (stderr, "osdp_COM: Addr %02x Baud (m->l) %02x %02x %02x %02x\n",
@@ -1548,11 +1586,11 @@ fprintf(context->log, "DEBUG3: NAK: %d.\n", osdp_nak_response_data [0]);
       fprintf (context->log,
         " Tamper %d Power %d\n",
         *(msg->data_payload + 0), *(msg->data_payload + 1));
-      osdp_test_set_status(OOC_SYMBOL_resp_lstatr, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_resp_lstatr, OCONFORM_EXERCISED);
       if (*(msg->data_payload) > 0)
-        osdp_test_set_status(OOC_SYMBOL_resp_lstatr_tamper, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_resp_lstatr_tamper, OCONFORM_EXERCISED);
       if (*(msg->data_payload + 1) > 0)
-        osdp_test_set_status(OOC_SYMBOL_resp_lstatr_power, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_resp_lstatr_power, OCONFORM_EXERCISED);
       break;
 
     case OSDP_MFGERRR:
@@ -1675,11 +1713,11 @@ printf ("MMSG DONE\n");
       break;
 
     case OSDP_OSTATR:
-      osdp_test_set_status(OOC_SYMBOL_resp_ostatr, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_resp_ostatr, OCONFORM_EXERCISED);
 
       // if this is in response to an OSTAT then mark that too.
       if (context->last_command_sent EQUALS OSDP_OSTAT)
-        osdp_test_set_status(OOC_SYMBOL_cmd_ostat, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_ostat, OCONFORM_EXERCISED);
 
       status = oosdp_make_message (OOSDP_MSG_OUT_STATUS, tlogmsg, msg);
       fprintf (context->log, "%s\n", tlogmsg);
@@ -1704,13 +1742,13 @@ printf ("MMSG DONE\n");
         msg->data_payload [5], msg->data_payload [6], msg->data_payload [7], msg->data_payload [8],
         msg->data_payload [9], msg->data_payload [10], msg->data_payload [11]);
 
-      osdp_test_set_status_ex(OOC_SYMBOL_rep_device_ident, OCONFORM_EXERCISED, details);
+      osdp_test_set_status_ex(OOC_ID_rep_device_ident, OCONFORM_EXERCISED, details);
       if ((msg->data_payload [0] EQUALS 0) &&
         (msg->data_payload [1] EQUALS 0) &&
         (msg->data_payload [2] EQUALS 0))
       {
         fprintf(context->log, "OUI in PDID is invalid (all 0's)\n");
-        osdp_test_set_status(OOC_SYMBOL_rep_pdid_check, OCONFORM_FAIL);
+        osdp_test_set_status(OOC_ID_rep_pdid_check, OCONFORM_FAIL);
       }
       else
       {
@@ -1727,15 +1765,21 @@ printf ("MMSG DONE\n");
         context->fw_version [1] = *(10+msg->data_payload);
         context->fw_version [2] = *(11+msg->data_payload);
 
-        sprintf(cmd, "/opt/osdp-conformance/ACU-actions/osdp_PDID OUI %02x%02x%02x M-V %d-%d SN %02x%02x%02x%02x FW %d.%d.%d",
+        sprintf(args, "OUI %02x%02x%02x M-V %d-%d SN %02x%02x%02x%02x FW %d.%d.%d",
           context->vendor_code [0], context->vendor_code [1], context->vendor_code [2],
           context->model, context->version,
           context->serial_number [0], context->serial_number [1],
           context->serial_number [2], context->serial_number [3],
           context->fw_version [0], context->fw_version [1], context->fw_version [2]);
-        system(cmd);
-
-        osdp_test_set_status(OOC_SYMBOL_rep_pdid_check, OCONFORM_EXERCISED);
+        memset (&event, 0, sizeof (event));
+        event.action = OSDP_ACTION_PDID;
+        event.data = msg->data_payload;
+        event.data_length = msg->data_length;
+        event.args = args;
+        sprintf(cmd, "/opt/osdp-conformance/ACU-actions/osdp_PDID %s", args);
+        (void)osdp_action (context, &event, cmd);
+
+        osdp_test_set_status(OOC_ID_rep_pdid_check, OCONFORM_EXERCISED);
       };
 
       context->last_was_processed = 1;
@@ -1793,10 +1837,13 @@ printf ("MMSG DONE\n");
         };
         fprintf (context->log, " Ext Rdr %d Tamper Status %s\n",
           0, tstatus);
-        osdp_test_set_status(OOC_SYMBOL_resp_rstatr, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_resp_rstatr, OCONFORM_EXERCISED);
       };
       break;
     };
+
+    // the last frame got its answer, or is sent again for a CRC NAK
+    (void)osdp_retransmit_reply (context, msg->msg_cmd);
   } /* role CP */
 
   if (status EQUALS ST_MSG_UNKNOWN)
@@ -53,6 +53,7 @@ int
 { /* background */
 
   int current_length;
+  int resent;
   int send_secure_poll;
   int send_poll;
   int status;
@@ -63,6 +64,22 @@ int
   send_poll = 0;
   send_secure_poll = 0;
 
+  // if the response timer ran out on the last frame try it again first
+
+  resent = osdp_retransmit (ctx);
+
+  // on a multi-drop bus it's the next PD's turn once nothing is
+  // outstanding.  its secure channel comes with it, so what kind of poll
+  // to send is decided after.  (a secure channel being set up or a file
+  // transfer keep the PD they're with.)
+
+  if ((ctx->role EQUALS OSDP_ROLE_ACU) && (osdp_bus (ctx)->count > 0) &&
+    (!resent) && (ctx->enable_poll EQUALS OO_POLL_ENABLED))
+    if ((ctx->xferctx.total_length EQUALS 0) &&
+      (!(ctx->secure_channel_use [OO_SCU_ENAB] & 0x80)) &&
+      (!osdp_awaiting_response (ctx)))
+      (void)osdp_bus_next (ctx);
+
   // if we're not in a file transfer...
   // if we're not set up with an operational secure channel
   // if we're not enabled for secure channel
@@ -113,6 +130,12 @@ int
     (OO_POLL_RESUME EQUALS (ctx->enable_poll)))
       send_poll = 0;
 
+  if (resent)
+  {
+    send_poll = 0;
+    send_secure_poll = 0;
+  };
+
   if (send_poll)
   {
     current_length = 0;
@@ -270,11 +293,8 @@ int
   {
     // 20181213 clarification: if it was a NAK and we were to RETRY then don't increment the sequence number.
 
-    // this is not a retry this will be for a new message
-
-    // if the last thing was a NAK and a CRC error don't increment
-    if (0) // (ctx->last_nak_error EQUALS OO_NAK_CHECK_CRC)
-      do_increment = 0;
+    // this is not a retry this will be for a new message.  (a CRC NAK is
+    // retried by resending the frame as it was, see oo-retransmit.c)
 
     // if the last thing was a NAK for sequence error reset sequence to 0
     if (ctx->last_nak_error EQUALS OO_NAK_SEQUENCE)
@@ -319,81 +339,44 @@ int
 
 { /* osdp_timeout */
 
-  long delta_nanotime;
-  int delta_time;
   int i;
   int return_value;
   int status_posix;
+  OSDP_TIMER *t;
   struct timespec time_spec;
 
 
   return_value = 0;
-  status_posix = clock_gettime (CLOCK_REALTIME, &time_spec);
+  status_posix = clock_gettime (CLOCK_MONOTONIC, &time_spec);
   if (status_posix == -1)
     ctx->last_errno = errno;
 
-  // update timers (new style)
-
+  // update timers (new style).  each one expires once its due time passes.
 
   for (i=0; i<ctx->timer_count; i++)
   {
-    if (ctx->timer [i].status != OSDP_TIMER_STOPPED)
+    t = &(ctx->timer [i]);
+    if (t->status != OSDP_TIMER_STOPPED)
     {
-      ctx->timer [i].status = OSDP_TIMER_RUNNING;
-      if (ctx->timer [i].i_sec > 0)
-      {
-        // it's a 1-second resolution timer
-
-        delta_time = time_spec.tv_sec - last_time_ex->tv_sec;
-        if (delta_time > 0)
-        {
-          if (ctx->timer [i].current_seconds >= delta_time)
-            ctx->timer [i].current_seconds =
-              ctx->timer [i].current_seconds - delta_time;
-          else
-            ctx->timer [i].current_seconds =  0;
-        };
-        if (ctx->timer [i].current_seconds == 0)
-        {
-          ctx->timer [i].status = OSDP_TIMER_STOPPED;
-          return_value = 1;
-          if (ctx->timer [i].timeout_action EQUALS OSDP_TIMER_RESTART_ALWAYS)
-          {
-            ctx->timer [i].current_seconds = ctx->timer [i].i_sec;
-            ctx->timer [i].status = OSDP_TIMER_RESTARTED;
-          };
-        };
-      };
-      if (ctx->timer [i].i_nsec > 0)
+      t->status = OSDP_TIMER_RUNNING;
+      if ((t->i_sec > 0) || (t->i_nsec > 0))
       {
-        // it's a nanosecond resolution timer
-
-        delta_nanotime = time_spec.tv_nsec - last_time_ex->tv_nsec;
-        if (delta_nanotime > 0)
-        {
-          if (ctx->timer [i].current_nanoseconds >= delta_nanotime)
-            ctx->timer [i].current_nanoseconds =
-              ctx->timer [i].current_nanoseconds - delta_nanotime;
-          else
-            ctx->timer [i].current_nanoseconds =  0;
-        };
-        if (ctx->timer [i].current_nanoseconds == 0)
+        if ((time_spec.tv_sec > t->due.tv_sec) ||
+          ((time_spec.tv_sec EQUALS t->due.tv_sec) &&
+          (time_spec.tv_nsec >= t->due.tv_nsec)))
         {
-if (i != OSDP_TIMER_RESPONSE)
+if ((t->i_sec EQUALS 0) && (i != OSDP_TIMER_RESPONSE))
   fprintf(stderr, "%d (n) stopped not %d\n", i, OSDP_TIMER_RESPONSE);
-          ctx->timer [i].status = OSDP_TIMER_STOPPED;
+          t->status = OSDP_TIMER_STOPPED;
           return_value = 1;
-          if (ctx->timer [i].timeout_action EQUALS OSDP_TIMER_RESTART_ALWAYS)
-          {
-            ctx->timer [i].current_nanoseconds = ctx->timer [i].i_nsec;
-            ctx->timer [i].status = OSDP_TIMER_RESTARTED;
-          };
+          if (t->timeout_action EQUALS OSDP_TIMER_RESTART_ALWAYS)
+            (void)osdp_timer_start (ctx, i);
         };
       };
     }; // timer not stopped
   };
-  last_time_ex->tv_sec = time_spec.tv_sec;;
-  last_time_ex->tv_nsec = time_spec.tv_nsec;;
+  last_time_ex->tv_sec = time_spec.tv_sec;
+  last_time_ex->tv_nsec = time_spec.tv_nsec;
   return (return_value);
 
 } /* osdp_timeout */
@@ -429,7 +412,7 @@ int
   param [3] =   (new_speed & 0xff0000) >> 16;
   param [4] = (new_speed & 0xff000000) >> 24;
   current_length = 0;
-  osdp_test_set_status(OOC_SYMBOL_cmd_comset, OCONFORM_EXERCISED);
+  osdp_test_set_status(OOC_ID_cmd_comset, OCONFORM_EXERCISED);
   status = send_message_ex(ctx, OSDP_COMSET, pd_address, &current_length,
     sizeof(param), param, OSDP_SEC_SCS_17, 0, NULL);
 
@@ -462,10 +445,12 @@ int
 
 { /* send_message */
 
-  unsigned char buf [2];
+  OSDP_MSG frame;
+  int parse_role;
   int status;
-  unsigned char test_blk [1024];
+  unsigned char *test_blk;
   int true_dest;
+  unsigned char wire_blk [1+1024];
 
 
   ctx->last_was_processed = 0; //starting fresh on the processing
@@ -479,72 +464,46 @@ int
   true_dest = dest_addr;
   *current_length = 0;
 
+  // the frame is built just past the mark so both go out in one write
+  wire_blk [0] = C_OSDP_MARK;
+  test_blk = wire_blk + 1;
+
   if (ctx->verbosity > 3)
   {
     if (command EQUALS OSDP_NAK)
     {
-      osdp_test_set_status(OOC_SYMBOL_rep_nak, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_rep_nak, OCONFORM_EXERCISED);
       fprintf (stderr, "NAK being sent...%02x\n", *data);
     };
   };
-  status = osdp_build_message
-    (test_blk, // message itself
+  // POLL, ACK and the like come prebuilt from the frame cache
+  status = osdp_build_message_cached
+    (ctx,
+    test_blk, // message itself
     current_length, // returned message length in bytes
     command,
     true_dest,
     ctx->next_sequence,
     data_length, // data length to use
     data,
-    0); // no security
+    &frame);
   if (status EQUALS ST_OK)
   {
     next_sequence(ctx);
 
-    // if (context->verbosity > 3)
-    {
-      OSDP_MSG m;
-      int parse_role;
-      OSDP_HDR returned_hdr;
-      int status_monitor;
-
-      memset (&m, 0, sizeof (m));
-
-      m.ptr = test_blk; // marshalled outbound message
-      m.lth = *current_length;
-
-      // parse the message for display.  role to parse is the OTHER guy
-      parse_role = OSDP_ROLE_ACU;
-      if (ctx->role EQUALS OSDP_ROLE_ACU)
-        parse_role = OSDP_ROLE_PD;
-      status_monitor = osdp_parse_message (ctx, parse_role,
-        &m, &returned_hdr);
-      if (status_monitor != ST_OK)
-      {
-        if (ctx->verbosity > 3)
-          fprintf(stderr, "DEBUG: ignoring osdp_parse_message status %d.\n", status);
-        status_monitor = ST_OK;
-      };
-      if (ctx->verbosity > 8)
-        if (status_monitor != ST_OK)
-        {
-          sprintf (tlogmsg,"parse_message for monitoring returned %d.\n",
-            status_monitor);
-          status = oosdp_log (ctx, OSDP_LOG_STRING_CP, 1, tlogmsg);
-        };
-      (void)monitor_osdp_message (ctx, &m);
-    };
+    // log it from the builder's description.  role is the OTHER guy
+    parse_role = OSDP_ROLE_ACU;
+    if (ctx->role EQUALS OSDP_ROLE_ACU)
+      parse_role = OSDP_ROLE_PD;
+    (void)osdp_log_tx_message (ctx, parse_role, &frame);
 
-    buf [0] = 0xff;
-    // send start-of-message marker (0xff)
-    status = send_osdp_data (ctx, buf, 1);
+    // send start-of-message marker (0xff) and the frame, kept for a resend
+    osdp_retransmit_save (ctx, wire_blk, 1 + *current_length);
+    status = send_osdp_data (ctx, wire_blk, 1 + *current_length);
 
+    // and after we sent the whole PDU bump the counter
     if (status EQUALS ST_OK)
-    {
-      status = send_osdp_data (ctx, test_blk, *current_length);
-
-      // and after we sent the whole PDU bump the counter
       ctx->pdus_sent++;
-    };
 
     if (ctx->verbosity > 4)
     {
@@ -553,7 +512,7 @@ int
   };
   if (status EQUALS ST_OK)
   {
-    ctx->timer [OSDP_TIMER_RESPONSE].current_nanoseconds = ctx->timer [OSDP_TIMER_RESPONSE].i_nsec;
+    (void)osdp_timer_start (ctx, OSDP_TIMER_RESPONSE);
     ctx->timer [OSDP_TIMER_RESPONSE].status = OSDP_TIMER_RUNNING;
     ctx->last_command_sent = command;
   };
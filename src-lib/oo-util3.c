@@ -65,7 +65,9 @@ int
     unsigned char
       *data,
     int
-      secure)
+      secure,
+    OSDP_MSG
+      *frame)
 
 { /* osdp_build_mesage */
 
@@ -200,6 +202,9 @@ status = -2;
   }
   
   *updated_length = new_length;
+  if (frame != NULL)
+    osdp_describe_frame (frame, buf, new_length, cmd_ptr, data_length,
+      OSDP_SEC_NOT_SCS, 0);
   return (status);
 
 } /* osdp_build_message */
@@ -256,7 +261,7 @@ if (ctx->verbosity>3) fprintf(stderr, "cm was %d, incrementing\n", osdp_conforma
       if (ctx->verbosity > 2)
         strcpy (tlogmsg2, "osdp_BUZZ");
 
-      osdp_test_set_status(OOC_SYMBOL_cmd_buz, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_cmd_buz, OCONFORM_EXERCISED);
 
       if (osdp_conformance.conforming_messages < PARAM_MMT)
         osdp_conformance.conforming_messages ++;
@@ -346,7 +351,7 @@ if (ctx->verbosity>3) fprintf(stderr, "cm was %d, incrementing\n", osdp_conforma
       if (ctx->verbosity > 2)
         strcpy (tlogmsg2, "osdp_LSTAT");
 
-      osdp_test_set_status(OOC_SYMBOL_cmd_lstat, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_cmd_lstat, OCONFORM_EXERCISED);
 
       if (osdp_conformance.conforming_messages < PARAM_MMT)
         osdp_conformance.conforming_messages ++;
@@ -371,7 +376,7 @@ if (ctx->verbosity>3) fprintf(stderr, "cm was %d, incrementing\n", osdp_conforma
       {
         if (ctx->verbosity > 2)
           strcpy (tlogmsg2, "osdp_MFG");
-        osdp_test_set_status(OOC_SYMBOL_cmd_mfg, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_mfg, OCONFORM_EXERCISED);
       };
 
         if (osdp_conformance.conforming_messages < PARAM_MMT)
@@ -474,7 +479,7 @@ if (ctx->verbosity>3) fprintf(stderr, "cm was %d, incrementing\n", osdp_conforma
       if (role EQUALS OSDP_ROLE_ACU)
       {
         // if we don't recognize the command/reply code it fails 2-15-1
-        osdp_test_set_status(OOC_SYMBOL_CMND_REPLY, OCONFORM_FAIL);
+        osdp_test_set_status(OOC_ID_CMND_REPLY, OCONFORM_FAIL);
       };
       break;
 
@@ -486,8 +491,8 @@ if (ctx->verbosity>3) fprintf(stderr, "cm was %d, incrementing\n", osdp_conforma
         strcpy (tlogmsg2, "osdp_ACK");
       ctx->pd_acks ++;
 
-      osdp_test_set_status(OOC_SYMBOL_cmd_poll, OCONFORM_EXERCISED);
-      osdp_test_set_status(OOC_SYMBOL_rep_ack, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_cmd_poll, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_rep_ack, OCONFORM_EXERCISED);
 
       if (ctx->verbosity > 3)
       {
@@ -498,17 +503,17 @@ if (ctx->verbosity>3) fprintf(stderr, "cm was %d, incrementing\n", osdp_conforma
       // if we just got an ack for (various things) mark them exercised
 
       if (ctx->last_command_sent EQUALS OSDP_ACURXSIZE)
-        osdp_test_set_status(OOC_SYMBOL_cmd_acurxsize, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_acurxsize, OCONFORM_EXERCISED);
       if (ctx->last_command_sent EQUALS OSDP_GENAUTH)
-        osdp_test_set_status(OOC_SYMBOL_cmd_genauth, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_genauth, OCONFORM_EXERCISED);
       if (ctx->last_command_sent EQUALS OSDP_KEEPACTIVE)
-        osdp_test_set_status(OOC_SYMBOL_cmd_keepactive, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_keepactive, OCONFORM_EXERCISED);
       if (ctx->last_command_sent EQUALS OSDP_KEYSET)
-        osdp_test_set_status(OOC_SYMBOL_cmd_keyset, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_keyset, OCONFORM_EXERCISED);
       if (ctx->last_command_sent EQUALS OSDP_OSTAT)
-        osdp_test_set_status(OOC_SYMBOL_resp_ostat_ack, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_resp_ostat_ack, OCONFORM_EXERCISED);
       if (ctx->last_command_sent EQUALS OSDP_PIVDATA)
-        osdp_test_set_status(OOC_SYMBOL_cmd_pivdata, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_pivdata, OCONFORM_EXERCISED);
 
       if (osdp_conformance.conforming_messages < PARAM_MMT)
         osdp_conformance.conforming_messages ++;
@@ -573,7 +578,7 @@ if (ctx->verbosity>3) fprintf(stderr, "cm was %d, incrementing\n", osdp_conforma
         strcpy (tlogmsg2, "osdp_LSTATR");
 
       if (ctx->last_command_sent EQUALS OSDP_LSTAT)
-        osdp_test_set_status(OOC_SYMBOL_cmd_lstat, OCONFORM_EXERCISED);
+        osdp_test_set_status(OOC_ID_cmd_lstat, OCONFORM_EXERCISED);
 
       if (osdp_conformance.conforming_messages < PARAM_MMT)
         osdp_conformance.conforming_messages ++;
@@ -586,7 +591,7 @@ if (ctx->verbosity>3) fprintf(stderr, "cm was %d, incrementing\n", osdp_conforma
       if (ctx->verbosity > 2)
         strcpy (tlogmsg2, "osdp_MFG");
 
-      osdp_test_set_status(OOC_SYMBOL_cmd_mfg, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_cmd_mfg, OCONFORM_EXERCISED);
 
       if (osdp_conformance.conforming_messages < PARAM_MMT)
         osdp_conformance.conforming_messages ++;
@@ -598,7 +603,7 @@ if (ctx->verbosity>3) fprintf(stderr, "cm was %d, incrementing\n", osdp_conforma
       m->data_payload = m->cmd_payload + 1;
       if (ctx->verbosity > 2)
         strcpy (tlogmsg2, "osdp_MFGERRR");
-      osdp_test_set_status(OOC_SYMBOL_resp_mfgerrr, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_resp_mfgerrr, OCONFORM_EXERCISED);
       break;
 
     case OSDP_MFGREP:
@@ -619,7 +624,7 @@ if (ctx->verbosity>3) fprintf(stderr, "cm was %d, incrementing\n", osdp_conforma
       if (ctx->verbosity > 2)
         strcpy (tlogmsg2, "osdp_NAK");
 
-      osdp_test_set_status(OOC_SYMBOL_rep_nak, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_rep_nak, OCONFORM_EXERCISED);
 
       if (osdp_conformance.conforming_messages < PARAM_MMT)
         osdp_conformance.conforming_messages ++;
@@ -662,7 +667,7 @@ if (ctx->verbosity>3) fprintf(stderr, "cm was %d, incrementing\n", osdp_conforma
       if (ctx->verbosity > 2)
         strcpy (tlogmsg2, "osdp_RAW");
 
-      osdp_test_set_status(OOC_SYMBOL_rep_raw, OCONFORM_EXERCISED);
+      osdp_test_set_status(OOC_ID_rep_raw, OCONFORM_EXERCISED);
 
       if (osdp_conformance.conforming_messages < PARAM_MMT)
         osdp_conformance.conforming_messages ++;
@@ -705,6 +710,109 @@ if (ctx->verbosity>3) fprintf(stderr, "cm was %d, incrementing\n", osdp_conforma
 } /* osdp_check_command_reply */
 
 
+/*
+  osdp_describe_frame - fill in an OSDP_MSG for a frame just built
+
+  the same fields osdp_parse_message sets, taken from what the builder
+  already knows, so the frame can be logged without parsing it again.
+  sec_block_length is the whole security block (length and type octets
+  included) as it is on the wire; 0 if there isn't one.
+*/
+
+void
+  osdp_describe_frame
+    (OSDP_MSG *frame,
+    unsigned char *buf,
+    int lth,
+    unsigned char *cmd_ptr,
+    int data_length,
+    int sec_block_type,
+    int sec_block_length)
+
+{ /* osdp_describe_frame */
+
+  memset (frame, 0, sizeof (*frame));
+  frame->ptr = buf;
+  frame->lth = lth;
+  frame->msg_cmd = *cmd_ptr;
+  frame->direction = 0x80 & ((OSDP_HDR *)buf)->addr;
+  frame->cmd_payload = cmd_ptr;
+  frame->data_payload = cmd_ptr + 1;
+  frame->data_length = data_length;
+  frame->check_size = 1;
+  if (((OSDP_HDR *)buf)->ctrl & 0x04)
+    frame->check_size = 2;
+  frame->crc_check = buf + lth - frame->check_size;
+  frame->security_block_type = sec_block_type;
+  frame->security_block_length = sec_block_length;
+  frame->check_verified = 1;
+
+} /* osdp_describe_frame */
+
+
+/*
+  osdp_log_tx_message - log a frame we are sending
+
+  uses the description the builder filled in; the frame is not parsed
+  again.  the conformance bookkeeping done on received frames (commands
+  exercised, polls counted) is done here for sent ones.  the frame header
+  goes in the log when the receive side would show it, so POLL and ACK
+  (the idle traffic) only show at verbosity 5 and above.
+
+  role is who the frame is for, as passed to osdp_parse_message.
+*/
+
+int
+  osdp_log_tx_message
+    (OSDP_CONTEXT *ctx,
+    int role,
+    OSDP_MSG *frame)
+
+{ /* osdp_log_tx_message */
+
+  int display;
+  int status;
+  char tx_logmsg [1024];
+
+
+  tx_logmsg [0] = 0;
+  (void)osdp_check_command_reply (role, frame->msg_cmd, frame, tlogmsg2);
+
+  display = 0;
+  if (ctx->verbosity > 4)
+    display = 1;
+  if ((frame->msg_cmd != OSDP_POLL) && (frame->msg_cmd != OSDP_ACK))
+  {
+    if ((frame->msg_cmd != OSDP_FILETRANSFER) && (frame->msg_cmd != OSDP_FTSTAT))
+      display = 1;
+    if (frame->msg_cmd EQUALS OSDP_FILETRANSFER)
+      display = 1;
+    if (frame->msg_cmd EQUALS OSDP_FTSTAT)
+    {
+      unsigned short int ft_status_detail;
+
+      osdp_array_to_doubleByte (((OSDP_HDR_FTSTAT *)(frame->data_payload))->FtStatusDetail,
+        &ft_status_detail);
+      if (ft_status_detail != 0)
+        display = 1;
+    };
+  };
+
+  osdp_trace_dump (ctx, display);
+  status = ST_OK;
+  if (display)
+  {
+    if (frame->direction)
+      status = oosdp_log (ctx, OSDP_LOG_STRING_PD, 1, tx_logmsg);
+    else
+      status = oosdp_log (ctx, OSDP_LOG_STRING_CP, 1, tx_logmsg);
+  };
+  (void)monitor_osdp_message (ctx, frame);
+  return (status);
+
+} /* osdp_log_tx_message */
+
+
 /*
   monitor_osdp_message - output the message to the log for tracing
 */
@@ -39,6 +39,7 @@ int
 { /* action_osdp_XRD */
 
   char cmd [2*1024];
+  OSDP_ACTION_EVENT event;
   int status;
 
 
@@ -56,8 +57,13 @@ int
 "Extended Read: Card Present - Interface not specified.  Rdr %d Status %02x\n",
         *(msg->data_payload + 2), *(msg->data_payload + 3));
       status = oosdp_log (ctx, OSDP_LOG_NOTIMESTAMP, 1, tlogmsg);
+      memset (&event, 0, sizeof (event));
+      event.action = OSDP_ACTION_XRD_CARD;
+      event.reader = *(msg->data_payload + 2);
+      event.status = *(msg->data_payload + 3);
+      event.args = "";
       sprintf(cmd, "/opt/osdp-conformance/run/ACU-actions/osdp_XRD_1_1");
-      system(cmd);
+      (void)osdp_action (ctx, &event, cmd);
     };
   };
 
@@ -80,9 +86,15 @@ int
 
       dump_buffer_log(ctx, "APDU: ", msg->data_payload+4, msg->data_length-4);
 
+      memset (&event, 0, sizeof (event));
+      event.action = OSDP_ACTION_XRD_APDU;
+      event.reader = *(msg->data_payload + 2);
+      event.data = msg->data_payload + 4;
+      event.data_length = msg->data_length - 4;
+      event.args = apdu;
       sprintf(cmd, "/opt/osdp-conformance/run/ACU-actions/osdp_XRD_1_2 %s",
         apdu);
-      system(cmd);
+      (void)osdp_action (ctx, &event, cmd);
     };
   };
 
@@ -418,33 +418,21 @@ int
 { /* main for osdp-net-client */
 
   int
-    c1;
+    commands;
   int
     done_tls;
-  fd_set
-    exceptfds;
-  fd_set
-    readfds;
-  int
-    nfds;
+  OSDP_EVENT_LOOP
+    loop;
   int
     request_immediate_poll;
-  const sigset_t
-    sigmask;
   int
     status;
-  int
-    status_io;
   int
     status_sock;
   int
     status_tls;
-  struct timespec
-    timeout;
   int
     tls_current_length;
-  fd_set
-    writefds;
   int
     ufd;
 
@@ -467,6 +455,12 @@ int
     request_immediate_poll = 0;
 
     status = init_tls_client ();
+    if (status EQUALS ST_OK)
+      status = osdp_loop_init (&loop);
+    if (status EQUALS ST_OK)
+      status = osdp_loop_watch (&loop, ufd);
+    if (status EQUALS ST_OK)
+      status = osdp_loop_watch (&loop, gnutls_transport_get_int (tls_session));
 
 #if TEMP_PASSPHRASE
     // for "phase 1" authentication, kludge it by sending a passphrase
@@ -491,25 +485,18 @@ int
         status_tls = gnutls_record_recv (tls_session, buffer, MAX_BUF);
         if (status_tls EQUALS GNUTLS_E_AGAIN)
         {
-          // look for file descriptor activity
-
-          nfds = 0;
-          FD_ZERO (&readfds);
-          FD_ZERO (&writefds);
-          FD_ZERO (&exceptfds);
-          FD_SET (ufd, &readfds);
-          nfds = ufd+1;
-          timeout.tv_sec = 0;
-          timeout.tv_nsec = 100000000;
-          status_sock = pselect (nfds, &readfds, &writefds, &exceptfds,
-            &timeout, &sigmask);
+          // look for file descriptor activity (TLS input, a command, a timer)
+
+          if (request_immediate_poll)
+            status_sock = osdp_loop_wait (&loop, &context, 0);
+          else
+            status_sock = osdp_loop_wait (&loop, &context, -1);
 
           if (status_sock > 0)
           {
             // check for command input (unix socket activity pokes us to check)
-            if (FD_ISSET (ufd, &readfds))
+            if (osdp_loop_ready (&loop, ufd))
             {
-              char cmdbuf [2];
               char gratuitous_data [2] = {C_OSDP_MARK, 0x00};;
 
               /*
@@ -521,26 +508,13 @@ int
 (unsigned char *)gratuitous_data, 1);
               if (status != ST_OK)
                 done_tls = 1;
-
-              c1 = accept (ufd, NULL, NULL);
-              if (c1 != -1)
-              {
-                status_io = read (c1, cmdbuf, sizeof (cmdbuf));
-                if (status_io > 0)
-                {
-                  close (c1);
-
-                  status = process_current_command(&context);
-                  if (status EQUALS ST_OK)
-                    preserve_current_command ();
-                  status = ST_OK;
-                };
-              };
+              (void)osdp_control_accept (&context, &loop, ufd);
             };
-          }
-          else
+            (void)osdp_control_service (&context, &loop, &commands);
+          };
+          if ((status_sock EQUALS 0) || (loop.timer_ready))
           {
-            // pselect returned no fd's
+            // a timer came due (or a poll was requested)
             if (context.role EQUALS OSDP_ROLE_CP)
             {
               /*
@@ -625,9 +599,8 @@ int
                   // saw an SOM, so normal incoming message
                   request_immediate_poll = 0; 
 
-                  memcpy (osdp_buf.buf + osdp_buf.next,
-                    buffer+i, current_length);
-                  osdp_buf.next = osdp_buf.next + current_length;
+                  (void)osdp_buffer_append (&osdp_buf,
+                    (unsigned char *)buffer+i, current_length);
                   status = ST_NET_INPUT_READY;
                   done = 1;
                 };
@@ -426,35 +426,23 @@ int
 { /* main for osdp-net-server */
 
   int
-    c1;
+    commands;
   int
     done_tls;
-  fd_set
-    exceptfds;
-  fd_set
-    readfds;
-  int
-    nfds;
+  OSDP_EVENT_LOOP
+    loop;
   int
     request_immediate_poll;
-  const sigset_t
-    sigmask;
   int
     status;
-  int
-    status_io;
   int
     status_sock;
   int
     status_tls;
-  struct timespec
-    timeout;
   int
     tls_current_length;
   int
     ufd;
-  fd_set
-    writefds;
 
 
   status = ST_OK;
@@ -475,6 +463,12 @@ int
     */
     fflush (context.log);
     status = init_tls_server ();
+    if (status EQUALS ST_OK)
+      status = osdp_loop_init (&loop);
+    if (status EQUALS ST_OK)
+      status = osdp_loop_watch (&loop, ufd);
+    if (status EQUALS ST_OK)
+      status = osdp_loop_watch (&loop, gnutls_transport_get_int (tls_session));
     if (status EQUALS 0)
     {
         done_tls = 0;
@@ -491,18 +485,14 @@ int
           status_tls = gnutls_record_recv (tls_session, buffer, MAX_BUF);
           if (status_tls EQUALS GNUTLS_E_AGAIN)
           {
-            nfds = 0;
-            FD_ZERO (&readfds);
-            FD_ZERO (&writefds);
-            FD_ZERO (&exceptfds);
-            FD_SET (ufd, &readfds);
-            nfds = ufd+1;
-            timeout.tv_sec = 0;
-            timeout.tv_nsec = 100000000;
-            status_sock = pselect (nfds, &readfds, &writefds, &exceptfds,
-              &timeout, &sigmask);
-
-            if (status_sock EQUALS 0)
+            // wait for TLS input, a command or a timer
+
+            if (request_immediate_poll)
+              status_sock = osdp_loop_wait (&loop, &context, 0);
+            else
+              status_sock = osdp_loop_wait (&loop, &context, -1);
+
+            if ((status_sock EQUALS 0) || (loop.timer_ready))
             {
               status = ST_OK;
 
@@ -525,26 +515,13 @@ int
             {
               // chk for cmd (unix socket activity pokes us to check)
 
-              if (FD_ISSET (ufd, &readfds))
+              if (osdp_loop_ready (&loop, ufd))
               {
-                char cmdbuf [2];
                 fprintf (stderr, "ufd socket was selected in READ (%d)\n",
                   ufd);
-                c1 = accept (ufd, NULL, NULL);
-                if (c1 != -1)
-                {
-                  status_io = read (c1, cmdbuf, sizeof (cmdbuf));
-                  if (status_io > 0)
-                  {
-                    close (c1);
-
-                    status = process_current_command (&context);
-                    if (status EQUALS ST_OK)
-                      preserve_current_command ();
-                    status = ST_OK;
-                  };
-                };
+                (void)osdp_control_accept (&context, &loop, ufd);
               };
+              (void)osdp_control_service (&context, &loop, &commands);
             };
           }
           else
@@ -620,9 +597,8 @@ int
                   else
                   {
                     request_immediate_poll = 0; // saw an SOM, so normal incoming message
-                    memcpy (osdp_buf.buf + osdp_buf.next,
-                      buffer+i, current_length);
-                    osdp_buf.next = osdp_buf.next + current_length;
+                    (void)osdp_buffer_append (&osdp_buf,
+                      (unsigned char *)buffer+i, current_length);
                     status = ST_NET_INPUT_READY;
                     done = 1;
                   };
@@ -289,18 +289,12 @@ int
 
 { /* main for osdp-tcp-client */
 
-  int c1;
+  int commands;
   int do_net_read;
   int done_tls;
-  fd_set exceptfds;
-  fd_set readfds;
-  int nfds;
-  const sigset_t sigmask;
+  OSDP_EVENT_LOOP loop;
   int status;
-  int status_io;
   int status_sock;
-  struct timespec timeout;
-  fd_set writefds;
   int ufd;
 
 
@@ -318,6 +312,12 @@ int
     done_tls = 0; // assume not done unless some bad status
 
     status = init_tls_client ();
+    if (status EQUALS ST_OK)
+      status = osdp_loop_init (&loop);
+    if (status EQUALS ST_OK)
+      status = osdp_loop_watch (&loop, ufd);
+    if (status EQUALS ST_OK)
+      status = osdp_loop_watch (&loop, current_sd);
     if (status != ST_OK)
       done_tls = 1;
   };
@@ -329,37 +329,41 @@ int
     fflush (stdout); fflush (stderr); fflush (context.log);
     
     // if we already have buffer contents try to process it before reading more.
-    if (osdp_buf.next > 0)
+    if (osdp_buffer_count (&osdp_buf) > 0)
     {
       int skip_done;
-      char tmp1 [8192];
 
       skip_done = 1; 
 
-      if (osdp_buf.next > 1)
-        if (osdp_buf.buf [0] != C_SOM)
+      if (osdp_buffer_count (&osdp_buf) > 1)
+        if (osdp_buffer_octet (&osdp_buf, 0) != C_SOM)
           skip_done = 0;
 
       while (!skip_done)
       {
-        if (osdp_buf.buf [0] != C_SOM)
+        if (osdp_buffer_octet (&osdp_buf, 0) != C_SOM)
         {
-          memcpy(tmp1, osdp_buf.buf+1, osdp_buf.next-1);
-          memcpy(osdp_buf.buf, tmp1, osdp_buf.next-1);
-          osdp_buf.next --;
+          osdp_buffer_consume (&osdp_buf, 1);
         }
         else
         {
           skip_done = 1;
         };
-        if (!osdp_buf.next)
+        if (!osdp_buffer_count (&osdp_buf))
           skip_done = 1;
       };
 
       status = process_osdp_input (&osdp_buf);
       if (context.verbosity > 9)
+      {
+        int dump_lth;
+        unsigned char *dump_ptr;
+
+        dump_lth = osdp_buffer_count (&osdp_buf);
+        dump_ptr = osdp_buffer_view (&osdp_buf, &dump_lth);
         dump_buffer_log(&context, "After process_osdp_input",
-          osdp_buf.buf, osdp_buf.next);
+          dump_ptr, dump_lth);
+      };
 
       // if it's too short so far it'll be 'serial_in' so ignore that
       if (status EQUALS ST_SERIAL_IN)
@@ -378,29 +382,18 @@ int
 
     if (do_net_read)
     {
-      // look for file descriptor activity
-
-      nfds = 0;
-      FD_ZERO (&readfds);
-      FD_ZERO (&writefds);
-      FD_ZERO (&exceptfds);
-      FD_SET (ufd, &readfds);
-
-      FD_SET (current_sd, &readfds);
-      nfds = ufd+1;
-      if (current_sd > ufd)
-        nfds = current_sd + 1;
-      timeout.tv_sec = 0;
-      timeout.tv_nsec = 100000000;
-      status_sock = pselect (nfds, &readfds, &writefds, &exceptfds,
-        &timeout, &sigmask);
+      // look for file descriptor activity (or a timer, or a requested poll)
+
+      if (request_immediate_poll)
+        status_sock = osdp_loop_wait (&loop, &context, 0);
+      else
+        status_sock = osdp_loop_wait (&loop, &context, -1);
 
       if (status_sock > 0)
       {
         // check for command input (unix socket activity pokes us to check)
-        if (FD_ISSET (ufd, &readfds))
+        if (osdp_loop_ready (&loop, ufd))
         {
-          char cmdbuf [2];
           char gratuitous_data [2] = {C_OSDP_MARK, 0x00};;
 
           /*
@@ -412,24 +405,11 @@ int
           status = send_osdp_data (&context, (unsigned char *)gratuitous_data, 1);
           if (status != ST_OK)
             done_tls = 1;
-
-          c1 = accept (ufd, NULL, NULL);
-          if (c1 != -1)
-          {
-            status_io = read (c1, cmdbuf, sizeof (cmdbuf));
-            if (status_io > 0)
-            {
-              close (c1);
-
-              status = process_current_command (&context);
-              if (status EQUALS ST_OK)
-                preserve_current_command ();
-              status = ST_OK;
-            };
-          };
+          (void)osdp_control_accept (&context, &loop, ufd);
         };
+        (void)osdp_control_service (&context, &loop, &commands);
 
-        if (FD_ISSET (current_sd, &readfds))
+        if (osdp_loop_ready (&loop, current_sd))
         {
           status = read_tcp_stream (&context, current_sd,
             &request_immediate_poll);
@@ -438,9 +418,14 @@ int
             if (context.verbosity > 8)
             {
               char octet [1024];
+              int dump_lth;
+              unsigned char *dump_ptr;
+
               sprintf(octet, " %02x", buffer [0]);
               strcat(trace_in_buffer, octet);
-              dump_buffer_log(&context, "TCP Input:", osdp_buf.buf, osdp_buf.next);
+              dump_lth = osdp_buffer_count (&osdp_buf);
+              dump_ptr = osdp_buffer_view (&osdp_buf, &dump_lth);
+              dump_buffer_log(&context, "TCP Input:", dump_ptr, dump_lth);
             };
           };
         };
@@ -448,7 +433,7 @@ int
 
       // idle processing
 
-      if (status_sock EQUALS 0)
+      if ((status_sock EQUALS 0) || (loop.timer_ready))
       {
         if ((context.role EQUALS OSDP_ROLE_CP) && context.authenticated)
         {
@@ -587,8 +572,7 @@ int
     {
       current_length = status_io;
       request_immediate_poll = 0; 
-      memcpy (osdp_buf.buf + osdp_buf.next, buffer, current_length);
-      osdp_buf.next = osdp_buf.next + current_length;
+      (void)osdp_buffer_append (&osdp_buf, (unsigned char *)buffer, current_length);
 
       status = ST_NET_INPUT_READY;
     };
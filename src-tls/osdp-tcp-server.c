@@ -308,24 +308,15 @@ int
 
 { /* main for osdp-net-server */
 
-  int c1;
+  int commands;
   int done_tls;
-  fd_set exceptfds;
   char gratuitous_data [2] = {C_OSDP_MARK, 0x00};
-  fd_set readfds;
-  int nfds;
+  OSDP_EVENT_LOOP loop;
   int request_immediate_poll;
-  const sigset_t sigmask;
   int status;
-  int status_io;
   int status_sock;
-  struct timespec timeout;
   int ufd;
-  fd_set writefds;
-
 
-#define PSELECT_NSEC (900000000)
-//#define PSELECT_NSEC (100000000)
 
   status = ST_OK;
   request_immediate_poll = 0;
@@ -337,6 +328,12 @@ int
   if (status EQUALS ST_OK)
   {
     status = init_tcp_server ();
+    if (status EQUALS ST_OK)
+      status = osdp_loop_init (&loop);
+    if (status EQUALS ST_OK)
+      status = osdp_loop_watch (&loop, ufd);
+    if (status EQUALS ST_OK)
+      status = osdp_loop_watch (&loop, current_sd);
     if (status EQUALS ST_OK)
     {
       trace_in_buffer [0] = 0;
@@ -354,29 +351,22 @@ int
         status_sock = 0;
 
         {
-          nfds = 0;
-          nfds = ufd+1;
-          if (current_sd > ufd)
-            nfds = current_sd + 1;
-          FD_ZERO (&readfds);
-          FD_SET (current_sd, &readfds);
-          FD_ZERO (&writefds);
-          FD_ZERO (&exceptfds);
-          FD_SET (ufd, &readfds);
-          timeout.tv_sec = 0;
-          timeout.tv_nsec = PSELECT_NSEC; //100000000;
-          status_sock = pselect (nfds, &readfds, &writefds, &exceptfds,
-            &timeout, &sigmask);
+          // wait for input or a timer; don't wait at all if a poll was requested
+
+          if (request_immediate_poll)
+            status_sock = osdp_loop_wait (&loop, &context, 0);
+          else
+            status_sock = osdp_loop_wait (&loop, &context, -1);
 
           if (context.verbosity > 9)
             if (context.verbosity > 9) if (status_sock > 0)
             {
-              fprintf (stderr, "pselect %d\n",
+              fprintf (stderr, "event loop %d\n",
                 status_sock);
-              if (FD_ISSET (current_sd, &readfds))
+              if (osdp_loop_ready (&loop, current_sd))
                 fprintf (stderr, "TCP FD ready\n");
             };
-          if (status_sock EQUALS 0)
+          if ((status_sock EQUALS 0) || (loop.timer_ready))
           {
             status = ST_OK;
 
@@ -399,37 +389,27 @@ int
           {
             // chk for cmd (unix socket activity pokes us to check)
 
-            if (FD_ISSET (ufd, &readfds))
+            if (osdp_loop_ready (&loop, ufd))
             {
-              char cmdbuf [2];
               fprintf (stderr, "ufd socket was selected in READ (%d)\n",
                 ufd);
-              c1 = accept (ufd, NULL, NULL);
-              if (c1 != -1)
+              (void)osdp_control_accept (&context, &loop, ufd);
+            };
+            (void)osdp_control_service (&context, &loop, &commands);
+            if (commands > 0)
+            {
+              /*
+                send a benign "message" up the line so that the CP knows we're
+                active.
+              */
+              if (context.role EQUALS OSDP_ROLE_PD)
               {
-                status_io = read (c1, cmdbuf, sizeof (cmdbuf));
-                if (status_io > 0)
-                {
-                  close (c1);
-
-                  status = process_current_command (&context);
-                  if (status EQUALS ST_OK)
-                    preserve_current_command ();
-                  status = ST_OK;
-                  /*
-                    send a benign "message" up the line so that the CP knows we're
-                    active.
-                  */
-                  if (context.role EQUALS OSDP_ROLE_PD)
-                  {
-                    status = send_osdp_data (&context,
-                     (unsigned char *)gratuitous_data, 1);
-                  };
-                };
+                status = send_osdp_data (&context,
+                 (unsigned char *)gratuitous_data, 1);
               };
             };
 
-            if (FD_ISSET (current_sd, &readfds))
+            if (osdp_loop_ready (&loop, current_sd))
             {
               status = read_tcp_stream (&context, current_sd,
                 &request_immediate_poll);
@@ -459,9 +439,9 @@ int
             status = process_osdp_input (&osdp_buf);
             if (status EQUALS ST_OK)
             {
-              if (osdp_buf.next > 0)
+              if (osdp_buffer_count (&osdp_buf) > 0)
               {
-  fprintf(stderr, "leftover in osdp input: %d,\n", osdp_buf.next);
+  fprintf(stderr, "leftover in osdp input: %d,\n", osdp_buffer_count (&osdp_buf));
                 // if there's more data in the buffer "re-read" the tcp stream.
                 // this will clear out any scruffy octets before the next 
                 // OSDP message.
@@ -473,7 +453,7 @@ int
               {
                 if (status != ST_OK)
                   done = 1;
-                if (osdp_buf.next EQUALS 0)
+                if (osdp_buffer_count (&osdp_buf) EQUALS 0)
                   done = 1;
               };
             };
@@ -530,7 +510,7 @@ int
 
   // if there was no data left in the buffer
 
-  if (osdp_buf.next EQUALS 0)
+  if (osdp_buffer_count (&osdp_buf) EQUALS 0)
   {
   status_io = read (net_fd, buffer, sizeof (buffer));
   if (status_io EQUALS 0)
@@ -571,9 +551,12 @@ int
     {
       // reprocess the leftovers
 
-      memcpy(buffer, osdp_buf.buf, osdp_buf.next);
-      current_length = osdp_buf.next;
-      osdp_buf.next = 0;
+      current_length = osdp_buffer_count (&osdp_buf);
+      if (current_length > sizeof (buffer))
+        current_length = sizeof (buffer);
+      for (i=0; i<current_length; i++)
+        buffer [i] = osdp_buffer_octet (&osdp_buf, i);
+      osdp_buffer_reset (&osdp_buf);
     };
 
     // append buffer to osdp buffer
@@ -600,9 +583,8 @@ int
         {
           // saw an SOM, so normal incoming message
           request_immediate_poll = 0; 
-          memcpy (osdp_buf.buf + osdp_buf.next,
-            buffer+i, current_length);
-          osdp_buf.next = osdp_buf.next + current_length;
+          (void)osdp_buffer_append (&osdp_buf,
+            (unsigned char *)buffer+i, current_length);
           status = ST_NET_INPUT_READY;
           done = 1;
         };
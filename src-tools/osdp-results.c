@@ -0,0 +1,310 @@
+/*
+  osdp-results - render the conformance results file
+
+  Usage:
+
+    osdp-results [-d directory | -h] [results-file]
+
+  With no option each test that has a result is written to stdout as
+  JSON, in the form the <test>-results.json files had.  -d writes
+  those files into the directory instead.  -h writes an HTML table.
+  The results file defaults to /opt/osdp-conformance/results/osdp-results.dat
+  and may be read while the program that writes it is running.
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+#include <open-osdp.h>
+#include <osdp_conformance.h>
+
+
+#define OSDP_RESULTS_RENDER_JSON  (0)
+#define OSDP_RESULTS_RENDER_FILES (1)
+#define OSDP_RESULTS_RENDER_HTML  (2)
+
+
+int
+  results_copy
+    (OSDP_RESULTS_RECORD *rec,
+    OSDP_RESULTS_RECORD *copy);
+void
+  results_json
+    (FILE *f,
+    OSDP_RESULTS_RECORD *rec);
+char
+  *results_status
+    (int test_status);
+
+
+int
+  main
+    (int argc,
+    char *argv [])
+
+{ /* main for osdp-results */
+
+  char directory [1024];
+  int fd;
+  struct stat file_status;
+  int i;
+  int mode;
+  char path [1024];
+  OSDP_RESULTS *r;
+  OSDP_RESULTS_RECORD rec;
+  FILE *rf;
+  char results_filename [2*1024];
+  int status;
+  char test_time [1024];
+  time_t when;
+
+
+  status = ST_OK;
+  mode = OSDP_RESULTS_RENDER_JSON;
+  directory [0] = 0;
+  strcpy (path, OSDP_RESULTS_FILE);
+  for (i=1; i<argc; i++)
+  {
+    if ((0 EQUALS strcmp (argv [i], "-d")) && (i+1 < argc))
+    {
+      mode = OSDP_RESULTS_RENDER_FILES;
+      i++;
+      strncpy (directory, argv [i], sizeof (directory)-1);
+      directory [sizeof (directory)-1] = 0;
+    }
+    else
+      if (0 EQUALS strcmp (argv [i], "-h"))
+        mode = OSDP_RESULTS_RENDER_HTML;
+      else
+        if (argv [i][0] EQUALS '-')
+          status = -1;
+        else
+        {
+          strncpy (path, argv [i], sizeof (path)-1);
+          path [sizeof (path)-1] = 0;
+        };
+  };
+  if (status != ST_OK)
+    fprintf (stderr, "Usage: osdp-results [-d directory | -h] [results-file]\n");
+
+  r = NULL;
+  if (status EQUALS ST_OK)
+  {
+    fd = open (path, O_RDONLY);
+    if (fd EQUALS -1)
+      status = ST_OSDP_RESULTS_MAP;
+    else
+    {
+      // a file that is short (cut off, or still being created) would fault
+      // when the records past its end were read
+
+      if (fstat (fd, &file_status) != 0)
+        status = ST_OSDP_RESULTS_MAP;
+      if (status EQUALS ST_OK)
+        if (file_status.st_size < sizeof (*r))
+          status = ST_OSDP_RESULTS_MAP;
+      if (status EQUALS ST_OK)
+      {
+        r = mmap (NULL, sizeof (*r), PROT_READ, MAP_SHARED, fd, 0);
+        if (r EQUALS MAP_FAILED)
+        {
+          r = NULL;
+          status = ST_OSDP_RESULTS_MAP;
+        };
+      };
+      close (fd);
+    };
+    if (r != NULL)
+      if ((r->magic != OSDP_RESULTS_MAGIC) ||
+        (r->version != OSDP_RESULTS_VERSION) ||
+        (r->record_size != sizeof (r->record [0])))
+        status = ST_OSDP_RESULTS_MAP;
+    if (status != ST_OK)
+      fprintf (stderr, "%s is not a results file\n", path);
+  };
+
+  if (status EQUALS ST_OK)
+  {
+    if (mode EQUALS OSDP_RESULTS_RENDER_HTML)
+    {
+      when = r->started;
+      strcpy (test_time, asctime (localtime (&when)));
+      if (test_time [strlen (test_time)-1] EQUALS '\n')
+        test_time [strlen (test_time)-1] = 0;
+      printf ("<TABLE BORDER=1>\n");
+      printf ("<TR><TH COLSPAN=4>%s results, started %s</TH></TR>\n",
+        (r->role EQUALS OSDP_ROLE_PD) ? "PD" : "ACU", test_time);
+      printf ("<TR><TH>Test</TH><TH>Result</TH><TH>Time</TH><TH>Description</TH></TR>\n");
+    };
+    for (i=0; i<OSDP_RESULTS_MAX; i++)
+    {
+      if (results_copy (&(r->record [i]), &rec))
+      {
+        switch (mode)
+        {
+        case OSDP_RESULTS_RENDER_FILES:
+          sprintf (results_filename, "%s/%s-results.json", directory, rec.test);
+          rf = fopen (results_filename, "w");
+          if (rf != NULL)
+          {
+            results_json (rf, &rec);
+            fclose (rf);
+          }
+          else
+          {
+            fprintf (stderr, "Error writing results for %s\n", rec.test);
+          };
+          break;
+        case OSDP_RESULTS_RENDER_HTML:
+          when = rec.changed;
+          strcpy (test_time, asctime (localtime (&when)));
+          if (test_time [strlen (test_time)-1] EQUALS '\n')
+            test_time [strlen (test_time)-1] = 0;
+          printf ("<TR><TD>%s</TD><TD>%s</TD><TD>%s</TD><TD>%s</TD></TR>\n",
+            rec.test, results_status (rec.status), test_time, rec.description);
+          break;
+        default:
+          results_json (stdout, &rec);
+          break;
+        };
+      };
+    };
+    if (mode EQUALS OSDP_RESULTS_RENDER_HTML)
+      printf ("</TABLE>\n");
+  };
+  if (status != ST_OK)
+    status = 1;
+  return (status);
+
+} /* main for osdp-results */
+
+
+/*
+  results_copy - copy a record that is not being changed
+
+  returns 1 if the copy is good and the test has a result.
+*/
+
+int
+  results_copy
+    (OSDP_RESULTS_RECORD *rec,
+    OSDP_RESULTS_RECORD *copy)
+
+{ /* results_copy */
+
+  int good;
+  int tries;
+  unsigned int sequence;
+
+
+  good = 0;
+  for (tries=0; (!good) && (tries<1000); tries++)
+  {
+    sequence = rec->sequence;
+    __sync_synchronize ();
+    memcpy (copy, rec, sizeof (*copy));
+    __sync_synchronize ();
+    if (((sequence & 1) EQUALS 0) && (sequence EQUALS rec->sequence))
+      good = 1;
+    else
+      usleep (1000);
+  };
+  copy->test [sizeof (copy->test)-1] = 0;
+  copy->description [sizeof (copy->description)-1] = 0;
+  copy->aux [sizeof (copy->aux)-1] = 0;
+  if (copy->changed EQUALS 0)
+    good = 0;
+  return (good);
+
+} /* results_copy */
+
+
+void
+  results_json
+    (FILE *f,
+    OSDP_RESULTS_RECORD *rec)
+
+{ /* results_json */
+
+  char test_time [1024];
+  time_t when;
+
+
+  when = rec->changed;
+  strcpy (test_time, asctime (localtime (&when)));
+  if (test_time [strlen (test_time)-1] EQUALS '\n')
+    test_time [strlen (test_time)-1] = 0;
+  fprintf (f, "{\"test\":\"%s\",\"test-status\":\"%d\",\n",
+    rec->test, rec->status);
+  if (rec->aux [0] EQUALS 0)
+    fprintf (f, " \"test-time\":\"%s\",\"test-description\":\"%s\"}\n",
+      test_time, rec->description);
+  else
+  {
+    fprintf (f, " \"test-time\":\"%s\",\"test-description\":\"%s\",\n",
+      test_time, rec->description);
+    fprintf (f, "%s", rec->aux);
+    fprintf (f, "\"_\":\"_\"}\n");
+  };
+
+} /* results_json */
+
+
+char
+  *results_status
+    (int test_status)
+
+{ /* results_status */
+
+  char *s;
+
+
+  switch (test_status)
+  {
+  case OCONFORM_UNTESTED:
+    s = "Untested";
+    break;
+  case OCONFORM_EXERCISED:
+    s = "Exercised";
+    break;
+  case OCONFORM_EX_GOOD_ONLY:
+    s = "Exercised (no edge case tests)";
+    break;
+  case OCONFORM_FAIL:
+    s = "Failed";
+    break;
+  case OCONFORM_SKIP:
+    s = "Skipped";
+    break;
+  default:
+    s = "Unknown";
+    break;
+  };
+  return (s);
+
+} /* results_status */
+
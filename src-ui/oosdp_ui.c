@@ -235,12 +235,10 @@ status = -1;
       {
         int count;
         int i;
-        count = 0;
-        if (osdp_buf.next > 0)
-          count = osdp_buf.next;
+        count = osdp_buffer_count (&osdp_buf);
         fprintf (stderr, "Buffer had %d bytes\n", count);
         for (i=0; i<count; i++)
-          fprintf (stderr, " %02x", osdp_buf.buf [i]);
+          fprintf (stderr, " %02x", osdp_buffer_octet (&osdp_buf, i));
         fprintf (stderr, "\n");
         status = ST_OK;
       };
@@ -456,12 +454,10 @@ status = -1;
       {
         int count;
         int i;
-        count = 0;
-        if (osdp_buf.next > 0)
-          count = osdp_buf.next;
+        count = osdp_buffer_count (&osdp_buf);
         fprintf (stderr, "Buffer had %d bytes\n", count);
         for (i=0; i<count; i++)
-          fprintf (stderr, " %02x", osdp_buf.buf [i]);
+          fprintf (stderr, " %02x", osdp_buffer_octet (&osdp_buf, i));
         fprintf (stderr, "\n");
         status = ST_OK;
       };
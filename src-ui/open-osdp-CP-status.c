@@ -42,6 +42,10 @@ int
     current_time;
   struct timespec
     current_time_fine;
+  OSDP_STATS
+    *s;
+  OSDP_STATS
+    stats;
   int
     status;
 
@@ -59,6 +63,12 @@ int
   printf ("Timestamp: %08ld.%08ld %s",
       (unsigned long int)current_time_fine.tv_sec, current_time_fine.tv_nsec,
       asctime (localtime (&current_time)));
+
+  // the live counters, then the rest of the status file
+
+  s = osdp_stats_map ("ACU");
+  if ((s != NULL) && osdp_stats_read (s, &stats))
+    osdp_stats_print (stdout, &stats);
 {
   FILE *sf;
   int status_io;
@@ -67,9 +77,12 @@ int
   sf = fopen ("/opt/osdp-conformance/run/CP/osdp-status.json", "r");
   if (sf != NULL)
   {
-    status_io = fread (buffer, sizeof (buffer [0]), sizeof (buffer), sf);
+    status_io = fread (buffer, sizeof (buffer [0]), sizeof (buffer)-1, sf);
     if (status_io > 0)
+    {
+      buffer [status_io] = 0;
       printf ("%s", buffer);
+    };
     fclose (sf);
   };
 };
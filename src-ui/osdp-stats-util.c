@@ -0,0 +1,176 @@
+/*
+  osdp-stats-util - read the live statistics segment
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Used by the status CGIs and osdp-stats.  The segment is mapped read
+  only; nothing here locks or waits on the program that writes it.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+
+#include <open-osdp.h>
+
+
+/*
+  osdp_stats_map - map a statistics segment by name ("ACU", "PD", "MON"
+  or a segment name like /open-osdp-PD)
+
+  returns NULL if there is none (the program has not been started.)
+*/
+
+OSDP_STATS
+  *osdp_stats_map
+    (char *name)
+
+{ /* osdp_stats_map */
+
+  int fd;
+  OSDP_STATS *s;
+  char segment [1024];
+
+
+  s = NULL;
+  if (name [0] EQUALS '/')
+    strncpy (segment, name, sizeof (segment)-1);
+  else
+    snprintf (segment, sizeof (segment), "/open-osdp-%s", name);
+  segment [sizeof (segment)-1] = 0;
+  fd = shm_open (segment, O_RDONLY, 0);
+  if (fd != -1)
+  {
+    s = mmap (NULL, sizeof (*s), PROT_READ, MAP_SHARED, fd, 0);
+    if (s EQUALS MAP_FAILED)
+      s = NULL;
+    close (fd);
+  };
+  if (s != NULL)
+    if ((s->magic != OSDP_STATS_MAGIC) || (s->version != OSDP_STATS_VERSION) ||
+      (s->size != sizeof (*s)))
+    {
+      munmap (s, sizeof (*s));
+      s = NULL;
+    };
+  return (s);
+
+} /* osdp_stats_map */
+
+
+/*
+  osdp_stats_print - the counters as text
+*/
+
+void
+  osdp_stats_print
+    (FILE *f,
+    OSDP_STATS *s)
+
+{ /* osdp_stats_print */
+
+  int i;
+  char key_slot [1024];
+  char update_time [1024];
+  time_t when;
+
+
+  when = s->updated;
+  strcpy (update_time, asctime (localtime (&when)));
+  if (update_time [strlen (update_time)-1] EQUALS '\n')
+    update_time [strlen (update_time)-1] = 0;
+  fprintf (f, "%s pid %d address %02x speed %s updated %s\n",
+    (s->role EQUALS OSDP_ROLE_PD) ? "PD" :
+      ((s->role EQUALS OSDP_ROLE_MONITOR) ? "MON" : "ACU"),
+    s->pid, s->pd_address, s->serial_speed, update_time);
+  fprintf (f, "%5d ACU Polls %5d PD Acks %5d NAKs %5d Retries %5d Write Errs\n",
+    s->acu_polls, s->pd_acks, s->pd_naks, s->retries, s->serial_write_errs);
+  fprintf (f, "%5d PDUs Received %5d PDUs Sent %7d Octets %5d Dropped\n",
+    s->pdus_received, s->pdus_sent, s->bytes_received, s->dropped_octets);
+  fprintf (f, "%5d HASH OK %5d HASH Bad %5d Seq Errs %5d CRC Errs %5d Checksum Errs %5d Buffer Overflows\n",
+    s->hash_ok, s->hash_bad, s->seq_bad, s->crc_errs, s->checksum_errs,
+    s->buffer_overflows);
+  key_slot [0] = 0;
+  if (s->key_slot EQUALS OSDP_KEY_SCBK_D)
+    strcpy (key_slot, "SCBK-D");
+  if (s->key_slot EQUALS OSDP_KEY_SCBK)
+    strcpy (key_slot, "SCBK");
+  if (key_slot [0] != 0)
+  {
+    fprintf (f, "  Key ");
+    for (i=0; i<sizeof (s->scbk); i++)
+      fprintf (f, "%02x", s->scbk [i]);
+    fprintf (f, " (%s)\n", key_slot);
+  };
+  fprintf (f, "LED ");
+  for (i=0; i<OSDP_STATS_LEDS; i++)
+    fprintf (f, " %s%06x", s->led_active [i] ? "*" : "", s->led_color [i]);
+  fprintf (f, "\nOut ");
+  for (i=0; i<OSDP_MAX_OUT; i++)
+    fprintf (f, " %d", s->out [i]);
+  fprintf (f, "\n");
+  if (s->xfer_total > 0)
+    fprintf (f, "File transfer %u of %u (fragment %d)\n",
+      s->xfer_offset, s->xfer_total, s->xfer_send_length);
+  if (s->text [0] != 0)
+    fprintf (f, "Text %s\n", s->text);
+
+} /* osdp_stats_print */
+
+
+/*
+  osdp_stats_read - copy the segment when it is not being changed
+
+  returns 1 if the copy is good.
+*/
+
+int
+  osdp_stats_read
+    (OSDP_STATS *s,
+    OSDP_STATS *copy)
+
+{ /* osdp_stats_read */
+
+  int good;
+  unsigned int sequence;
+  int tries;
+
+
+  good = 0;
+  for (tries=0; (!good) && (tries<1000); tries++)
+  {
+    sequence = s->sequence;
+    __sync_synchronize ();
+    memcpy (copy, s, sizeof (*copy));
+    __sync_synchronize ();
+    if (((sequence & 1) EQUALS 0) && (sequence EQUALS s->sequence))
+      good = 1;
+    else
+      usleep (1000);
+  };
+  copy->serial_speed [sizeof (copy->serial_speed)-1] = 0;
+  copy->text [sizeof (copy->text)-1] = 0;
+  return (good);
+
+} /* osdp_stats_read */
+
@@ -0,0 +1,108 @@
+/*
+  osdp-stats - print the live statistics of a running ACU, PD or monitor
+
+  Usage:
+
+    osdp-stats [-w seconds] [ACU | PD | MON | /segment-name]
+
+  Reads the program's shared memory statistics segment (default ACU).
+  -w prints them again every so many seconds until interrupted.
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#include <open-osdp.h>
+
+
+int
+  main
+    (int argc,
+    char *argv [])
+
+{ /* main for osdp-stats */
+
+  int done;
+  int i;
+  char name [1024];
+  OSDP_STATS *s;
+  OSDP_STATS stats;
+  int status;
+  int wait_seconds;
+
+
+  status = ST_OK;
+  strcpy (name, "ACU");
+  wait_seconds = 0;
+  for (i=1; i<argc; i++)
+  {
+    if ((0 EQUALS strcmp (argv [i], "-w")) && (i+1 < argc))
+    {
+      i++;
+      wait_seconds = atoi (argv [i]);
+    }
+    else
+      if (argv [i][0] EQUALS '-')
+        status = -1;
+      else
+      {
+        strncpy (name, argv [i], sizeof (name)-1);
+        name [sizeof (name)-1] = 0;
+      };
+  };
+  if (status != ST_OK)
+    fprintf (stderr, "Usage: osdp-stats [-w seconds] [ACU | PD | MON | /segment-name]\n");
+
+  s = NULL;
+  if (status EQUALS ST_OK)
+  {
+    s = osdp_stats_map (name);
+    if (s EQUALS NULL)
+    {
+      fprintf (stderr, "No statistics for %s\n", name);
+      status = ST_OSDP_STATS_SHM;
+    };
+  };
+  done = (status != ST_OK);
+  while (!done)
+  {
+    if (osdp_stats_read (s, &stats))
+      osdp_stats_print (stdout, &stats);
+    else
+      fprintf (stderr, "Statistics busy, try again\n");
+    fflush (stdout);
+    if (wait_seconds > 0)
+    {
+      sleep (wait_seconds);
+      printf ("\n");
+    }
+    else
+      done = 1;
+  };
+  if (status != ST_OK)
+    status = 1;
+  return (status);
+
+} /* main for osdp-stats */
+
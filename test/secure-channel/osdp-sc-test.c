@@ -0,0 +1,770 @@
+/*
+  osdp-sc-test - secure channel known answer and throughput test
+
+  usage: osdp-sc-test [-c auto|aes-ni|software] [-t milliseconds] [corpus]
+
+  Each session in the corpus (default sc-sessions.json) is played through
+  an ACU and a PD context.  The session keys (osdp_create_keys), client
+  cryptogram (osdp_create_client_cryptogram), server cryptogram and RMAC-I
+  must match the corpus.  Then for every frame in order the sender builds
+  it from the cleartext payload (osdp_build_secure_message) and it must
+  match the corpus octet for octet, and the receiver opens it
+  (osdp_secure_open) and must get the payload back.  That covers the MAC
+  chaining in both directions and payload encryption and decryption.  A
+  frame with one octet changed must then fail the MAC check.
+
+  If every session passes the sessions are replayed, build and open on both
+  ends, for the given time (default 1000 milliseconds) and the rate is
+  reported in frames a second and microseconds a frame.
+
+  cipher is "auto" (the default), "aes-ni" or "software", as for the
+  "cipher" setting.  A cipher asked for by name has to be the one in use
+  (it passed its known answer tests); if the processor does not have it
+  the test is skipped.  Every backend the processor has must pass the
+  known answer tests too, so they agree (a CBC-MAC over an input that is
+  not a whole number of blocks included).  The library logs to /dev/null
+  at verbosity 0.
+
+  Exits 0 if all the sessions pass, 77 if skipped, otherwise 1.
+
+  (C)Copyright 2017-2020 Smithee Solutions LLC
+
+  Support provided by the Security Industry Association
+  http://www.securityindustry.org
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+#include <jansson.h>
+
+
+#include <open-osdp.h>
+#include <osdp_conformance.h>
+
+
+OSDP_CONTEXT context; // the ACU
+unsigned char creds_buffer_a [64*1024];
+int creds_buffer_a_lth;
+int creds_buffer_a_next;
+int creds_buffer_a_remaining;
+OSDP_BUFFER osdp_buf;
+OSDP_INTEROP_ASSESSMENT osdp_conformance;
+OSDP_PARAMETERS p_card;
+OSDP_CONTEXT pd_context;
+char trace_in_buffer [4*OSDP_OFFICIAL_MSG_MAX];
+char trace_out_buffer [4*OSDP_OFFICIAL_MSG_MAX];
+
+#define ST_SC_TEST_CORPUS (1)
+#define ST_SC_TEST_KEYS   (2)
+#define ST_SC_TEST_BUILD  (3)
+#define ST_SC_TEST_OPEN   (4)
+#define ST_SC_TEST_TAMPER (5)
+#define ST_SC_TEST_CIPHER (6)
+#define ST_SC_TEST_SKIP   (7)
+
+#define SC_TEST_EXIT_SKIP (77) // as automake tests have it
+
+typedef struct sc_test_frame
+{
+  unsigned char frame [OSDP_OFFICIAL_MSG_MAX];
+  int frame_length;
+  unsigned char payload [OSDP_OFFICIAL_MSG_MAX];
+  int payload_length;
+} SC_TEST_FRAME;
+
+typedef struct sc_test_session
+{
+  char name [1024];
+  int check;
+  unsigned char scbk [OSDP_KEY_OCTETS];
+  unsigned char rnd_a [8];
+  unsigned char rnd_b [8];
+  unsigned char s_enc [OSDP_KEY_OCTETS];
+  unsigned char s_mac1 [OSDP_KEY_OCTETS];
+  unsigned char s_mac2 [OSDP_KEY_OCTETS];
+  unsigned char client_cryptogram [OSDP_KEY_OCTETS];
+  unsigned char server_cryptogram [OSDP_KEY_OCTETS];
+  unsigned char rmac_i [OSDP_KEY_OCTETS];
+  SC_TEST_FRAME *frames;
+  int frame_count;
+} SC_TEST_SESSION;
+
+int sc_test_build (SC_TEST_SESSION *session, SC_TEST_FRAME *f,
+  unsigned char *buffer, int *length);
+int sc_test_frame (SC_TEST_SESSION *session, SC_TEST_FRAME *f, int verify,
+  unsigned char *buffer, int *length);
+int sc_test_hex (json_t *obj, char *name, unsigned char *buffer, int size,
+  int *length);
+int sc_test_keys (SC_TEST_SESSION *session, int cipher, int verify);
+int sc_test_load (char *path, SC_TEST_SESSION **sessions, int *count);
+int sc_test_open (SC_TEST_SESSION *session, SC_TEST_FRAME *f,
+  unsigned char *buffer, int length, OSDP_MSG *msg);
+int sc_test_replay (SC_TEST_SESSION *session, int cipher, int verify,
+  long *frames, long *octets);
+int sc_test_tamper (SC_TEST_SESSION *session, int cipher);
+
+
+int
+  main
+    (int argc,
+    char *argv [])
+
+{ /* main for osdp-sc-test */
+
+  int cipher;
+  char *cipher_name;
+  char *corpus;
+  int count;
+  double elapsed_ns;
+  long frames;
+  int i;
+  long min_ns;
+  long octets;
+  int passed;
+  long replays;
+  int s;
+  SC_TEST_SESSION *sessions;
+  struct timespec start_time;
+  int status;
+  struct timespec stop_time;
+
+
+  status = ST_OK;
+  cipher = OSDP_CIPHER_AUTO;
+  cipher_name = "auto";
+  corpus = "sc-sessions.json";
+  min_ns = 1000 * 1000000l;
+  for (i=1; i<argc; i++)
+  {
+    if ((0 EQUALS strcmp (argv [i], "-c")) && (i+1 < argc))
+    {
+      i++;
+      cipher_name = argv [i];
+      if (0 EQUALS strcmp (cipher_name, "aes-ni"))
+        cipher = OSDP_CIPHER_AESNI;
+      else
+        if (0 EQUALS strcmp (cipher_name, "software"))
+          cipher = OSDP_CIPHER_SOFTWARE;
+        else
+          if (0 != strcmp (cipher_name, "auto"))
+            status = -1;
+    }
+    else
+      if ((0 EQUALS strcmp (argv [i], "-t")) && (i+1 < argc))
+      {
+        i++;
+        min_ns = atol (argv [i]) * 1000000l;
+      }
+      else
+        if (argv [i][0] EQUALS '-')
+          status = -1;
+        else
+          corpus = argv [i];
+  };
+  if (status != ST_OK)
+    fprintf (stderr,
+      "Usage: osdp-sc-test [-c auto|aes-ni|software] [-t milliseconds] [corpus]\n");
+
+  sessions = NULL;
+  count = 0;
+  if (status EQUALS ST_OK)
+    status = sc_test_load (corpus, &sessions, &count);
+
+  // the cipher asked for has to be the one that ends up in use
+
+  if (status EQUALS ST_OK)
+  {
+    if ((cipher != OSDP_CIPHER_AUTO) && !osdp_cipher_available (cipher))
+    {
+      fprintf (stdout, "SKIP cipher %s is not available on this processor\n",
+        cipher_name);
+      status = ST_SC_TEST_SKIP;
+    };
+  };
+  if (status EQUALS ST_OK)
+  {
+    context.log = fopen ("/dev/null", "w");
+    context.cipher = cipher;
+    if (osdp_cipher_select (&context) != ST_OK)
+    {
+      fprintf (stdout, "FAIL cipher %s failed its known answer tests\n",
+        osdp_cipher_name ());
+      status = ST_SC_TEST_CIPHER;
+    };
+    if ((status EQUALS ST_OK) && (cipher != OSDP_CIPHER_AUTO) &&
+      (0 != strcmp (osdp_cipher_name (), cipher_name)))
+    {
+      fprintf (stdout, "FAIL cipher %s asked for, %s in use\n",
+        cipher_name, osdp_cipher_name ());
+      status = ST_SC_TEST_CIPHER;
+    };
+  };
+
+  // all the backends give the same answers, whichever is in use
+
+  if (status EQUALS ST_OK)
+  {
+    for (i=0; i<OSDP_CIPHER_BACKENDS; i++)
+    {
+      if (osdp_cipher_available (i) && (osdp_cipher_kat (i) != ST_OK))
+      {
+        fprintf (stdout, "FAIL cipher %s failed its known answer tests\n",
+          (i EQUALS OSDP_CIPHER_AESNI)? "aes-ni": "software");
+        status = ST_SC_TEST_CIPHER;
+      };
+    };
+  };
+  if (status EQUALS ST_OK)
+  {
+    fprintf (stdout, "cipher %s\n", osdp_cipher_name ());
+
+    passed = 0;
+    for (s=0; s<count; s++)
+    {
+      frames = 0;
+      octets = 0;
+      status = sc_test_keys (sessions+s, cipher, 1);
+      if (status EQUALS ST_OK)
+        status = sc_test_replay (sessions+s, cipher, 1, &frames, &octets);
+      if (status EQUALS ST_OK)
+        status = sc_test_tamper (sessions+s, cipher);
+      fprintf (stdout, "%s %s (%ld frames)\n",
+        (status EQUALS ST_OK) ? "PASS" : "FAIL", sessions [s].name, frames);
+      if (status EQUALS ST_OK)
+        passed ++;
+    };
+    fprintf (stdout, "%d of %d sessions passed\n", passed, count);
+    status = ST_OK;
+    if (passed != count)
+      status = ST_SC_TEST_KEYS;
+  };
+
+  // replay the whole corpus until it has taken long enough
+
+  if ((status EQUALS ST_OK) && (min_ns > 0))
+  {
+    frames = 0;
+    octets = 0;
+    replays = 0;
+    clock_gettime (CLOCK_MONOTONIC, &start_time);
+    do
+    {
+      for (s=0; s<count; s++)
+      {
+        (void)sc_test_keys (sessions+s, cipher, 0);
+        (void)sc_test_replay (sessions+s, cipher, 0, &frames, &octets);
+      };
+      replays ++;
+      clock_gettime (CLOCK_MONOTONIC, &stop_time);
+      elapsed_ns = (stop_time.tv_sec - start_time.tv_sec) * 1e9 +
+        (stop_time.tv_nsec - start_time.tv_nsec);
+    } while (elapsed_ns < min_ns);
+    fprintf (stdout,
+      "replayed %ld frames (%ld octets) %ld times in %.3f sec: %.0f frames/sec %.2f usec/frame\n",
+      frames, octets, replays, elapsed_ns / 1e9, frames / (elapsed_ns / 1e9),
+      (elapsed_ns / 1e3) / frames);
+  };
+  if (status EQUALS ST_SC_TEST_SKIP)
+    status = SC_TEST_EXIT_SKIP;
+  else
+    if (status != ST_OK)
+      status = 1;
+  return (status);
+
+} /* main for osdp-sc-test */
+
+
+/*
+  sc_test_build - the sender builds a frame from the corpus payload
+*/
+
+int
+  sc_test_build
+    (SC_TEST_SESSION *session,
+    SC_TEST_FRAME *f,
+    unsigned char *buffer,
+    int *length)
+
+{ /* sc_test_build */
+
+  OSDP_CONTEXT *sender;
+  int status;
+
+
+  m_check = session->check;
+  sender = &context;
+  if (f->frame [1] & 0x80)
+    sender = &pd_context;
+  *length = 0;
+  status = osdp_build_secure_message (sender, buffer, length,
+    f->frame [5+f->frame [5]], 0x7f & f->frame [1], 0x03 & f->frame [4],
+    f->payload_length, f->payload, f->frame [6], 0, NULL, NULL);
+  return (status);
+
+} /* sc_test_build */
+
+
+/*
+  sc_test_frame - one frame: the sender builds it, the receiver opens it
+
+  the frame is built in buffer.  with verify it has to match the corpus and
+  the receiver has to get the corpus payload back.
+*/
+
+int
+  sc_test_frame
+    (SC_TEST_SESSION *session,
+    SC_TEST_FRAME *f,
+    int verify,
+    unsigned char *buffer,
+    int *length)
+
+{ /* sc_test_frame */
+
+  OSDP_MSG msg;
+  int status;
+
+
+  status = sc_test_build (session, f, buffer, length);
+  if (verify && (status EQUALS ST_OK))
+    if ((*length != f->frame_length) ||
+      (0 != memcmp (buffer, f->frame, *length)))
+      status = ST_SC_TEST_BUILD;
+  if (status EQUALS ST_OK)
+  {
+    status = sc_test_open (session, f, buffer, *length, &msg);
+    if (status != ST_OK)
+      status = ST_SC_TEST_OPEN;
+  };
+  if (verify && (status EQUALS ST_OK))
+    if ((msg.data_length != f->payload_length) ||
+      (0 != memcmp (msg.data_payload, f->payload, f->payload_length)))
+      status = ST_SC_TEST_OPEN;
+  return (status);
+
+} /* sc_test_frame */
+
+
+/*
+  sc_test_hex - a hex string from the corpus
+*/
+
+int
+  sc_test_hex
+    (json_t *obj,
+    char *name,
+    unsigned char *buffer,
+    int size,
+    int *length)
+
+{ /* sc_test_hex */
+
+  unsigned short int buffer_length;
+  json_t *value;
+  int status;
+
+
+  status = ST_OK;
+  *length = 0;
+  value = json_object_get (obj, name);
+  if (!json_is_string (value))
+    status = ST_SC_TEST_CORPUS;
+  if (status EQUALS ST_OK)
+    if (strlen (json_string_value (value)) > 2*size)
+      status = ST_SC_TEST_CORPUS;
+  if (status EQUALS ST_OK)
+  {
+    (void)osdp_string_to_buffer (&context, (char *)json_string_value (value),
+      buffer, &buffer_length);
+    *length = buffer_length;
+  };
+  if (status != ST_OK)
+    fprintf (stderr, "corpus: bad or missing \"%s\"\n", name);
+  return (status);
+
+} /* sc_test_hex */
+
+
+/*
+  sc_test_keys - set up both ends of a session
+
+  the ACU and PD derive the session keys from the SCBK and RND.A, the PD
+  makes the client cryptogram, the ACU the server cryptogram and the PD the
+  RMAC-I, as in the osdp_CHLNG..osdp_RMAC_I exchange.  both ends then
+  start their MAC chain from the RMAC-I.  with verify they are checked
+  against the corpus.
+*/
+
+int
+  sc_test_keys
+    (SC_TEST_SESSION *session,
+    int cipher,
+    int verify)
+
+{ /* sc_test_keys */
+
+  OSDP_SC_CCRYPT ccrypt;
+  OSDP_CONTEXT *ctx;
+  int i;
+  unsigned char iv [OSDP_KEY_OCTETS];
+  FILE *log;
+  unsigned char rmac_i [OSDP_KEY_OCTETS];
+  unsigned char server_cryptogram [OSDP_KEY_OCTETS];
+  int status;
+
+
+  status = ST_OK;
+  log = context.log;
+  for (i=0; i<2; i++)
+  {
+    ctx = &context;
+    if (i EQUALS 1)
+      ctx = &pd_context;
+    memset (ctx, 0, sizeof (*ctx));
+    ctx->log = log;
+    ctx->cipher = cipher;
+    ctx->role = OSDP_ROLE_ACU;
+    if (i EQUALS 1)
+      ctx->role = OSDP_ROLE_PD;
+    ctx->enable_secure_channel = 1;
+    memcpy (ctx->current_scbk, session->scbk, sizeof (ctx->current_scbk));
+    memcpy (ctx->rnd_a, session->rnd_a, sizeof (ctx->rnd_a));
+    memcpy (ctx->rnd_b, session->rnd_b, sizeof (ctx->rnd_b));
+    osdp_create_keys (ctx);
+    if (verify)
+      if ((0 != memcmp (ctx->s_enc, session->s_enc, OSDP_KEY_OCTETS)) ||
+        (0 != memcmp (ctx->s_mac1, session->s_mac1, OSDP_KEY_OCTETS)) ||
+        (0 != memcmp (ctx->s_mac2, session->s_mac2, OSDP_KEY_OCTETS)))
+        status = ST_SC_TEST_KEYS;
+  };
+
+  osdp_create_client_cryptogram (&pd_context, &ccrypt);
+  if (verify)
+    if (0 != memcmp (ccrypt.cryptogram, session->client_cryptogram,
+      OSDP_KEY_OCTETS))
+      status = ST_SC_TEST_KEYS;
+
+  memset (iv, 0, sizeof (iv));
+  memcpy (server_cryptogram, context.rnd_b, sizeof (context.rnd_b));
+  memcpy (server_cryptogram+sizeof (context.rnd_b), context.rnd_a,
+    sizeof (context.rnd_a));
+  osdp_cipher_cbc_encrypt (osdp_session_key (&context, OSDP_SESSION_S_ENC),
+    iv, server_cryptogram, sizeof (server_cryptogram));
+  if (verify)
+    if (0 != memcmp (server_cryptogram, session->server_cryptogram,
+      OSDP_KEY_OCTETS))
+      status = ST_SC_TEST_KEYS;
+
+  memcpy (rmac_i, server_cryptogram, sizeof (rmac_i));
+  osdp_cipher_cbc_encrypt (osdp_session_key (&pd_context, OSDP_SESSION_S_MAC1),
+    iv, rmac_i, sizeof (rmac_i));
+  osdp_cipher_cbc_encrypt (osdp_session_key (&pd_context, OSDP_SESSION_S_MAC2),
+    iv, rmac_i, sizeof (rmac_i));
+  if (verify)
+    if (0 != memcmp (rmac_i, session->rmac_i, OSDP_KEY_OCTETS))
+      status = ST_SC_TEST_KEYS;
+
+  for (i=0; i<2; i++)
+  {
+    ctx = &context;
+    if (i EQUALS 1)
+      ctx = &pd_context;
+    memcpy (ctx->rmac_i, rmac_i, sizeof (ctx->rmac_i));
+    memcpy (ctx->last_calculated_in_mac, rmac_i, OSDP_KEY_OCTETS);
+    memcpy (ctx->last_calculated_out_mac, rmac_i, OSDP_KEY_OCTETS);
+    ctx->secure_channel_use [OO_SCU_ENAB] = OO_SCS_OPERATIONAL;
+  };
+  if (status != ST_OK)
+    fprintf (stdout, "  session keys or cryptograms differ\n");
+  return (status);
+
+} /* sc_test_keys */
+
+
+/*
+  sc_test_load - read the corpus
+*/
+
+int
+  sc_test_load
+    (char *path,
+    SC_TEST_SESSION **sessions,
+    int *count)
+
+{ /* sc_test_load */
+
+  json_t *frame;
+  json_t *frames;
+  int i;
+  json_t *item;
+  int length;
+  json_t *list;
+  json_t *root;
+  int s;
+  SC_TEST_SESSION *session;
+  int status;
+  json_error_t status_json;
+  json_t *value;
+
+
+  status = ST_OK;
+  *sessions = NULL;
+  *count = 0;
+  list = NULL;
+  root = json_load_file (path, 0, &status_json);
+  if (root EQUALS NULL)
+  {
+    fprintf (stderr, "corpus %s: %s (line %d)\n",
+      path, status_json.text, status_json.line);
+    status = ST_SC_TEST_CORPUS;
+  };
+  if (status EQUALS ST_OK)
+  {
+    list = json_object_get (root, "sessions");
+    if (!json_is_array (list) || (json_array_size (list) EQUALS 0))
+      status = ST_SC_TEST_CORPUS;
+  };
+  if (status EQUALS ST_OK)
+  {
+    *count = json_array_size (list);
+    *sessions = calloc (*count, sizeof (SC_TEST_SESSION));
+    if (*sessions EQUALS NULL)
+      status = ST_SC_TEST_CORPUS;
+  };
+  for (s=0; (status EQUALS ST_OK) && (s<*count); s++)
+  {
+    session = *sessions + s;
+    item = json_array_get (list, s);
+    value = json_object_get (item, "name");
+    if (json_is_string (value))
+      strncpy (session->name, json_string_value (value),
+        sizeof (session->name)-1);
+    session->check = OSDP_CRC;
+    value = json_object_get (item, "check");
+    if (json_is_string (value))
+      if (0 EQUALS strcmp (json_string_value (value), "checksum"))
+        session->check = OSDP_CHECKSUM;
+
+    status = sc_test_hex (item, "scbk", session->scbk,
+      sizeof (session->scbk), &length);
+    if (status EQUALS ST_OK)
+      status = sc_test_hex (item, "rnd-a", session->rnd_a,
+        sizeof (session->rnd_a), &length);
+    if (status EQUALS ST_OK)
+      status = sc_test_hex (item, "rnd-b", session->rnd_b,
+        sizeof (session->rnd_b), &length);
+    if (status EQUALS ST_OK)
+      status = sc_test_hex (item, "s-enc", session->s_enc,
+        sizeof (session->s_enc), &length);
+    if (status EQUALS ST_OK)
+      status = sc_test_hex (item, "s-mac1", session->s_mac1,
+        sizeof (session->s_mac1), &length);
+    if (status EQUALS ST_OK)
+      status = sc_test_hex (item, "s-mac2", session->s_mac2,
+        sizeof (session->s_mac2), &length);
+    if (status EQUALS ST_OK)
+      status = sc_test_hex (item, "client-cryptogram",
+        session->client_cryptogram, sizeof (session->client_cryptogram),
+        &length);
+    if (status EQUALS ST_OK)
+      status = sc_test_hex (item, "server-cryptogram",
+        session->server_cryptogram, sizeof (session->server_cryptogram),
+        &length);
+    if (status EQUALS ST_OK)
+      status = sc_test_hex (item, "rmac-i", session->rmac_i,
+        sizeof (session->rmac_i), &length);
+
+    frames = json_object_get (item, "frames");
+    if (status EQUALS ST_OK)
+      if (!json_is_array (frames) || (json_array_size (frames) EQUALS 0))
+        status = ST_SC_TEST_CORPUS;
+    if (status EQUALS ST_OK)
+    {
+      session->frame_count = json_array_size (frames);
+      session->frames = calloc (session->frame_count, sizeof (SC_TEST_FRAME));
+      if (session->frames EQUALS NULL)
+        status = ST_SC_TEST_CORPUS;
+    };
+    for (i=0; (status EQUALS ST_OK) && (i<session->frame_count); i++)
+    {
+      frame = json_array_get (frames, i);
+      status = sc_test_hex (frame, "frame", session->frames [i].frame,
+        sizeof (session->frames [i].frame), &(session->frames [i].frame_length));
+      if (status EQUALS ST_OK)
+        status = sc_test_hex (frame, "payload", session->frames [i].payload,
+          sizeof (session->frames [i].payload),
+          &(session->frames [i].payload_length));
+
+      // SOM, ADDR, LEN, CTRL, SEC_BLK_LEN, SEC_BLK_TYPE, CMND, MAC, check
+
+      if (status EQUALS ST_OK)
+        if (session->frames [i].frame_length < 13)
+          status = ST_SC_TEST_CORPUS;
+    };
+    if (status != ST_OK)
+      fprintf (stderr, "corpus %s: session %d (%s) is not usable\n",
+        path, s, session->name);
+  };
+  if (root != NULL)
+    json_decref (root);
+  return (status);
+
+} /* sc_test_load */
+
+
+/*
+  sc_test_open - the receiver checks the MAC and decrypts the payload
+
+  msg is set up as osdp_parse_message would for a frame in buffer.
+*/
+
+int
+  sc_test_open
+    (SC_TEST_SESSION *session,
+    SC_TEST_FRAME *f,
+    unsigned char *buffer,
+    int length,
+    OSDP_MSG *msg)
+
+{ /* sc_test_open */
+
+  int check_size;
+  OSDP_CONTEXT *receiver;
+  int status;
+
+
+  check_size = 2;
+  if (session->check EQUALS OSDP_CHECKSUM)
+    check_size = 1;
+  receiver = &pd_context;
+  if (f->frame [1] & 0x80)
+    receiver = &context;
+  memset (msg, 0, sizeof (*msg));
+  msg->ptr = buffer;
+  msg->lth = length;
+  msg->check_size = check_size;
+  msg->security_block_type = buffer [6];
+  msg->security_block_length = buffer [5];
+  msg->cmd_payload = buffer + 5 + buffer [5];
+  msg->data_payload = msg->cmd_payload + 1;
+  msg->crc_check = buffer + length - check_size;
+  msg->data_length = (msg->crc_check - 4) - msg->data_payload;
+  status = osdp_secure_open (receiver, msg, msg->security_block_type,
+    length - check_size);
+  return (status);
+
+} /* sc_test_open */
+
+
+/*
+  sc_test_replay - all the frames of a session in order
+
+  counts the frames and their octets.
+*/
+
+int
+  sc_test_replay
+    (SC_TEST_SESSION *session,
+    int cipher,
+    int verify,
+    long *frames,
+    long *octets)
+
+{ /* sc_test_replay */
+
+  unsigned char buffer [OSDP_BUF_MAX];
+  int i;
+  int length;
+  int status;
+
+
+  status = ST_OK;
+  for (i=0; (status EQUALS ST_OK) && (i<session->frame_count); i++)
+  {
+    status = sc_test_frame (session, session->frames+i, verify, buffer,
+      &length);
+    if (status EQUALS ST_OK)
+    {
+      (*frames) ++;
+      *octets = *octets + length;
+    }
+    else
+    {
+      fprintf (stdout, "  frame %d: %s\n", i,
+        (status EQUALS ST_SC_TEST_BUILD) ? "built frame differs" :
+          "did not open to the payload");
+    };
+  };
+  return (status);
+
+} /* sc_test_replay */
+
+
+/*
+  sc_test_tamper - a frame with one octet of its MAC changed must be
+  rejected
+*/
+
+int
+  sc_test_tamper
+    (SC_TEST_SESSION *session,
+    int cipher)
+
+{ /* sc_test_tamper */
+
+  unsigned char buffer [OSDP_BUF_MAX];
+  int length;
+  OSDP_MSG msg;
+  int status;
+
+
+  status = sc_test_keys (session, cipher, 0);
+  if (status EQUALS ST_OK)
+    status = sc_test_build (session, session->frames, buffer, &length);
+  if (status EQUALS ST_OK)
+  {
+    buffer [length - (session->check EQUALS OSDP_CHECKSUM ? 1 : 2) - 1] ^= 0x01;
+    if (ST_OSDP_SC_BAD_HASH != sc_test_open (session, session->frames, buffer,
+      length, &msg))
+      status = ST_SC_TEST_TAMPER;
+  };
+  if (status != ST_OK)
+    fprintf (stdout, "  changed frame was not rejected\n");
+  return (status);
+
+} /* sc_test_tamper */
+
+
+/*
+  send_osdp_data - nothing here is sent anywhere
+*/
+
+int
+  send_osdp_data
+    (OSDP_CONTEXT *ctx,
+    unsigned char *buf,
+    int lth)
+
+{ /* send_osdp_data */
+
+  return (ST_OK);
+
+} /* send_osdp_data */
+